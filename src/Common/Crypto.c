@@ -226,6 +226,10 @@ void EncipherBlocks (int cipher, void *dataPtr, void *ks, size_t blockCount)
 		KeRestoreFloatingPointState (&floatingPointState);
 #endif
 	}
+	else if (cipher == SERPENT)
+		serpent_encrypt_blocks (data, data, blockCount, ks);
+	else if (cipher == TWOFISH)
+		twofish_encrypt_blocks (ks, data, data, blockCount);
 	else
 	{
 		size_t blockSize = CipherGetBlockSize (cipher);
@@ -295,6 +299,10 @@ void DecipherBlocks (int cipher, void *dataPtr, void *ks, size_t blockCount)
 		KeRestoreFloatingPointState (&floatingPointState);
 #endif
 	}
+	else if (cipher == SERPENT)
+		serpent_decrypt_blocks (data, data, blockCount, ks);
+	else if (cipher == TWOFISH)
+		twofish_decrypt_blocks (ks, data, data, blockCount);
 	else
 	{
 		size_t blockSize = CipherGetBlockSize (cipher);
@@ -345,7 +353,8 @@ int CipherGetKeyScheduleSize (int cipherId)
 
 BOOL CipherSupportsIntraDataUnitParallelization (int cipher)
 {
-	return cipher == AES && IsAesHwCpuSupported();
+	// Serpent and Twofish have multi-block functions, so XTS passes them whole data units
+	return (cipher == AES && IsAesHwCpuSupported()) || cipher == SERPENT || cipher == TWOFISH;
 }
 
 #endif
@@ -826,6 +835,7 @@ void EncryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 	unsigned __int64 b;
 
 	*(unsigned __int64 *)i = BE64(blockIndex);
+	Gf128MulBy64Tab (i, t, &cryptoInfo->gf_ctx);
 
 	if (length % 16)
 		TC_THROW_FATAL_EXCEPTION;
@@ -834,7 +844,6 @@ void EncryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 
 	for (b = 0; b < length >> 4; b++)
 	{
-		Gf128MulBy64Tab (i, t, &cryptoInfo->gf_ctx);
 		Xor128 ((unsigned __int64 *)p, (unsigned __int64 *)t);
 
 		if (cipherCount > 1)
@@ -858,10 +867,7 @@ void EncryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 
 		p += 16;
 
-		if (i[7] != 0xff)
-			i[7]++;
-		else
-			*(unsigned __int64 *)i = BE64 ( BE64(*(unsigned __int64 *)i) + 1 );
+		Gf128MulBy64TabInc (blockIndex++, t, &cryptoInfo->gf_ctx);
 	}
 
 	FAST_ERASE64 (t, sizeof(t));
@@ -880,13 +886,13 @@ void EncryptBufferLRW64 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPTO
 	unsigned __int64 b;
 
 	*(unsigned __int64 *)i = BE64(blockIndex);
+	Gf64MulTab (i, t, &cryptoInfo->gf_ctx);
 
 	if (length % 8)
 		TC_THROW_FATAL_EXCEPTION;
 
 	for (b = 0; b < length >> 3; b++)
 	{
-		Gf64MulTab (i, t, &cryptoInfo->gf_ctx);
 		Xor64 ((unsigned __int64 *)p, (unsigned __int64 *)t);
 
 		EncipherBlock (cipher, p, ks);
@@ -895,10 +901,7 @@ void EncryptBufferLRW64 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPTO
 
 		p += 8;
 
-		if (i[7] != 0xff)
-			i[7]++;
-		else
-			*(unsigned __int64 *)i = BE64 ( BE64(*(unsigned __int64 *)i) + 1 );
+		Gf64MulTabInc (blockIndex++, t, &cryptoInfo->gf_ctx);
 	}
 
 	FAST_ERASE64 (t, sizeof(t));
@@ -918,6 +921,7 @@ void DecryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 	unsigned __int64 b;
 
 	*(unsigned __int64 *)i = BE64(blockIndex);
+	Gf128MulBy64Tab (i, t, &cryptoInfo->gf_ctx);
 
 	if (length % 16)
 		TC_THROW_FATAL_EXCEPTION;
@@ -926,7 +930,6 @@ void DecryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 
 	for (b = 0; b < length >> 4; b++)
 	{
-		Gf128MulBy64Tab (i, t, &cryptoInfo->gf_ctx);
 		Xor128 ((unsigned __int64 *)p, (unsigned __int64 *)t);
 
 		if (cipherCount > 1)
@@ -951,10 +954,7 @@ void DecryptBufferLRW128 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPT
 
 		p += 16;
 
-		if (i[7] != 0xff)
-			i[7]++;
-		else
-			*(unsigned __int64 *)i = BE64 ( BE64(*(unsigned __int64 *)i) + 1 );
+		Gf128MulBy64TabInc (blockIndex++, t, &cryptoInfo->gf_ctx);
 	}
 
 	FAST_ERASE64 (t, sizeof(t));
@@ -974,13 +974,13 @@ void DecryptBufferLRW64 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPTO
 	unsigned __int64 b;
 
 	*(unsigned __int64 *)i = BE64(blockIndex);
+	Gf64MulTab (i, t, &cryptoInfo->gf_ctx);
 
 	if (length % 8)
 		TC_THROW_FATAL_EXCEPTION;
 
 	for (b = 0; b < length >> 3; b++)
 	{
-		Gf64MulTab (i, t, &cryptoInfo->gf_ctx);
 		Xor64 ((unsigned __int64 *)p, (unsigned __int64 *)t);
 
 		DecipherBlock (cipher, p, ks);
@@ -989,10 +989,7 @@ void DecryptBufferLRW64 (byte *buffer, uint64 length, uint64 blockIndex, PCRYPTO
 
 		p += 8;
 
-		if (i[7] != 0xff)
-			i[7]++;
-		else
-			*(unsigned __int64 *)i = BE64 ( BE64(*(unsigned __int64 *)i) + 1 );
+		Gf64MulTabInc (blockIndex++, t, &cryptoInfo->gf_ctx);
 	}
 
 	FAST_ERASE64 (t, sizeof(t));
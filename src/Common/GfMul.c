@@ -613,6 +613,35 @@ void MirrorBits64 (unsigned __int8 *a)
 	burn (t,sizeof (t));
 }
 
+/* Incrementing a 64-bit operand flips its trailing one bits and the zero bit above them, i.e. the operand is
+   XORed with 2^(k+1)-1 where k is the number of trailing one bits. As multiplication distributes over XOR,
+   the product for the next operand is the product for the current one XORed with the product of that value. */
+static void GetIncrementDelta (int k, unsigned __int8 delta[8])
+{
+	int i;
+
+	memset (delta, 0, 8);
+	for (i = 0; i <= k; i++)
+		delta[7 - i / 8] |= 1 << (i % 8);
+}
+
+static int GetTrailingOneBitCount (uint64 a)
+{
+#if defined (__GNUC__)
+	return ~a ? __builtin_ctzll (~a) : 63;
+#else
+	int k = 0;
+
+	while ((a & 1) && k < 63)
+	{
+		a >>= 1;
+		k++;
+	}
+
+	return k;
+#endif
+}
+
 /* Allocate and initialize speed optimization table
    for multiplication by 64-bit operand in MSB-first mode */
 int Gf128Tab64Init (unsigned __int8 *a, GfCtx *ctx)
@@ -645,6 +674,12 @@ int Gf128Tab64Init (unsigned __int8 *a, GfCtx *ctx)
 		}
 	}
 
+	for (i = 0; i < 64; i++)
+	{
+		GetIncrementDelta (i, am);
+		Gf128MulBy64Tab (am, (unsigned __int8 *) ctx->gf_t128_inc[i], ctx);
+	}
+
 	burn (ctx8k ,sizeof (*ctx8k));
 	burn (am, sizeof (am));
 	TCfree (ctx8k);
@@ -683,6 +718,12 @@ int Gf64TabInit (unsigned __int8 *a, GfCtx *ctx)
 		}
 	}
 
+	for (i = 0; i < 64; i++)
+	{
+		GetIncrementDelta (i, am);
+		Gf64MulTab (am, (unsigned __int8 *) ctx->gf_t64_inc[i], ctx);
+	}
+
 	burn (ctx4k,sizeof (*ctx4k));
 	burn (am, sizeof (am));
 	TCfree (ctx4k);
@@ -718,6 +759,39 @@ void Gf128MulBy64Tab (unsigned __int8 a[8], unsigned __int8 p[16], GfCtx *ctx)
     move_block_aligned(p, r);
 }
 
+/* Given the product p of a 128-bit number and the 64-bit number a (see Gf128MulBy64Tab),
+   compute the product of the 128-bit number and a + 1 */
+void Gf128MulBy64TabInc (uint64 a, unsigned __int8 p[16], GfCtx *ctx)
+{
+	Gf128MulBy64TabSeq (a, p, NULL, 1, ctx);
+}
+
+/* Store the products of a 128-bit number and count consecutive 64-bit numbers starting with a (see Gf128MulBy64Tab)
+   in products, unless products is NULL. On entry, p holds the product for a; on return, it holds the product for a + count. */
+void Gf128MulBy64TabSeq (uint64 a, unsigned __int8 p[16], unsigned __int8 *products, size_t count, GfCtx *ctx)
+{
+	uint64 r[2];
+	uint64 delta[2];
+	size_t i;
+
+	memcpy (r, p, sizeof (r));
+
+	for (i = 0; i < count; i++)
+	{
+		if (products)
+		{
+			memcpy (products, r, sizeof (r));
+			products += sizeof (r);
+		}
+
+		memcpy (delta, ctx->gf_t128_inc[GetTrailingOneBitCount (a++)], sizeof (delta));
+		r[0] ^= delta[0];
+		r[1] ^= delta[1];
+	}
+
+	memcpy (p, r, sizeof (r));
+}
+
 #define xor_8k64(i)   \
     xor_block_aligned64(r, ctx->gf_t64[i + i][a[i] & 15]); \
     xor_block_aligned64(r, ctx->gf_t64[i + i + 1][a[i] >> 4])
@@ -749,6 +823,42 @@ void Gf64MulTab (unsigned char a[8], unsigned char p[8], GfCtx *ctx)
     move_block_aligned64(p, r);
 }
 
+/* Given the product p of a 64-bit number and the 64-bit number a (see Gf64MulTab),
+   compute the product of the first number and a + 1 */
+void Gf64MulTabInc (uint64 a, unsigned char p[8], GfCtx *ctx)
+{
+	/* Deprecated/legacy */
+
+	Gf64MulTabSeq (a, p, NULL, 1, ctx);
+}
+
+/* Store the products of a 64-bit number and count consecutive 64-bit numbers starting with a (see Gf64MulTab)
+   in products, unless products is NULL. On entry, p holds the product for a; on return, it holds the product for a + count. */
+void Gf64MulTabSeq (uint64 a, unsigned char p[8], unsigned char *products, size_t count, GfCtx *ctx)
+{
+	/* Deprecated/legacy */
+
+	uint64 r;
+	uint64 delta;
+	size_t i;
+
+	memcpy (&r, p, sizeof (r));
+
+	for (i = 0; i < count; i++)
+	{
+		if (products)
+		{
+			memcpy (products, &r, sizeof (r));
+			products += sizeof (r);
+		}
+
+		memcpy (&delta, ctx->gf_t64_inc[GetTrailingOneBitCount (a++)], sizeof (delta));
+		r ^= delta;
+	}
+
+	memcpy (p, &r, sizeof (r));
+}
+
 
 /* Basic algorithms for testing of optimized algorithms */
 
@@ -843,6 +953,7 @@ BOOL GfMulSelfTest ()
 	unsigned __int8 b[16];
 	unsigned __int8 p1[16];
 	unsigned __int8 p2[16];
+	unsigned __int8 products[8 * 16];
 	GfCtx *gfCtx = (GfCtx *) TCalloc (sizeof (GfCtx));
 	int i, j;
 
@@ -885,6 +996,59 @@ BOOL GfMulSelfTest ()
 			result = FALSE;
 	}
 
+	/* Incremental multiplication */
+	for (i = 0; i < 0x100; i++)
+	{
+		static const uint64 operands[] = { 0, 0xff, 0x7fffffffffffffffULL, 0xffffffffffffffffULL };
+		uint64 operand = operands[i % (sizeof (operands) / sizeof (operands[0]))] - 4;
+
+		for (j = 0; j < 16; j++)
+			a[j] = (unsigned __int8) (i + j * 0x1d);
+
+		Gf64TabInit (a, gfCtx);
+		Gf128Tab64Init (a, gfCtx);
+
+		*(uint64 *) b = BE64 (operand);
+		Gf64MulTab (b, p1, gfCtx);
+		Gf128MulBy64Tab (b, p2, gfCtx);
+
+		for (j = 0; j < 8; j++)
+		{
+			Gf64MulTabInc (operand, p1, gfCtx);
+			Gf128MulBy64TabInc (operand, p2, gfCtx);
+
+			*(uint64 *) b = BE64 (++operand);
+			Gf64MulTab (b, a, gfCtx);
+			if (memcmp (p1, a, 8) != 0)
+				result = FALSE;
+
+			Gf128MulBy64Tab (b, a, gfCtx);
+			if (memcmp (p2, a, 16) != 0)
+				result = FALSE;
+		}
+
+		/* Products of the 8 operands preceding the current one */
+		operand -= 8;
+		*(uint64 *) b = BE64 (operand);
+		Gf64MulTab (b, a, gfCtx);
+		Gf64MulTabSeq (operand, a, products, 8, gfCtx);
+		if (memcmp (p1, a, 8) != 0)
+			result = FALSE;
+
+		Gf128MulBy64Tab (b, a, gfCtx);
+		Gf128MulBy64TabSeq (operand, a, products, 8, gfCtx);
+		if (memcmp (p2, a, 16) != 0)
+			result = FALSE;
+
+		for (j = 0; j < 8; j++)
+		{
+			*(uint64 *) b = BE64 (operand + j);
+			Gf128MulBy64Tab (b, a, gfCtx);
+			if (memcmp (products + j * 16, a, 16) != 0)
+				result = FALSE;
+		}
+	}
+
 	TCfree (gfCtx);
 	return result;
 }
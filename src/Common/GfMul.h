@@ -31,6 +31,7 @@
 #define _GCM_H
 
 #include "Tcdefs.h"
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -55,6 +56,10 @@ typedef struct
 	/* union not used to support faster mounting */
     unsigned __int32 gf_t128[CBLK_LEN * 2 / 2][16][CBLK_LEN / 4];
     unsigned __int32 gf_t64[CBLK_LEN8 * 2][16][CBLK_LEN8 / 4];
+
+	/* Products of the key and 2^(k+1)-1 (k = 0..63) for incremental multiplication by consecutive operands */
+    unsigned __int32 gf_t128_inc[64][CBLK_LEN / 4];
+    unsigned __int32 gf_t64_inc[64][CBLK_LEN8 / 4];
 } GfCtx;
 
 typedef int  ret_type;
@@ -63,8 +68,12 @@ void GfMul128 (void *a, const void* b);
 void GfMul128Tab(unsigned char a[16], GfCtx8k *ctx);
 int Gf128Tab64Init (unsigned __int8 *a, GfCtx *ctx);
 void Gf128MulBy64Tab (unsigned __int8 a[8], unsigned __int8 p[16], GfCtx *ctx);
+void Gf128MulBy64TabInc (uint64 a, unsigned __int8 p[16], GfCtx *ctx);
+void Gf128MulBy64TabSeq (uint64 a, unsigned __int8 p[16], unsigned __int8 *products, size_t count, GfCtx *ctx);
 int Gf64TabInit (unsigned __int8 *a, GfCtx *ctx);
 void Gf64MulTab (unsigned char a[8], unsigned char p[8], GfCtx *ctx);
+void Gf64MulTabInc (uint64 a, unsigned char p[8], GfCtx *ctx);
+void Gf64MulTabSeq (uint64 a, unsigned char p[8], unsigned char *products, size_t count, GfCtx *ctx);
 void MirrorBits128 (unsigned __int8 *a);
 void MirrorBits64 (unsigned __int8 *a);
 BOOL GfMulSelfTest ();
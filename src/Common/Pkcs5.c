@@ -21,6 +21,8 @@
 #include "Pkcs5.h"
 #include "Crypto.h"
 
+#define PKCS5_ABORTED(aborted) ((aborted) && *(aborted))
+
 void hmac_truncate
   (
 	  char *d1,		/* data to be truncated */
@@ -35,18 +37,11 @@ void hmac_truncate
 
 #ifndef TC_WINDOWS_BOOT
 
-void hmac_sha512
-(
-	  char *k,		/* secret key */
-	  int lk,		/* length of the key in bytes */
-	  char *d,		/* data */
-	  int ld,		/* length of data in bytes */
-	  char *out,		/* output buffer, at least "t" bytes */
-	  int t
-)
+/* The key is absorbed into the inner and outer hash states only once. Each HMAC computation
+   then starts from a copy of the precomputed states, which halves the number of compression
+   function calls performed by PBKDF2. The context must be burned by the caller. */
+void hmac_sha512_init (hmac_sha512_ctx *hctx, char *k, int lk)
 {
-	sha512_ctx ictx, octx;
-	char isha[SHA512_DIGESTSIZE], osha[SHA512_DIGESTSIZE];
 	char key[SHA512_DIGESTSIZE];
 	char buf[SHA512_BLOCKSIZE];
 	int i;
@@ -55,80 +50,101 @@ void hmac_sha512
 	   let key = sha512(key), as per HMAC specifications. */
 	if (lk > SHA512_BLOCKSIZE)
 	{
-		sha512_ctx tctx;
-
-		sha512_begin (&tctx);
-		sha512_hash ((unsigned char *) k, lk, &tctx);
-		sha512_end ((unsigned char *) key, &tctx);
+		sha512_begin (&hctx->work);
+		sha512_hash ((unsigned char *) k, lk, &hctx->work);
+		sha512_end ((unsigned char *) key, &hctx->work);
 
 		k = key;
 		lk = SHA512_DIGESTSIZE;
-
-		burn (&tctx, sizeof(tctx));		// Prevent leaks
 	}
 
-	/**** Inner Digest ****/
-
-	sha512_begin (&ictx);
-
 	/* Pad the key for inner digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x36);
 	for (i = lk; i < SHA512_BLOCKSIZE; ++i)
 		buf[i] = 0x36;
 
-	sha512_hash ((unsigned char *) buf, SHA512_BLOCKSIZE, &ictx);
-	sha512_hash ((unsigned char *) d, ld, &ictx);
-
-	sha512_end ((unsigned char *) isha, &ictx);
-
-	/**** Outer Digest ****/
-
-	sha512_begin (&octx);
+	sha512_begin (&hctx->inner);
+	sha512_hash ((unsigned char *) buf, SHA512_BLOCKSIZE, &hctx->inner);
 
+	/* Pad the key for outer digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x5C);
 	for (i = lk; i < SHA512_BLOCKSIZE; ++i)
 		buf[i] = 0x5C;
 
-	sha512_hash ((unsigned char *) buf, SHA512_BLOCKSIZE, &octx);
-	sha512_hash ((unsigned char *) isha, SHA512_DIGESTSIZE, &octx);
+	sha512_begin (&hctx->outer);
+	sha512_hash ((unsigned char *) buf, SHA512_BLOCKSIZE, &hctx->outer);
+
+	/* Prevent leaks */
+	burn (&hctx->work, sizeof(hctx->work));
+	burn (buf, sizeof(buf));
+	burn (key, sizeof(key));
+}
+
+
+void hmac_sha512_compute (hmac_sha512_ctx *hctx, char *d, int ld, char *out, int t)
+{
+	/**** Inner Digest ****/
+
+	hctx->work = hctx->inner;
+	sha512_hash ((unsigned char *) d, ld, &hctx->work);
+	sha512_end ((unsigned char *) hctx->digest, &hctx->work);
 
-	sha512_end ((unsigned char *) osha, &octx);
+	/**** Outer Digest ****/
+
+	hctx->work = hctx->outer;
+	sha512_hash ((unsigned char *) hctx->digest, SHA512_DIGESTSIZE, &hctx->work);
+	sha512_end ((unsigned char *) hctx->digest, &hctx->work);
 
 	/* truncate and print the results */
 	t = t > SHA512_DIGESTSIZE ? SHA512_DIGESTSIZE : t;
-	hmac_truncate (osha, out, t);
+	hmac_truncate (hctx->digest, out, t);
+}
+
+
+void hmac_sha512
+(
+	  char *k,		/* secret key */
+	  int lk,		/* length of the key in bytes */
+	  char *d,		/* data */
+	  int ld,		/* length of data in bytes */
+	  char *out,		/* output buffer, at least "t" bytes */
+	  int t
+)
+{
+	hmac_sha512_ctx hctx;
+
+	hmac_sha512_init (&hctx, k, lk);
+	hmac_sha512_compute (&hctx, d, ld, out, t);
 
 	/* Prevent leaks */
-	burn (&ictx, sizeof(ictx));
-	burn (&octx, sizeof(octx));
-	burn (isha, sizeof(isha));
-	burn (osha, sizeof(osha));
-	burn (buf, sizeof(buf));
-	burn (key, sizeof(key));
+	burn (&hctx, sizeof(hctx));
 }
 
 
 void derive_u_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b)
 {
+	hmac_sha512_ctx hctx;
 	char j[SHA512_DIGESTSIZE], k[SHA512_DIGESTSIZE];
 	char init[128];
 	char counter[4];
 	int c, i;
 
+	hmac_sha512_init (&hctx, pwd, pwd_len);
+
 	/* iteration 1 */
 	memset (counter, 0, 4);
 	counter[3] = (char) b;
 	memcpy (init, salt, salt_len);	/* salt */
 	memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
-	hmac_sha512 (pwd, pwd_len, init, salt_len + 4, j, SHA512_DIGESTSIZE);
+	hmac_sha512_compute (&hctx, init, salt_len + 4, j, SHA512_DIGESTSIZE);
 	memcpy (u, j, SHA512_DIGESTSIZE);
 
 	/* remaining iterations */
 	for (c = 1; c < iterations; c++)
 	{
-		hmac_sha512 (pwd, pwd_len, j, SHA512_DIGESTSIZE, k, SHA512_DIGESTSIZE);
+		hmac_sha512_compute (&hctx, j, SHA512_DIGESTSIZE, k, SHA512_DIGESTSIZE);
 		for (i = 0; i < SHA512_DIGESTSIZE; i++)
 		{
 			u[i] ^= k[i];
@@ -137,39 +153,122 @@ void derive_u_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iter
 	}
 
 	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
 	burn (j, sizeof(j));
 	burn (k, sizeof(k));
 }
 
 
-void derive_key_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
+/* Pads a message consisting of an HMAC key block followed by a digest */
+static void sha512_pad_digest (uint_64t *wbuf)
 {
-	char u[SHA512_DIGESTSIZE];
-	int b, l, r;
+	int i;
 
-	if (dklen % SHA512_DIGESTSIZE)
-	{
-		l = 1 + dklen / SHA512_DIGESTSIZE;
-	}
-	else
-	{
-		l = dklen / SHA512_DIGESTSIZE;
-	}
+	wbuf[SHA512_DIGESTSIZE / 8] = li_64 (8000000000000000);
+	for (i = SHA512_DIGESTSIZE / 8 + 1; i < 15; ++i)
+		wbuf[i] = 0;
+	wbuf[15] = (SHA512_BLOCKSIZE + SHA512_DIGESTSIZE) * 8;
+}
 
-	r = dklen - (l - 1) * SHA512_DIGESTSIZE;
 
-	/* first l - 1 blocks */
-	for (b = 1; b < l; b++)
+/* Derives the blocks b, b + 1, ..., b + count - 1 of the key into u. The HMAC computations of the
+   remaining iterations of up to SHA512_MAX_LANES blocks are performed in lockstep by the multi-buffer
+   compression function. The messages hashed by these computations always fit into a single block,
+   which is therefore padded in place instead of using sha512_hash and sha512_end. The derivation is
+   abandoned, leaving u undefined, when aborted is not NULL and *aborted becomes non-zero. */
+void derive_u_sha512_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted)
+{
+	hmac_sha512_ctx hctx;
+	sha512_ctx work[SHA512_MAX_LANES];
+	sha512_ctx *lanes[SHA512_MAX_LANES];
+	uint_64t acc[SHA512_MAX_LANES][8];
+	char init[128];
+	char counter[4];
+	int c, i, l, n;
+
+	hmac_sha512_init (&hctx, pwd, pwd_len);
+
+	for (; count > 0 && !PKCS5_ABORTED (aborted); count -= n, b += n, u += n * SHA512_DIGESTSIZE)
 	{
-		derive_u_sha512 (pwd, pwd_len, salt, salt_len, iterations, u, b);
-		memcpy (dk, u, SHA512_DIGESTSIZE);
-		dk += SHA512_DIGESTSIZE;
+		n = count < SHA512_MAX_LANES ? count : SHA512_MAX_LANES;
+
+		/* iteration 1 */
+		for (l = 0; l < n; ++l)
+		{
+			memset (counter, 0, 4);
+			counter[3] = (char) (b + l);
+			memcpy (init, salt, salt_len);	/* salt */
+			memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
+			hmac_sha512_compute (&hctx, init, salt_len + 4, hctx.digest, SHA512_DIGESTSIZE);
+
+			for (i = 0; i < 8; ++i)
+				work[l].hash[i] = acc[l][i] = BE64 (((uint_64t *) hctx.digest)[i]);
+
+			lanes[l] = &work[l];
+		}
+
+		/* remaining iterations */
+		for (c = 1; c < iterations && !PKCS5_ABORTED (aborted); c++)
+		{
+			/* inner digest of the previous result */
+			for (l = 0; l < n; ++l)
+			{
+				memcpy (work[l].wbuf, work[l].hash, SHA512_DIGESTSIZE);
+				memcpy (work[l].hash, hctx.inner.hash, sizeof (work[l].hash));
+				sha512_pad_digest (work[l].wbuf);
+			}
+			sha512_compile_lanes (lanes, n);
+
+			/* outer digest */
+			for (l = 0; l < n; ++l)
+			{
+				memcpy (work[l].wbuf, work[l].hash, SHA512_DIGESTSIZE);
+				memcpy (work[l].hash, hctx.outer.hash, sizeof (work[l].hash));
+				sha512_pad_digest (work[l].wbuf);
+			}
+			sha512_compile_lanes (lanes, n);
+
+			for (l = 0; l < n; ++l)
+			{
+				for (i = 0; i < 8; ++i)
+					acc[l][i] ^= work[l].hash[i];
+			}
+		}
+
+		for (l = 0; l < n; ++l)
+		{
+			for (i = 0; i < 8; ++i)
+				acc[l][i] = BE64 (acc[l][i]);
+		}
+
+		memcpy (u, acc, n * sizeof (acc[0]));
 	}
 
-	/* last block */
-	derive_u_sha512 (pwd, pwd_len, salt, salt_len, iterations, u, b);
-	memcpy (dk, u, r);
+	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
+	burn (work, sizeof(work));
+	burn (acc, sizeof(acc));
+	burn (init, sizeof(init));
+}
+
 
+void derive_key_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
+{
+	char u[SHA512_DIGESTSIZE * SHA512_MAX_LANES];
+	int b, l, n;
+
+	l = (dklen + SHA512_DIGESTSIZE - 1) / SHA512_DIGESTSIZE;
+
+	/* up to SHA512_MAX_LANES blocks are derived at once */
+	for (b = 1; b <= l; b += n)
+	{
+		n = l - b + 1 < SHA512_MAX_LANES ? l - b + 1 : SHA512_MAX_LANES;
+		derive_u_sha512_lanes (pwd, pwd_len, salt, salt_len, iterations, u, b, n, NULL);
+
+		memcpy (dk, u, dklen < n * SHA512_DIGESTSIZE ? dklen : n * SHA512_DIGESTSIZE);
+		dk += n * SHA512_DIGESTSIZE;
+		dklen -= n * SHA512_DIGESTSIZE;
+	}
 
 	/* Prevent possible leaks. */
 	burn (u, sizeof(u));
@@ -177,18 +276,8 @@ void derive_key_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int it
 
 
 /* Deprecated/legacy */
-void hmac_sha1
-(
-	  char *k,		/* secret key */
-	  int lk,		/* length of the key in bytes */
-	  char *d,		/* data */
-	  int ld,		/* length of data in bytes */
-	  char *out,		/* output buffer, at least "t" bytes */
-	  int t
-)
+void hmac_sha1_init (hmac_sha1_ctx *hctx, char *k, int lk)
 {
-	sha1_ctx ictx, octx;
-	char isha[SHA1_DIGESTSIZE], osha[SHA1_DIGESTSIZE];
 	char key[SHA1_DIGESTSIZE];
 	char buf[SHA1_BLOCKSIZE];
 	int i;
@@ -197,81 +286,104 @@ void hmac_sha1
 	   let key = sha1(key), as per HMAC specifications. */
 	if (lk > SHA1_BLOCKSIZE)
 	{
-		sha1_ctx tctx;
-
-		sha1_begin (&tctx);
-		sha1_hash ((unsigned char *) k, lk, &tctx);
-		sha1_end ((unsigned char *) key, &tctx);
+		sha1_begin (&hctx->work);
+		sha1_hash ((unsigned char *) k, lk, &hctx->work);
+		sha1_end ((unsigned char *) key, &hctx->work);
 
 		k = key;
 		lk = SHA1_DIGESTSIZE;
-
-		burn (&tctx, sizeof(tctx));		// Prevent leaks
 	}
 
-	/**** Inner Digest ****/
-
-	sha1_begin (&ictx);
-
 	/* Pad the key for inner digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x36);
 	for (i = lk; i < SHA1_BLOCKSIZE; ++i)
 		buf[i] = 0x36;
 
-	sha1_hash ((unsigned char *) buf, SHA1_BLOCKSIZE, &ictx);
-	sha1_hash ((unsigned char *) d, ld, &ictx);
-
-	sha1_end ((unsigned char *) isha, &ictx);
-
-	/**** Outer Digest ****/
-
-	sha1_begin (&octx);
+	sha1_begin (&hctx->inner);
+	sha1_hash ((unsigned char *) buf, SHA1_BLOCKSIZE, &hctx->inner);
 
+	/* Pad the key for outer digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x5C);
 	for (i = lk; i < SHA1_BLOCKSIZE; ++i)
 		buf[i] = 0x5C;
 
-	sha1_hash ((unsigned char *) buf, SHA1_BLOCKSIZE, &octx);
-	sha1_hash ((unsigned char *) isha, SHA1_DIGESTSIZE, &octx);
+	sha1_begin (&hctx->outer);
+	sha1_hash ((unsigned char *) buf, SHA1_BLOCKSIZE, &hctx->outer);
 
-	sha1_end ((unsigned char *) osha, &octx);
+	/* Prevent leaks */
+	burn (&hctx->work, sizeof(hctx->work));
+	burn (buf, sizeof(buf));
+	burn (key, sizeof(key));
+}
+
+
+/* Deprecated/legacy */
+void hmac_sha1_compute (hmac_sha1_ctx *hctx, char *d, int ld, char *out, int t)
+{
+	/**** Inner Digest ****/
+
+	hctx->work = hctx->inner;
+	sha1_hash ((unsigned char *) d, ld, &hctx->work);
+	sha1_end ((unsigned char *) hctx->digest, &hctx->work);
+
+	/**** Outer Digest ****/
+
+	hctx->work = hctx->outer;
+	sha1_hash ((unsigned char *) hctx->digest, SHA1_DIGESTSIZE, &hctx->work);
+	sha1_end ((unsigned char *) hctx->digest, &hctx->work);
 
 	/* truncate and print the results */
 	t = t > SHA1_DIGESTSIZE ? SHA1_DIGESTSIZE : t;
-	hmac_truncate (osha, out, t);
+	hmac_truncate (hctx->digest, out, t);
+}
+
+
+/* Deprecated/legacy */
+void hmac_sha1
+(
+	  char *k,		/* secret key */
+	  int lk,		/* length of the key in bytes */
+	  char *d,		/* data */
+	  int ld,		/* length of data in bytes */
+	  char *out,		/* output buffer, at least "t" bytes */
+	  int t
+)
+{
+	hmac_sha1_ctx hctx;
+
+	hmac_sha1_init (&hctx, k, lk);
+	hmac_sha1_compute (&hctx, d, ld, out, t);
 
 	/* Prevent leaks */
-	burn (&ictx, sizeof(ictx));
-	burn (&octx, sizeof(octx));
-	burn (isha, sizeof(isha));
-	burn (osha, sizeof(osha));
-	burn (buf, sizeof(buf));
-	burn (key, sizeof(key));
+	burn (&hctx, sizeof(hctx));
 }
 
 
 /* Deprecated/legacy */
 void derive_u_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b)
 {
+	hmac_sha1_ctx hctx;
 	char j[SHA1_DIGESTSIZE], k[SHA1_DIGESTSIZE];
 	char init[128];
 	char counter[4];
 	int c, i;
 
+	hmac_sha1_init (&hctx, pwd, pwd_len);
+
 	/* iteration 1 */
 	memset (counter, 0, 4);
 	counter[3] = (char) b;
 	memcpy (init, salt, salt_len);	/* salt */
 	memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
-	hmac_sha1 (pwd, pwd_len, init, salt_len + 4, j, SHA1_DIGESTSIZE);
+	hmac_sha1_compute (&hctx, init, salt_len + 4, j, SHA1_DIGESTSIZE);
 	memcpy (u, j, SHA1_DIGESTSIZE);
 
 	/* remaining iterations */
 	for (c = 1; c < iterations; c++)
 	{
-		hmac_sha1 (pwd, pwd_len, j, SHA1_DIGESTSIZE, k, SHA1_DIGESTSIZE);
+		hmac_sha1_compute (&hctx, j, SHA1_DIGESTSIZE, k, SHA1_DIGESTSIZE);
 		for (i = 0; i < SHA1_DIGESTSIZE; i++)
 		{
 			u[i] ^= k[i];
@@ -280,40 +392,120 @@ void derive_u_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterat
 	}
 
 	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
 	burn (j, sizeof(j));
 	burn (k, sizeof(k));
 }
 
 
+/* Pads a message consisting of an HMAC key block followed by a digest */
+static void sha1_pad_digest (sha1_32t *wbuf)
+{
+	int i;
+
+	wbuf[SHA1_DIGESTSIZE / 4] = 0x80000000;
+	for (i = SHA1_DIGESTSIZE / 4 + 1; i < 15; ++i)
+		wbuf[i] = 0;
+	wbuf[15] = (SHA1_BLOCKSIZE + SHA1_DIGESTSIZE) * 8;
+}
+
+
 /* Deprecated/legacy */
-void derive_key_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
+/* See derive_u_sha512_lanes */
+void derive_u_sha1_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted)
 {
-	char u[SHA1_DIGESTSIZE];
-	int b, l, r;
+	hmac_sha1_ctx hctx;
+	sha1_ctx work[SHA1_MAX_LANES];
+	sha1_ctx *lanes[SHA1_MAX_LANES];
+	sha1_32t acc[SHA1_MAX_LANES][5];
+	char init[128];
+	char counter[4];
+	int c, i, l, n;
 
-	if (dklen % SHA1_DIGESTSIZE)
-	{
-		l = 1 + dklen / SHA1_DIGESTSIZE;
-	}
-	else
+	hmac_sha1_init (&hctx, pwd, pwd_len);
+
+	for (; count > 0 && !PKCS5_ABORTED (aborted); count -= n, b += n, u += n * SHA1_DIGESTSIZE)
 	{
-		l = dklen / SHA1_DIGESTSIZE;
-	}
+		n = count < SHA1_MAX_LANES ? count : SHA1_MAX_LANES;
 
-	r = dklen - (l - 1) * SHA1_DIGESTSIZE;
+		/* iteration 1 */
+		for (l = 0; l < n; ++l)
+		{
+			memset (counter, 0, 4);
+			counter[3] = (char) (b + l);
+			memcpy (init, salt, salt_len);	/* salt */
+			memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
+			hmac_sha1_compute (&hctx, init, salt_len + 4, hctx.digest, SHA1_DIGESTSIZE);
 
-	/* first l - 1 blocks */
-	for (b = 1; b < l; b++)
-	{
-		derive_u_sha1 (pwd, pwd_len, salt, salt_len, iterations, u, b);
-		memcpy (dk, u, SHA1_DIGESTSIZE);
-		dk += SHA1_DIGESTSIZE;
+			for (i = 0; i < 5; ++i)
+				work[l].hash[i] = acc[l][i] = BE32 (((sha1_32t *) hctx.digest)[i]);
+
+			lanes[l] = &work[l];
+		}
+
+		/* remaining iterations */
+		for (c = 1; c < iterations && !PKCS5_ABORTED (aborted); c++)
+		{
+			/* inner digest of the previous result */
+			for (l = 0; l < n; ++l)
+			{
+				memcpy (work[l].wbuf, work[l].hash, SHA1_DIGESTSIZE);
+				memcpy (work[l].hash, hctx.inner.hash, sizeof (work[l].hash));
+				sha1_pad_digest (work[l].wbuf);
+			}
+			sha1_compile_lanes (lanes, n);
+
+			/* outer digest */
+			for (l = 0; l < n; ++l)
+			{
+				memcpy (work[l].wbuf, work[l].hash, SHA1_DIGESTSIZE);
+				memcpy (work[l].hash, hctx.outer.hash, sizeof (work[l].hash));
+				sha1_pad_digest (work[l].wbuf);
+			}
+			sha1_compile_lanes (lanes, n);
+
+			for (l = 0; l < n; ++l)
+			{
+				for (i = 0; i < 5; ++i)
+					acc[l][i] ^= work[l].hash[i];
+			}
+		}
+
+		for (l = 0; l < n; ++l)
+		{
+			for (i = 0; i < 5; ++i)
+				acc[l][i] = BE32 (acc[l][i]);
+		}
+
+		memcpy (u, acc, n * sizeof (acc[0]));
 	}
 
-	/* last block */
-	derive_u_sha1 (pwd, pwd_len, salt, salt_len, iterations, u, b);
-	memcpy (dk, u, r);
+	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
+	burn (work, sizeof(work));
+	burn (acc, sizeof(acc));
+	burn (init, sizeof(init));
+}
+
 
+/* Deprecated/legacy */
+void derive_key_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
+{
+	char u[SHA1_DIGESTSIZE * SHA1_MAX_LANES];
+	int b, l, n;
+
+	l = (dklen + SHA1_DIGESTSIZE - 1) / SHA1_DIGESTSIZE;
+
+	/* up to SHA1_MAX_LANES blocks are derived at once */
+	for (b = 1; b <= l; b += n)
+	{
+		n = l - b + 1 < SHA1_MAX_LANES ? l - b + 1 : SHA1_MAX_LANES;
+		derive_u_sha1_lanes (pwd, pwd_len, salt, salt_len, iterations, u, b, n, NULL);
+
+		memcpy (dk, u, dklen < n * SHA1_DIGESTSIZE ? dklen : n * SHA1_DIGESTSIZE);
+		dk += n * SHA1_DIGESTSIZE;
+		dklen -= n * SHA1_DIGESTSIZE;
+	}
 
 	/* Prevent possible leaks. */
 	burn (u, sizeof(u));
@@ -321,9 +513,8 @@ void derive_key_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iter
 
 #endif // TC_WINDOWS_BOOT
 
-void hmac_ripemd160 (char *key, int keylen, char *input, int len, char *digest)
+void hmac_ripemd160_init (hmac_ripemd160_ctx *hctx, char *key, int keylen)
 {
-    RMD160_CTX context;
     unsigned char k_ipad[65];  /* inner padding - key XORd with ipad */
     unsigned char k_opad[65];  /* outer padding - key XORd with opad */
     unsigned char tk[RIPEMD160_DIGESTSIZE];
@@ -331,18 +522,14 @@ void hmac_ripemd160 (char *key, int keylen, char *input, int len, char *digest)
 
     /* If the key is longer than the hash algorithm block size,
 	   let key = ripemd160(key), as per HMAC specifications. */
-    if (keylen > RIPEMD160_BLOCKSIZE) 
+    if (keylen > RIPEMD160_BLOCKSIZE)
 	{
-        RMD160_CTX      tctx;
-
-        RMD160Init(&tctx);
-        RMD160Update(&tctx, (const unsigned char *) key, keylen);
-        RMD160Final(tk, &tctx);
+        RMD160Init(&hctx->work);
+        RMD160Update(&hctx->work, (const unsigned char *) key, keylen);
+        RMD160Final(tk, &hctx->work);
 
         key = (char *) tk;
         keylen = RIPEMD160_DIGESTSIZE;
-
-		burn (&tctx, sizeof(tctx));	// Prevent leaks
     }
 
 	/*
@@ -360,52 +547,72 @@ void hmac_ripemd160 (char *key, int keylen, char *input, int len, char *digest)
     memset(k_opad, 0x5c, sizeof(k_opad));
 
     /* XOR key with ipad and opad values */
-    for (i=0; i<keylen; i++) 
+    for (i=0; i<keylen; i++)
 	{
         k_ipad[i] ^= key[i];
         k_opad[i] ^= key[i];
     }
 
-    /* perform inner RIPEMD-160 */
+    RMD160Init(&hctx->inner);
+    RMD160Update(&hctx->inner, k_ipad, RIPEMD160_BLOCKSIZE);  /* start with inner pad */
 
-    RMD160Init(&context);           /* init context for 1st pass */
-    RMD160Update(&context, k_ipad, RIPEMD160_BLOCKSIZE);  /* start with inner pad */
-    RMD160Update(&context, (const unsigned char *) input, len); /* then text of datagram */
-    RMD160Final((unsigned char *) digest, &context);         /* finish up 1st pass */
-
-    /* perform outer RIPEMD-160 */
-    RMD160Init(&context);           /* init context for 2nd pass */
-    RMD160Update(&context, k_opad, RIPEMD160_BLOCKSIZE);  /* start with outer pad */
-    /* results of 1st hash */
-    RMD160Update(&context, (const unsigned char *) digest, RIPEMD160_DIGESTSIZE);
-    RMD160Final((unsigned char *) digest, &context);         /* finish up 2nd pass */
+    RMD160Init(&hctx->outer);
+    RMD160Update(&hctx->outer, k_opad, RIPEMD160_BLOCKSIZE);  /* start with outer pad */
 
 	/* Prevent possible leaks. */
     burn (k_ipad, sizeof(k_ipad));
     burn (k_opad, sizeof(k_opad));
 	burn (tk, sizeof(tk));
-	burn (&context, sizeof(context));
+	burn (&hctx->work, sizeof(hctx->work));
+}
+
+void hmac_ripemd160_compute (hmac_ripemd160_ctx *hctx, char *input, int len, char *digest)
+{
+    /* perform inner RIPEMD-160 */
+    hctx->work = hctx->inner;
+    RMD160Update(&hctx->work, (const unsigned char *) input, len); /* text of datagram */
+    RMD160Final((unsigned char *) digest, &hctx->work);         /* finish up 1st pass */
+
+    /* perform outer RIPEMD-160 */
+    hctx->work = hctx->outer;
+    /* results of 1st hash */
+    RMD160Update(&hctx->work, (const unsigned char *) digest, RIPEMD160_DIGESTSIZE);
+    RMD160Final((unsigned char *) digest, &hctx->work);         /* finish up 2nd pass */
+}
+
+void hmac_ripemd160 (char *key, int keylen, char *input, int len, char *digest)
+{
+	hmac_ripemd160_ctx hctx;
+
+	hmac_ripemd160_init (&hctx, key, keylen);
+	hmac_ripemd160_compute (&hctx, input, len, digest);
+
+	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
 }
 
 void derive_u_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b)
 {
+	hmac_ripemd160_ctx hctx;
 	char j[RIPEMD160_DIGESTSIZE], k[RIPEMD160_DIGESTSIZE];
 	char init[128];
 	char counter[4];
 	int c, i;
 
+	hmac_ripemd160_init (&hctx, pwd, pwd_len);
+
 	/* iteration 1 */
 	memset (counter, 0, 4);
 	counter[3] = (char) b;
 	memcpy (init, salt, salt_len);	/* salt */
 	memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
-	hmac_ripemd160 (pwd, pwd_len, init, salt_len + 4, j);
+	hmac_ripemd160_compute (&hctx, init, salt_len + 4, j);
 	memcpy (u, j, RIPEMD160_DIGESTSIZE);
 
 	/* remaining iterations */
 	for (c = 1; c < iterations; c++)
 	{
-		hmac_ripemd160 (pwd, pwd_len, j, RIPEMD160_DIGESTSIZE, k);
+		hmac_ripemd160_compute (&hctx, j, RIPEMD160_DIGESTSIZE, k);
 		for (i = 0; i < RIPEMD160_DIGESTSIZE; i++)
 		{
 			u[i] ^= k[i];
@@ -414,10 +621,122 @@ void derive_u_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int i
 	}
 
 	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
 	burn (j, sizeof(j));
 	burn (k, sizeof(k));
 }
 
+#ifndef TC_WINDOWS_BOOT
+
+/* See derive_u_sha512_lanes */
+void derive_u_ripemd160_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted)
+{
+	hmac_ripemd160_ctx hctx;
+	unsigned __int32 state[RIPEMD160_MAX_LANES][5];
+	unsigned __int32 block[RIPEMD160_MAX_LANES][16];
+	unsigned __int32 acc[RIPEMD160_MAX_LANES][5];
+	unsigned __int32 *states[RIPEMD160_MAX_LANES];
+	const unsigned __int32 *blocks[RIPEMD160_MAX_LANES];
+	char init[128];
+	char counter[4];
+	int c, i, l, n;
+
+	hmac_ripemd160_init (&hctx, pwd, pwd_len);
+
+	/* The message words are passed to RMD160Transform in little-endian byte order */
+	memset (block, 0, sizeof (block));
+	for (l = 0; l < RIPEMD160_MAX_LANES; ++l)
+	{
+		block[l][RIPEMD160_DIGESTSIZE / 4] = LE32 (0x80);
+		block[l][14] = LE32 ((RIPEMD160_BLOCKSIZE + RIPEMD160_DIGESTSIZE) * 8);
+
+		states[l] = state[l];
+		blocks[l] = block[l];
+	}
+
+	for (; count > 0 && !PKCS5_ABORTED (aborted); count -= n, b += n, u += n * RIPEMD160_DIGESTSIZE)
+	{
+		n = count < RIPEMD160_MAX_LANES ? count : RIPEMD160_MAX_LANES;
+
+		/* iteration 1 */
+		for (l = 0; l < n; ++l)
+		{
+			memset (counter, 0, 4);
+			counter[3] = (char) (b + l);
+			memcpy (init, salt, salt_len);	/* salt */
+			memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
+			hmac_ripemd160_compute (&hctx, init, salt_len + 4, (char *) block[l]);
+
+			for (i = 0; i < 5; ++i)
+				acc[l][i] = block[l][i];
+		}
+
+		/* remaining iterations */
+		for (c = 1; c < iterations && !PKCS5_ABORTED (aborted); c++)
+		{
+			/* inner digest of the previous result */
+			for (l = 0; l < n; ++l)
+				memcpy (state[l], hctx.inner.state, sizeof (state[l]));
+
+			RMD160TransformLanes (states, blocks, n);
+
+			/* outer digest */
+			for (l = 0; l < n; ++l)
+			{
+				for (i = 0; i < 5; ++i)
+					block[l][i] = LE32 (state[l][i]);
+
+				memcpy (state[l], hctx.outer.state, sizeof (state[l]));
+			}
+
+			RMD160TransformLanes (states, blocks, n);
+
+			for (l = 0; l < n; ++l)
+			{
+				for (i = 0; i < 5; ++i)
+				{
+					block[l][i] = LE32 (state[l][i]);
+					acc[l][i] ^= block[l][i];
+				}
+			}
+		}
+
+		memcpy (u, acc, n * RIPEMD160_DIGESTSIZE);
+	}
+
+	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
+	burn (state, sizeof(state));
+	burn (block, sizeof(block));
+	burn (acc, sizeof(acc));
+	burn (init, sizeof(init));
+}
+
+
+void derive_key_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
+{
+	char u[RIPEMD160_DIGESTSIZE * RIPEMD160_MAX_LANES];
+	int b, l, n;
+
+	l = (dklen + RIPEMD160_DIGESTSIZE - 1) / RIPEMD160_DIGESTSIZE;
+
+	/* up to RIPEMD160_MAX_LANES blocks are derived at once */
+	for (b = 1; b <= l; b += n)
+	{
+		n = l - b + 1 < RIPEMD160_MAX_LANES ? l - b + 1 : RIPEMD160_MAX_LANES;
+		derive_u_ripemd160_lanes (pwd, pwd_len, salt, salt_len, iterations, u, b, n, NULL);
+
+		memcpy (dk, u, dklen < n * RIPEMD160_DIGESTSIZE ? dklen : n * RIPEMD160_DIGESTSIZE);
+		dk += n * RIPEMD160_DIGESTSIZE;
+		dklen -= n * RIPEMD160_DIGESTSIZE;
+	}
+
+	/* Prevent possible leaks. */
+	burn (u, sizeof(u));
+}
+
+#else // TC_WINDOWS_BOOT
+
 void derive_key_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen)
 {
 	char u[RIPEMD160_DIGESTSIZE];
@@ -451,20 +770,12 @@ void derive_key_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int
 	burn (u, sizeof(u));
 }
 
+#endif // TC_WINDOWS_BOOT
+
 #ifndef TC_WINDOWS_BOOT
 
-void hmac_whirlpool
-(
-	  char *k,		/* secret key */
-	  int lk,		/* length of the key in bytes */
-	  char *d,		/* data */
-	  int ld,		/* length of data in bytes */
-	  char *out,	/* output buffer, at least "t" bytes */
-	  int t
-)
+void hmac_whirlpool_init (hmac_whirlpool_ctx *hctx, char *k, int lk)
 {
-	WHIRLPOOL_CTX ictx, octx;
-	char iwhi[WHIRLPOOL_DIGESTSIZE], owhi[WHIRLPOOL_DIGESTSIZE];
 	char key[WHIRLPOOL_DIGESTSIZE];
 	char buf[WHIRLPOOL_BLOCKSIZE];
 	int i;
@@ -473,79 +784,100 @@ void hmac_whirlpool
 	   let key = whirlpool(key), as per HMAC specifications. */
 	if (lk > WHIRLPOOL_BLOCKSIZE)
 	{
-		WHIRLPOOL_CTX tctx;
-
-		WHIRLPOOL_init (&tctx);
-		WHIRLPOOL_add ((unsigned char *) k, lk * 8, &tctx);
-		WHIRLPOOL_finalize (&tctx, (unsigned char *) key);
+		WHIRLPOOL_init (&hctx->work);
+		WHIRLPOOL_add ((unsigned char *) k, lk * 8, &hctx->work);
+		WHIRLPOOL_finalize (&hctx->work, (unsigned char *) key);
 
 		k = key;
 		lk = WHIRLPOOL_DIGESTSIZE;
-
-		burn (&tctx, sizeof(tctx));		// Prevent leaks
 	}
 
-	/**** Inner Digest ****/
-
-	WHIRLPOOL_init (&ictx);
-
 	/* Pad the key for inner digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x36);
 	for (i = lk; i < WHIRLPOOL_BLOCKSIZE; ++i)
 		buf[i] = 0x36;
 
-	WHIRLPOOL_add ((unsigned char *) buf, WHIRLPOOL_BLOCKSIZE * 8, &ictx);
-	WHIRLPOOL_add ((unsigned char *) d, ld * 8, &ictx);
-
-	WHIRLPOOL_finalize (&ictx, (unsigned char *) iwhi);
-
-	/**** Outer Digest ****/
-
-	WHIRLPOOL_init (&octx);
+	WHIRLPOOL_init (&hctx->inner);
+	WHIRLPOOL_add ((unsigned char *) buf, WHIRLPOOL_BLOCKSIZE * 8, &hctx->inner);
+	WHIRLPOOL_expand_key (&hctx->inner, hctx->innerKeySchedule);
 
+	/* Pad the key for outer digest */
 	for (i = 0; i < lk; ++i)
 		buf[i] = (char) (k[i] ^ 0x5C);
 	for (i = lk; i < WHIRLPOOL_BLOCKSIZE; ++i)
 		buf[i] = 0x5C;
 
-	WHIRLPOOL_add ((unsigned char *) buf, WHIRLPOOL_BLOCKSIZE * 8, &octx);
-	WHIRLPOOL_add ((unsigned char *) iwhi, WHIRLPOOL_DIGESTSIZE * 8, &octx);
+	WHIRLPOOL_init (&hctx->outer);
+	WHIRLPOOL_add ((unsigned char *) buf, WHIRLPOOL_BLOCKSIZE * 8, &hctx->outer);
+	WHIRLPOOL_expand_key (&hctx->outer, hctx->outerKeySchedule);
+
+	/* Prevent possible leaks. */
+	burn (&hctx->work, sizeof(hctx->work));
+	burn (buf, sizeof(buf));
+	burn (key, sizeof(key));
+}
+
+void hmac_whirlpool_compute (hmac_whirlpool_ctx *hctx, char *d, int ld, char *out, int t)
+{
+	/**** Inner Digest ****/
+
+	hctx->work = hctx->inner;
+	WHIRLPOOL_add ((unsigned char *) d, ld * 8, &hctx->work);
+	WHIRLPOOL_finalize (&hctx->work, (unsigned char *) hctx->digest);
+
+	/**** Outer Digest ****/
 
-	WHIRLPOOL_finalize (&octx, (unsigned char *) owhi);
+	hctx->work = hctx->outer;
+	WHIRLPOOL_add ((unsigned char *) hctx->digest, WHIRLPOOL_DIGESTSIZE * 8, &hctx->work);
+	WHIRLPOOL_finalize (&hctx->work, (unsigned char *) hctx->digest);
 
 	/* truncate and print the results */
 	t = t > WHIRLPOOL_DIGESTSIZE ? WHIRLPOOL_DIGESTSIZE : t;
-	hmac_truncate (owhi, out, t);
+	hmac_truncate (hctx->digest, out, t);
+}
+
+void hmac_whirlpool
+(
+	  char *k,		/* secret key */
+	  int lk,		/* length of the key in bytes */
+	  char *d,		/* data */
+	  int ld,		/* length of data in bytes */
+	  char *out,	/* output buffer, at least "t" bytes */
+	  int t
+)
+{
+	hmac_whirlpool_ctx hctx;
+
+	hmac_whirlpool_init (&hctx, k, lk);
+	hmac_whirlpool_compute (&hctx, d, ld, out, t);
 
 	/* Prevent possible leaks. */
-	burn (&ictx, sizeof(ictx));
-	burn (&octx, sizeof(octx));
-	burn (owhi, sizeof(owhi));
-	burn (iwhi, sizeof(iwhi));
-	burn (buf, sizeof(buf));
-	burn (key, sizeof(key));
+	burn (&hctx, sizeof(hctx));
 }
 
-void derive_u_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b)
+void derive_u_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, volatile int *aborted)
 {
+	hmac_whirlpool_ctx hctx;
 	char j[WHIRLPOOL_DIGESTSIZE], k[WHIRLPOOL_DIGESTSIZE];
 	char init[128];
 	char counter[4];
 	int c, i;
 
+	hmac_whirlpool_init (&hctx, pwd, pwd_len);
+
 	/* iteration 1 */
 	memset (counter, 0, 4);
 	counter[3] = (char) b;
 	memcpy (init, salt, salt_len);	/* salt */
 	memcpy (&init[salt_len], counter, 4);	/* big-endian block number */
-	hmac_whirlpool (pwd, pwd_len, init, salt_len + 4, j, WHIRLPOOL_DIGESTSIZE);
+	hmac_whirlpool_compute (&hctx, init, salt_len + 4, j, WHIRLPOOL_DIGESTSIZE);
 	memcpy (u, j, WHIRLPOOL_DIGESTSIZE);
 
 	/* remaining iterations */
-	for (c = 1; c < iterations; c++)
+	for (c = 1; c < iterations && !PKCS5_ABORTED (aborted); c++)
 	{
-		hmac_whirlpool (pwd, pwd_len, j, WHIRLPOOL_DIGESTSIZE, k, WHIRLPOOL_DIGESTSIZE);
+		hmac_whirlpool_compute (&hctx, j, WHIRLPOOL_DIGESTSIZE, k, WHIRLPOOL_DIGESTSIZE);
 		for (i = 0; i < WHIRLPOOL_DIGESTSIZE; i++)
 		{
 			u[i] ^= k[i];
@@ -554,6 +886,7 @@ void derive_u_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int i
 	}
 
 	/* Prevent possible leaks. */
+	burn (&hctx, sizeof(hctx));
 	burn (j, sizeof(j));
 	burn (k, sizeof(k));
 }
@@ -577,13 +910,13 @@ void derive_key_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int
 	/* first l - 1 blocks */
 	for (b = 1; b < l; b++)
 	{
-		derive_u_whirlpool (pwd, pwd_len, salt, salt_len, iterations, u, b);
+		derive_u_whirlpool (pwd, pwd_len, salt, salt_len, iterations, u, b, NULL);
 		memcpy (dk, u, WHIRLPOOL_DIGESTSIZE);
 		dk += WHIRLPOOL_DIGESTSIZE;
 	}
 
 	/* last block */
-	derive_u_whirlpool (pwd, pwd_len, salt, salt_len, iterations, u, b);
+	derive_u_whirlpool (pwd, pwd_len, salt, salt_len, iterations, u, b, NULL);
 	memcpy (dk, u, r);
 
 
@@ -13,23 +13,77 @@
 #define TC_HEADER_PKCS5
 
 #include "Tcdefs.h"
+#include "Crypto.h"
 
 #if defined(__cplusplus)
 extern "C"
 {
 #endif
 
+/* HMAC contexts holding the hash states after absorbing the padded key (see hmac_*_init) */
+
+#ifndef TC_WINDOWS_BOOT
+typedef struct
+{
+	sha512_ctx inner;
+	sha512_ctx outer;
+	sha512_ctx work;
+	char digest[SHA512_DIGESTSIZE];
+} hmac_sha512_ctx;
+
+typedef struct
+{
+	sha1_ctx inner;
+	sha1_ctx outer;
+	sha1_ctx work;
+	char digest[SHA1_DIGESTSIZE];
+} hmac_sha1_ctx;
+
+typedef struct
+{
+	WHIRLPOOL_CTX inner;
+	WHIRLPOOL_CTX outer;
+	WHIRLPOOL_CTX work;
+	WHIRLPOOL_KEY_SCHEDULE innerKeySchedule;
+	WHIRLPOOL_KEY_SCHEDULE outerKeySchedule;
+	char digest[WHIRLPOOL_DIGESTSIZE];
+} hmac_whirlpool_ctx;
+#endif
+
+typedef struct
+{
+	RMD160_CTX inner;
+	RMD160_CTX outer;
+	RMD160_CTX work;
+} hmac_ripemd160_ctx;
+
+#ifndef TC_WINDOWS_BOOT
+void hmac_sha512_init (hmac_sha512_ctx *hctx, char *k, int lk);
+void hmac_sha512_compute (hmac_sha512_ctx *hctx, char *d, int ld, char *out, int t);
+void hmac_sha1_init (hmac_sha1_ctx *hctx, char *k, int lk);
+void hmac_sha1_compute (hmac_sha1_ctx *hctx, char *d, int ld, char *out, int t);
+void hmac_whirlpool_init (hmac_whirlpool_ctx *hctx, char *k, int lk);
+void hmac_whirlpool_compute (hmac_whirlpool_ctx *hctx, char *d, int ld, char *out, int t);
+#endif
+void hmac_ripemd160_init (hmac_ripemd160_ctx *hctx, char *key, int keylen);
+void hmac_ripemd160_compute (hmac_ripemd160_ctx *hctx, char *input, int len, char *digest);
+
 void hmac_sha512 (char *k, int lk, char *d, int ld, char *out, int t);
 void derive_u_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b);
+void derive_u_sha512_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted);
 void derive_key_sha512 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen);
 void hmac_sha1 (char *k, int lk, char *d, int ld, char *out, int t);
 void derive_u_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b);
+void derive_u_sha1_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted);
 void derive_key_sha1 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen);
 void hmac_ripemd160 (char *key, int keylen, char *input, int len, char *digest);
 void derive_u_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b);
+#ifndef TC_WINDOWS_BOOT
+void derive_u_ripemd160_lanes (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, int count, volatile int *aborted);
+#endif
 void derive_key_ripemd160 (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen);
 void hmac_whirlpool (char *k, int lk, char *d, int ld, char *out, int t);
-void derive_u_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b);
+void derive_u_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b, volatile int *aborted);
 void derive_key_whirlpool (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen);
 int get_pkcs5_iteration_count (int pkcs5_prf_id, BOOL bBoot);
 char *get_pkcs5_prf_name (int pkcs5_prf_id);
@@ -15,6 +15,10 @@
 #include "Endian.h" // we are in Common ... #include "Common/Endian.h"
 #include "Crypto.h"
 
+#ifdef CS_UNITTESTING
+#include "../unit-tests/faux/windows/LONG.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,7 +45,7 @@ extern "C" {
 
 // Custom data types
 
-#ifndef TC_LARGEST_COMPILER_UINT
+#if !defined (TC_LARGEST_COMPILER_UINT) && !defined (TC_INT_TYPES_DEFINED)
 #	ifdef TC_NO_COMPILER_INT64
 		typedef unsigned __int32	TC_LARGEST_COMPILER_UINT;
 #	else
@@ -0,0 +1,276 @@
+/*
+ Copyright (c) 2008-2010 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Common_XtsEngine
+#define TC_HEADER_Common_XtsEngine
+
+#include "Tcdefs.h"
+#include "Crypto.h"
+#include "Endian.h"
+#include "../Crypto/Aes_bitsliced.h"
+
+namespace CipherShed
+{
+	// Processes a buffer in XTS mode with one cipher. ks and ks2 are the complete key schedules of the primary
+	// and of the secondary cipher (as initialized by CipherInit() or returned by Cipher::GetScheduledKey()).
+	typedef void (*XtsDecryptBufferFunction) (const byte *ks, const byte *ks2, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
+	typedef void (*XtsEncryptBufferFunction) (const byte *ks, const byte *ks2, const byte *source, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
+
+	struct XtsEngineFunctions
+	{
+		XtsDecryptBufferFunction DecryptBuffer;
+		XtsEncryptBufferFunction EncryptBuffer;
+	};
+
+	// XTS mode specialized at compile time for one cipher. CipherImpl provides static DecryptBlocks (ks, data, blockCount)
+	// and EncryptBlocks (ks, data, blockCount), which operate directly on the scheduled key and are inlined into the
+	// engine, so no virtual calls or key checks are made per data unit or per block. The data unit numbers are encrypted
+	// in batches of TweakBatchSize blocks, which lets multi-block implementations process them in parallel.
+	template <class CipherImpl>
+	class XtsEngine
+	{
+	public:
+		static void DecryptBuffer (const byte *ks, const byte *ks2, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+		{
+			ProcessBuffer <true> (ks, ks2, buffer, buffer, length, startDataUnitNo, startCipherBlockNo);
+		}
+
+		static void EncryptBuffer (const byte *ks, const byte *ks2, const byte *source, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+		{
+			ProcessBuffer <false> (ks, ks2, source, buffer, length, startDataUnitNo, startCipherBlockNo);
+		}
+
+		static XtsEngineFunctions GetFunctions ()
+		{
+			XtsEngineFunctions functions;
+			functions.DecryptBuffer = &DecryptBuffer;
+			functions.EncryptBuffer = &EncryptBuffer;
+			return functions;
+		}
+
+		static const unsigned int TweakBatchSize = 8;
+
+	protected:
+		// startDataUnitNo: The sequential number of the data unit with which the buffer starts.
+		// startCipherBlockNo: The sequential number of the first block to process inside the data unit startDataUnitNo.
+		// The source and the destination buffer may be identical.
+		template <bool Decryption>
+		static void ProcessBuffer (const byte *ks, const byte *ks2, const byte *source, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+		{
+			byte finalCarry;
+			byte whiteningValues [ENCRYPTION_DATA_UNIT_SIZE];
+			byte whiteningValue [BYTES_PER_XTS_BLOCK];
+			byte encryptedDataUnitNos [TweakBatchSize * BYTES_PER_XTS_BLOCK];
+			unsigned int encryptedDataUnitNoCount = 0, encryptedDataUnitNoIndex = 0;
+			uint64 *whiteningValuesPtr64;
+			uint64 *whiteningValuePtr64;
+			const uint64 *sourcePtr = (const uint64 *) source;
+			uint64 *bufPtr = (uint64 *) buffer;
+			uint64 *dataUnitBufPtr;
+			unsigned int startBlock = startCipherBlockNo, endBlock, block;
+			uint64 *const finalInt64WhiteningValuesPtr = (uint64 *) whiteningValues + sizeof (whiteningValues) / sizeof (uint64) - 1;
+			uint64 blockCount, dataUnitNo;
+
+			/* The encrypted data unit number (i.e. the resultant ciphertext block) is to be multiplied in the
+			finite field GF(2^128) by j-th power of n, where j is the sequential plaintext/ciphertext block
+			number and n is 2, a primitive element of GF(2^128). This can be (and is) simplified and implemented
+			as a left shift of the preceding whitening value by one bit (with carry propagating). In addition, if
+			the shift of the highest byte results in a carry, 135 is XORed into the lowest byte. The value 135 is
+			derived from the modulus of the Galois Field (x^128+x^7+x^2+x+1). */
+
+			if (length % BYTES_PER_XTS_BLOCK)
+				TC_THROW_FATAL_EXCEPTION;
+
+			dataUnitNo = startDataUnitNo;
+			blockCount = length / BYTES_PER_XTS_BLOCK;
+
+			// Process all blocks in the buffer
+			while (blockCount > 0)
+			{
+				if (blockCount < BLOCKS_PER_XTS_DATA_UNIT)
+					endBlock = startBlock + (unsigned int) blockCount;
+				else
+					endBlock = BLOCKS_PER_XTS_DATA_UNIT;
+
+				whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
+				whiteningValuePtr64 = (uint64 *) whiteningValue;
+
+				// Encrypt the data unit number (converted into a little-endian 16-byte array) using the secondary key
+				// in order to generate the first whitening value for this data unit. The numbers of up to TweakBatchSize
+				// data units remaining in the buffer are encrypted at once.
+				if (encryptedDataUnitNoIndex == encryptedDataUnitNoCount)
+				{
+					uint64 dataUnitCount = (startBlock + blockCount + BLOCKS_PER_XTS_DATA_UNIT - 1) / BLOCKS_PER_XTS_DATA_UNIT;
+					encryptedDataUnitNoCount = dataUnitCount < TweakBatchSize ? (unsigned int) dataUnitCount : TweakBatchSize;
+					encryptedDataUnitNoIndex = 0;
+
+					for (block = 0; block < encryptedDataUnitNoCount; block++)
+					{
+						((uint64 *) encryptedDataUnitNos)[block * 2] = LE64 (dataUnitNo + block);
+						((uint64 *) encryptedDataUnitNos)[block * 2 + 1] = 0;
+					}
+
+					CipherImpl::EncryptBlocks (ks2, encryptedDataUnitNos, encryptedDataUnitNoCount);
+				}
+
+				*whiteningValuePtr64 = ((uint64 *) encryptedDataUnitNos)[encryptedDataUnitNoIndex * 2];
+				*(whiteningValuePtr64 + 1) = ((uint64 *) encryptedDataUnitNos)[encryptedDataUnitNoIndex * 2 + 1];
+				encryptedDataUnitNoIndex++;
+
+				// Generate subsequent whitening values for blocks in this data unit. Note that all generated 128-bit
+				// whitening values are stored in memory as a sequence of 64-bit integers in reverse order.
+				for (block = 0; block < endBlock; block++)
+				{
+					if (block >= startBlock)
+					{
+						*whiteningValuesPtr64-- = *whiteningValuePtr64++;
+						*whiteningValuesPtr64-- = *whiteningValuePtr64;
+					}
+					else
+						whiteningValuePtr64++;
+
+					// Derive the next whitening value
+
+#if BYTE_ORDER == LITTLE_ENDIAN
+
+					// Little-endian platforms
+
+					finalCarry =
+						(*whiteningValuePtr64 & 0x8000000000000000ULL) ?
+						135 : 0;
+
+					*whiteningValuePtr64-- <<= 1;
+
+					if (*whiteningValuePtr64 & 0x8000000000000000ULL)
+						*(whiteningValuePtr64 + 1) |= 1;
+
+					*whiteningValuePtr64 <<= 1;
+#else
+
+					// Big-endian platforms
+
+					finalCarry =
+						(*whiteningValuePtr64 & 0x80) ?
+						135 : 0;
+
+					*whiteningValuePtr64 = LE64 (LE64 (*whiteningValuePtr64) << 1);
+
+					whiteningValuePtr64--;
+
+					if (*whiteningValuePtr64 & 0x80)
+						*(whiteningValuePtr64 + 1) |= 0x0100000000000000ULL;
+
+					*whiteningValuePtr64 = LE64 (LE64 (*whiteningValuePtr64) << 1);
+#endif
+
+					whiteningValue[0] ^= finalCarry;
+				}
+
+				dataUnitBufPtr = bufPtr;
+				whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
+
+				// Pre-whitening
+				for (block = startBlock; block < endBlock; block++)
+				{
+					*bufPtr++ = *sourcePtr++ ^ *whiteningValuesPtr64--;
+					*bufPtr++ = *sourcePtr++ ^ *whiteningValuesPtr64--;
+				}
+
+				if (Decryption)
+					CipherImpl::DecryptBlocks (ks, (byte *) dataUnitBufPtr, endBlock - startBlock);
+				else
+					CipherImpl::EncryptBlocks (ks, (byte *) dataUnitBufPtr, endBlock - startBlock);
+
+				bufPtr = dataUnitBufPtr;
+				whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
+
+				// Post-whitening
+				for (block = startBlock; block < endBlock; block++)
+				{
+					*bufPtr++ ^= *whiteningValuesPtr64--;
+					*bufPtr++ ^= *whiteningValuesPtr64--;
+				}
+
+				blockCount -= endBlock - startBlock;
+				startBlock = 0;
+				dataUnitNo++;
+			}
+
+			FAST_ERASE64 (whiteningValue, sizeof (whiteningValue));
+			FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
+			FAST_ERASE64 (encryptedDataUnitNos, sizeof (encryptedDataUnitNos));
+		}
+	};
+
+	// Block functions of the ciphers supported by XtsEngine
+
+	struct XtsCipherAES
+	{
+		static void DecryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			const aes_decrypt_ctx *decryptionKey = (const aes_decrypt_ctx *) (ks + sizeof (aes_encrypt_ctx));
+
+			for (; blockCount > 0; --blockCount, data += BYTES_PER_XTS_BLOCK)
+				aes_decrypt (data, data, decryptionKey);
+		}
+
+		static void EncryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			for (; blockCount > 0; --blockCount, data += BYTES_PER_XTS_BLOCK)
+				aes_encrypt (data, data, (const aes_encrypt_ctx *) ks);
+		}
+	};
+
+	// ks is the key schedule of CipherAES, which appends the bitsliced key schedule to the table-based ones.
+	// The caller must ensure that aes_bitsliced_supported() returns nonzero.
+	struct XtsCipherAESBitsliced
+	{
+		static const aes_bitsliced_ctx *GetContext (const byte *ks)
+		{
+			return (const aes_bitsliced_ctx *) (ks + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx));
+		}
+
+		static void DecryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			aes_bitsliced_decrypt_blocks (GetContext (ks), data, data, blockCount);
+		}
+
+		static void EncryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			aes_bitsliced_encrypt_blocks (GetContext (ks), data, data, blockCount);
+		}
+	};
+
+	struct XtsCipherSerpent
+	{
+		static void DecryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			serpent_decrypt_blocks (data, data, blockCount, const_cast <byte *> (ks));
+		}
+
+		static void EncryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			serpent_encrypt_blocks (data, data, blockCount, const_cast <byte *> (ks));
+		}
+	};
+
+	struct XtsCipherTwofish
+	{
+		static void DecryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			twofish_decrypt_blocks ((TwofishInstance *) ks, data, data, blockCount);
+		}
+
+		static void EncryptBlocks (const byte *ks, byte *data, size_t blockCount)
+		{
+			twofish_encrypt_blocks ((TwofishInstance *) ks, data, data, blockCount);
+		}
+	};
+}
+
+#endif // TC_HEADER_Common_XtsEngine
@@ -10,6 +10,7 @@
 
 #include "CoreBase.h"
 #include "RandomNumberGenerator.h"
+#include "../Volume/EncryptionThreadPool.h"
 #include "../Volume/Volume.h"
 
 namespace CipherShed
@@ -41,30 +42,45 @@ namespace CipherShed
 		RandomNumberGenerator::SetHash (newPkcs5Kdf->GetHash());
 
 		SecureBuffer newSalt (openVolume->GetSaltSize());
-		SecureBuffer newHeaderKey (VolumeHeader::GetLargestSerializedKeySize());
-
 		shared_ptr <VolumePassword> password (Keyfile::ApplyListToPassword (newKeyfiles, newPassword));
 
-		bool backupHeader = false;
-		while (true)
+		// Header keys for the wipe passes of both headers are derived concurrently by the encryption thread pool,
+		// while the headers are written in the original order as their keys become available. The number of pending
+		// derivations is limited so that the pool remains available to the I/O of mounted volumes.
+		int passCount = SecureWipePassCount * (openVolume->GetLayout()->HasBackupHeader() ? 2 : 1);
+		size_t maxPendingDerivations = max (EncryptionThreadPool::GetThreadCount() * 2, (size_t) 1);
+
+		typedef list < shared_ptr <EncryptionThreadPool::KeyDerivation> > KeyDerivationList;
+		KeyDerivationList keyDerivations;
+
+		finally_do_arg (KeyDerivationList *, &keyDerivations,
+		{
+			foreach (shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation, *finally_arg)
+				keyDerivation->Abort();
+		});
+
+		int derivationCount = 0;
+		for (int pass = 0; pass < passCount; pass++)
 		{
-			for (int i = 1; i <= SecureWipePassCount; i++)
+			while (derivationCount < passCount && keyDerivations.size() < maxPendingDerivations)
 			{
-				if (i == SecureWipePassCount)
+				if (++derivationCount % SecureWipePassCount == 0)
 					RandomNumberGenerator::GetData (newSalt);
 				else
 					RandomNumberGenerator::GetDataFast (newSalt);
 
-				newPkcs5Kdf->DeriveKey (newHeaderKey, *password, newSalt);
+				shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation (
+					new EncryptionThreadPool::KeyDerivation (newPkcs5Kdf, *password, newSalt, VolumeHeader::GetLargestSerializedKeySize()));
 
-				openVolume->ReEncryptHeader (backupHeader, newSalt, newHeaderKey, newPkcs5Kdf);
-				openVolume->GetFile()->Flush();
+				keyDerivations.push_back (keyDerivation);
+				EncryptionThreadPool::BeginKeyDerivation (keyDerivation);
 			}
 
-			if (!openVolume->GetLayout()->HasBackupHeader() || backupHeader)
-				break;
+			shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation = keyDerivations.front();
+			keyDerivations.pop_front();
 
-			backupHeader = true;
+			openVolume->ReEncryptHeader (pass >= SecureWipePassCount, keyDerivation->GetSalt(), keyDerivation->WaitForKey(), newPkcs5Kdf);
+			openVolume->GetFile()->Flush();
 		}
 	}
 		
@@ -242,6 +258,33 @@ namespace CipherShed
 		return GetMountedVolume (volumePath);
 	}
 
+	VolumeMountResultList CoreBase::MountVolumes (const MountOptionsList &optionsList, size_t jobCount)
+	{
+		VolumeMountResultList results;
+
+		foreach (shared_ptr <MountOptions> options, optionsList)
+		{
+			VolumeMountResult result;
+
+			try
+			{
+				// A slot number specified by the options is the first slot considered for the volume
+				if (IsSlotNumberValid (options->SlotNumber) && !IsSlotNumberAvailable (options->SlotNumber))
+					options->SlotNumber = GetFirstFreeSlotNumber (options->SlotNumber);
+
+				result.MountedVolume = MountVolume (*options);
+			}
+			catch (Exception &e)
+			{
+				result.Error.reset (e.CloneNew());
+			}
+
+			results.push_back (result);
+		}
+
+		return results;
+	}
+
 	shared_ptr <Volume> CoreBase::OpenVolume (shared_ptr <VolumePath> volumePath, bool preserveTimestamps, shared_ptr <VolumePassword> password, shared_ptr <KeyfileList> keyfiles, VolumeProtection::Enum protection, shared_ptr <VolumePassword> protectionPassword, shared_ptr <KeyfileList> protectionKeyfiles, bool sharedAccessAllowed, VolumeType::Enum volumeType, bool useBackupHeaders, bool partitionInSystemEncryptionScope) const
 	{
 		make_shared_auto (Volume, volume);
@@ -21,6 +21,7 @@ namespace CipherShed
 		TC_CLONE (CachePassword);
 		TC_CLONE (FilesystemOptions);
 		TC_CLONE (FilesystemType);
+		TC_CLONE (HeaderKeyCacheTimeToLive);
 		TC_CLONE_SHARED (KeyfileList, Keyfiles);
 		TC_CLONE_SHARED (DirectoryPath, MountPoint);
 		TC_CLONE (NoFilesystem);
@@ -33,6 +34,7 @@ namespace CipherShed
 		TC_CLONE (Protection);
 		TC_CLONE_SHARED (VolumePassword, ProtectionPassword);
 		TC_CLONE_SHARED (KeyfileList, ProtectionKeyfiles);
+		TC_CLONE (ReadCacheSize);
 		TC_CLONE (Removable);
 		TC_CLONE (SharedAccessAllowed);
 		TC_CLONE (SlotNumber);
@@ -46,6 +48,7 @@ namespace CipherShed
 		sr.Deserialize ("CachePassword", CachePassword);
 		sr.Deserialize ("FilesystemOptions", FilesystemOptions);
 		sr.Deserialize ("FilesystemType", FilesystemType);
+		sr.Deserialize ("HeaderKeyCacheTimeToLive", HeaderKeyCacheTimeToLive);
 
 		Keyfiles = Keyfile::DeserializeList (stream, "Keyfiles");
 
@@ -79,6 +82,7 @@ namespace CipherShed
 			ProtectionPassword.reset();
 
 		ProtectionKeyfiles = Keyfile::DeserializeList (stream, "ProtectionKeyfiles");
+		sr.Deserialize ("ReadCacheSize", ReadCacheSize);
 		sr.Deserialize ("Removable", Removable);
 		sr.Deserialize ("SharedAccessAllowed", SharedAccessAllowed);
 		sr.Deserialize ("SlotNumber", SlotNumber);
@@ -93,6 +97,7 @@ namespace CipherShed
 		sr.Serialize ("CachePassword", CachePassword);
 		sr.Serialize ("FilesystemOptions", FilesystemOptions);
 		sr.Serialize ("FilesystemType", FilesystemType);
+		sr.Serialize ("HeaderKeyCacheTimeToLive", HeaderKeyCacheTimeToLive);
 		Keyfile::SerializeList (stream, "Keyfiles", Keyfiles);
 
 		sr.Serialize ("MountPointNull", MountPoint == nullptr);
@@ -120,6 +125,7 @@ namespace CipherShed
 			ProtectionPassword->Serialize (stream);
 
 		Keyfile::SerializeList (stream, "ProtectionKeyfiles", ProtectionKeyfiles);
+		sr.Serialize ("ReadCacheSize", ReadCacheSize);
 		sr.Serialize ("Removable", Removable);
 		sr.Serialize ("SharedAccessAllowed", SharedAccessAllowed);
 		sr.Serialize ("SlotNumber", SlotNumber);
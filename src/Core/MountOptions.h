@@ -22,12 +22,14 @@ namespace CipherShed
 		MountOptions ()
 			:
 			CachePassword (false),
+			HeaderKeyCacheTimeToLive (0),
 			NoFilesystem (false),
 			NoHardwareCrypto (false),
 			NoKernelCrypto (false),
 			PartitionInSystemEncryptionScope (false),
 			PreserveTimestamps (true),
 			Protection (VolumeProtection::None),
+			ReadCacheSize (0),
 			Removable (false),
 			SharedAccessAllowed (false),
 			SlotNumber (0),
@@ -45,6 +47,7 @@ namespace CipherShed
 		bool CachePassword;
 		wstring FilesystemOptions;
 		wstring FilesystemType;
+		uint64 HeaderKeyCacheTimeToLive;
 		shared_ptr <KeyfileList> Keyfiles;
 		shared_ptr <DirectoryPath> MountPoint;
 		bool NoFilesystem;
@@ -57,6 +60,7 @@ namespace CipherShed
 		VolumeProtection::Enum Protection;
 		shared_ptr <VolumePassword> ProtectionPassword;
 		shared_ptr <KeyfileList> ProtectionKeyfiles;
+		uint64 ReadCacheSize;
 		bool Removable;
 		bool SharedAccessAllowed;
 		VolumeSlotNumber SlotNumber;
@@ -65,6 +69,8 @@ namespace CipherShed
 	protected:
 		void CopyFrom (const MountOptions &other);
 	};
+
+	typedef list < shared_ptr <MountOptions> > MountOptionsList;
 }
 
 #endif // TC_HEADER_Core_MountOptions
@@ -15,6 +15,8 @@
 #include "../../Platform/SystemLog.h"
 #include "../../Platform/Thread.h"
 #include "../../Platform/Unix/Poller.h"
+#include "../../Volume/EncryptionThreadPool.h"
+#include "../../Volume/VolumeHeaderKeyCache.h"
 #include "../Core.h"
 #include "CoreUnix.h"
 #include "CoreServiceRequest.h"
@@ -89,6 +91,10 @@ namespace CipherShed
 		{
 			Core = CoreDirect;
 
+			// Header key derivations and volume opening performed by the service use the encryption thread pool
+			EncryptionThreadPool::Start();
+			finally_do ({ EncryptionThreadPool::Stop(); });
+
 			shared_ptr <Stream> inputStream (new FileStream (inputFD != -1 ? inputFD : InputPipe->GetReadFD()));
 			shared_ptr <Stream> outputStream (new FileStream (outputFD != -1 ? outputFD : OutputPipe->GetWriteFD()));
 
@@ -192,6 +198,17 @@ namespace CipherShed
 						continue;
 					}
 
+					// MountVolumesRequest
+					MountVolumesRequest *mountVolumesRequest = dynamic_cast <MountVolumesRequest*> (request.get());
+					if (mountVolumesRequest)
+					{
+						MountVolumesResponse (
+							Core->MountVolumes (mountVolumesRequest->OptionsList, (size_t) mountVolumesRequest->JobCount)
+						).Serialize (outputStream);
+
+						continue;
+					}
+
 					// SetFileOwnerRequest
 					SetFileOwnerRequest *setFileOwnerRequest = dynamic_cast <SetFileOwnerRequest*> (request.get());
 					if (setFileOwnerRequest)
@@ -205,6 +222,22 @@ namespace CipherShed
 						continue;
 					}
 
+					// WipeHeaderKeyCacheRequest
+					if (dynamic_cast <WipeHeaderKeyCacheRequest*> (request.get()) != nullptr)
+					{
+						VolumeHeaderKeyCache::Clear();
+
+						// Volumes mounted with elevated privileges cached their header keys in the elevated service
+						if (ElevatedServiceAvailable)
+						{
+							request->Serialize (ServiceInputStream);
+							GetResponse <Serializable>();
+						}
+
+						WipeHeaderKeyCacheResponse().Serialize (outputStream);
+						continue;
+					}
+
 					throw ParameterIncorrect (SRC_POS);
 				}
 				catch (Exception &e)
@@ -268,12 +301,24 @@ namespace CipherShed
 		return SendRequest <MountVolumeResponse> (request)->MountedVolumeInfo;
 	}
 
+	VolumeMountResultList CoreService::RequestMountVolumes (const MountOptionsList &optionsList, size_t jobCount)
+	{
+		MountVolumesRequest request (optionsList, jobCount);
+		return SendRequest <MountVolumesResponse> (request)->Results;
+	}
+
 	void CoreService::RequestSetFileOwner (const FilesystemPath &path, const UserId &owner)
 	{
 		SetFileOwnerRequest request (path, owner);
 		SendRequest <SetFileOwnerResponse> (request);
 	}
 
+	void CoreService::RequestWipeHeaderKeyCache ()
+	{
+		WipeHeaderKeyCacheRequest request;
+		SendRequest <WipeHeaderKeyCacheResponse> (request);
+	}
+
 	template <class T>
 	std::auto_ptr <T> CoreService::SendRequest (CoreServiceRequest &request)
 	{
@@ -31,7 +31,9 @@ namespace CipherShed
 		static uint64 RequestGetDeviceSize (const DevicePath &devicePath);
 		static HostDeviceList RequestGetHostDevices (bool pathListOnly);
 		static shared_ptr <VolumeInfo> RequestMountVolume (MountOptions &options);
+		static VolumeMountResultList RequestMountVolumes (const MountOptionsList &optionsList, size_t jobCount);
 		static void RequestSetFileOwner (const FilesystemPath &path, const UserId &owner);
+		static void RequestWipeHeaderKeyCache ();
 		static void SetAdminPasswordCallback (shared_ptr <GetStringFunctor> functor) { AdminPasswordCallback = functor; }
 		static void Start ();
 		static void Stop ();
@@ -18,7 +18,7 @@ namespace CipherShed
 	class CoreServiceProxy : public T
 	{
 	public:
-		CoreServiceProxy () { }
+		CoreServiceProxy () : HeaderKeysCached (false) { }
 		virtual ~CoreServiceProxy () { }
 
 		virtual void CheckFilesystem (shared_ptr <VolumeInfo> mountedVolume, bool repair) const
@@ -60,12 +60,16 @@ namespace CipherShed
 				return CoreService::RequestGetHostDevices (pathListOnly);
 		}
 #endif
-		virtual bool IsPasswordCacheEmpty () const { return VolumePasswordCache::IsEmpty(); }
+		virtual bool IsPasswordCacheEmpty () const { return VolumePasswordCache::IsEmpty() && !HeaderKeysCached; }
 
 		virtual shared_ptr <VolumeInfo> MountVolume (MountOptions &options)
 		{
 			shared_ptr <VolumeInfo> mountedVolume;
 
+			// Header keys are cached by the service even if mounting fails
+			if (options.HeaderKeyCacheTimeToLive != 0)
+				HeaderKeysCached = true;
+
 			if (!VolumePasswordCache::IsEmpty()
 				&& (!options.Password || options.Password->IsEmpty())
 				&& (!options.Keyfiles || options.Keyfiles->empty()))
@@ -132,6 +136,104 @@ namespace CipherShed
 			return mountedVolume;
 		}
 
+		virtual VolumeMountResultList MountVolumes (const MountOptionsList &optionsList, size_t jobCount = 0)
+		{
+			bool useCachedPasswords = !VolumePasswordCache::IsEmpty();
+			MountOptionsList newOptionsList;
+
+			foreach (shared_ptr <MountOptions> options, optionsList)
+			{
+				// Header keys are cached by the service even if mounting fails
+				if (options->HeaderKeyCacheTimeToLive != 0)
+					HeaderKeysCached = true;
+
+				if ((options->Password && !options->Password->IsEmpty()) || (options->Keyfiles && !options->Keyfiles->empty()))
+					useCachedPasswords = false;
+
+				newOptionsList.push_back (ApplyKeyfiles (*options, optionsList, newOptionsList));
+			}
+
+			VolumeMountResultList results;
+
+			if (!useCachedPasswords)
+			{
+				results = CoreService::RequestMountVolumes (newOptionsList, jobCount);
+			}
+			else
+			{
+				foreach (shared_ptr <MountOptions> options, newOptionsList)
+				{
+					VolumeMountResult result;
+					result.Error.reset (new PasswordIncorrect (SRC_POS));
+					results.push_back (result);
+				}
+
+				foreach (shared_ptr <VolumePassword> password, VolumePasswordCache::GetPasswords())
+				{
+					// Volumes not mounted with any of the previous passwords are retried with the next one
+					MountOptionsList retryOptionsList;
+					list <VolumeMountResult *> retryResults;
+
+					MountOptionsList::const_iterator options = newOptionsList.begin();
+					for (VolumeMountResultList::iterator result = results.begin(); result != results.end(); ++result, ++options)
+					{
+						if (result->Error && dynamic_cast <PasswordIncorrect *> (result->Error.get()))
+						{
+							shared_ptr <MountOptions> retryOptions (new MountOptions (**options));
+							retryOptions->Password = password;
+
+							retryOptionsList.push_back (retryOptions);
+							retryResults.push_back (&*result);
+						}
+					}
+
+					if (retryOptionsList.empty())
+						break;
+
+					VolumeMountResultList retryMountResults = CoreService::RequestMountVolumes (retryOptionsList, jobCount);
+
+					list <VolumeMountResult *>::iterator result = retryResults.begin();
+					foreach (const VolumeMountResult &retryResult, retryMountResults)
+					{
+						if (retryResult.MountedVolume || !dynamic_cast <PasswordIncorrect *> (retryResult.Error.get()))
+							**result = retryResult;
+						++result;
+					}
+				}
+			}
+
+			MountOptionsList::const_iterator options = optionsList.begin();
+			MountOptionsList::const_iterator newOptions = newOptionsList.begin();
+			for (VolumeMountResultList::iterator result = results.begin(); result != results.end(); ++result, ++options, ++newOptions)
+			{
+				const MountOptions &mountOptions = **options;
+
+				if (result->MountedVolume)
+				{
+					if (mountOptions.CachePassword
+						&& ((mountOptions.Password && !mountOptions.Password->IsEmpty()) || (mountOptions.Keyfiles && !mountOptions.Keyfiles->empty())))
+					{
+						VolumePasswordCache::Store (*(*newOptions)->Password);
+					}
+
+					VolumeEventArgs eventArgs (result->MountedVolume);
+					T::VolumeMountedEvent.Raise (eventArgs);
+				}
+				else if (dynamic_cast <ProtectionPasswordIncorrect *> (result->Error.get()))
+				{
+					if (mountOptions.ProtectionKeyfiles && !mountOptions.ProtectionKeyfiles->empty())
+						result->Error.reset (new ProtectionPasswordKeyfilesIncorrect (result->Error->what()));
+				}
+				else if (dynamic_cast <PasswordIncorrect *> (result->Error.get()))
+				{
+					if (mountOptions.Keyfiles && !mountOptions.Keyfiles->empty())
+						result->Error.reset (new PasswordKeyfilesIncorrect (result->Error->what()));
+				}
+			}
+
+			return results;
+		}
+
 		virtual void SetAdminPasswordCallback (shared_ptr <GetStringFunctor> functor)
 		{
 			CoreService::SetAdminPasswordCallback (functor);
@@ -145,7 +247,66 @@ namespace CipherShed
 		virtual void WipePasswordCache () const
 		{
 			VolumePasswordCache::Clear();
+
+			if (HeaderKeysCached)
+			{
+				CoreService::RequestWipeHeaderKeyCache();
+				HeaderKeysCached = false;
+			}
 		}
+
+	protected:
+		shared_ptr <MountOptions> ApplyKeyfiles (const MountOptions &options, const MountOptionsList &optionsList, const MountOptionsList &appliedOptionsList) const
+		{
+			shared_ptr <MountOptions> newOptions (new MountOptions (options));
+
+			// Volumes mounted together usually share the password and keyfiles, which are then processed only once
+			newOptions->Password.reset();
+			newOptions->ProtectionPassword.reset();
+
+			MountOptionsList::const_iterator sourceOptions = optionsList.begin();
+			foreach (shared_ptr <MountOptions> appliedOptions, appliedOptionsList)
+			{
+				if (IsSameKeyfileSource ((*sourceOptions)->Keyfiles, (*sourceOptions)->Password, options.Keyfiles, options.Password))
+					newOptions->Password = appliedOptions->Password;
+
+				if (IsSameKeyfileSource ((*sourceOptions)->ProtectionKeyfiles, (*sourceOptions)->ProtectionPassword, options.ProtectionKeyfiles, options.ProtectionPassword))
+					newOptions->ProtectionPassword = appliedOptions->ProtectionPassword;
+
+				++sourceOptions;
+			}
+
+			if (!newOptions->Password)
+				newOptions->Password = Keyfile::ApplyListToPassword (options.Keyfiles, options.Password);
+
+			if (!newOptions->ProtectionPassword)
+				newOptions->ProtectionPassword = Keyfile::ApplyListToPassword (options.ProtectionKeyfiles, options.ProtectionPassword);
+
+			if (newOptions->Keyfiles)
+				newOptions->Keyfiles.reset (new KeyfileList);
+
+			if (newOptions->ProtectionKeyfiles)
+				newOptions->ProtectionKeyfiles.reset (new KeyfileList);
+
+			return newOptions;
+		}
+
+		static bool IsSameKeyfileSource (shared_ptr <KeyfileList> keyfiles1, shared_ptr <VolumePassword> password1, shared_ptr <KeyfileList> keyfiles2, shared_ptr <VolumePassword> password2)
+		{
+			// Copies of mount options share the keyfile objects but not the passwords
+			bool noKeyfiles1 = !keyfiles1 || keyfiles1->empty();
+			bool noKeyfiles2 = !keyfiles2 || keyfiles2->empty();
+
+			if (noKeyfiles1 != noKeyfiles2 || (!noKeyfiles1 && *keyfiles1 != *keyfiles2))
+				return false;
+
+			bool noPassword1 = !password1 || password1->IsEmpty();
+			bool noPassword2 = !password2 || password2->IsEmpty();
+
+			return noPassword1 == noPassword2 && (noPassword1 || *password1 == *password2);
+		}
+
+		mutable bool HeaderKeysCached;
 	};
 }
 
@@ -227,6 +227,34 @@ namespace CipherShed
 		Options->Serialize (stream);
 	}
 	
+	// MountVolumesRequest
+	void MountVolumesRequest::Deserialize (shared_ptr <Stream> stream)
+	{
+		CoreServiceRequest::Deserialize (stream);
+		Serializer sr (stream);
+		sr.Deserialize ("JobCount", JobCount);
+		Serializable::DeserializeList (stream, OptionsList);
+	}
+
+	bool MountVolumesRequest::RequiresElevation () const
+	{
+		foreach (shared_ptr <MountOptions> options, OptionsList)
+		{
+			if (MountVolumeRequest (options.get()).RequiresElevation())
+				return true;
+		}
+
+		return false;
+	}
+
+	void MountVolumesRequest::Serialize (shared_ptr <Stream> stream) const
+	{
+		CoreServiceRequest::Serialize (stream);
+		Serializer sr (stream);
+		sr.Serialize ("JobCount", JobCount);
+		Serializable::SerializeList (stream, OptionsList);
+	}
+
 	// SetFileOwnerRequest
 	void SetFileOwnerRequest::Deserialize (shared_ptr <Stream> stream)
 	{
@@ -256,6 +284,16 @@ namespace CipherShed
 		sr.Serialize ("Path", wstring (Path));
 	}
 
+	// WipeHeaderKeyCacheRequest
+	void WipeHeaderKeyCacheRequest::Deserialize (shared_ptr <Stream> stream)
+	{
+		CoreServiceRequest::Deserialize (stream);
+	}
+
+	void WipeHeaderKeyCacheRequest::Serialize (shared_ptr <Stream> stream) const
+	{
+		CoreServiceRequest::Serialize (stream);
+	}
 
 	TC_SERIALIZER_FACTORY_ADD_CLASS (CoreServiceRequest);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (CheckFilesystemRequest);
@@ -266,5 +304,7 @@ namespace CipherShed
 	TC_SERIALIZER_FACTORY_ADD_CLASS (GetDeviceSizeRequest);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (GetHostDevicesRequest);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (MountVolumeRequest);
+	TC_SERIALIZER_FACTORY_ADD_CLASS (MountVolumesRequest);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (SetFileOwnerRequest);
+	TC_SERIALIZER_FACTORY_ADD_CLASS (WipeHeaderKeyCacheRequest);
 }
@@ -119,6 +119,18 @@ namespace CipherShed
 		shared_ptr <MountOptions> DeserializedOptions;
 	};
 
+	struct MountVolumesRequest : CoreServiceRequest
+	{
+		MountVolumesRequest () : JobCount (0) { }
+		MountVolumesRequest (const MountOptionsList &optionsList, size_t jobCount) : JobCount (jobCount), OptionsList (optionsList) { }
+		TC_SERIALIZABLE (MountVolumesRequest);
+
+		virtual bool RequiresElevation () const;
+
+		uint64 JobCount;
+		MountOptionsList OptionsList;
+	};
+
 
 	struct SetFileOwnerRequest : CoreServiceRequest
 	{
@@ -131,6 +143,12 @@ namespace CipherShed
 		UserId Owner;
 		FilesystemPath Path;
 	};
+
+	struct WipeHeaderKeyCacheRequest : CoreServiceRequest
+	{
+		WipeHeaderKeyCacheRequest () { }
+		TC_SERIALIZABLE (WipeHeaderKeyCacheRequest);
+	};
 }
 
 #endif // TC_HEADER_Core_Unix_CoreServiceRequest
@@ -99,6 +99,45 @@ namespace CipherShed
 		MountedVolumeInfo->Serialize (stream);
 	}
 
+	// MountVolumesResponse
+	void MountVolumesResponse::Deserialize (shared_ptr <Stream> stream)
+	{
+		Serializer sr (stream);
+
+		uint64 resultCount;
+		sr.Deserialize ("ResultCount", resultCount);
+
+		Results.clear();
+		for (uint64 i = 0; i < resultCount; ++i)
+		{
+			VolumeMountResult result;
+
+			if (sr.DeserializeBool ("Mounted"))
+				result.MountedVolume = Serializable::DeserializeNew <VolumeInfo> (stream);
+			else
+				result.Error = Serializable::DeserializeNew <Exception> (stream);
+
+			Results.push_back (result);
+		}
+	}
+
+	void MountVolumesResponse::Serialize (shared_ptr <Stream> stream) const
+	{
+		Serializable::Serialize (stream);
+		Serializer sr (stream);
+
+		sr.Serialize ("ResultCount", (uint64) Results.size());
+		foreach (VolumeMountResult result, Results)
+		{
+			sr.Serialize ("Mounted", result.MountedVolume != nullptr);
+
+			if (result.MountedVolume)
+				result.MountedVolume->Serialize (stream);
+			else
+				result.Error->Serialize (stream);
+		}
+	}
+
 	// SetFileOwnerResponse
 	void SetFileOwnerResponse::Deserialize (shared_ptr <Stream> stream)
 	{
@@ -109,6 +148,16 @@ namespace CipherShed
 		Serializable::Serialize (stream);
 	}
 
+	// WipeHeaderKeyCacheResponse
+	void WipeHeaderKeyCacheResponse::Deserialize (shared_ptr <Stream> stream)
+	{
+	}
+
+	void WipeHeaderKeyCacheResponse::Serialize (shared_ptr <Stream> stream) const
+	{
+		Serializable::Serialize (stream);
+	}
+
 	TC_SERIALIZER_FACTORY_ADD_CLASS (CheckFilesystemResponse);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (DismountFilesystemResponse);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (DismountVolumeResponse);
@@ -116,5 +165,7 @@ namespace CipherShed
 	TC_SERIALIZER_FACTORY_ADD_CLASS (GetDeviceSizeResponse);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (GetHostDevicesResponse);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (MountVolumeResponse);
+	TC_SERIALIZER_FACTORY_ADD_CLASS (MountVolumesResponse);
 	TC_SERIALIZER_FACTORY_ADD_CLASS (SetFileOwnerResponse);
+	TC_SERIALIZER_FACTORY_ADD_CLASS (WipeHeaderKeyCacheResponse);
 }
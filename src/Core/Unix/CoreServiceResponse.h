@@ -74,11 +74,26 @@ namespace CipherShed
 		shared_ptr <VolumeInfo> MountedVolumeInfo;
 	};
 
+	struct MountVolumesResponse : CoreServiceResponse
+	{
+		MountVolumesResponse () { }
+		MountVolumesResponse (const VolumeMountResultList &results) : Results (results) { }
+		TC_SERIALIZABLE (MountVolumesResponse);
+
+		VolumeMountResultList Results;
+	};
+
 	struct SetFileOwnerResponse : CoreServiceResponse
 	{
 		SetFileOwnerResponse () { }
 		TC_SERIALIZABLE (SetFileOwnerResponse);
 	};
+
+	struct WipeHeaderKeyCacheResponse : CoreServiceResponse
+	{
+		WipeHeaderKeyCacheResponse () { }
+		TC_SERIALIZABLE (WipeHeaderKeyCacheResponse);
+	};
 }
 
 #endif // TC_HEADER_Core_Unix_CoreServiceResponse
@@ -8,19 +8,25 @@
 
 #include "CoreUnix.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <iostream>
+#include <poll.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
 #include "../../Platform/FileStream.h"
+#include "../../Platform/MemoryStream.h"
 #include "../../Driver/Fuse/FuseService.h"
+#include "../../Platform/SystemInfo.h"
+#include "../../Volume/VolumeHeaderKeyCache.h"
 #include "../../Volume/VolumePasswordCache.h"
 
 namespace CipherShed
 {
-	CoreUnix::CoreUnix ()
+	CoreUnix::CoreUnix () : MountTableFd (-1), MountTableFdProcessId (0)
 	{
 		signal (SIGPIPE, SIG_IGN);
 		
@@ -31,6 +37,8 @@ namespace CipherShed
 
 	CoreUnix::~CoreUnix ()
 	{
+		if (MountTableFd != -1 && MountTableFdProcessId == getpid())
+			close (MountTableFd);
 	}
 	
 	void CoreUnix::CheckFilesystem (shared_ptr <VolumeInfo> mountedVolume, bool repair) const
@@ -101,6 +109,7 @@ namespace CipherShed
 				DetachLoopDevice (mountedVolume->LoopDevice);
 			}
 			catch (ExecutedProcessFailed&) { }
+			catch (SystemException&) { }
 		}
 
 		if (syncVolumeInfo || mountedVolume->Protection == VolumeProtection::HiddenVolumeReadOnly)
@@ -250,8 +259,24 @@ namespace CipherShed
 	VolumeInfoList CoreUnix::GetMountedVolumes (const VolumePath &volumePath) const
 	{
 		VolumeInfoList volumes;
+		ScopeLock lock (MountedVolumeInfoCacheMutex);
 
-		foreach_ref (const MountedFilesystem &mf, GetMountedFilesystems ())
+		if (IsMountedFilesystemListChanged())
+		{
+			MountedFilesystemCache = GetMountedFilesystems ();
+
+			// Information of dismounted volumes is discarded
+			map <string, CachedVolumeInfo> volumeInfoCache;
+			foreach_ref (const MountedFilesystem &mf, MountedFilesystemCache)
+			{
+				map <string, CachedVolumeInfo>::const_iterator cachedInfo = MountedVolumeInfoCache.find (string (mf.MountPoint));
+				if (cachedInfo != MountedVolumeInfoCache.end())
+					volumeInfoCache.insert (*cachedInfo);
+			}
+			MountedVolumeInfoCache.swap (volumeInfoCache);
+		}
+
+		foreach_ref (const MountedFilesystem &mf, MountedFilesystemCache)
 		{
 			if (string (mf.MountPoint).find (GetFuseMountDirPrefix()) == string::npos)
 				continue;
@@ -259,11 +284,7 @@ namespace CipherShed
 			shared_ptr <VolumeInfo> mountedVol;
 			try
 			{
-				shared_ptr <File> controlFile (new File);
-				controlFile->Open (string (mf.MountPoint) + FuseService::GetControlPath());
-
-				shared_ptr <Stream> controlFileStream (new FileStream (controlFile));
-				mountedVol = Serializable::DeserializeNew <VolumeInfo> (controlFileStream);
+				mountedVol = ReadMountedVolumeInfo (mf.MountPoint, volumePath);
 			}
 			catch (...)
 			{
@@ -277,10 +298,23 @@ namespace CipherShed
 
 			if (!mountedVol->VirtualDevice.IsEmpty())
 			{
-				MountedFilesystemList mpl = GetMountedFilesystems (mountedVol->VirtualDevice);
+				DevicePath realDevicePath = mountedVol->VirtualDevice;
+
+				char *resolvedPath = realpath (string (mountedVol->VirtualDevice).c_str(), NULL);
+				if (resolvedPath)
+				{
+					realDevicePath = resolvedPath;
+					free (resolvedPath);
+				}
 
-				if (mpl.size() > 0)
-					mountedVol->MountPoint = mpl.front()->MountPoint;
+				foreach_ref (const MountedFilesystem &deviceFs, MountedFilesystemCache)
+				{
+					if (deviceFs.Device == mountedVol->VirtualDevice || deviceFs.Device == realDevicePath)
+					{
+						mountedVol->MountPoint = deviceFs.MountPoint;
+						break;
+					}
+				}
 			}
 
 			volumes.push_back (mountedVol);
@@ -330,6 +364,32 @@ namespace CipherShed
 		return envDir ? envDir : "/tmp";
 	}
 
+	bool CoreUnix::IsMountedFilesystemListChanged () const
+	{
+		// A descriptor inherited by a forked process would share the change notifications with the parent process
+		if (MountTableFd != -1 && MountTableFdProcessId != getpid())
+		{
+			close (MountTableFd);
+			MountTableFd = -1;
+		}
+
+		if (MountTableFd == -1)
+		{
+			// The kernel notifies pollers of mountinfo of mount table changes. Where it is not available,
+			// the mount table is read by every query.
+			MountTableFd = open ("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+			MountTableFdProcessId = getpid();
+			return true;
+		}
+
+		struct pollfd pollData;
+		pollData.fd = MountTableFd;
+		pollData.events = POLLPRI;
+		pollData.revents = 0;
+
+		return poll (&pollData, 1, 0) != 0;
+	}
+
 	bool CoreUnix::IsMountPointAvailable (const DirectoryPath &mountPoint) const
 	{
 		return GetMountedFilesystems (DevicePath(), mountPoint).size() == 0;
@@ -399,44 +459,121 @@ namespace CipherShed
 
 		Cipher::EnableHwSupport (!options.NoHardwareCrypto);
 
-		shared_ptr <Volume> volume;
+		if (options.HeaderKeyCacheTimeToLive != 0)
+			VolumeHeaderKeyCache::Enable (options.HeaderKeyCacheTimeToLive);
 
-		while (true)
+		return MountOpenedVolume (OpenVolumeToMount (options), options);
+	}
+
+	VolumeMountResultList CoreUnix::MountVolumes (const MountOptionsList &optionsList, size_t jobCount)
+	{
+		// Opening a volume is dominated by the derivation of header keys. The volumes are therefore opened concurrently
+		// by up to jobCount threads, and then mounted one at a time in the order of the list. Slot numbers and mount
+		// points are thus assigned as if the volumes were mounted by MountVolume() one after another.
+		MountVolumesState state;
+		state.NextIndex = 0;
+
+		// Hardware acceleration is enabled for the whole process, so all volumes must be mounted with the same setting
+		foreach (shared_ptr <MountOptions> options, optionsList)
 		{
+			if (options->NoHardwareCrypto != optionsList.front()->NoHardwareCrypto)
+				throw ParameterIncorrect (SRC_POS);
+		}
+
+		if (!optionsList.empty())
+			Cipher::EnableHwSupport (!optionsList.front()->NoHardwareCrypto);
+
+		foreach (shared_ptr <MountOptions> options, optionsList)
+		{
+			state.Options.push_back (options.get());
+			state.Volumes.push_back (shared_ptr <Volume> ());
+			state.Results.push_back (VolumeMountResult());
+
 			try
 			{
-				volume = OpenVolume (
-					options.Path,
-					options.PreserveTimestamps,
-					options.Password,
-					options.Keyfiles,
-					options.Protection,
-					options.ProtectionPassword,
-					options.ProtectionKeyfiles,
-					options.SharedAccessAllowed,
-					VolumeType::Unknown,
-					options.UseBackupHeaders,
-					options.PartitionInSystemEncryptionScope
-					);
+				if (IsVolumeMounted (*options->Path))
+					throw VolumeAlreadyMounted (SRC_POS);
 
-				options.Password.reset();
+				if (options->HeaderKeyCacheTimeToLive != 0)
+					VolumeHeaderKeyCache::Enable (options->HeaderKeyCacheTimeToLive);
 			}
-			catch (SystemException &e)
+			catch (Exception &e)
 			{
-				if (options.Protection != VolumeProtection::ReadOnly
-					&& (e.GetErrorCode() == EROFS || e.GetErrorCode() == EACCES || e.GetErrorCode() == EPERM))
+				state.Results.back().Error.reset (e.CloneNew());
+			}
+		}
+
+		// The encryption thread pool may not be running in this process (e.g., in the core service)
+		if (jobCount < 1)
+			jobCount = SystemInfo::GetProcessorCount();
+
+		jobCount = min (jobCount, state.Options.size());
+
+		struct ThreadFunctor : public Functor
+		{
+			ThreadFunctor (CoreUnix *core, MountVolumesState *state) : MountingCore (core), State (state) { }
+			virtual void operator() ()
+			{
+				MountingCore->OpenVolumesThread (*State);
+			}
+			CoreUnix *MountingCore;
+			MountVolumesState *State;
+		};
+
+		list < shared_ptr <Thread> > threads;
+		for (size_t i = 1; i < jobCount; ++i)
+		{
+			make_shared_auto (Thread, thread);
+			thread->Start (new ThreadFunctor (this, &state));
+			threads.push_back (thread);
+		}
+
+		OpenVolumesThread (state);
+
+		foreach (shared_ptr <Thread> thread, threads)
+			thread->Join();
+
+		VolumeMountResultList results;
+		for (size_t i = 0; i < state.Options.size(); ++i)
+		{
+			VolumeMountResult &result = state.Results[i];
+
+			if (!result.Error)
+			{
+				MountOptions &options = *state.Options[i];
+
+				try
 				{
-					// Read-only filesystem
-					options.Protection = VolumeProtection::ReadOnly;
-					continue;
+					if (IsVolumeMounted (*options.Path))
+						throw VolumeAlreadyMounted (SRC_POS);
+
+					// A slot number specified by the options is the first slot considered for the volume
+					if (IsSlotNumberValid (options.SlotNumber) && !IsSlotNumberAvailable (options.SlotNumber))
+						options.SlotNumber = GetFirstFreeSlotNumber (options.SlotNumber);
+
+					CoalesceSlotNumberAndMountPoint (options);
+					result.MountedVolume = MountOpenedVolume (state.Volumes[i], options);
+				}
+				catch (Exception &e)
+				{
+					result.Error.reset (e.CloneNew());
+				}
+				catch (exception &e)
+				{
+					result.Error.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
 				}
 
-				throw;
+				state.Volumes[i].reset();
 			}
 
-			break;
+			results.push_back (result);
 		}
 
+		return results;
+	}
+
+	shared_ptr <VolumeInfo> CoreUnix::MountOpenedVolume (shared_ptr <Volume> volume, MountOptions &options)
+	{
 		if (options.Path->IsDevice())
 		{
 			if (volume->GetFile()->GetDeviceSectorSize() != volume->GetSectorSize())
@@ -496,7 +633,7 @@ namespace CipherShed
 
 		try
 		{
-			FuseService::Mount (volume, options.SlotNumber, fuseMountPoint);
+			FuseService::Mount (volume, options.SlotNumber, fuseMountPoint, options.ReadCacheSize);
 		}
 		catch (...)
 		{
@@ -601,6 +738,120 @@ namespace CipherShed
 		}
 	}
 
+	shared_ptr <Volume> CoreUnix::OpenVolumeToMount (MountOptions &options) const
+	{
+		while (true)
+		{
+			try
+			{
+				shared_ptr <Volume> volume = OpenVolume (
+					options.Path,
+					options.PreserveTimestamps,
+					options.Password,
+					options.Keyfiles,
+					options.Protection,
+					options.ProtectionPassword,
+					options.ProtectionKeyfiles,
+					options.SharedAccessAllowed,
+					VolumeType::Unknown,
+					options.UseBackupHeaders,
+					options.PartitionInSystemEncryptionScope
+					);
+
+				options.Password.reset();
+				return volume;
+			}
+			catch (SystemException &e)
+			{
+				if (options.Protection != VolumeProtection::ReadOnly
+					&& (e.GetErrorCode() == EROFS || e.GetErrorCode() == EACCES || e.GetErrorCode() == EPERM))
+				{
+					// Read-only filesystem
+					options.Protection = VolumeProtection::ReadOnly;
+					continue;
+				}
+
+				throw;
+			}
+		}
+	}
+
+	void CoreUnix::OpenVolumesThread (MountVolumesState &state) const
+	{
+		while (true)
+		{
+			size_t index;
+			{
+				ScopeLock lock (state.NextIndexMutex);
+				if (state.NextIndex >= state.Options.size())
+					return;
+
+				index = state.NextIndex++;
+			}
+
+			if (state.Results[index].Error)
+				continue;
+
+			try
+			{
+				state.Volumes[index] = OpenVolumeToMount (*state.Options[index]);
+			}
+			catch (Exception &e)
+			{
+				state.Results[index].Error.reset (e.CloneNew());
+			}
+			catch (exception &e)
+			{
+				state.Results[index].Error.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			}
+		}
+	}
+
+	shared_ptr <VolumeInfo> CoreUnix::ReadMountedVolumeInfo (const DirectoryPath &auxMountPoint, const VolumePath &volumePath) const
+	{
+		string controlPath = string (auxMountPoint) + FuseService::GetControlPath();
+
+		// The modification time of the control file identifies the version of the volume information
+		struct stat statData;
+		throw_sys_sub_if (stat (controlPath.c_str(), &statData) == -1, controlPath);
+
+#ifdef TC_MACOSX
+		uint64 version = (uint64) statData.st_mtimespec.tv_sec * 1000000000ULL + statData.st_mtimespec.tv_nsec;
+#else
+		uint64 version = (uint64) statData.st_mtim.tv_sec * 1000000000ULL + statData.st_mtim.tv_nsec;
+#endif
+		CachedVolumeInfo &cachedInfo = MountedVolumeInfoCache[string (auxMountPoint)];
+
+		if (cachedInfo.SerializedInfo && cachedInfo.Version == version && cachedInfo.Size == (uint64) statData.st_size)
+		{
+			shared_ptr <Stream> stream (new MemoryStream (*cachedInfo.SerializedInfo));
+			shared_ptr <VolumeInfo> volumeInfo = Serializable::DeserializeNew <VolumeInfo> (stream);
+
+			// File attributes may be cached by the kernel. A volume queried by its path is read to report its current state.
+			if (volumePath.IsEmpty() || wstring (volumeInfo->Path).compare (volumePath) != 0)
+				return volumeInfo;
+		}
+
+		File controlFile;
+		controlFile.Open (controlPath);
+
+		MemoryStream serializedInfo;
+		Buffer buffer ((size_t) min ((uint64) statData.st_size + 1, (uint64) File::GetOptimalReadSize()));
+		uint64 readSize;
+
+		while ((readSize = controlFile.Read (buffer)) > 0)
+			serializedInfo.Write (buffer.GetRange (0, readSize));
+
+		ConstBufferPtr infoBuf = serializedInfo;
+		cachedInfo.SerializedInfo.reset (new Buffer (infoBuf.Size()));
+		cachedInfo.SerializedInfo->CopyFrom (infoBuf);
+		cachedInfo.Size = (uint64) statData.st_size;
+		cachedInfo.Version = version;
+
+		shared_ptr <Stream> stream (new MemoryStream (infoBuf));
+		return Serializable::DeserializeNew <VolumeInfo> (stream);
+	}
+
 	void CoreUnix::SetFileOwner (const FilesystemPath &path, const UserId &owner) const
 	{
 		throw_sys_if (chown (string (path).c_str(), owner.SystemId, (gid_t) -1) == -1);
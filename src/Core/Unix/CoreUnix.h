@@ -41,11 +41,30 @@ namespace CipherShed
 		virtual bool HasAdminPrivileges () const { return getuid() == 0 || geteuid() == 0; }
 		virtual VolumeSlotNumber MountPointToSlotNumber (const DirectoryPath &mountPoint) const;
 		virtual shared_ptr <VolumeInfo> MountVolume (MountOptions &options);
+		virtual VolumeMountResultList MountVolumes (const MountOptionsList &optionsList, size_t jobCount = 0);
 		virtual void SetFileOwner (const FilesystemPath &path, const UserId &owner) const;
 		virtual DirectoryPath SlotNumberToMountPoint (VolumeSlotNumber slotNumber) const;
 		virtual void WipePasswordCache () const { throw NotApplicable (SRC_POS); }
 
 	protected:
+		struct CachedVolumeInfo
+		{
+			CachedVolumeInfo () : Size (0), Version (0) { }
+
+			shared_ptr <Buffer> SerializedInfo;
+			uint64 Size;	// Size and modification time of the control file
+			uint64 Version;
+		};
+
+		struct MountVolumesState
+		{
+			size_t NextIndex;
+			Mutex NextIndexMutex;
+			vector <MountOptions *> Options;
+			vector <VolumeMountResult> Results;
+			vector < shared_ptr <Volume> > Volumes;
+		};
+
 		virtual DevicePath AttachFileToLoopDevice (const FilePath &filePath, bool readOnly) const { throw NotApplicable (SRC_POS); }
 		virtual void DetachLoopDevice (const DevicePath &devicePath) const { throw NotApplicable (SRC_POS); }
 		virtual void DismountNativeVolume (shared_ptr <VolumeInfo> mountedVolume) const { throw NotApplicable (SRC_POS); }
@@ -56,9 +75,22 @@ namespace CipherShed
 		virtual uid_t GetRealUserId () const;
 		virtual gid_t GetRealGroupId () const;
 		virtual string GetTempDirectory () const;
+		virtual bool IsMountedFilesystemListChanged () const;
 		virtual void MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &systemMountOptions) const;
 		virtual void MountAuxVolumeImage (const DirectoryPath &auxMountPoint, const MountOptions &options) const;
+		virtual shared_ptr <VolumeInfo> MountOpenedVolume (shared_ptr <Volume> volume, MountOptions &options);
 		virtual void MountVolumeNative (shared_ptr <Volume> volume, MountOptions &options, const DirectoryPath &auxMountPoint) const { throw NotApplicable (SRC_POS); }
+		virtual void OpenVolumesThread (MountVolumesState &state) const;
+		virtual shared_ptr <Volume> OpenVolumeToMount (MountOptions &options) const;
+		virtual shared_ptr <VolumeInfo> ReadMountedVolumeInfo (const DirectoryPath &auxMountPoint, const VolumePath &volumePath) const;
+
+		// Mounted volumes are listed from a copy of the mount table, which is read again when the kernel reports
+		// a change, and from volume information cached until its control file reports a new version
+		mutable MountedFilesystemList MountedFilesystemCache;
+		mutable map <string, CachedVolumeInfo> MountedVolumeInfoCache;	// Indexed by auxiliary mount point
+		mutable Mutex MountedVolumeInfoCacheMutex;
+		mutable int MountTableFd;
+		mutable pid_t MountTableFdProcessId;
 		
 	private:
 		CoreUnix (const CoreUnix &);
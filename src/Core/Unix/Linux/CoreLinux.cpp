@@ -26,7 +26,11 @@
 
 namespace CipherShed
 {
-	CoreLinux::CoreLinux ()
+	CoreLinux::CoreLinux () : DeviceControl (new LinuxKernelDeviceControl)
+	{
+	}
+
+	CoreLinux::CoreLinux (shared_ptr <LinuxDeviceControl> deviceControl) : DeviceControl (deviceControl)
 	{
 	}
 
@@ -36,79 +40,23 @@ namespace CipherShed
 
 	DevicePath CoreLinux::AttachFileToLoopDevice (const FilePath &filePath, bool readOnly) const
 	{
-		list <string> loopPaths;
-		loopPaths.push_back ("/dev/loop");
-		loopPaths.push_back ("/dev/loop/");
-		loopPaths.push_back ("/dev/.static/dev/loop");
-
-		for (int devIndex = 0; devIndex < 256; devIndex++)
-		{
-			string loopDev;
-			foreach (const string &loopPath, loopPaths)
-			{
-				loopDev = loopPath + StringConverter::ToSingle (devIndex);
-				if (FilesystemPath (loopDev).IsBlockDevice())
-					break;
-			}
-
-			if (loopDev.empty())
-				continue;
-
-			list <string> args;
-
-			list <string>::iterator readOnlyArg;
-			if (readOnly)
-			{
-				args.push_back ("-r");
-				readOnlyArg = --args.end();
-			}
-
-			args.push_back ("--");
-			args.push_back (loopDev);
-			args.push_back (filePath);
-
-			try
-			{
-				Process::Execute ("losetup", args);
-				return loopDev;
-			}
-			catch (ExecutedProcessFailed&)
-			{
-				if (readOnly)
-				{
-					try
-					{
-						args.erase (readOnlyArg);
-						Process::Execute ("losetup", args);
-						return loopDev;
-					}
-					catch (ExecutedProcessFailed&) { }
-				}
-			}
-		}
-
-		throw LoopDeviceSetupFailed (SRC_POS, wstring (filePath));
+		return DeviceControl->AttachLoopDevice (filePath, readOnly);
 	}
 
 	void CoreLinux::DetachLoopDevice (const DevicePath &devicePath) const
 	{
-		list <string> args;
-		args.push_back ("-d");
-		args.push_back (devicePath);
+		DeviceControl->DetachLoopDevice (devicePath);
+	}
 
-		for (int t = 0; true; t++)
+	void CoreLinux::DismountFilesystem (const DirectoryPath &mountPoint, bool force) const
+	{
+		try
 		{
-			try
-			{
-				Process::Execute ("losetup", args);
-				break;
-			}
-			catch (ExecutedProcessFailed&)
-			{
-				if (t > 5)
-					throw;
-				Thread::Sleep (200);
-			}
+			DeviceControl->DismountFilesystem (mountPoint, force);
+		}
+		catch (NotApplicable &)
+		{
+			CoreUnix::DismountFilesystem (mountPoint, force);
 		}
 	}
 
@@ -119,35 +67,14 @@ namespace CipherShed
 		if (devPath.find ("/dev/mapper/ciphershed") != 0)
 			throw NotApplicable (SRC_POS);
 
+		// Devices of cascaded ciphers are removed starting with the topmost one
+		string devName = StringConverter::Split (devPath, "/").back();
 		size_t devCount = 0;
-		while (FilesystemPath (devPath).IsBlockDevice())
-		{
-			list <string> dmsetupArgs;
-			dmsetupArgs.push_back ("remove");
-			dmsetupArgs.push_back (StringConverter::Split (devPath, "/").back());
-
-			for (int t = 0; true; t++)
-			{
-				try
-				{
-					Process::Execute ("dmsetup", dmsetupArgs);
-					break;
-				}
-				catch (...)
-				{
-					if (t > 20)
-						throw;
 
-					Thread::Sleep (100);
-				}
-			}
-
-			for (int t = 0; FilesystemPath (devPath).IsBlockDevice() && t < 20; t++)
-			{
-				Thread::Sleep (100);
-			}
-
-			devPath = string (mountedVolume->VirtualDevice) + "_" + StringConverter::ToSingle (devCount++);
+		while (DeviceControl->IsMappedDevicePresent (devName))
+		{
+			DeviceControl->RemoveMappedDevice (devName);
+			devName = StringConverter::Split (devPath, "/").back() + "_" + StringConverter::ToSingle (devCount++);
 		}
 	}
 
@@ -279,14 +206,30 @@ namespace CipherShed
 				stringstream userMountOptions;
 				userMountOptions << "uid=" << GetRealUserId() << ",gid=" << GetRealGroupId() << ",umask=077" << (!systemMountOptions.empty() ? "," : "");
 
-				CoreUnix::MountFilesystem (devicePath, mountPoint, filesystemType, readOnly, userMountOptions.str() + systemMountOptions);
+				MountFilesystemDirect (devicePath, mountPoint, filesystemType, readOnly, userMountOptions.str() + systemMountOptions);
 				fsMounted = true;
 			}
 		}
 		catch (...) { }
 
 		if (!fsMounted)
+			MountFilesystemDirect (devicePath, mountPoint, filesystemType, readOnly, systemMountOptions);
+	}
+
+	void CoreLinux::MountFilesystemDirect (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &systemMountOptions) const
+	{
+		if (GetMountedFilesystems (DevicePath(), mountPoint).size() > 0)
+			throw MountPointUnavailable (SRC_POS);
+
+		try
+		{
+			DeviceControl->MountFilesystem (devicePath, mountPoint, filesystemType, readOnly, systemMountOptions);
+		}
+		catch (NotApplicable &)
+		{
+			// Filesystem type detection and mount helpers are provided by mount(8)
 			CoreUnix::MountFilesystem (devicePath, mountPoint, filesystemType, readOnly, systemMountOptions);
+		}
 	}
 
 	void CoreLinux::MountVolumeNative (shared_ptr <Volume> volume, MountOptions &options, const DirectoryPath &auxMountPoint) const
@@ -304,24 +247,9 @@ namespace CipherShed
 		if (!SystemInfo::IsVersionAtLeast (2, 6, xts ? 24 : 20))
 			throw NotApplicable (SRC_POS);
 
-		// Load device mapper kernel module
-		list <string> execArgs;
-		foreach (const string &dmModule, StringConverter::Split ("dm_mod dm-mod dm"))
-		{
-			execArgs.clear();
-			execArgs.push_back (dmModule);
-
-			try
-			{
-				Process::Execute ("modprobe", execArgs);
-				break;
-			}
-			catch (...) { }
-		}
-
 		bool loopDevAttached = false;
-		bool nativeDevCreated = false;
 		bool filesystemMounted = false;
+		list <string> nativeDevNames;
 
 		// Attach volume to loopback device if required
 		VolumePath volumePath = volume->GetPath();
@@ -342,10 +270,8 @@ namespace CipherShed
 
 			foreach_reverse_ref (const Cipher &cipher, volume->GetEncryptionAlgorithm()->GetCiphers())
 			{
-				stringstream dmCreateArgs;
-				dmCreateArgs << "0 " << volume->GetSize() / ENCRYPTION_DATA_UNIT_SIZE << " crypt ";
-
 				// Mode
+				stringstream dmCreateArgs;
 				dmCreateArgs << StringConverter::ToLower (StringConverter::ToSingle (cipher.GetName())) << (xts ? (SystemInfo::IsVersionAtLeast (2, 6, 33) ? "-xts-plain64 " : "-xts-plain ") : "-lrw-benbi ");
 
 				size_t keyArgOffset = dmCreateArgs.str().size();
@@ -387,32 +313,8 @@ namespace CipherShed
 				if (nativeDevCount != cipherCount - 1)
 					nativeDevName << "_" << cipherCount - nativeDevCount - 2;
 				
-				nativeDevPath = "/dev/mapper/" + nativeDevName.str();
-
-				execArgs.clear();
-				execArgs.push_back ("create");
-				execArgs.push_back (nativeDevName.str());
-
-				Process::Execute ("dmsetup", execArgs, -1, nullptr, &dmCreateArgsBuf);
-				
-				// Wait for the device to be created
-				for (int t = 0; true; t++)
-				{
-					try
-					{
-						FilesystemPath (nativeDevPath).GetType();
-						break;
-					}
-					catch (...)
-					{
-						if (t > 20)
-							throw;
-
-						Thread::Sleep (100);
-					}
-				}
-
-				nativeDevCreated = true;
+				nativeDevPath = DeviceControl->CreateMappedDevice (nativeDevName.str(), volume->GetSize() / ENCRYPTION_DATA_UNIT_SIZE, "crypt", dmCreateArgsBuf);
+				nativeDevNames.push_front (nativeDevName.str());
 				++nativeDevCount;
 			}
 
@@ -452,16 +354,14 @@ namespace CipherShed
 			}
 			catch (...) { }
 
-			try
+			foreach (const string &nativeDevName, nativeDevNames)
 			{
-				if (nativeDevCreated)
+				try
 				{
-					make_shared_auto (VolumeInfo, vol);
-					vol->VirtualDevice = nativeDevPath;
-					DismountNativeVolume (vol);
+					DeviceControl->RemoveMappedDevice (nativeDevName);
 				}
+				catch (...) { }
 			}
-			catch (...) { }
 
 			try
 			{
@@ -11,6 +11,7 @@
 
 #include "System.h"
 #include "../CoreUnix.h"
+#include "LinuxDeviceControl.h"
 
 namespace CipherShed
 {
@@ -18,8 +19,10 @@ namespace CipherShed
 	{
 	public:
 		CoreLinux ();
+		CoreLinux (shared_ptr <LinuxDeviceControl> deviceControl);
 		virtual ~CoreLinux ();
 
+		virtual void DismountFilesystem (const DirectoryPath &mountPoint, bool force) const;
 		virtual HostDeviceList GetHostDevices (bool pathListOnly = false) const; 
 
 	protected:
@@ -28,8 +31,11 @@ namespace CipherShed
 		virtual void DismountNativeVolume (shared_ptr <VolumeInfo> mountedVolume) const;
 		virtual MountedFilesystemList GetMountedFilesystems (const DevicePath &devicePath = DevicePath(), const DirectoryPath &mountPoint = DirectoryPath()) const;
 		virtual void MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &systemMountOptions) const;
+		void MountFilesystemDirect (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &systemMountOptions) const;
 		virtual void MountVolumeNative (shared_ptr <Volume> volume, MountOptions &options, const DirectoryPath &auxMountPoint) const;
 
+		shared_ptr <LinuxDeviceControl> DeviceControl;
+
 	private:
 		CoreLinux (const CoreLinux &);
 		CoreLinux &operator= (const CoreLinux &);
@@ -0,0 +1,494 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <errno.h>
+#include <map>
+#include <pthread.h>
+#include <set>
+#include <stdlib.h>
+#include <unistd.h>
+#include "CoreLinuxTest.h"
+#include "../../../Platform/Finally.h"
+#include "../../../Platform/SystemInfo.h"
+#include "../../../Platform/Time.h"
+#include "../../../Volume/EncryptionThreadPool.h"
+#include "../../../Volume/Pkcs5Kdf.h"
+#include "../../../Volume/VolumeHeader.h"
+#include "../../../Driver/Fuse/FuseService.h"
+
+namespace CipherShed
+{
+	// Records the requested operations and keeps track of the device mapper devices present. The topmost device
+	// of a cascade is backed by a file containing the decrypted volume data expected by CoreLinux.
+	class CoreLinuxTestDeviceControl : public LinuxDeviceControl
+	{
+	public:
+		CoreLinuxTestDeviceControl () : FailedCreateIndex (-1), CreateCount (0) { }
+		virtual ~CoreLinuxTestDeviceControl () { }
+
+		virtual DevicePath AttachLoopDevice (const FilePath &filePath, bool readOnly)
+		{
+			Operations.push_back ("attach");
+			return string ("/dev/loop99");
+		}
+
+		virtual DevicePath CreateMappedDevice (const string &name, uint64 sectorCount, const string &targetType, const ConstBufferPtr &targetParameters)
+		{
+			Operations.push_back ("create:" + name);
+
+			if (CreateCount++ == FailedCreateIndex)
+				throw SystemException (SRC_POS, EBUSY);
+
+			Devices.insert (name);
+			TargetParameters[name] = string ((const char *) targetParameters.Get(), targetParameters.Size());
+
+			if (name.find ('_') == string::npos)
+				return TopmostDevicePath;
+
+			return "/dev/mapper/" + name;
+		}
+
+		virtual void DetachLoopDevice (const DevicePath &devicePath)
+		{
+			Operations.push_back ("detach:" + string (devicePath));
+		}
+
+		virtual void DismountFilesystem (const DirectoryPath &mountPoint, bool force)
+		{
+			throw NotApplicable (SRC_POS);
+		}
+
+		virtual bool IsMappedDevicePresent (const string &name)
+		{
+			return Devices.find (name) != Devices.end();
+		}
+
+		virtual void MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &mountOptions)
+		{
+			throw NotApplicable (SRC_POS);
+		}
+
+		virtual void RemoveMappedDevice (const string &name)
+		{
+			Operations.push_back ("remove:" + name);
+			Devices.erase (name);
+		}
+
+		bool TargetParametersEndWith (const string &name, const string &suffix) const
+		{
+			map <string, string>::const_iterator params = TargetParameters.find (name);
+			if (params == TargetParameters.end() || params->second.size() < suffix.size())
+				return false;
+
+			return params->second.compare (params->second.size() - suffix.size(), suffix.size(), suffix) == 0;
+		}
+
+		set <string> Devices;
+		int FailedCreateIndex;
+		list <string> Operations;
+		string TopmostDevicePath;
+
+	protected:
+		int CreateCount;
+		map <string, string> TargetParameters;
+	};
+
+	class CoreLinuxTestCore : public CoreLinux
+	{
+	public:
+		CoreLinuxTestCore (shared_ptr <LinuxDeviceControl> deviceControl) : CoreLinux (deviceControl) { }
+
+		using CoreLinux::DismountNativeVolume;
+		using CoreLinux::GetTempDirectory;
+		using CoreLinux::MountVolumeNative;
+	};
+
+	// Records the number of volumes opened concurrently by MountVolumes(). Each open waits until the expected
+	// number of concurrent opens has been reached once, or until a timeout.
+	class CoreLinuxTestMountCore : public CoreLinux
+	{
+	public:
+		CoreLinuxTestMountCore (size_t expectedOpenCount)
+			: CoreLinux (shared_ptr <LinuxDeviceControl> (new CoreLinuxTestDeviceControl)),
+			ActiveOpenCount (0), ExpectedOpenCount (expectedOpenCount), MaxOpenCount (0) { }
+
+		virtual VolumeInfoList GetMountedVolumes (const VolumePath &volumePath = VolumePath()) const { return VolumeInfoList(); }
+
+		size_t ActiveOpenCount;
+		size_t ExpectedOpenCount;
+		size_t MaxOpenCount;
+		Mutex OpenCountMutex;
+
+	protected:
+		virtual shared_ptr <VolumeInfo> MountOpenedVolume (shared_ptr <Volume> volume, MountOptions &options)
+		{
+			return shared_ptr <VolumeInfo> (new VolumeInfo);
+		}
+
+		virtual shared_ptr <Volume> OpenVolumeToMount (MountOptions &options) const
+		{
+			CoreLinuxTestMountCore *core = const_cast <CoreLinuxTestMountCore *> (this);
+			uint64 timeout = Time::GetCurrent() + 2ULL * 1000 * 1000 * 10;
+			{
+				ScopeLock lock (core->OpenCountMutex);
+				core->MaxOpenCount = max (core->MaxOpenCount, ++core->ActiveOpenCount);
+			}
+
+			while (true)
+			{
+				{
+					ScopeLock lock (core->OpenCountMutex);
+					if (core->MaxOpenCount >= ExpectedOpenCount || Time::GetCurrent() >= timeout)
+					{
+						--core->ActiveOpenCount;
+						break;
+					}
+				}
+
+				Thread::Sleep (1);
+			}
+
+			return shared_ptr <Volume> ();
+		}
+	};
+
+	// Records the threads deriving PBKDF2 output blocks. If WaitForOtherThread is set, each thread waits after deriving
+	// its blocks until blocks have been derived by another thread too, or until a timeout, so that the worker threads
+	// of the encryption thread pool get a chance to take part even on a single processor.
+	class CoreLinuxTestKdfThreads
+	{
+	public:
+		CoreLinuxTestKdfThreads () : WaitForOtherThread (false) { }
+
+		void Record ()
+		{
+			uint64 timeout = Time::GetCurrent() + 2ULL * 1000 * 1000 * 10;
+			{
+				ScopeLock lock (ThreadsMutex);
+				Threads.insert (pthread_self());
+			}
+
+			while (WaitForOtherThread)
+			{
+				{
+					ScopeLock lock (ThreadsMutex);
+					if (Threads.size() > 1 || Time::GetCurrent() >= timeout)
+						break;
+				}
+
+				Thread::Sleep (1);
+			}
+		}
+
+		set <pthread_t> Threads;
+		Mutex ThreadsMutex;
+		bool WaitForOtherThread;
+	};
+
+	template <class Kdf>
+	class CoreLinuxTestKdf : public Kdf
+	{
+	public:
+		CoreLinuxTestKdf (CoreLinuxTestKdfThreads *threads) : Threads (threads) { }
+
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
+		{
+			Kdf::DeriveBlocks (blocks, password, salt, iterationCount, firstBlockNumber, aborted);
+			Threads->Record();
+		}
+
+		CoreLinuxTestKdfThreads *Threads;
+	};
+
+	// Creates a volume encrypted by a cascade of three ciphers in directory and a file containing its decrypted data
+	static shared_ptr <Volume> CreateCascadeTestVolume (const string &directory)
+	{
+		const uint64 dataSize = 64 * 1024;
+		const uint64 dataStart = 131072;
+
+		shared_ptr <EncryptionAlgorithm> ea;
+		foreach_ref (const EncryptionAlgorithm &algorithm, EncryptionAlgorithm::GetAvailableAlgorithms())
+		{
+			if (!algorithm.IsDeprecated() && algorithm.GetCiphers().size() == 3)
+			{
+				ea = algorithm.GetNew();
+				break;
+			}
+		}
+
+		if (!ea)
+			throw TestFailed (SRC_POS);
+
+		shared_ptr <Pkcs5Kdf> kdf = Pkcs5Kdf::GetAvailableAlgorithms().front();
+		VolumePassword password (L"CoreLinuxTest");
+
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		for (size_t i = 0; i < salt.Size(); ++i)
+			salt[i] = (byte) i;
+
+		SecureBuffer dataKey (ea->GetKeySize() * 2);
+		for (size_t i = 0; i < dataKey.Size(); ++i)
+			dataKey[i] = (byte) (i * 3 + 1);
+
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+		kdf->DeriveKey (headerKey, password, salt);
+
+		VolumeHeaderCreationOptions options;
+		options.DataKey = dataKey;
+		options.EA = ea;
+		options.HeaderKey = headerKey;
+		options.Kdf = kdf;
+		options.Salt = salt;
+		options.SectorSize = TC_SECTOR_SIZE_LEGACY;
+		options.Type = VolumeType::Normal;
+		options.VolumeDataSize = dataSize;
+		options.VolumeDataStart = dataStart;
+
+		SecureBuffer headerBuffer (TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		VolumeHeader header (TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		header.Create (headerBuffer, options);
+
+		File volumeFile;
+		volumeFile.Open (directory + "/volume", File::CreateWrite);
+		volumeFile.WriteAt (headerBuffer, 0);
+		volumeFile.WriteAt (headerBuffer, dataStart + dataSize);
+
+		SecureBuffer tail (dataStart - headerBuffer.Size());
+		tail.Zero();
+		volumeFile.WriteAt (tail, dataStart + dataSize + headerBuffer.Size());
+		volumeFile.Close();
+
+		shared_ptr <Volume> volume (new Volume);
+		volume->Open (VolumePath (StringConverter::ToWide (directory + "/volume")), false, shared_ptr <VolumePassword> (new VolumePassword (password)), shared_ptr <KeyfileList> ());
+
+		// Only the last sector is read back through the topmost device
+		SecureBuffer lastSector (volume->GetSectorSize());
+		volume->ReadSectors (lastSector, volume->GetSize() - volume->GetSectorSize());
+
+		File imageFile;
+		imageFile.Open (directory + "/image", File::CreateWrite);
+		imageFile.WriteAt (lastSector, volume->GetSize() - volume->GetSectorSize());
+
+		File controlFile;
+		controlFile.Open (directory + FuseService::GetControlPath(), File::CreateWrite);
+
+		return volume;
+	}
+
+	static void DeleteCascadeTestVolume (const string &directory)
+	{
+		unlink ((directory + "/volume").c_str());
+		unlink ((directory + "/image").c_str());
+		unlink ((directory + FuseService::GetControlPath()).c_str());
+		rmdir (directory.c_str());
+	}
+
+	static string MakeTestDirectory (const CoreLinuxTestCore &core)
+	{
+		string path = core.GetTempDirectory() + "/ciphershed-test-XXXXXX";
+		vector <char> pathBuf (path.begin(), path.end());
+		pathBuf.push_back (0);
+
+		throw_sys_sub_if (!mkdtemp (&pathBuf.front()), path);
+		return string (&pathBuf.front());
+	}
+
+	// Devices of a cascade are created starting with the innermost cipher and removed starting with the topmost device
+	void CoreLinuxTest::TestCascadeDevices ()
+	{
+		CoreLinuxTestDeviceControl *deviceControl = new CoreLinuxTestDeviceControl;
+		CoreLinuxTestCore core ((shared_ptr <LinuxDeviceControl> (deviceControl)));
+
+		string directory = MakeTestDirectory (core);
+		finally_do_arg (string, directory, { DeleteCascadeTestVolume (finally_arg); });
+
+		shared_ptr <Volume> volume = CreateCascadeTestVolume (directory);
+		deviceControl->TopmostDevicePath = directory + "/image";
+
+		MountOptions options;
+		options.NoFilesystem = true;
+		options.SlotNumber = 7;
+
+		core.MountVolumeNative (volume, options, directory);
+
+		list <string> expected;
+		expected.push_back ("attach");
+		expected.push_back ("create:ciphershed7_1");
+		expected.push_back ("create:ciphershed7_0");
+		expected.push_back ("create:ciphershed7");
+
+		if (deviceControl->Operations != expected)
+			throw TestFailed (SRC_POS);
+
+		if (!deviceControl->TargetParametersEndWith ("ciphershed7_1", " /dev/loop99 256")
+			|| !deviceControl->TargetParametersEndWith ("ciphershed7_0", " /dev/mapper/ciphershed7_1 0")
+			|| !deviceControl->TargetParametersEndWith ("ciphershed7", " /dev/mapper/ciphershed7_0 0"))
+			throw TestFailed (SRC_POS);
+
+		shared_ptr <VolumeInfo> mountedVolume (new VolumeInfo);
+		mountedVolume->VirtualDevice = string ("/dev/mapper/ciphershed7");
+
+		deviceControl->Operations.clear();
+		core.DismountNativeVolume (mountedVolume);
+
+		expected.clear();
+		expected.push_back ("remove:ciphershed7");
+		expected.push_back ("remove:ciphershed7_0");
+		expected.push_back ("remove:ciphershed7_1");
+
+		if (deviceControl->Operations != expected || !deviceControl->Devices.empty())
+			throw TestFailed (SRC_POS);
+	}
+
+	// Devices created before a failure are removed starting with the most recent one and the loop device is detached
+	void CoreLinuxTest::TestCascadeDeviceRollback ()
+	{
+		CoreLinuxTestDeviceControl *deviceControl = new CoreLinuxTestDeviceControl;
+		CoreLinuxTestCore core ((shared_ptr <LinuxDeviceControl> (deviceControl)));
+
+		string directory = MakeTestDirectory (core);
+		finally_do_arg (string, directory, { DeleteCascadeTestVolume (finally_arg); });
+
+		shared_ptr <Volume> volume = CreateCascadeTestVolume (directory);
+		deviceControl->TopmostDevicePath = directory + "/image";
+		deviceControl->FailedCreateIndex = 2;
+
+		MountOptions options;
+		options.NoFilesystem = true;
+		options.SlotNumber = 3;
+
+		try
+		{
+			core.MountVolumeNative (volume, options, directory);
+			throw TestFailed (SRC_POS);
+		}
+		catch (SystemException &e)
+		{
+			if (e.GetErrorCode() != EBUSY)
+				throw;
+		}
+
+		list <string> expected;
+		expected.push_back ("attach");
+		expected.push_back ("create:ciphershed3_1");
+		expected.push_back ("create:ciphershed3_0");
+		expected.push_back ("create:ciphershed3");
+		expected.push_back ("remove:ciphershed3_0");
+		expected.push_back ("remove:ciphershed3_1");
+		expected.push_back ("detach:/dev/loop99");
+
+		if (deviceControl->Operations != expected || !deviceControl->Devices.empty())
+			throw TestFailed (SRC_POS);
+	}
+
+	// Without a job count, MountVolumes() opens as many volumes concurrently as there are processors available to
+	// the process, whether or not the encryption thread pool is running
+	void CoreLinuxTest::TestMountJobCount ()
+	{
+		size_t processorCount = SystemInfo::GetProcessorCount();
+		CoreLinuxTestMountCore core (processorCount);
+
+		MountOptionsList optionsList;
+		for (size_t i = 0; i <= processorCount; ++i)
+		{
+			make_shared_auto (MountOptions, options);
+			options->NoFilesystem = true;
+			options->Path.reset (new VolumePath (L"/ciphershed-test-volume-" + StringConverter::ToWide ((uint64) i)));
+			optionsList.push_back (options);
+		}
+
+		VolumeMountResultList results = core.MountVolumes (optionsList);
+
+		if (results.size() != optionsList.size() || core.MaxOpenCount != processorCount)
+			throw TestFailed (SRC_POS);
+
+		foreach (const VolumeMountResult &result, results)
+		{
+			if (result.Error || !result.MountedVolume)
+				throw TestFailed (SRC_POS);
+		}
+	}
+
+	// When the volume header is decrypted during mount, the header keys of all PRFs are derived by the worker threads
+	// of the encryption thread pool and the output blocks of a single header key are distributed among threads
+	void CoreLinuxTest::TestMountKeyDerivation ()
+	{
+		CoreLinuxTestCore core ((shared_ptr <LinuxDeviceControl> (new CoreLinuxTestDeviceControl)));
+
+		string directory = MakeTestDirectory (core);
+		finally_do_arg (string, directory, { DeleteCascadeTestVolume (finally_arg); });
+
+		CreateCascadeTestVolume (directory);
+
+		SecureBuffer headerBuffer (TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		File volumeFile;
+		volumeFile.Open (directory + "/volume");
+		volumeFile.ReadAt (headerBuffer, 0);
+
+		// The pool is started with two worker threads regardless of the number of processors available
+		bool poolRunning = EncryptionThreadPool::IsRunning();
+		finally_do_arg (bool, poolRunning,
+		{
+			EncryptionThreadPool::Stop();
+			if (finally_arg)
+				EncryptionThreadPool::Start();
+		});
+
+		EncryptionThreadPool::Stop();
+		EncryptionThreadPool::Start (2);
+
+		if (!EncryptionThreadPool::IsRunning())
+			throw TestFailed (SRC_POS);
+
+		CoreLinuxTestKdfThreads headerKdfThreads;
+		Pkcs5KdfList keyDerivationFunctions;
+		keyDerivationFunctions.push_back (shared_ptr <Pkcs5Kdf> (new CoreLinuxTestKdf <Pkcs5HmacRipemd160> (&headerKdfThreads)));
+		keyDerivationFunctions.push_back (shared_ptr <Pkcs5Kdf> (new CoreLinuxTestKdf <Pkcs5HmacSha512> (&headerKdfThreads)));
+		keyDerivationFunctions.push_back (shared_ptr <Pkcs5Kdf> (new CoreLinuxTestKdf <Pkcs5HmacWhirlpool> (&headerKdfThreads)));
+		keyDerivationFunctions.push_back (shared_ptr <Pkcs5Kdf> (new CoreLinuxTestKdf <Pkcs5HmacSha1> (&headerKdfThreads)));
+
+		VolumeHeader header (TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		if (!header.Decrypt (headerBuffer, VolumePassword (L"CoreLinuxTest"), keyDerivationFunctions,
+			EncryptionAlgorithm::GetAvailableAlgorithms(), EncryptionMode::GetAvailableModes()))
+		{
+			throw TestFailed (SRC_POS);
+		}
+
+		{
+			ScopeLock lock (headerKdfThreads.ThreadsMutex);
+			if (headerKdfThreads.Threads.empty() || headerKdfThreads.Threads.find (pthread_self()) != headerKdfThreads.Threads.end())
+				throw TestFailed (SRC_POS);
+		}
+
+		// Output blocks of a header key
+		CoreLinuxTestKdfThreads blockKdfThreads;
+		blockKdfThreads.WaitForOtherThread = true;
+
+		CoreLinuxTestKdf <Pkcs5HmacRipemd160> blockKdf (&blockKdfThreads);
+		Pkcs5HmacRipemd160 referenceKdf;
+
+		ConstBufferPtr salt (headerBuffer.GetRange (0, VolumeHeader::GetSaltSize()));
+		SecureBuffer key (VolumeHeader::GetLargestSerializedKeySize());
+		SecureBuffer referenceKey (key.Size());
+
+		blockKdf.DeriveKey (key, VolumePassword (L"CoreLinuxTest"), salt);
+		referenceKdf.DeriveKey (referenceKey, VolumePassword (L"CoreLinuxTest"), salt);
+
+		if (memcmp (key.Ptr(), referenceKey.Ptr(), key.Size()) != 0 || blockKdfThreads.Threads.size() < 2)
+			throw TestFailed (SRC_POS);
+	}
+
+	void CoreLinuxTest::TestAll ()
+	{
+		TestCascadeDevices();
+		TestCascadeDeviceRollback();
+		TestMountJobCount();
+		TestMountKeyDerivation();
+	}
+}
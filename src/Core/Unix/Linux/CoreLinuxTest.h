@@ -0,0 +1,31 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_CoreLinuxTest
+#define TC_HEADER_Core_CoreLinuxTest
+
+#include "CoreLinux.h"
+
+namespace CipherShed
+{
+	// Tests of CoreLinux using a fake LinuxDeviceControl which records the requested device operations
+	class CoreLinuxTest
+	{
+	public:
+		static void TestAll ();
+
+	protected:
+		CoreLinuxTest ();
+		static void TestCascadeDevices ();
+		static void TestCascadeDeviceRollback ();
+		static void TestMountJobCount ();
+		static void TestMountKeyDerivation ();
+	};
+}
+
+#endif // TC_HEADER_Core_CoreLinuxTest
@@ -0,0 +1,546 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/dm-ioctl.h>
+#include <linux/loop.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include "LinuxDeviceControl.h"
+#include "../../CoreException.h"
+#include "../../../Platform/Finally.h"
+#include "../../../Platform/SystemException.h"
+#include "../../../Platform/TextReader.h"
+#include "../../../Platform/Thread.h"
+#include "../../../Platform/Time.h"
+
+#ifndef LOOP_CTL_GET_FREE
+#	define LOOP_CTL_GET_FREE 0x4C82
+#endif
+
+#ifndef LOOP_CONFIGURE
+#	define LOOP_CONFIGURE 0x4C0A
+
+	struct loop_config
+	{
+		uint32_t fd;
+		uint32_t block_size;
+		struct loop_info64 info;
+		uint64_t __reserved[8];
+	};
+#endif
+
+#ifndef DM_SECURE_DATA_FLAG
+#	define DM_SECURE_DATA_FLAG (1 << 15)
+#endif
+
+#ifndef DM_DEFERRED_REMOVE
+#	define DM_DEFERRED_REMOVE (1 << 17)
+#endif
+
+namespace CipherShed
+{
+	DevicePath LinuxKernelDeviceControl::AttachLoopDevice (const FilePath &filePath, bool readOnly)
+	{
+		int fileFd = open (string (filePath).c_str(), (readOnly ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+
+		// Read-only files are attached read-only as done by losetup
+		if (fileFd == -1 && !readOnly && (errno == EROFS || errno == EACCES || errno == EPERM))
+		{
+			readOnly = true;
+			fileFd = open (string (filePath).c_str(), O_RDONLY | O_CLOEXEC);
+		}
+
+		throw_sys_sub_if (fileFd == -1, wstring (filePath));
+		finally_do_arg (int, fileFd, { close (finally_arg); });
+
+		// A free device may be claimed by another process before it is configured
+		for (int attempt = 0; attempt < 256; ++attempt)
+		{
+			int loopDeviceFd;
+			DevicePath loopDevice = OpenFreeLoopDevice (loopDeviceFd);
+
+			if (loopDevice.IsEmpty())
+				break;
+
+			finally_do_arg (int, loopDeviceFd, { close (finally_arg); });
+
+			if (ConfigureLoopDevice (loopDeviceFd, fileFd, filePath, readOnly))
+				return loopDevice;
+		}
+
+		throw LoopDeviceSetupFailed (SRC_POS, wstring (filePath));
+	}
+
+	bool LinuxKernelDeviceControl::ConfigureLoopDevice (int loopDeviceFd, int fileFd, const FilePath &filePath, bool readOnly) const
+	{
+		struct loop_config config;
+		memset (&config, 0, sizeof (config));
+
+		config.fd = fileFd;
+		config.info.lo_flags = readOnly ? LO_FLAGS_READ_ONLY : 0;
+		strncpy ((char *) config.info.lo_file_name, string (filePath).c_str(), LO_NAME_SIZE - 1);
+
+		if (ioctl (loopDeviceFd, LOOP_CONFIGURE, &config) == 0)
+			return true;
+
+		if (errno == EBUSY)
+			return false;
+
+		throw_sys_sub_if (errno != EINVAL && errno != ENOTTY, wstring (filePath));
+
+		// Kernels older than 5.8 require the file and the status to be set separately
+		if (ioctl (loopDeviceFd, LOOP_SET_FD, fileFd) == -1)
+		{
+			if (errno == EBUSY)
+				return false;
+
+			throw SystemException (SRC_POS, wstring (filePath));
+		}
+
+		if (ioctl (loopDeviceFd, LOOP_SET_STATUS64, &config.info) == -1)
+		{
+			SystemException ex (SRC_POS, wstring (filePath));
+			ioctl (loopDeviceFd, LOOP_CLR_FD, 0);
+			throw ex;
+		}
+
+		return true;
+	}
+
+	DevicePath LinuxKernelDeviceControl::CreateMappedDevice (const string &name, uint64 sectorCount, const string &targetType, const ConstBufferPtr &targetParameters)
+	{
+		Buffer createBuffer (sizeof (struct dm_ioctl));
+		struct dm_ioctl *createIo = InitDeviceMapperIoctl (createBuffer, name);
+
+		int errorCode = DeviceMapperIoctl (DM_DEV_CREATE, createBuffer);
+
+		// A device of the same name may be pending deferred removal
+		if (errorCode == EBUSY && WaitForMappedDeviceRemoval (name))
+		{
+			createIo = InitDeviceMapperIoctl (createBuffer, name);
+			errorCode = DeviceMapperIoctl (DM_DEV_CREATE, createBuffer);
+		}
+
+		if (errorCode != 0)
+			throw SystemException (SRC_POS, errorCode);
+
+		uint64 deviceNumber = createIo->dev;
+
+		try
+		{
+			// The table carries the keys and is therefore kept in a secure buffer
+			size_t tableOffset = sizeof (struct dm_ioctl);
+			size_t parametersOffset = tableOffset + sizeof (struct dm_target_spec);
+			SecureBuffer tableBuffer ((parametersOffset + targetParameters.Size() + 1 + 7) & ~(size_t) 7);
+			tableBuffer.Zero();
+
+			struct dm_ioctl *tableIo = InitDeviceMapperIoctl (tableBuffer, name);
+			tableIo->target_count = 1;
+			tableIo->flags = DM_SECURE_DATA_FLAG;
+
+			struct dm_target_spec *target = reinterpret_cast <struct dm_target_spec *> (tableBuffer.Ptr() + tableOffset);
+			target->sector_start = 0;
+			target->length = sectorCount;
+			strncpy (target->target_type, targetType.c_str(), sizeof (target->target_type) - 1);
+
+			tableBuffer.GetRange (parametersOffset, targetParameters.Size()).CopyFrom (targetParameters);
+
+			errorCode = DeviceMapperIoctl (DM_TABLE_LOAD, tableBuffer);
+			if (errorCode != 0)
+				throw SystemException (SRC_POS, errorCode);
+
+			// Resuming the device activates the loaded table
+			Buffer resumeBuffer (sizeof (struct dm_ioctl));
+			InitDeviceMapperIoctl (resumeBuffer, name);
+
+			errorCode = DeviceMapperIoctl (DM_DEV_SUSPEND, resumeBuffer);
+			if (errorCode != 0)
+				throw SystemException (SRC_POS, errorCode);
+
+			string devicePath = "/dev/mapper/" + name;
+			WaitForDeviceNode (devicePath, deviceNumber);
+
+			return devicePath;
+		}
+		catch (...)
+		{
+			try
+			{
+				RemoveMappedDevice (name);
+			}
+			catch (...) { }
+
+			throw;
+		}
+	}
+
+	int LinuxKernelDeviceControl::DeviceMapperIoctl (unsigned long request, const BufferPtr &ioBuffer) const
+	{
+		const char *controlPath = "/dev/mapper/control";
+		int controlFd = open (controlPath, O_RDWR | O_CLOEXEC);
+
+		// Opening the control device loads the device mapper module
+		if (controlFd == -1 && errno == ENOENT)
+		{
+			MakeDeviceNode (controlPath, makedev (10, 236), false);
+			controlFd = open (controlPath, O_RDWR | O_CLOEXEC);
+		}
+
+		if (controlFd == -1)
+		{
+			if (errno == ENODEV || errno == ENXIO)
+				throw NotApplicable (SRC_POS);
+
+			throw SystemException (SRC_POS, controlPath);
+		}
+
+		finally_do_arg (int, controlFd, { close (finally_arg); });
+
+		if (ioctl (controlFd, request, ioBuffer.Get()) == -1)
+			return errno;
+
+		return 0;
+	}
+
+	void LinuxKernelDeviceControl::DetachLoopDevice (const DevicePath &devicePath)
+	{
+		int loopDeviceFd = open (string (devicePath).c_str(), O_RDONLY | O_CLOEXEC);
+		throw_sys_sub_if (loopDeviceFd == -1, wstring (devicePath));
+		finally_do_arg (int, loopDeviceFd, { close (finally_arg); });
+
+		if (ioctl (loopDeviceFd, LOOP_CLR_FD, 0) == 0 || errno == ENXIO)
+			return;
+
+		throw_sys_sub_if (errno != EBUSY, wstring (devicePath));
+
+		// The device is still open and will be detached by the kernel when it is closed
+		struct loop_info64 info;
+		throw_sys_sub_if (ioctl (loopDeviceFd, LOOP_GET_STATUS64, &info) == -1, wstring (devicePath));
+
+		info.lo_flags |= LO_FLAGS_AUTOCLEAR;
+		throw_sys_sub_if (ioctl (loopDeviceFd, LOOP_SET_STATUS64, &info) == -1, wstring (devicePath));
+	}
+
+	void LinuxKernelDeviceControl::DismountFilesystem (const DirectoryPath &mountPoint, bool force)
+	{
+		if (geteuid() != 0 || !IsMountedFilesystemListKernelMaintained())
+			throw NotApplicable (SRC_POS);
+
+		if (umount2 (string (mountPoint).c_str(), 0) == 0)
+			return;
+
+		// A busy filesystem is reported by umount(8), whose failure is expected by callers handling volumes in use
+		throw_sys_sub_if (errno != EBUSY, wstring (mountPoint));
+		throw NotApplicable (SRC_POS);
+	}
+
+	struct dm_ioctl *LinuxKernelDeviceControl::InitDeviceMapperIoctl (const BufferPtr &ioBuffer, const string &name)
+	{
+		if (ioBuffer.Size() < sizeof (struct dm_ioctl) || name.size() >= DM_NAME_LEN)
+			throw ParameterIncorrect (SRC_POS);
+
+		struct dm_ioctl *io = reinterpret_cast <struct dm_ioctl *> (ioBuffer.Get());
+		memset (io, 0, sizeof (*io));
+
+		io->version[0] = DM_VERSION_MAJOR;
+		io->data_size = ioBuffer.Size();
+		io->data_start = sizeof (*io);
+		strncpy (io->name, name.c_str(), sizeof (io->name) - 1);
+
+		return io;
+	}
+
+	bool LinuxKernelDeviceControl::IsMappedDevicePresent (const string &name)
+	{
+		Buffer statusBuffer (sizeof (struct dm_ioctl));
+		InitDeviceMapperIoctl (statusBuffer, name);
+
+		int errorCode = DeviceMapperIoctl (DM_DEV_STATUS, statusBuffer);
+		if (errorCode == ENXIO)
+			return false;
+
+		if (errorCode != 0)
+			throw SystemException (SRC_POS, errorCode);
+
+		return true;
+	}
+
+	bool LinuxKernelDeviceControl::IsMountedFilesystemListKernelMaintained () const
+	{
+		// Mounts made by mount(2) are not recorded in a regular /etc/mtab file, which is read by CoreLinux
+		struct stat statData;
+		if (lstat ("/etc/mtab", &statData) == -1)
+			return errno == ENOENT;
+
+		return S_ISLNK (statData.st_mode);
+	}
+
+	bool LinuxKernelDeviceControl::IsUdevRunning () const
+	{
+		return access ("/run/udev/control", F_OK) == 0;
+	}
+
+	void LinuxKernelDeviceControl::MakeDeviceNode (const string &path, uint64 deviceNumber, bool blockDevice) const
+	{
+		string directory = path.substr (0, path.rfind ('/'));
+		if (mkdir (directory.c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) == -1)
+			throw_sys_sub_if (errno != EEXIST, directory);
+
+		// A stale node of a previously removed device may still exist
+		throw_sys_sub_if (unlink (path.c_str()) == -1 && errno != ENOENT, path);
+		throw_sys_sub_if (mknod (path.c_str(), (blockDevice ? S_IFBLK : S_IFCHR) | S_IRUSR | S_IWUSR, (dev_t) deviceNumber) == -1, path);
+	}
+
+	void LinuxKernelDeviceControl::MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &mountOptions)
+	{
+		if (geteuid() != 0 || !IsMountedFilesystemListKernelMaintained())
+			throw NotApplicable (SRC_POS);
+
+		// Filesystem type detection is left to mount(8), as are filesystems mounted using a helper program, such as
+		// ntfs-3g, and filesystem types not yet registered with the kernel
+		if (filesystemType.empty()
+			|| access (("/sbin/mount." + filesystemType).c_str(), X_OK) == 0
+			|| access (("/usr/sbin/mount." + filesystemType).c_str(), X_OK) == 0)
+		{
+			throw NotApplicable (SRC_POS);
+		}
+
+		struct MountFlag
+		{
+			const char *Name;
+			unsigned long Set;
+			unsigned long Clear;
+		};
+
+		static const MountFlag mountFlags[] =
+		{
+			{ "async",			0,				MS_SYNCHRONOUS },
+			{ "atime",			0,				MS_NOATIME },
+			{ "dev",			0,				MS_NODEV },
+			{ "diratime",		0,				MS_NODIRATIME },
+			{ "dirsync",		MS_DIRSYNC,		0 },
+			{ "exec",			0,				MS_NOEXEC },
+			{ "noatime",		MS_NOATIME,		0 },
+			{ "nodev",			MS_NODEV,		0 },
+			{ "nodiratime",		MS_NODIRATIME,	0 },
+			{ "noexec",			MS_NOEXEC,		0 },
+			{ "norelatime",		0,				MS_RELATIME },
+			{ "nostrictatime",	0,				MS_STRICTATIME },
+			{ "nosuid",			MS_NOSUID,		0 },
+			{ "relatime",		MS_RELATIME,	0 },
+			{ "ro",				MS_RDONLY,		0 },
+			{ "rw",				0,				MS_RDONLY },
+			{ "strictatime",	MS_STRICTATIME,	0 },
+			{ "suid",			0,				MS_NOSUID },
+			{ "sync",			MS_SYNCHRONOUS,	0 }
+		};
+
+		// Options interpreted by mount(8) which do not apply to the kernel
+		static const char *userspaceOptions[] = { "auto", "defaults", "group", "noauto", "nofail", "nouser", "owner", "user", "users", "_netdev" };
+
+		unsigned long flags = readOnly ? MS_RDONLY : 0;
+		string data;
+
+		foreach (const string &option, StringConverter::Split (mountOptions, ","))
+		{
+			bool optionHandled = (option.find ("x-") == 0 || option.find ("comment=") == 0);
+
+			for (size_t i = 0; !optionHandled && i < array_capacity (userspaceOptions); ++i)
+				optionHandled = (option == userspaceOptions[i]);
+
+			for (size_t i = 0; !optionHandled && i < array_capacity (mountFlags); ++i)
+			{
+				if (option == mountFlags[i].Name)
+				{
+					flags = (flags & ~mountFlags[i].Clear) | mountFlags[i].Set;
+					optionHandled = true;
+				}
+			}
+
+			if (!optionHandled)
+				data += (data.empty() ? "" : ",") + option;
+		}
+
+		if (mount (string (devicePath).c_str(), string (mountPoint).c_str(), filesystemType.c_str(), flags, data.empty() ? nullptr : data.c_str()) == 0)
+			return;
+
+		// Write-protected devices are mounted read-only as done by mount(8)
+		if ((errno == EROFS || errno == EACCES) && !(flags & MS_RDONLY)
+			&& mount (string (devicePath).c_str(), string (mountPoint).c_str(), filesystemType.c_str(), flags | MS_RDONLY, data.empty() ? nullptr : data.c_str()) == 0)
+		{
+			return;
+		}
+
+		throw NotApplicable (SRC_POS);
+	}
+
+	DevicePath LinuxKernelDeviceControl::OpenFreeLoopDevice (int &loopDeviceFd) const
+	{
+		int controlFd = open ("/dev/loop-control", O_RDWR | O_CLOEXEC);
+
+		if (controlFd != -1)
+		{
+			finally_do_arg (int, controlFd, { close (finally_arg); });
+
+			int deviceIndex = ioctl (controlFd, LOOP_CTL_GET_FREE);
+			throw_sys_sub_if (deviceIndex == -1, "/dev/loop-control");
+
+			string devicePath = "/dev/loop" + StringConverter::ToSingle (deviceIndex);
+
+			// The device number depends on the number of partitions supported by the loop driver
+			string deviceNumber;
+			TextReader tr (FilePath ("/sys/block/loop" + StringConverter::ToSingle (deviceIndex) + "/dev"));
+			tr.ReadLine (deviceNumber);
+
+			vector <string> numbers = StringConverter::Split (deviceNumber, ":\n");
+			if (numbers.size() != 2)
+				throw ParameterIncorrect (SRC_POS);
+
+			WaitForDeviceNode (devicePath, makedev (StringConverter::ToUInt32 (numbers[0]), StringConverter::ToUInt32 (numbers[1])));
+
+			loopDeviceFd = open (devicePath.c_str(), O_RDWR | O_CLOEXEC);
+			throw_sys_sub_if (loopDeviceFd == -1, devicePath);
+
+			return devicePath;
+		}
+
+		// Kernels older than 3.1 do not provide loop-control
+		for (int deviceIndex = 0; deviceIndex < 256; ++deviceIndex)
+		{
+			string devicePath = "/dev/loop" + StringConverter::ToSingle (deviceIndex);
+
+			loopDeviceFd = open (devicePath.c_str(), O_RDWR | O_CLOEXEC);
+			if (loopDeviceFd == -1)
+				continue;
+
+			struct loop_info64 info;
+			if (ioctl (loopDeviceFd, LOOP_GET_STATUS64, &info) == -1 && errno == ENXIO)
+				return devicePath;
+
+			close (loopDeviceFd);
+		}
+
+		return DevicePath();
+	}
+
+	void LinuxKernelDeviceControl::RemoveMappedDevice (const string &name)
+	{
+		Buffer removeBuffer (sizeof (struct dm_ioctl));
+		struct dm_ioctl *removeIo = InitDeviceMapperIoctl (removeBuffer, name);
+
+		int errorCode = DeviceMapperIoctl (DM_DEV_REMOVE, removeBuffer);
+
+		// A device may still be opened for a short time, for instance by udev probing its contents
+		uint64 timeout = Time::GetCurrent() + (uint64) DeviceRemovalTimeout * 1000 * 10;
+
+		while (errorCode == EBUSY && Time::GetCurrent() < timeout)
+		{
+			Thread::Sleep (DeviceRemovalRetryInterval);
+
+			InitDeviceMapperIoctl (removeBuffer, name);
+			errorCode = DeviceMapperIoctl (DM_DEV_REMOVE, removeBuffer);
+		}
+
+		// A device still in use is removed by the kernel when it is closed. CreateMappedDevice() waits for the removal
+		// if the name is reused before.
+		if (errorCode == EBUSY)
+		{
+			removeIo = InitDeviceMapperIoctl (removeBuffer, name);
+			removeIo->flags = DM_DEFERRED_REMOVE;
+
+			errorCode = DeviceMapperIoctl (DM_DEV_REMOVE, removeBuffer);
+			if (errorCode == 0)
+				return;
+		}
+
+		if (errorCode != 0 && errorCode != ENXIO)
+			throw SystemException (SRC_POS, errorCode);
+
+		// Without udev, the node has been created by CreateMappedDevice()
+		if (!IsUdevRunning())
+		{
+			string devicePath = "/dev/mapper/" + name;
+			throw_sys_sub_if (unlink (devicePath.c_str()) == -1 && errno != ENOENT, devicePath);
+		}
+	}
+
+	bool LinuxKernelDeviceControl::WaitForMappedDeviceRemoval (const string &name)
+	{
+		uint64 timeout = Time::GetCurrent() + (uint64) DeviceRemovalTimeout * 1000 * 10;
+
+		while (IsMappedDevicePresent (name))
+		{
+			if (Time::GetCurrent() >= timeout)
+				return false;
+
+			Thread::Sleep (DeviceRemovalRetryInterval);
+		}
+
+		return true;
+	}
+
+	void LinuxKernelDeviceControl::WaitForDeviceNode (const string &path, uint64 deviceNumber) const
+	{
+		struct NodeCheck
+		{
+			static bool IsReady (const string &path, uint64 deviceNumber)
+			{
+				struct stat statData;
+				return stat (path.c_str(), &statData) == 0 && S_ISBLK (statData.st_mode) && (uint64) statData.st_rdev == deviceNumber;
+			}
+		};
+
+		if (NodeCheck::IsReady (path, deviceNumber))
+			return;
+
+		// Nodes are created by udev, which is waited for by watching the parent directory
+		if (IsUdevRunning())
+		{
+			int inotifyFd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+			throw_sys_if (inotifyFd == -1);
+			finally_do_arg (int, inotifyFd, { close (finally_arg); });
+
+			string directory = path.substr (0, path.rfind ('/'));
+			if (inotify_add_watch (inotifyFd, directory.c_str(), IN_CREATE | IN_MOVED_TO | IN_ATTRIB) != -1)
+			{
+				uint64 timeout = Time::GetCurrent() + (uint64) DeviceNodeTimeout * 1000 * 10;
+
+				while (!NodeCheck::IsReady (path, deviceNumber))
+				{
+					uint64 currentTime = Time::GetCurrent();
+					if (currentTime >= timeout)
+						break;
+
+					struct pollfd pollData;
+					pollData.fd = inotifyFd;
+					pollData.events = POLLIN;
+					pollData.revents = 0;
+
+					if (poll (&pollData, 1, (int) ((timeout - currentTime) / (1000 * 10)) + 1) == -1 && errno != EINTR)
+						throw SystemException (SRC_POS);
+
+					char events[4096];
+					while (read (inotifyFd, events, sizeof (events)) > 0);
+				}
+
+				if (NodeCheck::IsReady (path, deviceNumber))
+					return;
+			}
+		}
+
+		MakeDeviceNode (path, deviceNumber, true);
+	}
+}
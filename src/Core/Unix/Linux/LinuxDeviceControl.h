@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_Linux_LinuxDeviceControl
+#define TC_HEADER_Core_Linux_LinuxDeviceControl
+
+#include "System.h"
+#include "../../../Platform/Buffer.h"
+#include "../../../Platform/FilesystemPath.h"
+
+struct dm_ioctl;
+
+namespace CipherShed
+{
+	// Kernel services used by CoreLinux to set up loop devices, device mapper devices and filesystems. Methods
+	// throw NotApplicable if a request cannot be handled, in which case CoreLinux falls back to system utilities.
+	class LinuxDeviceControl
+	{
+	public:
+		LinuxDeviceControl () { }
+		virtual ~LinuxDeviceControl () { }
+
+		virtual DevicePath AttachLoopDevice (const FilePath &filePath, bool readOnly) = 0;
+		virtual DevicePath CreateMappedDevice (const string &name, uint64 sectorCount, const string &targetType, const ConstBufferPtr &targetParameters) = 0;
+		virtual void DetachLoopDevice (const DevicePath &devicePath) = 0;
+		virtual void DismountFilesystem (const DirectoryPath &mountPoint, bool force) = 0;
+		virtual bool IsMappedDevicePresent (const string &name) = 0;
+		virtual void MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &mountOptions) = 0;
+		virtual void RemoveMappedDevice (const string &name) = 0;
+
+	private:
+		LinuxDeviceControl (const LinuxDeviceControl &);
+		LinuxDeviceControl &operator= (const LinuxDeviceControl &);
+	};
+
+	// Implementation using loop and device mapper ioctls and mount(2). Device nodes are awaited using inotify when
+	// udev is running and created directly otherwise.
+	class LinuxKernelDeviceControl : public LinuxDeviceControl
+	{
+	public:
+		LinuxKernelDeviceControl () { }
+		virtual ~LinuxKernelDeviceControl () { }
+
+		virtual DevicePath AttachLoopDevice (const FilePath &filePath, bool readOnly);
+		virtual DevicePath CreateMappedDevice (const string &name, uint64 sectorCount, const string &targetType, const ConstBufferPtr &targetParameters);
+		virtual void DetachLoopDevice (const DevicePath &devicePath);
+		virtual void DismountFilesystem (const DirectoryPath &mountPoint, bool force);
+		virtual bool IsMappedDevicePresent (const string &name);
+		virtual void MountFilesystem (const DevicePath &devicePath, const DirectoryPath &mountPoint, const string &filesystemType, bool readOnly, const string &mountOptions);
+		virtual void RemoveMappedDevice (const string &name);
+
+		static const int DeviceNodeTimeout = 2000;	// Milliseconds
+		static const int DeviceRemovalRetryInterval = 20;	// Milliseconds
+		static const int DeviceRemovalTimeout = 2000;	// Milliseconds
+
+	protected:
+		bool ConfigureLoopDevice (int loopDeviceFd, int fileFd, const FilePath &filePath, bool readOnly) const;
+		int DeviceMapperIoctl (unsigned long request, const BufferPtr &ioBuffer) const;
+		static struct dm_ioctl *InitDeviceMapperIoctl (const BufferPtr &ioBuffer, const string &name);
+		bool IsMountedFilesystemListKernelMaintained () const;
+		bool IsUdevRunning () const;
+		void MakeDeviceNode (const string &path, uint64 deviceNumber, bool blockDevice) const;
+		DevicePath OpenFreeLoopDevice (int &loopDeviceFd) const;
+		void WaitForDeviceNode (const string &path, uint64 deviceNumber) const;
+		bool WaitForMappedDeviceRemoval (const string &name);
+
+	private:
+		LinuxKernelDeviceControl (const LinuxKernelDeviceControl &);
+		LinuxKernelDeviceControl &operator= (const LinuxKernelDeviceControl &);
+	};
+}
+
+#endif // TC_HEADER_Core_Linux_LinuxDeviceControl
@@ -0,0 +1,514 @@
+/*
+ Copyright (c) 2010 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/* Constant-time AES-256 for CPUs without AES-NI. Eight blocks are bitsliced into eight SSE registers,
+each holding one bit plane of all 128 state bytes: byte i of plane k contains bit k of state byte i
+of each of the eight blocks. SubBytes is computed with the Boyar-Peralta circuit of 115 logic
+gates, ShiftRows and the row rotations of MixColumns are byte shuffles (SSSE3), and no memory
+access depends on the key or on the data. Fewer than eight blocks are padded to eight.
+
+The key schedule is derived from the encryption key schedule of Aeskey.c. Decryption uses the
+straightforward inverse cipher with the encryption round keys in reverse order. The caller must
+ensure that aes_bitsliced_supported() returns nonzero. */
+
+#include "Aes_bitsliced.h"
+
+#include <string.h>
+
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__))
+#	define AES_BITSLICED_SIMD
+#endif
+
+#ifdef AES_BITSLICED_SIMD
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+#define AES_BITSLICED_FUNCTION static __attribute__ ((target ("ssse3")))
+#define AES_BITSLICED_INLINE_FUNCTION static inline __attribute__ ((always_inline, target ("ssse3")))
+
+// The state must stay in registers, which requires the loops over the bit planes to be unrolled
+#if __GNUC__ >= 8
+#	define AES_BITSLICED_UNROLL _Pragma ("GCC unroll 8")
+#else
+#	define AES_BITSLICED_UNROLL
+#endif
+
+#define AES_BITSLICED_PARALLEL_BLOCKS 8
+
+
+// Moves the bits selected by mask from b into a and vice versa, shifted by n
+#define AES_BITSLICED_SWAPMOVE(a, b, mask, n) \
+	do { \
+		__m128i t_ = _mm_and_si128 (_mm_xor_si128 (_mm_srli_epi64 ((a), (n)), (b)), (mask)); \
+		(b) = _mm_xor_si128 ((b), t_); \
+		(a) = _mm_xor_si128 ((a), _mm_slli_epi64 (t_, (n))); \
+	} while (0)
+
+
+// Transposes the 8x8 bit matrix formed by each byte position of the eight registers. The operation
+// is its own inverse and converts eight blocks into eight bit planes and back.
+AES_BITSLICED_INLINE_FUNCTION void transpose (__m128i *q)
+{
+	const __m128i m1 = _mm_set1_epi8 (0x55);
+	const __m128i m2 = _mm_set1_epi8 (0x33);
+	const __m128i m4 = _mm_set1_epi8 (0x0f);
+
+	AES_BITSLICED_SWAPMOVE (q[0], q[1], m1, 1);
+	AES_BITSLICED_SWAPMOVE (q[2], q[3], m1, 1);
+	AES_BITSLICED_SWAPMOVE (q[4], q[5], m1, 1);
+	AES_BITSLICED_SWAPMOVE (q[6], q[7], m1, 1);
+
+	AES_BITSLICED_SWAPMOVE (q[0], q[2], m2, 2);
+	AES_BITSLICED_SWAPMOVE (q[1], q[3], m2, 2);
+	AES_BITSLICED_SWAPMOVE (q[4], q[6], m2, 2);
+	AES_BITSLICED_SWAPMOVE (q[5], q[7], m2, 2);
+
+	AES_BITSLICED_SWAPMOVE (q[0], q[4], m4, 4);
+	AES_BITSLICED_SWAPMOVE (q[1], q[5], m4, 4);
+	AES_BITSLICED_SWAPMOVE (q[2], q[6], m4, 4);
+	AES_BITSLICED_SWAPMOVE (q[3], q[7], m4, 4);
+}
+
+
+// S-box circuit by J. Boyar and R. Peralta (q[7] holds the most significant bit)
+AES_BITSLICED_INLINE_FUNCTION void sub_bytes (__m128i *q)
+{
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7;
+	__m128i y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	__m128i y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	__m128i y20, y21;
+	__m128i z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	__m128i z10, z11, z12, z13, z14, z15, z16, z17;
+	__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	__m128i t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	__m128i t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	__m128i t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	__m128i t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	__m128i t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	__m128i t60, t61, t62, t63, t64, t65, t66, t67;
+	const __m128i ones = _mm_set1_epi8 ((char) 0xff);
+
+#define XOR _mm_xor_si128
+#define AND _mm_and_si128
+#define XNOR(a, b) _mm_xor_si128 (_mm_xor_si128 ((a), (b)), ones)
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	// Top linear transformation
+	y14 = XOR (x3, x5);
+	y13 = XOR (x0, x6);
+	y9 = XOR (x0, x3);
+	y8 = XOR (x0, x5);
+	t0 = XOR (x1, x2);
+	y1 = XOR (t0, x7);
+	y4 = XOR (y1, x3);
+	y12 = XOR (y13, y14);
+	y2 = XOR (y1, x0);
+	y5 = XOR (y1, x6);
+	y3 = XOR (y5, y8);
+	t1 = XOR (x4, y12);
+	y15 = XOR (t1, x5);
+	y20 = XOR (t1, x1);
+	y6 = XOR (y15, x7);
+	y10 = XOR (y15, t0);
+	y11 = XOR (y20, y9);
+	y7 = XOR (x7, y11);
+	y17 = XOR (y10, y11);
+	y19 = XOR (y10, y8);
+	y16 = XOR (t0, y11);
+	y21 = XOR (y13, y16);
+	y18 = XOR (x0, y16);
+
+	// Non-linear section
+	t2 = AND (y12, y15);
+	t3 = AND (y3, y6);
+	t4 = XOR (t3, t2);
+	t5 = AND (y4, x7);
+	t6 = XOR (t5, t2);
+	t7 = AND (y13, y16);
+	t8 = AND (y5, y1);
+	t9 = XOR (t8, t7);
+	t10 = AND (y2, y7);
+	t11 = XOR (t10, t7);
+	t12 = AND (y9, y11);
+	t13 = AND (y14, y17);
+	t14 = XOR (t13, t12);
+	t15 = AND (y8, y10);
+	t16 = XOR (t15, t12);
+	t17 = XOR (t4, t14);
+	t18 = XOR (t6, t16);
+	t19 = XOR (t9, t14);
+	t20 = XOR (t11, t16);
+	t21 = XOR (t17, y20);
+	t22 = XOR (t18, y19);
+	t23 = XOR (t19, y21);
+	t24 = XOR (t20, y18);
+
+	t25 = XOR (t21, t22);
+	t26 = AND (t21, t23);
+	t27 = XOR (t24, t26);
+	t28 = AND (t25, t27);
+	t29 = XOR (t28, t22);
+	t30 = XOR (t23, t24);
+	t31 = XOR (t22, t26);
+	t32 = AND (t31, t30);
+	t33 = XOR (t32, t24);
+	t34 = XOR (t23, t33);
+	t35 = XOR (t27, t33);
+	t36 = AND (t24, t35);
+	t37 = XOR (t36, t34);
+	t38 = XOR (t27, t36);
+	t39 = AND (t29, t38);
+	t40 = XOR (t25, t39);
+
+	t41 = XOR (t40, t37);
+	t42 = XOR (t29, t33);
+	t43 = XOR (t29, t40);
+	t44 = XOR (t33, t37);
+	t45 = XOR (t42, t41);
+	z0 = AND (t44, y15);
+	z1 = AND (t37, y6);
+	z2 = AND (t33, x7);
+	z3 = AND (t43, y16);
+	z4 = AND (t40, y1);
+	z5 = AND (t29, y7);
+	z6 = AND (t42, y11);
+	z7 = AND (t45, y17);
+	z8 = AND (t41, y10);
+	z9 = AND (t44, y12);
+	z10 = AND (t37, y3);
+	z11 = AND (t33, y4);
+	z12 = AND (t43, y13);
+	z13 = AND (t40, y5);
+	z14 = AND (t29, y2);
+	z15 = AND (t42, y9);
+	z16 = AND (t45, y14);
+	z17 = AND (t41, y8);
+
+	// Bottom linear transformation
+	t46 = XOR (z15, z16);
+	t47 = XOR (z10, z11);
+	t48 = XOR (z5, z13);
+	t49 = XOR (z9, z10);
+	t50 = XOR (z2, z12);
+	t51 = XOR (z2, z5);
+	t52 = XOR (z7, z8);
+	t53 = XOR (z0, z3);
+	t54 = XOR (z6, z7);
+	t55 = XOR (z16, z17);
+	t56 = XOR (z12, t48);
+	t57 = XOR (t50, t53);
+	t58 = XOR (z4, t46);
+	t59 = XOR (z3, t54);
+	t60 = XOR (t46, t57);
+	t61 = XOR (z14, t57);
+	t62 = XOR (t52, t58);
+	t63 = XOR (t49, t58);
+	t64 = XOR (z4, t59);
+	t65 = XOR (t61, t62);
+	t66 = XOR (z1, t63);
+	q[7] = XOR (t59, t63);
+	q[1] = XNOR (t56, t62);
+	q[0] = XNOR (t48, t60);
+	t67 = XOR (t64, t65);
+	q[4] = XOR (t53, t66);
+	q[3] = XOR (t51, t66);
+	q[2] = XOR (t47, t65);
+	q[6] = XNOR (t64, q[4]);
+	q[5] = XNOR (t55, t67);
+
+#undef XOR
+#undef AND
+#undef XNOR
+}
+
+
+// Inverse of the affine transformation of the S-box: b = (x <<< 1) ^ (x <<< 3) ^ (x <<< 6) ^ 0x05
+AES_BITSLICED_INLINE_FUNCTION void inverse_affine (__m128i *q)
+{
+	__m128i x[8];
+	const __m128i ones = _mm_set1_epi8 ((char) 0xff);
+	int i;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		x[i] = q[i];
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_xor_si128 (_mm_xor_si128 (x[(i + 7) & 7], x[(i + 5) & 7]), x[(i + 2) & 7]);
+
+	q[0] = _mm_xor_si128 (q[0], ones);
+	q[2] = _mm_xor_si128 (q[2], ones);
+}
+
+
+// The inverse S-box is the inverse affine transformation of the multiplicative inverse, which in turn
+// equals the inverse affine transformation of the S-box
+AES_BITSLICED_INLINE_FUNCTION void inverse_sub_bytes (__m128i *q)
+{
+	inverse_affine (q);
+	sub_bytes (q);
+	inverse_affine (q);
+}
+
+
+AES_BITSLICED_INLINE_FUNCTION void shuffle_planes (__m128i *q, __m128i indices)
+{
+	int i;
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_shuffle_epi8 (q[i], indices);
+}
+
+
+// State byte i is in row i % 4 and column i / 4
+AES_BITSLICED_INLINE_FUNCTION void shift_rows (__m128i *q)
+{
+	shuffle_planes (q, _mm_setr_epi8 (0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11));
+}
+
+
+AES_BITSLICED_INLINE_FUNCTION void inverse_shift_rows (__m128i *q)
+{
+	shuffle_planes (q, _mm_setr_epi8 (0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3));
+}
+
+
+// Multiplies each state byte by x in GF(2^8) (the modulus is x^8+x^4+x^3+x+1)
+AES_BITSLICED_INLINE_FUNCTION void multiply_by_x (__m128i *q)
+{
+	__m128i high = q[7];
+
+	q[7] = q[6];
+	q[6] = q[5];
+	q[5] = q[4];
+	q[4] = _mm_xor_si128 (q[3], high);
+	q[3] = _mm_xor_si128 (q[2], high);
+	q[2] = q[1];
+	q[1] = _mm_xor_si128 (q[0], high);
+	q[0] = high;
+}
+
+
+// b = a ^ rot1 (a); a' = 2 * b ^ rot1 (a) ^ rot2 (b), where rotN replaces each byte of a column with the byte N rows below
+AES_BITSLICED_INLINE_FUNCTION void mix_columns (__m128i *q)
+{
+	const __m128i rotate1 = _mm_setr_epi8 (1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+	const __m128i rotate2 = _mm_setr_epi8 (2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	__m128i r1[8], b[8];
+	int i;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+	{
+		r1[i] = _mm_shuffle_epi8 (q[i], rotate1);
+		b[i] = _mm_xor_si128 (q[i], r1[i]);
+		q[i] = _mm_xor_si128 (r1[i], _mm_shuffle_epi8 (b[i], rotate2));
+	}
+
+	multiply_by_x (b);
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_xor_si128 (q[i], b[i]);
+}
+
+
+// InvMixColumns (a) = MixColumns (a ^ 4 * (a ^ rot2 (a)))
+AES_BITSLICED_INLINE_FUNCTION void inverse_mix_columns (__m128i *q)
+{
+	const __m128i rotate2 = _mm_setr_epi8 (2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	__m128i u[8];
+	int i;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		u[i] = _mm_xor_si128 (q[i], _mm_shuffle_epi8 (q[i], rotate2));
+
+	multiply_by_x (u);
+	multiply_by_x (u);
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_xor_si128 (q[i], u[i]);
+
+	mix_columns (q);
+}
+
+
+AES_BITSLICED_INLINE_FUNCTION void add_round_key (__m128i *q, const byte roundKey[8][16])
+{
+	int i;
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_xor_si128 (q[i], _mm_loadu_si128 ((const __m128i *) roundKey[i]));
+}
+
+
+AES_BITSLICED_INLINE_FUNCTION void erase_planes (__m128i *q)
+{
+	volatile __m128i *p = q;
+	int i;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		p[i] = _mm_setzero_si128 ();
+}
+
+
+AES_BITSLICED_FUNCTION void encrypt_8_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out)
+{
+	__m128i q[8];
+	int i, round;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_loadu_si128 ((const __m128i *) in + i);
+
+	transpose (q);
+	add_round_key (q, ks->RoundKeys[0]);
+
+	for (round = 1; round < AES_BITSLICED_ROUND_KEY_COUNT - 1; ++round)
+	{
+		sub_bytes (q);
+		shift_rows (q);
+		mix_columns (q);
+		add_round_key (q, ks->RoundKeys[round]);
+	}
+
+	sub_bytes (q);
+	shift_rows (q);
+	add_round_key (q, ks->RoundKeys[AES_BITSLICED_ROUND_KEY_COUNT - 1]);
+	transpose (q);
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		_mm_storeu_si128 ((__m128i *) out + i, q[i]);
+
+	erase_planes (q);
+}
+
+
+AES_BITSLICED_FUNCTION void decrypt_8_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out)
+{
+	__m128i q[8];
+	int i, round;
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		q[i] = _mm_loadu_si128 ((const __m128i *) in + i);
+
+	transpose (q);
+	add_round_key (q, ks->RoundKeys[AES_BITSLICED_ROUND_KEY_COUNT - 1]);
+
+	for (round = AES_BITSLICED_ROUND_KEY_COUNT - 2; round > 0; --round)
+	{
+		inverse_shift_rows (q);
+		inverse_sub_bytes (q);
+		add_round_key (q, ks->RoundKeys[round]);
+		inverse_mix_columns (q);
+	}
+
+	inverse_shift_rows (q);
+	inverse_sub_bytes (q);
+	add_round_key (q, ks->RoundKeys[0]);
+	transpose (q);
+
+	AES_BITSLICED_UNROLL
+	for (i = 0; i < 8; ++i)
+		_mm_storeu_si128 ((__m128i *) out + i, q[i]);
+
+	erase_planes (q);
+}
+
+
+// Processes whole groups of eight blocks in place and pads the remaining blocks to eight
+#define AES_BITSLICED_PROCESS_BLOCKS(FUNCTION) \
+	do { \
+		for (; blockCount >= AES_BITSLICED_PARALLEL_BLOCKS; blockCount -= AES_BITSLICED_PARALLEL_BLOCKS) \
+		{ \
+			FUNCTION (ks, in, out); \
+			in += AES_BITSLICED_PARALLEL_BLOCKS * 16; \
+			out += AES_BITSLICED_PARALLEL_BLOCKS * 16; \
+		} \
+\
+		if (blockCount > 0) \
+		{ \
+			byte buffer[AES_BITSLICED_PARALLEL_BLOCKS * 16]; \
+			memset (buffer, 0, sizeof (buffer)); \
+			memcpy (buffer, in, blockCount * 16); \
+			FUNCTION (ks, buffer, buffer); \
+			memcpy (out, buffer, blockCount * 16); \
+			burn (buffer, sizeof (buffer)); \
+		} \
+	} while (0)
+
+
+int aes_bitsliced_supported ()
+{
+	return __builtin_cpu_supports ("ssse3") ? 1 : 0;
+}
+
+
+void aes_bitsliced_decrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount)
+{
+	AES_BITSLICED_PROCESS_BLOCKS (decrypt_8_blocks);
+}
+
+
+void aes_bitsliced_encrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount)
+{
+	AES_BITSLICED_PROCESS_BLOCKS (encrypt_8_blocks);
+}
+
+#else // AES_BITSLICED_SIMD
+
+int aes_bitsliced_supported ()
+{
+	return 0;
+}
+
+
+void aes_bitsliced_decrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount)
+{
+	TC_THROW_FATAL_EXCEPTION;
+}
+
+
+void aes_bitsliced_encrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount)
+{
+	TC_THROW_FATAL_EXCEPTION;
+}
+
+#endif // AES_BITSLICED_SIMD
+
+
+void aes_bitsliced_set_key (const aes_encrypt_ctx *encryptionKey, aes_bitsliced_ctx *ks)
+{
+	// The round keys of Aeskey.c are stored in the byte order of the cipher state
+	const byte *roundKeys = (const byte *) encryptionKey->ks;
+	int round, plane, i;
+
+	for (round = 0; round < AES_BITSLICED_ROUND_KEY_COUNT; ++round)
+	{
+		for (plane = 0; plane < 8; ++plane)
+		{
+			for (i = 0; i < 16; ++i)
+				ks->RoundKeys[round][plane][i] = (byte) (0 - ((roundKeys[round * 16 + i] >> plane) & 1));
+		}
+	}
+}
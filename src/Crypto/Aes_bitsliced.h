@@ -0,0 +1,40 @@
+/*
+ Copyright (c) 2010 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Crypto_Aes_Bitsliced
+#define TC_HEADER_Crypto_Aes_Bitsliced
+
+#include "../Common/Tcdefs.h"
+#include "Aes.h"
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+#define AES_BITSLICED_ROUND_KEY_COUNT	15
+
+// Each round key is stored as 8 bit planes of 16 bytes. A byte of plane k is 0xff if bit k of the
+// corresponding round key byte is set, and 0 otherwise.
+typedef struct
+{
+	byte RoundKeys[AES_BITSLICED_ROUND_KEY_COUNT][8][16];
+
+} aes_bitsliced_ctx;
+
+int aes_bitsliced_supported ();
+void aes_bitsliced_set_key (const aes_encrypt_ctx *encryptionKey, aes_bitsliced_ctx *ks);
+void aes_bitsliced_decrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount);
+void aes_bitsliced_encrypt_blocks (const aes_bitsliced_ctx *ks, const byte *in, byte *out, size_t blockCount);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // TC_HEADER_Crypto_Aes_Bitsliced
@@ -22,6 +22,8 @@ void aes_hw_cpu_decrypt (const byte *ks, byte *data);
 void aes_hw_cpu_decrypt_32_blocks (const byte *ks, byte *data);
 void aes_hw_cpu_encrypt (const byte *ks, byte *data);
 void aes_hw_cpu_encrypt_32_blocks (const byte *ks, byte *data);
+void aes_hw_cpu_decrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
+void aes_hw_cpu_encrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
 
 #if defined(__cplusplus)
 }
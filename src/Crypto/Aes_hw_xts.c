@@ -0,0 +1,202 @@
+/*
+ Copyright (c) 2010 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/* XTS-AES using AES-NI instructions. The whitening values are kept in SSE registers and
+several cipher blocks are processed in an interleaved manner in order to keep the pipelines
+of the AES units busy. The key schedules must be in the format used by Aes_hw_cpu.asm
+(i.e., 15 consecutive 16-byte round keys). The caller must ensure that the CPU supports AES-NI. */
+
+#include "Aes_hw_cpu.h"
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#if defined (__GNUC__) && !defined (__INTEL_COMPILER)
+#	define AES_HW_XTS_FUNCTION static __attribute__ ((target ("sse2,aes")))
+#else
+#	define AES_HW_XTS_FUNCTION static
+#endif
+
+#define AES_HW_XTS_ROUND_KEY_COUNT			15
+#define AES_HW_XTS_BLOCK_SIZE				16
+#define AES_HW_XTS_BLOCKS_PER_DATA_UNIT		(512 / AES_HW_XTS_BLOCK_SIZE)
+#define AES_HW_XTS_PARALLEL_BLOCKS			8
+
+
+typedef struct
+{
+	__m128i RoundKeys[AES_HW_XTS_ROUND_KEY_COUNT];
+	__m128i SecondaryRoundKeys[AES_HW_XTS_ROUND_KEY_COUNT];
+	__m128i WhiteningValue;
+	uint64 DataUnitNo;
+	unsigned int DataUnitBlock;
+
+} aes_hw_xts_state;
+
+
+AES_HW_XTS_FUNCTION void load_round_keys (__m128i *roundKeys, const byte *ks)
+{
+	int round;
+	for (round = 0; round < AES_HW_XTS_ROUND_KEY_COUNT; ++round)
+		roundKeys[round] = _mm_loadu_si128 ((const __m128i *) (ks + AES_HW_XTS_BLOCK_SIZE * round));
+}
+
+
+// Multiplies the whitening value by the primitive element 2 of GF(2^128) (the modulus is x^128+x^7+x^2+x+1)
+AES_HW_XTS_FUNCTION __m128i next_whitening_value (__m128i value)
+{
+	__m128i carry = _mm_srai_epi32 (value, 31);
+	carry = _mm_and_si128 (carry, _mm_set_epi32 (135, 1, 1, 1));
+	carry = _mm_shuffle_epi32 (carry, _MM_SHUFFLE (2, 1, 0, 3));
+
+	return _mm_xor_si128 (_mm_slli_epi32 (value, 1), carry);
+}
+
+
+AES_HW_XTS_FUNCTION __m128i encrypt_data_unit_no (const aes_hw_xts_state *state)
+{
+	int round;
+	__m128i block = _mm_set_epi32 (0, 0, (int) (uint32) (state->DataUnitNo >> 32), (int) (uint32) state->DataUnitNo);
+
+	block = _mm_xor_si128 (block, state->SecondaryRoundKeys[0]);
+
+	for (round = 1; round < AES_HW_XTS_ROUND_KEY_COUNT - 1; ++round)
+		block = _mm_aesenc_si128 (block, state->SecondaryRoundKeys[round]);
+
+	return _mm_aesenclast_si128 (block, state->SecondaryRoundKeys[AES_HW_XTS_ROUND_KEY_COUNT - 1]);
+}
+
+
+AES_HW_XTS_FUNCTION void init_state (aes_hw_xts_state *state, const byte *ks, const byte *ks2, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+{
+	unsigned int block;
+
+	load_round_keys (state->RoundKeys, ks);
+	load_round_keys (state->SecondaryRoundKeys, ks2);
+
+	state->DataUnitNo = startDataUnitNo;
+	state->DataUnitBlock = startCipherBlockNo;
+	state->WhiteningValue = encrypt_data_unit_no (state);
+
+	for (block = 0; block < startCipherBlockNo; ++block)
+		state->WhiteningValue = next_whitening_value (state->WhiteningValue);
+}
+
+
+// Returns the whitening value for the next cipher block and advances to the subsequent block
+AES_HW_XTS_FUNCTION __m128i get_whitening_value (aes_hw_xts_state *state)
+{
+	__m128i value;
+
+	if (state->DataUnitBlock == AES_HW_XTS_BLOCKS_PER_DATA_UNIT)
+	{
+		++state->DataUnitNo;
+		state->DataUnitBlock = 0;
+		state->WhiteningValue = encrypt_data_unit_no (state);
+	}
+
+	value = state->WhiteningValue;
+	state->WhiteningValue = next_whitening_value (value);
+	++state->DataUnitBlock;
+
+	return value;
+}
+
+
+AES_HW_XTS_FUNCTION void erase_state (aes_hw_xts_state *state)
+{
+	volatile byte *p = (volatile byte *) state;
+	size_t size = sizeof (*state);
+
+	while (size-- > 0)
+		*p++ = 0;
+}
+
+
+#define AES_HW_XTS_PROCESS_BLOCKS(OPERATION, BLOCK_COUNT) \
+	do { \
+		__m128i whiteningValues[BLOCK_COUNT]; \
+		__m128i blocks[BLOCK_COUNT]; \
+		int block, round; \
+\
+		for (block = 0; block < (BLOCK_COUNT); ++block) \
+		{ \
+			whiteningValues[block] = get_whitening_value (&state); \
+			blocks[block] = _mm_loadu_si128 ((const __m128i *) in + block); \
+			blocks[block] = _mm_xor_si128 (blocks[block], whiteningValues[block]); \
+			blocks[block] = _mm_xor_si128 (blocks[block], state.RoundKeys[0]); \
+		} \
+\
+		for (round = 1; round < AES_HW_XTS_ROUND_KEY_COUNT - 1; ++round) \
+		{ \
+			for (block = 0; block < (BLOCK_COUNT); ++block) \
+				blocks[block] = _mm_##OPERATION##_si128 (blocks[block], state.RoundKeys[round]); \
+		} \
+\
+		for (block = 0; block < (BLOCK_COUNT); ++block) \
+		{ \
+			blocks[block] = _mm_##OPERATION##last_si128 (blocks[block], state.RoundKeys[AES_HW_XTS_ROUND_KEY_COUNT - 1]); \
+			_mm_storeu_si128 ((__m128i *) out + block, _mm_xor_si128 (blocks[block], whiteningValues[block])); \
+		} \
+\
+		in += (BLOCK_COUNT) * AES_HW_XTS_BLOCK_SIZE; \
+		out += (BLOCK_COUNT) * AES_HW_XTS_BLOCK_SIZE; \
+	} while (0)
+
+
+// ks: the primary key schedule (encryption schedule for encryption, decryption schedule for decryption)
+// ks2: the secondary (encryption) key schedule
+// in, out: the input and output buffers, which may be identical (in-place processing) but must not overlap otherwise
+// length: number of bytes to process; must be divisible by the cipher block size
+// startDataUnitNo: the sequential number of the data unit with which the buffer starts
+// startCipherBlockNo: the sequential number of the first cipher block inside the data unit startDataUnitNo
+
+AES_HW_XTS_FUNCTION void encrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+{
+	aes_hw_xts_state state;
+	uint64 blockCount = length / AES_HW_XTS_BLOCK_SIZE;
+
+	init_state (&state, ks, ks2, startDataUnitNo, startCipherBlockNo);
+
+	for (; blockCount >= AES_HW_XTS_PARALLEL_BLOCKS; blockCount -= AES_HW_XTS_PARALLEL_BLOCKS)
+		AES_HW_XTS_PROCESS_BLOCKS (aesenc, AES_HW_XTS_PARALLEL_BLOCKS);
+
+	for (; blockCount > 0; --blockCount)
+		AES_HW_XTS_PROCESS_BLOCKS (aesenc, 1);
+
+	erase_state (&state);
+}
+
+
+AES_HW_XTS_FUNCTION void decrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+{
+	aes_hw_xts_state state;
+	uint64 blockCount = length / AES_HW_XTS_BLOCK_SIZE;
+
+	init_state (&state, ks, ks2, startDataUnitNo, startCipherBlockNo);
+
+	for (; blockCount >= AES_HW_XTS_PARALLEL_BLOCKS; blockCount -= AES_HW_XTS_PARALLEL_BLOCKS)
+		AES_HW_XTS_PROCESS_BLOCKS (aesdec, AES_HW_XTS_PARALLEL_BLOCKS);
+
+	for (; blockCount > 0; --blockCount)
+		AES_HW_XTS_PROCESS_BLOCKS (aesdec, 1);
+
+	erase_state (&state);
+}
+
+
+void aes_hw_cpu_encrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+{
+	encrypt_xts (ks, ks2, in, out, length, startDataUnitNo, startCipherBlockNo);
+}
+
+
+void aes_hw_cpu_decrypt_xts (const byte *ks, const byte *ks2, const byte *in, byte *out, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
+{
+	decrypt_xts (ks, ks2, in, out, length, startDataUnitNo, startCipherBlockNo);
+}
@@ -14,6 +14,11 @@
 #include "../Common/Endian.h"
 #include "Rmd160.h"
 
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__)) && !defined (TC_MINIMIZE_CODE_SIZE)
+#	define RMD160_SIMD
+#	include <immintrin.h>
+#endif
+
 #define F(x, y, z)    (x ^ y ^ z) 
 #define G(x, y, z)    (z ^ (x & (y^z)))
 #define H(x, y, z)    (z ^ (x | ~y))
@@ -36,6 +41,49 @@
 	(cp)[1] = (byte) ((value) >> 8);                                         \
 	(cp)[0] = (byte) (value); } while (0)
 
+#if defined (TC_MINIMIZE_CODE_SIZE) || defined (RMD160_SIMD)
+
+static const unsigned __int8 OrderTab[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13,
+	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+
+static const unsigned __int8 RolTab[] = {
+	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6,
+	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+
+static const unsigned __int32 KTab[] = {
+	0x00000000UL,
+	0x5A827999UL,
+	0x6ED9EBA1UL,
+	0x8F1BBCDCUL,
+	0xA953FD4EUL,
+	0x50A28BE6UL,
+	0x5C4DD124UL,
+	0x6D703EF3UL,
+	0x7A6D76E9UL,
+	0x00000000UL
+};
+
+#endif
+
 #ifndef TC_MINIMIZE_CODE_SIZE
 
 static byte PADDING[64] = {
@@ -372,6 +420,106 @@ void RMD160Transform (unsigned __int32 *digest, const unsigned __int32 *data)
 	digest[0] = c1;
 }
 
+#ifdef RMD160_SIMD
+
+/* Multi-buffer RIPEMD-160: word i of the message and of the working variables of eight
+independent hash states is held in the eight 32-bit elements of an AVX2 register. The left
+and right lines are computed in the same loop to provide more independent instructions. */
+
+#define RMD160_AVX2_LANES 8
+
+#define RMD160_X8_NOT(x) _mm256_xor_si256 ((x), _mm256_set1_epi32 (-1))
+
+#define RMD160_X8_LANES(v,i) _mm256_set_epi32 ((int) (v)[7][i], (int) (v)[6][i], (int) (v)[5][i], (int) (v)[4][i], \
+	(int) (v)[3][i], (int) (v)[2][i], (int) (v)[1][i], (int) (v)[0][i])
+
+#define RMD160_X8_ROTL(x,n) _mm256_or_si256 (_mm256_sll_epi32 ((x), _mm_cvtsi32_si128 (n)), _mm256_srl_epi32 ((x), _mm_cvtsi32_si128 (32 - (n))))
+
+static __attribute__ ((target ("avx2"))) __m256i RMD160X8Function (int round, __m256i x, __m256i y, __m256i z)
+{
+	switch (round)
+	{
+	case 0: case 9: return _mm256_xor_si256 (_mm256_xor_si256 (x, y), z);											// F
+	case 1: case 8: return _mm256_xor_si256 (z, _mm256_and_si256 (x, _mm256_xor_si256 (y, z)));					// G
+	case 2: case 7: return _mm256_xor_si256 (z, _mm256_or_si256 (x, RMD160_X8_NOT (y)));							// H
+	case 3: case 6: return _mm256_xor_si256 (y, _mm256_and_si256 (z, _mm256_xor_si256 (x, y)));					// I
+	default:		return _mm256_xor_si256 (x, _mm256_or_si256 (y, RMD160_X8_NOT (z)));							// J
+	}
+}
+
+static __attribute__ ((target ("avx2"))) void RMD160TransformAvx2 (unsigned __int32 *state[], const unsigned __int32 *data[], int lanes)
+{
+	__m256i x[16];
+	__m256i a1, b1, c1, d1, e1, a2, b2, c2, d2, e2, t;
+	unsigned __int32 *s[RMD160_AVX2_LANES];
+	const unsigned __int32 *d[RMD160_AVX2_LANES];
+	unsigned __int32 result[5][RMD160_AVX2_LANES];
+	int i, pos;
+
+	// Unused elements compute a copy of the first state
+	for (i = 0; i < RMD160_AVX2_LANES; ++i)
+	{
+		s[i] = state[i < lanes ? i : 0];
+		d[i] = data[i < lanes ? i : 0];
+	}
+
+	for (i = 0; i < 16; ++i)
+		x[i] = RMD160_X8_LANES (d, i);
+
+	a1 = a2 = RMD160_X8_LANES (s, 0);
+	b1 = b2 = RMD160_X8_LANES (s, 1);
+	c1 = c2 = RMD160_X8_LANES (s, 2);
+	d1 = d2 = RMD160_X8_LANES (s, 3);
+	e1 = e2 = RMD160_X8_LANES (s, 4);
+
+	for (pos = 0; pos < 80; ++pos)
+	{
+		int round = pos >> 4;
+
+		t = _mm256_add_epi32 (_mm256_add_epi32 (a1, x[OrderTab[pos]]), _mm256_add_epi32 (_mm256_set1_epi32 ((int) KTab[round]), RMD160X8Function (round, b1, c1, d1)));
+		t = _mm256_add_epi32 (RMD160_X8_ROTL (t, RolTab[pos]), e1);
+		a1 = e1; e1 = d1; d1 = RMD160_X8_ROTL (c1, 10); c1 = b1; b1 = t;
+
+		t = _mm256_add_epi32 (_mm256_add_epi32 (a2, x[OrderTab[pos + 80]]), _mm256_add_epi32 (_mm256_set1_epi32 ((int) KTab[round + 5]), RMD160X8Function (round + 5, b2, c2, d2)));
+		t = _mm256_add_epi32 (RMD160_X8_ROTL (t, RolTab[pos + 80]), e2);
+		a2 = e2; e2 = d2; d2 = RMD160_X8_ROTL (c2, 10); c2 = b2; b2 = t;
+	}
+
+	_mm256_storeu_si256 ((__m256i *) result[0], _mm256_add_epi32 (_mm256_add_epi32 (RMD160_X8_LANES (s, 1), c1), d2));
+	_mm256_storeu_si256 ((__m256i *) result[1], _mm256_add_epi32 (_mm256_add_epi32 (RMD160_X8_LANES (s, 2), d1), e2));
+	_mm256_storeu_si256 ((__m256i *) result[2], _mm256_add_epi32 (_mm256_add_epi32 (RMD160_X8_LANES (s, 3), e1), a2));
+	_mm256_storeu_si256 ((__m256i *) result[3], _mm256_add_epi32 (_mm256_add_epi32 (RMD160_X8_LANES (s, 4), a1), b2));
+	_mm256_storeu_si256 ((__m256i *) result[4], _mm256_add_epi32 (_mm256_add_epi32 (RMD160_X8_LANES (s, 0), b1), c2));
+
+	for (pos = 0; pos < lanes; ++pos)
+	{
+		state[pos][0] = result[0][pos];
+		state[pos][1] = result[1][pos];
+		state[pos][2] = result[2][pos];
+		state[pos][3] = result[3][pos];
+		state[pos][4] = result[4][pos];
+	}
+}
+
+#endif // RMD160_SIMD
+
+void RMD160TransformLanes (unsigned __int32 *state[], const unsigned __int32 *data[], int lanes)
+{
+	int i = 0;
+
+#ifdef RMD160_SIMD
+	if (lanes >= 2 && __builtin_cpu_supports ("avx2"))
+	{
+		for (; i < lanes; i += RMD160_AVX2_LANES)
+			RMD160TransformAvx2 (state + i, data + i, lanes - i < RMD160_AVX2_LANES ? lanes - i : RMD160_AVX2_LANES);
+		return;
+	}
+#endif
+
+	for (; i < lanes; ++i)
+		RMD160Transform (state[i], data[i]);
+}
+
 #else // TC_MINIMIZE_CODE_SIZE
 
 /*
@@ -390,46 +538,6 @@ typedef unsigned __int8 byte;
 #include <stdlib.h>
 #pragma intrinsic (_lrotl)
 
-static const byte OrderTab[] = {
-	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
-	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
-	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
-	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13,
-	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
-	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
-	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
-	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
-	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
-};
-
-static const byte RolTab[] = {
-	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
-	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
-	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
-	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
-	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6,
-	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
-	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
-	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
-	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
-	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
-};
-
-static const uint32 KTab[] = {
-	0x00000000UL,
-	0x5A827999UL,
-	0x6ED9EBA1UL,
-	0x8F1BBCDCUL,
-	0xA953FD4EUL,
-	0x50A28BE6UL,
-	0x5C4DD124UL,
-	0x6D703EF3UL,
-	0x7A6D76E9UL,
-	0x00000000UL
-};
-
-
 void RMD160Transform (unsigned __int32 *state, const unsigned __int32 *data)
 {
 	uint32 a, b, c, d, e;
@@ -26,6 +26,13 @@ void RMD160Transform (unsigned __int32 *state, const unsigned __int32 *data);
 void RMD160Update (RMD160_CTX *ctx, const unsigned char *input, unsigned __int32 len);
 void RMD160Final (unsigned char *digest, RMD160_CTX *ctx);
 
+#ifndef TC_MINIMIZE_CODE_SIZE
+// The number of hash states transformed in lockstep by RMD160TransformLanes
+#define RIPEMD160_MAX_LANES 8
+
+void RMD160TransformLanes (unsigned __int32 *state[], const unsigned __int32 *data[], int lanes);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
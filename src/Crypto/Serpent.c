@@ -941,3 +941,278 @@ start:
 }
 
 #endif // TC_MINIMIZE_CODE_SIZE && !TC_WINDOWS_BOOT_SERPENT
+
+
+#ifndef TC_MINIMIZE_CODE_SIZE
+
+/* Multi-block processing. On x86 and x64 CPUs, four (SSE2) or eight (AVX2) blocks are encrypted in parallel.
+The blocks are transposed so that each vector register holds the same 32-bit word of all blocks, which allows
+the S-box and linear transformation macros to be applied to the vectors unchanged. */
+
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__))
+#	define SERPENT_SIMD
+#endif
+
+#ifdef SERPENT_SIMD
+
+#include <immintrin.h>
+
+#undef rotlFixed
+#undef rotrFixed
+#define rotlFixed(x,n)   (((x) << (n)) | ((x) >> (32 - (n))))
+#define rotrFixed(x,n)   (((x) >> (n)) | ((x) << (32 - (n))))
+
+typedef unsigned __int32 serpent_u32x4 __attribute__ ((vector_size (16)));
+typedef unsigned __int32 serpent_u32x8 __attribute__ ((vector_size (32)));
+
+#define SERPENT_TRANSPOSE(PREFIX, VECTOR_TYPE, x0, x1, x2, x3) { \
+	VECTOR_TYPE t0 = PREFIX##_unpacklo_epi32 (x0, x1); \
+	VECTOR_TYPE t1 = PREFIX##_unpacklo_epi32 (x2, x3); \
+	VECTOR_TYPE t2 = PREFIX##_unpackhi_epi32 (x0, x1); \
+	VECTOR_TYPE t3 = PREFIX##_unpackhi_epi32 (x2, x3); \
+	x0 = PREFIX##_unpacklo_epi64 (t0, t1); \
+	x1 = PREFIX##_unpackhi_epi64 (t0, t1); \
+	x2 = PREFIX##_unpacklo_epi64 (t2, t3); \
+	x3 = PREFIX##_unpackhi_epi64 (t2, t3);}
+
+#define SERPENT_ENCRYPT_ROUNDS { \
+	do \
+	{ \
+		beforeS0(KX); beforeS0(S0); afterS0(LT); \
+		afterS0(KX); afterS0(S1); afterS1(LT); \
+		afterS1(KX); afterS1(S2); afterS2(LT); \
+		afterS2(KX); afterS2(S3); afterS3(LT); \
+		afterS3(KX); afterS3(S4); afterS4(LT); \
+		afterS4(KX); afterS4(S5); afterS5(LT); \
+		afterS5(KX); afterS5(S6); afterS6(LT); \
+		afterS6(KX); afterS6(S7); \
+\
+		if (i == 4) \
+			break; \
+\
+		++i; \
+		c = b; \
+		b = e; \
+		e = d; \
+		d = a; \
+		a = e; \
+		k += 32; \
+		beforeS0(LT); \
+	} \
+	while (1); \
+\
+	afterS7(KX);}
+
+#define SERPENT_DECRYPT_ROUNDS { \
+	beforeI7(KX); \
+	goto start; \
+\
+	do \
+	{ \
+		c = b; \
+		b = d; \
+		d = e; \
+		k -= 32; \
+		beforeI7(ILT); \
+start: \
+		beforeI7(I7); afterI7(KX); \
+		afterI7(ILT); afterI7(I6); afterI6(KX); \
+		afterI6(ILT); afterI6(I5); afterI5(KX); \
+		afterI5(ILT); afterI5(I4); afterI4(KX); \
+		afterI4(ILT); afterI4(I3); afterI3(KX); \
+		afterI3(ILT); afterI3(I2); afterI2(KX); \
+		afterI2(ILT); afterI2(I1); afterI1(KX); \
+		afterI1(ILT); afterI1(I0); afterI0(KX); \
+	} \
+	while (--i != 0);}
+
+#define SERPENT_LOAD_4_BLOCKS(in, x0, x1, x2, x3) { \
+	x0 = _mm_loadu_si128 ((const __m128i *) (in) + 0); \
+	x1 = _mm_loadu_si128 ((const __m128i *) (in) + 1); \
+	x2 = _mm_loadu_si128 ((const __m128i *) (in) + 2); \
+	x3 = _mm_loadu_si128 ((const __m128i *) (in) + 3); \
+	SERPENT_TRANSPOSE (_mm, __m128i, x0, x1, x2, x3);}
+
+#define SERPENT_STORE_4_BLOCKS(out, x0, x1, x2, x3) { \
+	SERPENT_TRANSPOSE (_mm, __m128i, x0, x1, x2, x3); \
+	_mm_storeu_si128 ((__m128i *) (out) + 0, x0); \
+	_mm_storeu_si128 ((__m128i *) (out) + 1, x1); \
+	_mm_storeu_si128 ((__m128i *) (out) + 2, x2); \
+	_mm_storeu_si128 ((__m128i *) (out) + 3, x3);}
+
+// Blocks n and n + 4 share a register (in the low and high 128-bit lane, respectively)
+#define SERPENT_LOAD_8_BLOCKS(in, x0, x1, x2, x3) { \
+	x0 = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in) + 0)), _mm_loadu_si128 ((const __m128i *) (in) + 4), 1); \
+	x1 = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in) + 1)), _mm_loadu_si128 ((const __m128i *) (in) + 5), 1); \
+	x2 = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in) + 2)), _mm_loadu_si128 ((const __m128i *) (in) + 6), 1); \
+	x3 = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in) + 3)), _mm_loadu_si128 ((const __m128i *) (in) + 7), 1); \
+	SERPENT_TRANSPOSE (_mm256, __m256i, x0, x1, x2, x3);}
+
+#define SERPENT_STORE_8_BLOCKS(out, x0, x1, x2, x3) { \
+	SERPENT_TRANSPOSE (_mm256, __m256i, x0, x1, x2, x3); \
+	_mm_storeu_si128 ((__m128i *) (out) + 0, _mm256_castsi256_si128 (x0)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 1, _mm256_castsi256_si128 (x1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 2, _mm256_castsi256_si128 (x2)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 3, _mm256_castsi256_si128 (x3)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 4, _mm256_extracti128_si256 (x0, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 5, _mm256_extracti128_si256 (x1, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 6, _mm256_extracti128_si256 (x2, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 7, _mm256_extracti128_si256 (x3, 1));}
+
+
+static __attribute__ ((target ("sse2"))) void serpent_encrypt_4_blocks (const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, unsigned __int8 *ks)
+{
+	serpent_u32x4 a, b, c, d, e;
+	__m128i x0, x1, x2, x3;
+	unsigned int i=1;
+	const unsigned __int32 *k = (unsigned __int32 *)ks + 8;
+
+	SERPENT_LOAD_4_BLOCKS (inBlocks, x0, x1, x2, x3);
+	a = (serpent_u32x4) x0;
+	b = (serpent_u32x4) x1;
+	c = (serpent_u32x4) x2;
+	d = (serpent_u32x4) x3;
+
+	SERPENT_ENCRYPT_ROUNDS;
+
+	x0 = (__m128i) d;
+	x1 = (__m128i) e;
+	x2 = (__m128i) b;
+	x3 = (__m128i) a;
+	SERPENT_STORE_4_BLOCKS (outBlocks, x0, x1, x2, x3);
+}
+
+static __attribute__ ((target ("sse2"))) void serpent_decrypt_4_blocks (const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, unsigned __int8 *ks)
+{
+	serpent_u32x4 a, b, c, d, e;
+	__m128i x0, x1, x2, x3;
+	unsigned int i=4;
+	const unsigned __int32 *k = (unsigned __int32 *)ks + 104;
+
+	SERPENT_LOAD_4_BLOCKS (inBlocks, x0, x1, x2, x3);
+	a = (serpent_u32x4) x0;
+	b = (serpent_u32x4) x1;
+	c = (serpent_u32x4) x2;
+	d = (serpent_u32x4) x3;
+
+	SERPENT_DECRYPT_ROUNDS;
+
+	x0 = (__m128i) a;
+	x1 = (__m128i) d;
+	x2 = (__m128i) b;
+	x3 = (__m128i) e;
+	SERPENT_STORE_4_BLOCKS (outBlocks, x0, x1, x2, x3);
+}
+
+static __attribute__ ((target ("avx2"))) void serpent_encrypt_8_blocks (const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, unsigned __int8 *ks)
+{
+	serpent_u32x8 a, b, c, d, e;
+	__m256i x0, x1, x2, x3;
+	unsigned int i=1;
+	const unsigned __int32 *k = (unsigned __int32 *)ks + 8;
+
+	SERPENT_LOAD_8_BLOCKS (inBlocks, x0, x1, x2, x3);
+	a = (serpent_u32x8) x0;
+	b = (serpent_u32x8) x1;
+	c = (serpent_u32x8) x2;
+	d = (serpent_u32x8) x3;
+
+	SERPENT_ENCRYPT_ROUNDS;
+
+	x0 = (__m256i) d;
+	x1 = (__m256i) e;
+	x2 = (__m256i) b;
+	x3 = (__m256i) a;
+	SERPENT_STORE_8_BLOCKS (outBlocks, x0, x1, x2, x3);
+}
+
+static __attribute__ ((target ("avx2"))) void serpent_decrypt_8_blocks (const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, unsigned __int8 *ks)
+{
+	serpent_u32x8 a, b, c, d, e;
+	__m256i x0, x1, x2, x3;
+	unsigned int i=4;
+	const unsigned __int32 *k = (unsigned __int32 *)ks + 104;
+
+	SERPENT_LOAD_8_BLOCKS (inBlocks, x0, x1, x2, x3);
+	a = (serpent_u32x8) x0;
+	b = (serpent_u32x8) x1;
+	c = (serpent_u32x8) x2;
+	d = (serpent_u32x8) x3;
+
+	SERPENT_DECRYPT_ROUNDS;
+
+	x0 = (__m256i) a;
+	x1 = (__m256i) d;
+	x2 = (__m256i) b;
+	x3 = (__m256i) e;
+	SERPENT_STORE_8_BLOCKS (outBlocks, x0, x1, x2, x3);
+}
+
+#endif // SERPENT_SIMD
+
+
+void serpent_encrypt_blocks(const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, size_t blockCount, unsigned __int8 *ks)
+{
+#ifdef SERPENT_SIMD
+	if (blockCount >= 8 && __builtin_cpu_supports ("avx2"))
+	{
+		for (; blockCount >= 8; blockCount -= 8)
+		{
+			serpent_encrypt_8_blocks (inBlocks, outBlocks, ks);
+			inBlocks += 8 * 16;
+			outBlocks += 8 * 16;
+		}
+	}
+
+	if (__builtin_cpu_supports ("sse2"))
+	{
+		for (; blockCount >= 4; blockCount -= 4)
+		{
+			serpent_encrypt_4_blocks (inBlocks, outBlocks, ks);
+			inBlocks += 4 * 16;
+			outBlocks += 4 * 16;
+		}
+	}
+#endif
+
+	while (blockCount-- > 0)
+	{
+		serpent_encrypt (inBlocks, outBlocks, ks);
+		inBlocks += 16;
+		outBlocks += 16;
+	}
+}
+
+void serpent_decrypt_blocks(const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, size_t blockCount, unsigned __int8 *ks)
+{
+#ifdef SERPENT_SIMD
+	if (blockCount >= 8 && __builtin_cpu_supports ("avx2"))
+	{
+		for (; blockCount >= 8; blockCount -= 8)
+		{
+			serpent_decrypt_8_blocks (inBlocks, outBlocks, ks);
+			inBlocks += 8 * 16;
+			outBlocks += 8 * 16;
+		}
+	}
+
+	if (__builtin_cpu_supports ("sse2"))
+	{
+		for (; blockCount >= 4; blockCount -= 4)
+		{
+			serpent_decrypt_4_blocks (inBlocks, outBlocks, ks);
+			inBlocks += 4 * 16;
+			outBlocks += 4 * 16;
+		}
+	}
+#endif
+
+	while (blockCount-- > 0)
+	{
+		serpent_decrypt (inBlocks, outBlocks, ks);
+		inBlocks += 16;
+		outBlocks += 16;
+	}
+}
+
+#endif // TC_MINIMIZE_CODE_SIZE
@@ -2,6 +2,7 @@
 #define HEADER_Crypto_Serpent
 
 #include "../Common/Tcdefs.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -11,6 +12,8 @@ extern "C"
 void serpent_set_key(const unsigned __int8 userKey[], int keylen, unsigned __int8 *ks);
 void serpent_encrypt(const unsigned __int8 *inBlock, unsigned __int8 *outBlock, unsigned __int8 *ks);
 void serpent_decrypt(const unsigned __int8 *inBlock,  unsigned __int8 *outBlock, unsigned __int8 *ks);
+void serpent_encrypt_blocks(const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, size_t blockCount, unsigned __int8 *ks);
+void serpent_decrypt_blocks(const unsigned __int8 *inBlocks, unsigned __int8 *outBlocks, size_t blockCount, unsigned __int8 *ks);
 
 #ifdef __cplusplus
 }
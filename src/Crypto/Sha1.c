@@ -35,6 +35,11 @@
 #include <string.h>     /* for memcpy() etc.        */
 #include <stdlib.h>     /* for _lrotl with VC++     */
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SHA1_SIMD       /* for multi-buffer SHA1    */
+#include <immintrin.h>
+#endif
+
 #include "Sha1.h"
 
 #if defined(__cplusplus)
@@ -193,6 +198,104 @@ void sha1_compile(sha1_ctx ctx[1])
 #endif
 }
 
+#ifdef SHA1_SIMD
+
+/* Multi-buffer SHA1: word i of the message schedule and of */
+/* the working variables of eight independent contexts is   */
+/* held in the eight 32-bit elements of an AVX2 register    */
+
+#define SHA1_AVX2_LANES     8
+
+#define add_x8(x,y)     _mm256_add_epi32((x), (y))
+#define rotl32_x8(x,n)  _mm256_or_si256(_mm256_slli_epi32((x), n), _mm256_srli_epi32((x), 32 - n))
+#define xor3_x8(x,y,z)  _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+
+#define ch_x8(x,y,z)        _mm256_xor_si256((z), _mm256_and_si256((x), _mm256_xor_si256((y), (z))))
+#define parity_x8(x,y,z)    xor3_x8((x), (y), (z))
+#define maj_x8(x,y,z)       _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256((z), _mm256_xor_si256((x), (y))))
+
+#define hf_x8(w,j)  ((j) < 16 ? (w)[(j) & 15] : ((w)[(j) & 15] = rotl32_x8(_mm256_xor_si256( \
+                        xor3_x8((w)[((j) + 13) & 15], (w)[((j) + 8) & 15], (w)[((j) + 2) & 15]), (w)[(j) & 15]), 1)))
+
+#define one_cycle_x8(a,b,c,d,e,f,k,j)                                               \
+    e = add_x8(add_x8(e, rotl32_x8(a, 5)), add_x8(add_x8(f(b, c, d),                \
+               _mm256_set1_epi32((int)(k))), hf_x8(w, j)));                         \
+    b = rotl32_x8(b, 30)
+
+#define five_cycle_x8(f,k,j)                                \
+    one_cycle_x8(v0, v1, v2, v3, v4, f, k, (j)    );        \
+    one_cycle_x8(v4, v0, v1, v2, v3, f, k, (j) + 1);        \
+    one_cycle_x8(v3, v4, v0, v1, v2, f, k, (j) + 2);        \
+    one_cycle_x8(v2, v3, v4, v0, v1, f, k, (j) + 3);        \
+    one_cycle_x8(v1, v2, v3, v4, v0, f, k, (j) + 4)
+
+#define lanes_x8(c,f,i) _mm256_set_epi32((int)(c)[7]->f[i], (int)(c)[6]->f[i], (int)(c)[5]->f[i], (int)(c)[4]->f[i], \
+                                         (int)(c)[3]->f[i], (int)(c)[2]->f[i], (int)(c)[1]->f[i], (int)(c)[0]->f[i])
+
+static __attribute__ ((target ("avx2"))) void sha1_compile_avx2(sha1_ctx *ctx[], int lanes)
+{   __m256i     w[16], v0, v1, v2, v3, v4;
+    sha1_ctx    *c[SHA1_AVX2_LANES];
+    sha1_32t    h[5][SHA1_AVX2_LANES];
+    int         i, j;
+
+    /* unused elements compute a copy of the first context  */
+    for(i = 0; i < SHA1_AVX2_LANES; ++i)
+        c[i] = ctx[i < lanes ? i : 0];
+
+    for(i = 0; i < 16; ++i)
+        w[i] = lanes_x8(c, wbuf, i);
+
+    v0 = lanes_x8(c, hash, 0); v1 = lanes_x8(c, hash, 1);
+    v2 = lanes_x8(c, hash, 2); v3 = lanes_x8(c, hash, 3);
+    v4 = lanes_x8(c, hash, 4);
+
+    for(j = 0; j < 20; j += 5)
+    {
+        five_cycle_x8(ch_x8, 0x5a827999, j);
+    }
+    for(; j < 40; j += 5)
+    {
+        five_cycle_x8(parity_x8, 0x6ed9eba1, j);
+    }
+    for(; j < 60; j += 5)
+    {
+        five_cycle_x8(maj_x8, 0x8f1bbcdc, j);
+    }
+    for(; j < 80; j += 5)
+    {
+        five_cycle_x8(parity_x8, 0xca62c1d6, j);
+    }
+
+    _mm256_storeu_si256((__m256i *)h[0], v0); _mm256_storeu_si256((__m256i *)h[1], v1);
+    _mm256_storeu_si256((__m256i *)h[2], v2); _mm256_storeu_si256((__m256i *)h[3], v3);
+    _mm256_storeu_si256((__m256i *)h[4], v4);
+
+    for(j = 0; j < lanes; ++j)
+        for(i = 0; i < 5; ++i)
+            ctx[j]->hash[i] += h[i][j];
+}
+
+#endif
+
+/* Compile one block of each of the given contexts, as if   */
+/* sha1_compile were called on each of them in turn         */
+
+void sha1_compile_lanes(sha1_ctx *ctx[], int lanes)
+{   int i = 0;
+
+#ifdef SHA1_SIMD
+    if(lanes >= 2 && __builtin_cpu_supports("avx2"))
+    {
+        for(; i < lanes; i += SHA1_AVX2_LANES)
+            sha1_compile_avx2(ctx + i, lanes - i < SHA1_AVX2_LANES ? lanes - i : SHA1_AVX2_LANES);
+        return;
+    }
+#endif
+
+    for(; i < lanes; ++i)
+        sha1_compile(ctx[i]);
+}
+
 void sha1_begin(sha1_ctx ctx[1])
 {
     ctx->count[0] = ctx->count[1] = 0;
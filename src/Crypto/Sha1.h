@@ -68,6 +68,11 @@ typedef struct
 
 void sha1_compile(sha1_ctx ctx[1]);
 
+/* The number of contexts compiled in lockstep by sha1_compile_lanes */
+#define SHA1_MAX_LANES  8
+
+void sha1_compile_lanes(sha1_ctx *ctx[], int lanes);
+
 void sha1_begin(sha1_ctx ctx[1]);
 void sha1_hash(const unsigned char data[], unsigned __int32 len, sha1_ctx ctx[1]);
 void sha1_end(unsigned char hval[], sha1_ctx ctx[1]);
@@ -78,6 +78,11 @@
 
 #include <string.h>     /* for memcpy() etc.        */
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SHA512_SIMD     /* for multi-buffer SHA512  */
+#include <immintrin.h>
+#endif
+
 #include "Sha2.h"
 
 #if defined(__cplusplus)
@@ -532,6 +537,100 @@ VOID_RETURN sha512_compile(sha512_ctx ctx[1])
     ctx->hash[6] += v[6]; ctx->hash[7] += v[7];
 }
 
+#ifdef SHA512_SIMD
+
+/* Multi-buffer SHA512: word i of the message schedule and of  */
+/* the working variables of four independent contexts is held */
+/* in the four 64-bit elements of an AVX2 register, so that    */
+/* each instruction advances the compression of all of them   */
+
+#define SHA512_AVX2_LANES   4
+
+#define add_x4(x,y)     _mm256_add_epi64((x), (y))
+#define rotr64_x4(x,n)  _mm256_or_si256(_mm256_srli_epi64((x), n), _mm256_slli_epi64((x), 64 - n))
+#define xor3_x4(x,y,z)  _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+
+#define ch_x4(x,y,z)    _mm256_xor_si256((z), _mm256_and_si256((x), _mm256_xor_si256((y), (z))))
+#define maj_x4(x,y,z)   _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256((z), _mm256_xor_si256((x), (y))))
+
+#define s_0_x4(x)   xor3_x4(rotr64_x4((x), 28), rotr64_x4((x), 34), rotr64_x4((x), 39))
+#define s_1_x4(x)   xor3_x4(rotr64_x4((x), 14), rotr64_x4((x), 18), rotr64_x4((x), 41))
+#define g_0_x4(x)   xor3_x4(rotr64_x4((x),  1), rotr64_x4((x),  8), _mm256_srli_epi64((x), 7))
+#define g_1_x4(x)   xor3_x4(rotr64_x4((x), 19), rotr64_x4((x), 61), _mm256_srli_epi64((x), 6))
+
+#define lanes_x4(c,f,i) _mm256_set_epi64x((long long)(c)[3]->f[i], (long long)(c)[2]->f[i], \
+                                          (long long)(c)[1]->f[i], (long long)(c)[0]->f[i])
+
+#define hf_x4(w,j)  ((j) < 16 ? (w)[(j) & 15] : ((w)[(j) & 15] = add_x4(add_x4((w)[(j) & 15], \
+                        g_1_x4((w)[((j) + 14) & 15])), add_x4((w)[((j) + 9) & 15], g_0_x4((w)[((j) + 1) & 15])))))
+
+#define v_cycle_x4(a,b,c,d,e,f,g,h,j)                                                      \
+    {   __m256i t = add_x4(add_x4(h, s_1_x4(e)), add_x4(ch_x4(e, f, g),                    \
+                           add_x4(_mm256_set1_epi64x((long long)k512[j]), hf_x4(w, j))));   \
+        d = add_x4(d, t);                                                                   \
+        h = add_x4(t, add_x4(s_0_x4(a), maj_x4(a, b, c))); }
+
+static __attribute__ ((target ("avx2"))) void sha512_compile_avx2(sha512_ctx *ctx[], int lanes)
+{   __m256i     w[16], a, b, c, d, e, f, g, h;
+    sha512_ctx  *cx[SHA512_AVX2_LANES];
+    uint_64t    v[8][SHA512_AVX2_LANES];
+    int         i, j;
+
+    /* unused elements compute a copy of the first context  */
+    for(i = 0; i < SHA512_AVX2_LANES; ++i)
+        cx[i] = ctx[i < lanes ? i : 0];
+
+    for(i = 0; i < 16; ++i)
+        w[i] = lanes_x4(cx, wbuf, i);
+
+    a = lanes_x4(cx, hash, 0); b = lanes_x4(cx, hash, 1);
+    c = lanes_x4(cx, hash, 2); d = lanes_x4(cx, hash, 3);
+    e = lanes_x4(cx, hash, 4); f = lanes_x4(cx, hash, 5);
+    g = lanes_x4(cx, hash, 6); h = lanes_x4(cx, hash, 7);
+
+    for(j = 0; j < 80; j += 8)
+    {
+        v_cycle_x4(a, b, c, d, e, f, g, h, j    );
+        v_cycle_x4(h, a, b, c, d, e, f, g, j + 1);
+        v_cycle_x4(g, h, a, b, c, d, e, f, j + 2);
+        v_cycle_x4(f, g, h, a, b, c, d, e, j + 3);
+        v_cycle_x4(e, f, g, h, a, b, c, d, j + 4);
+        v_cycle_x4(d, e, f, g, h, a, b, c, j + 5);
+        v_cycle_x4(c, d, e, f, g, h, a, b, j + 6);
+        v_cycle_x4(b, c, d, e, f, g, h, a, j + 7);
+    }
+
+    _mm256_storeu_si256((__m256i *)v[0], a); _mm256_storeu_si256((__m256i *)v[1], b);
+    _mm256_storeu_si256((__m256i *)v[2], c); _mm256_storeu_si256((__m256i *)v[3], d);
+    _mm256_storeu_si256((__m256i *)v[4], e); _mm256_storeu_si256((__m256i *)v[5], f);
+    _mm256_storeu_si256((__m256i *)v[6], g); _mm256_storeu_si256((__m256i *)v[7], h);
+
+    for(j = 0; j < lanes; ++j)
+        for(i = 0; i < 8; ++i)
+            ctx[j]->hash[i] += v[i][j];
+}
+
+#endif
+
+/* Compile one block of each of the given contexts, as if   */
+/* sha512_compile were called on each of them in turn       */
+
+VOID_RETURN sha512_compile_lanes(sha512_ctx *ctx[], int lanes)
+{   int i = 0;
+
+#ifdef SHA512_SIMD
+    if(lanes >= 2 && __builtin_cpu_supports("avx2"))
+    {
+        for(; i < lanes; i += SHA512_AVX2_LANES)
+            sha512_compile_avx2(ctx + i, lanes - i < SHA512_AVX2_LANES ? lanes - i : SHA512_AVX2_LANES);
+        return;
+    }
+#endif
+
+    for(; i < lanes; ++i)
+        sha512_compile(ctx[i]);
+}
+
 /* Compile 128 bytes of hash data into SHA256 digest value  */
 /* NOTE: this routine assumes that the byte order in the    */
 /* ctx->wbuf[] at this point is in such an order that low   */
@@ -131,6 +131,11 @@ typedef struct
 
 VOID_RETURN sha512_compile(sha512_ctx ctx[1]);
 
+/* The number of contexts compiled in lockstep by sha512_compile_lanes  */
+#define SHA512_MAX_LANES    4
+
+VOID_RETURN sha512_compile_lanes(sha512_ctx *ctx[], int lanes);
+
 VOID_RETURN sha384_begin(sha384_ctx ctx[1]);
 #define sha384_hash sha512_hash
 VOID_RETURN sha384_end(unsigned char hval[], sha384_ctx ctx[1]);
@@ -546,3 +546,174 @@ void twofish_decrypt(TwofishInstance *instance, const u4byte in_blk[4], u4byte o
 };
 
 #endif // TC_MINIMIZE_CODE_SIZE
+
+
+#ifndef TC_MINIMIZE_CODE_SIZE
+
+/* Multi-block processing. On x86 and x64 CPUs supporting AVX2, eight blocks are processed in parallel. The
+blocks are transposed so that each vector register holds the same 32-bit word of all blocks, and the key-dependent
+S-box lookups are performed using gather instructions. */
+
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__))
+#	define TWOFISH_SIMD
+#endif
+
+#ifdef TWOFISH_SIMD
+
+#include <immintrin.h>
+
+#define TWOFISH_TRANSPOSE(x0, x1, x2, x3) { \
+	__m256i u0 = _mm256_unpacklo_epi32 (x0, x1); \
+	__m256i u1 = _mm256_unpacklo_epi32 (x2, x3); \
+	__m256i u2 = _mm256_unpackhi_epi32 (x0, x1); \
+	__m256i u3 = _mm256_unpackhi_epi32 (x2, x3); \
+	x0 = _mm256_unpacklo_epi64 (u0, u1); \
+	x1 = _mm256_unpackhi_epi64 (u0, u1); \
+	x2 = _mm256_unpacklo_epi64 (u2, u3); \
+	x3 = _mm256_unpackhi_epi64 (u2, u3);}
+
+// Blocks n and n + 4 share a register (in the low and high 128-bit lane, respectively)
+#define TWOFISH_LOAD_BLOCKS(in, blk) { \
+	int j; \
+	for (j = 0; j < 4; ++j) \
+		blk[j] = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) (in) + j)), _mm_loadu_si128 ((const __m128i *) (in) + j + 4), 1); \
+	TWOFISH_TRANSPOSE (blk[0], blk[1], blk[2], blk[3]);}
+
+#define TWOFISH_STORE_BLOCKS(out, x0, x1, x2, x3) { \
+	TWOFISH_TRANSPOSE (x0, x1, x2, x3); \
+	_mm_storeu_si128 ((__m128i *) (out) + 0, _mm256_castsi256_si128 (x0)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 1, _mm256_castsi256_si128 (x1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 2, _mm256_castsi256_si128 (x2)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 3, _mm256_castsi256_si128 (x3)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 4, _mm256_extracti128_si256 (x0, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 5, _mm256_extracti128_si256 (x1, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 6, _mm256_extracti128_si256 (x2, 1)); \
+	_mm_storeu_si128 ((__m128i *) (out) + 7, _mm256_extracti128_si256 (x3, 1));}
+
+#define v_xor(x,y)		_mm256_xor_si256 (x, y)
+#define v_add(x,y)		_mm256_add_epi32 (x, y)
+#define v_rotl(x,n)		_mm256_or_si256 (_mm256_slli_epi32 (x, n), _mm256_srli_epi32 (x, 32 - (n)))
+#define v_rotr(x,n)		_mm256_or_si256 (_mm256_srli_epi32 (x, n), _mm256_slli_epi32 (x, 32 - (n)))
+#define v_key(i)		_mm256_set1_epi32 ((int) l_key[i])
+
+// mk_tab[n + 4 * extract_byte(x,b)]
+#define v_mk_tab(x,b,n)	_mm256_i32gather_epi32 ((const int *) mk_tab + (n), \
+	(b) == 3 ? _mm256_slli_epi32 (_mm256_srli_epi32 (x, 24), 2) : _mm256_slli_epi32 (_mm256_and_si256 (_mm256_srli_epi32 (x, 8 * (b)), byteMask), 2), 4)
+
+#define v_g0_fun(x)		v_xor (v_xor (v_mk_tab (x,0,0), v_mk_tab (x,1,1)), v_xor (v_mk_tab (x,2,2), v_mk_tab (x,3,3)))
+#define v_g1_fun(x)		v_xor (v_xor (v_mk_tab (x,3,0), v_mk_tab (x,0,1)), v_xor (v_mk_tab (x,1,2), v_mk_tab (x,2,3)))
+
+#define v_f_rnd(i)                                                                          \
+    t1 = v_g1_fun(blk[1]); t0 = v_g0_fun(blk[0]);                                           \
+    blk[2] = v_rotr(v_xor (blk[2], v_add (v_add (t0, t1), v_key(4 * (i) + 8))), 1);         \
+    blk[3] = v_xor (v_rotl(blk[3], 1), v_add (v_add (t0, v_add (t1, t1)), v_key(4 * (i) + 9))); \
+    t1 = v_g1_fun(blk[3]); t0 = v_g0_fun(blk[2]);                                           \
+    blk[0] = v_rotr(v_xor (blk[0], v_add (v_add (t0, t1), v_key(4 * (i) + 10))), 1);        \
+    blk[1] = v_xor (v_rotl(blk[1], 1), v_add (v_add (t0, v_add (t1, t1)), v_key(4 * (i) + 11)))
+
+#define v_i_rnd(i)                                                                          \
+    t1 = v_g1_fun(blk[1]); t0 = v_g0_fun(blk[0]);                                           \
+    blk[2] = v_xor (v_rotl(blk[2], 1), v_add (v_add (t0, t1), v_key(4 * (i) + 10)));        \
+    blk[3] = v_rotr(v_xor (blk[3], v_add (v_add (t0, v_add (t1, t1)), v_key(4 * (i) + 11))), 1); \
+    t1 = v_g1_fun(blk[3]); t0 = v_g0_fun(blk[2]);                                           \
+    blk[0] = v_xor (v_rotl(blk[0], 1), v_add (v_add (t0, t1), v_key(4 * (i) +  8)));        \
+    blk[1] = v_rotr(v_xor (blk[1], v_add (v_add (t0, v_add (t1, t1)), v_key(4 * (i) +  9))), 1)
+
+static __attribute__ ((target ("avx2"))) void twofish_encrypt_8_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk)
+{   __m256i t0, t1, blk[4];
+	const __m256i byteMask = _mm256_set1_epi32 (0xff);
+
+	u4byte *l_key = instance->l_key;
+	u4byte *mk_tab = instance->mk_tab;
+
+	TWOFISH_LOAD_BLOCKS (in_blk, blk);
+
+	blk[0] = v_xor (blk[0], v_key(0));
+	blk[1] = v_xor (blk[1], v_key(1));
+	blk[2] = v_xor (blk[2], v_key(2));
+	blk[3] = v_xor (blk[3], v_key(3));
+
+	v_f_rnd(0); v_f_rnd(1); v_f_rnd(2); v_f_rnd(3);
+	v_f_rnd(4); v_f_rnd(5); v_f_rnd(6); v_f_rnd(7);
+
+	t0 = v_xor (blk[2], v_key(4));
+	t1 = v_xor (blk[3], v_key(5));
+	blk[2] = v_xor (blk[0], v_key(6));
+	blk[3] = v_xor (blk[1], v_key(7));
+
+	TWOFISH_STORE_BLOCKS (out_blk, t0, t1, blk[2], blk[3]);
+}
+
+static __attribute__ ((target ("avx2"))) void twofish_decrypt_8_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk)
+{   __m256i t0, t1, blk[4];
+	const __m256i byteMask = _mm256_set1_epi32 (0xff);
+
+	u4byte *l_key = instance->l_key;
+	u4byte *mk_tab = instance->mk_tab;
+
+	TWOFISH_LOAD_BLOCKS (in_blk, blk);
+
+	blk[0] = v_xor (blk[0], v_key(4));
+	blk[1] = v_xor (blk[1], v_key(5));
+	blk[2] = v_xor (blk[2], v_key(6));
+	blk[3] = v_xor (blk[3], v_key(7));
+
+	v_i_rnd(7); v_i_rnd(6); v_i_rnd(5); v_i_rnd(4);
+	v_i_rnd(3); v_i_rnd(2); v_i_rnd(1); v_i_rnd(0);
+
+	t0 = v_xor (blk[2], v_key(0));
+	t1 = v_xor (blk[3], v_key(1));
+	blk[2] = v_xor (blk[0], v_key(2));
+	blk[3] = v_xor (blk[1], v_key(3));
+
+	TWOFISH_STORE_BLOCKS (out_blk, t0, t1, blk[2], blk[3]);
+}
+
+#endif // TWOFISH_SIMD
+
+
+void twofish_encrypt_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk, size_t blockCount)
+{
+#ifdef TWOFISH_SIMD
+	if (blockCount >= 8 && __builtin_cpu_supports ("avx2"))
+	{
+		for (; blockCount >= 8; blockCount -= 8)
+		{
+			twofish_encrypt_8_blocks (instance, in_blk, out_blk);
+			in_blk += 8 * 16;
+			out_blk += 8 * 16;
+		}
+	}
+#endif
+
+	while (blockCount-- > 0)
+	{
+		twofish_encrypt (instance, (const u4byte *) in_blk, (u4byte *) out_blk);
+		in_blk += 16;
+		out_blk += 16;
+	}
+}
+
+void twofish_decrypt_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk, size_t blockCount)
+{
+#ifdef TWOFISH_SIMD
+	if (blockCount >= 8 && __builtin_cpu_supports ("avx2"))
+	{
+		for (; blockCount >= 8; blockCount -= 8)
+		{
+			twofish_decrypt_8_blocks (instance, in_blk, out_blk);
+			in_blk += 8 * 16;
+			out_blk += 8 * 16;
+		}
+	}
+#endif
+
+	while (blockCount-- > 0)
+	{
+		twofish_decrypt (instance, (const u4byte *) in_blk, (u4byte *) out_blk);
+		in_blk += 16;
+		out_blk += 16;
+	}
+}
+
+#endif // TC_MINIMIZE_CODE_SIZE
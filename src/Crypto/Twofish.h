@@ -2,6 +2,7 @@
 #define TWOFISH_H
 
 #include "../Common/Tcdefs.h"
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -47,6 +48,8 @@ typedef struct
 u4byte * twofish_set_key(TwofishInstance *instance, const u4byte in_key[], const u4byte key_len);
 void twofish_encrypt(TwofishInstance *instance, const u4byte in_blk[4], u4byte out_blk[]);
 void twofish_decrypt(TwofishInstance *instance, const u4byte in_blk[4], u4byte out_blk[4]);
+void twofish_encrypt_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk, size_t blockCount);
+void twofish_decrypt_blocks(TwofishInstance *instance, const u1byte *in_blk, u1byte *out_blk, size_t blockCount);
 
 #if defined(__cplusplus)
 }
@@ -126,12 +126,20 @@ typedef signed long long s64;
 #define LENGTHBYTES 32
 #define LENGTHBITS  (8*LENGTHBYTES) /* 256 */
 
+#define WHIRLPOOL_ROUNDS 10
+
+/*
+ * Round keys K^1 .. K^R derived from a hashing state.
+ */
+typedef u64 WHIRLPOOL_KEY_SCHEDULE[WHIRLPOOL_ROUNDS][DIGESTBYTES/8];
+
 typedef struct NESSIEstruct {
 	u8  bitLength[LENGTHBYTES]; /* global number of hashed bits (256-bit counter) */
 	u8  buffer[WBLOCKBYTES];	/* buffer of data to hash */
 	int bufferBits;		        /* current number of bits on the buffer */
 	int bufferPos;		        /* current (possibly incomplete) byte slot on the buffer */
 	u64 hash[DIGESTBYTES/8];    /* the hashing state */
+	const u64 (*keySchedule)[DIGESTBYTES/8]; /* key schedule of the hashing state, or NULL */
 } NESSIEstruct;
 
 #endif   /* PORTABLE_C__ */
@@ -141,6 +149,7 @@ typedef struct NESSIEstruct {
 typedef NESSIEstruct WHIRLPOOL_CTX;
 
 void WHIRLPOOL_add(const unsigned char * const source, unsigned __int32 sourceBits, struct NESSIEstruct * const structpointer);
+void WHIRLPOOL_expand_key(struct NESSIEstruct * const structpointer, WHIRLPOOL_KEY_SCHEDULE keySchedule);
 void WHIRLPOOL_finalize(struct NESSIEstruct * const structpointer, unsigned char * const result);
 void WHIRLPOOL_init(struct NESSIEstruct * const structpointer); 
 
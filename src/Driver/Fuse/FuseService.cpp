@@ -6,11 +6,19 @@
  packages.
 */
 
-#define FUSE_USE_VERSION  25
+#ifdef TC_FUSE3
+#	define FUSE_USE_VERSION  32
+#else
+#	define FUSE_USE_VERSION  25
+#endif
 #include <errno.h>
 #include <fcntl.h>
 #ifndef CS_UNITTESTING
-#include <fuse.h>
+#	ifdef TC_FUSE3
+#		include <fuse_lowlevel.h>
+#	else
+#		include <fuse.h>
+#	endif
 #endif
 #include <iostream>
 #include <signal.h>
@@ -34,6 +42,7 @@
 
 namespace CipherShed
 {
+#ifndef TC_FUSE3
 	static int fuse_service_access (const char *path, int mask)
 	{
 		try
@@ -48,6 +57,7 @@ namespace CipherShed
 
 		return 0;
 	}
+#endif
 
 	static void *fuse_service_init ()
 	{
@@ -64,6 +74,8 @@ namespace CipherShed
 
 			if (!EncryptionThreadPool::IsRunning())
 				EncryptionThreadPool::Start();
+
+			FuseService::StartReadCache();
 		}
 		catch (exception &e)
 		{
@@ -93,6 +105,23 @@ namespace CipherShed
 		}
 	}
 
+	static void fuse_service_get_control_attributes (struct stat *statData)
+	{
+		uint64 version;
+		statData->st_mode = S_IFREG | 0600;
+		statData->st_nlink = 1;
+		statData->st_size = FuseService::GetVolumeInfo (version)->Size();
+
+		// The modification time identifies the version of the volume information to allow clients to skip unchanged data
+		statData->st_ctime = statData->st_mtime = version / 1000000000ULL;
+#ifdef TC_MACOSX
+		statData->st_ctimespec.tv_nsec = statData->st_mtimespec.tv_nsec = version % 1000000000ULL;
+#else
+		statData->st_ctim.tv_nsec = statData->st_mtim.tv_nsec = version % 1000000000ULL;
+#endif
+	}
+
+#ifndef TC_FUSE3
 	static int fuse_service_getattr (const char *path, struct stat *statData)
 	{
 		try
@@ -123,9 +152,7 @@ namespace CipherShed
 				}
 				else if (strcmp (path, FuseService::GetControlPath()) == 0)
 				{
-					statData->st_mode = S_IFREG | 0600;
-					statData->st_nlink = 1;
-					statData->st_size = FuseService::GetVolumeInfo()->Size();
+					fuse_service_get_control_attributes (statData);
 				}
 				else
 				{
@@ -190,42 +217,7 @@ namespace CipherShed
 				return -EACCES;
 
 			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
-			{
-				try
-				{
-					// Test for read beyond the end of the volume
-					if ((uint64) offset + size > FuseService::GetVolumeSize())
-						size = FuseService::GetVolumeSize() - offset;
-
-					size_t sectorSize = FuseService::GetVolumeSectorSize();
-					if (size % sectorSize != 0 || offset % sectorSize != 0)
-					{
-						// Support for non-sector-aligned read operations is required by some loop device tools
-						// which may analyze the volume image before attaching it as a device
-
-						uint64 alignedOffset = offset - (offset % sectorSize);
-						uint64 alignedSize = size + (offset % sectorSize);
-
-						if (alignedSize % sectorSize != 0)
-							alignedSize += sectorSize - (alignedSize % sectorSize);
-
-						SecureBuffer alignedBuffer (alignedSize);
-
-						FuseService::ReadVolumeSectors (alignedBuffer, alignedOffset);
-						BufferPtr ((byte *) buf, size).CopyFrom (alignedBuffer.GetRange (offset % sectorSize, size));
-					}
-					else
-					{
-						FuseService::ReadVolumeSectors (BufferPtr ((byte *) buf, size), offset);
-					}
-				}
-				catch (MissingVolumeData)
-				{
-					return 0;
-				}
-
-				return size;
-			}
+				return FuseService::ReadVolumeImage (BufferPtr ((byte *) buf, size), offset);
 
 			if (strcmp (path, FuseService::GetControlPath()) == 0)
 			{
@@ -314,13 +306,403 @@ namespace CipherShed
 		return -ENOENT;
 	}
 
+#else // TC_FUSE3
+
+	struct FuseServiceInode
+	{
+		enum
+		{
+			Root = FUSE_ROOT_ID,
+			VolumeImage,
+			Control
+		};
+	};
+
+	static const double FuseServiceAttributeTimeout = 1.0;
+
+	static int fuse_service_ll_get_attributes (fuse_req_t req, fuse_ino_t ino, struct stat *statData)
+	{
+		Memory::Zero (statData, sizeof(*statData));
+
+		statData->st_ino = ino;
+		statData->st_uid = FuseService::GetUserId();
+		statData->st_gid = FuseService::GetGroupId();
+		statData->st_atime = time (NULL);
+		statData->st_ctime = time (NULL);
+		statData->st_mtime = time (NULL);
+
+		if (ino == FuseServiceInode::Root)
+		{
+			statData->st_mode = S_IFDIR | 0500;
+			statData->st_nlink = 2;
+			return 0;
+		}
+
+		if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+			return EACCES;
+
+		switch (ino)
+		{
+		case FuseServiceInode::VolumeImage:
+			statData->st_mode = S_IFREG | 0600;
+			statData->st_nlink = 1;
+			statData->st_size = FuseService::GetVolumeSize();
+			return 0;
+
+		case FuseServiceInode::Control:
+			fuse_service_get_control_attributes (statData);
+			return 0;
+
+		default:
+			return ENOENT;
+		}
+	}
+
+	static void fuse_service_ll_init (void *userdata, struct fuse_conn_info *conn)
+	{
+		// Large requests reduce the per-request overhead of the loop device attached to the volume image.
+		// The values are reduced by the library to the limits of the kernel.
+		conn->max_write = FuseService::MaxIoSize;
+		conn->max_readahead = FuseService::MaxIoSize;
+
+		// Data is transferred by splicing when supported by the kernel
+		if (conn->capable & FUSE_CAP_SPLICE_READ)
+			conn->want |= FUSE_CAP_SPLICE_READ;
+
+		if (conn->capable & FUSE_CAP_SPLICE_WRITE)
+			conn->want |= FUSE_CAP_SPLICE_WRITE;
+
+		if (conn->capable & FUSE_CAP_SPLICE_MOVE)
+			conn->want |= FUSE_CAP_SPLICE_MOVE;
+
+		fuse_service_init ();
+	}
+
+	static void fuse_service_ll_access (fuse_req_t req, fuse_ino_t ino, int mask)
+	{
+		int error = 0;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+				error = EACCES;
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		fuse_reply_err (req, error);
+	}
+
+	static void fuse_service_ll_getattr (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+	{
+		struct stat statData;
+		int error;
+
+		try
+		{
+			error = fuse_service_ll_get_attributes (req, ino, &statData);
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		if (error != 0)
+			fuse_reply_err (req, error);
+		else
+			fuse_reply_attr (req, &statData, FuseServiceAttributeTimeout);
+	}
+
+	static void fuse_service_ll_lookup (fuse_req_t req, fuse_ino_t parent, const char *name)
+	{
+		struct fuse_entry_param entry;
+		Memory::Zero (&entry, sizeof (entry));
+		int error;
+
+		try
+		{
+			if (parent == FuseServiceInode::Root)
+			{
+				if (strcmp (name, FuseService::GetVolumeImagePath() + 1) == 0)
+					entry.ino = FuseServiceInode::VolumeImage;
+				else if (strcmp (name, FuseService::GetControlPath() + 1) == 0)
+					entry.ino = FuseServiceInode::Control;
+			}
+
+			error = entry.ino != 0 ? fuse_service_ll_get_attributes (req, entry.ino, &entry.attr) : ENOENT;
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		entry.attr_timeout = FuseServiceAttributeTimeout;
+		entry.entry_timeout = FuseServiceAttributeTimeout;
+
+		if (error != 0)
+			fuse_reply_err (req, error);
+		else
+			fuse_reply_entry (req, &entry);
+	}
+
+	static void fuse_service_ll_opendir (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+	{
+		int error = 0;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+				error = EACCES;
+			else if (ino != FuseServiceInode::Root)
+				error = ENOTDIR;
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		if (error != 0)
+			fuse_reply_err (req, error);
+		else
+			fuse_reply_open (req, fi);
+	}
+
+	static void fuse_service_ll_open (fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+	{
+		int error = 0;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+				error = EACCES;
+			else if (ino == FuseServiceInode::Control)
+				fi->direct_io = 1;
+			else if (ino == FuseServiceInode::Root)
+				error = EISDIR;
+			else if (ino != FuseServiceInode::VolumeImage)
+				error = ENOENT;
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		if (error != 0)
+			fuse_reply_err (req, error);
+		else
+			fuse_reply_open (req, fi);
+	}
+
+	static void fuse_service_ll_read (fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		int error = ENOENT;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+			{
+				error = EACCES;
+			}
+			else if (ino == FuseServiceInode::VolumeImage)
+			{
+				// Sectors are decrypted to a scratch buffer reused by subsequent requests. The data is copied to the
+				// reply, as pages moved to the kernel could not be erased.
+				PooledSecureBuffer buffer (FuseService::GetScratchBufferPool(), size);
+				finally_do_arg (BufferPtr, buffer, { finally_arg.Erase(); });
+
+				size_t readSize = FuseService::ReadVolumeImage (buffer, offset);
+
+				struct fuse_bufvec bufVec = FUSE_BUFVEC_INIT (readSize);
+				bufVec.buf[0].mem = buffer.Ptr();
+
+				fuse_reply_data (req, &bufVec, (enum fuse_buf_copy_flags) 0);
+				return;
+			}
+			else if (ino == FuseServiceInode::Control)
+			{
+				shared_ptr <Buffer> infoBuf = FuseService::GetVolumeInfo();
+
+				if (offset >= (off_t) infoBuf->Size())
+					size = 0;
+				else if (offset + size > infoBuf->Size())
+					size = infoBuf->Size () - offset;
+
+				fuse_reply_buf (req, (const char *) infoBuf->Ptr() + (size > 0 ? offset : 0), size);
+				return;
+			}
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		fuse_reply_err (req, error);
+	}
+
+	static void fuse_service_ll_readdir (fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		int error = 0;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+			{
+				error = EACCES;
+			}
+			else if (ino != FuseServiceInode::Root)
+			{
+				error = ENOTDIR;
+			}
+			else
+			{
+				const char *names[] = { ".", "..", FuseService::GetVolumeImagePath() + 1, FuseService::GetControlPath() + 1 };
+				const fuse_ino_t inodes[] = { FuseServiceInode::Root, FuseServiceInode::Root, FuseServiceInode::VolumeImage, FuseServiceInode::Control };
+
+				Buffer entries (size > 0 ? size : 1);
+				size_t entriesSize = 0;
+
+				for (size_t i = (size_t) offset; i < sizeof (names) / sizeof (names[0]); ++i)
+				{
+					struct stat statData;
+					Memory::Zero (&statData, sizeof (statData));
+					statData.st_ino = inodes[i];
+					statData.st_mode = (inodes[i] == FuseServiceInode::Root ? S_IFDIR : S_IFREG);
+
+					size_t entrySize = fuse_add_direntry (req, (char *) entries.Ptr() + entriesSize, size - entriesSize, names[i], &statData, i + 1);
+					if (entrySize > size - entriesSize)
+						break;
+
+					entriesSize += entrySize;
+				}
+
+				fuse_reply_buf (req, (const char *) entries.Ptr(), entriesSize);
+				return;
+			}
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		fuse_reply_err (req, error);
+	}
+
+	static void fuse_service_ll_write_buf (fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufVec, off_t offset, struct fuse_file_info *fi)
+	{
+		int error = ENOENT;
+		try
+		{
+			if (!FuseService::CheckAccessRights (fuse_req_ctx (req)->uid))
+			{
+				error = EACCES;
+			}
+			else if (ino == FuseServiceInode::VolumeImage || ino == FuseServiceInode::Control)
+			{
+				size_t size = fuse_buf_size (bufVec);
+				ConstBufferPtr data;
+
+				// Data spliced from the kernel is copied to a scratch buffer, whereas data read to memory by the
+				// library is processed in place
+				std::auto_ptr <PooledSecureBuffer> scratchBuffer;
+				finally_do_arg (std::auto_ptr <PooledSecureBuffer> *, &scratchBuffer, { if (finally_arg->get()) BufferPtr (**finally_arg).Erase(); });
+
+				if (bufVec->count == 1 && bufVec->idx == 0 && bufVec->off == 0 && !(bufVec->buf[0].flags & FUSE_BUF_IS_FD))
+				{
+					data.Set ((const byte *) bufVec->buf[0].mem, size);
+				}
+				else
+				{
+					scratchBuffer.reset (new PooledSecureBuffer (FuseService::GetScratchBufferPool(), size));
+
+					struct fuse_bufvec scratchBufVec = FUSE_BUFVEC_INIT (size);
+					scratchBufVec.buf[0].mem = scratchBuffer->Ptr();
+
+					ssize_t copiedSize = fuse_buf_copy (&scratchBufVec, bufVec, (enum fuse_buf_copy_flags) 0);
+					if (copiedSize < 0)
+						throw SystemException (SRC_POS, (int64) -copiedSize);
+
+					data.Set (scratchBuffer->Ptr(), (size_t) copiedSize);
+				}
+
+				if (ino == FuseServiceInode::VolumeImage)
+				{
+					FuseService::WriteVolumeSectors (data, offset);
+				}
+				else if (FuseService::AuxDeviceInfoReceived())
+				{
+					fuse_reply_err (req, EACCES);
+					return;
+				}
+				else
+				{
+					FuseService::ReceiveAuxDeviceInfo (data);
+				}
+
+				fuse_reply_write (req, data.Size());
+				return;
+			}
+		}
+		catch (...)
+		{
+			error = -FuseService::ExceptionToErrorCode();
+		}
+
+		fuse_reply_err (req, error);
+	}
+
+	static int fuse_service_ll_main (int argc, char *argv[], const struct fuse_lowlevel_ops *operations)
+	{
+		struct fuse_args args = FUSE_ARGS_INIT (argc, argv);
+		struct fuse_cmdline_opts options;
+		int result = 1;
+
+		if (fuse_parse_cmdline (&args, &options) != 0)
+			return 1;
+
+		struct fuse_session *session = fuse_session_new (&args, operations, sizeof (*operations), nullptr);
+		if (session)
+		{
+			if (fuse_session_mount (session, options.mountpoint) == 0)
+			{
+				fuse_daemonize (options.foreground);
+
+				// Requests are dispatched to multiple threads, each of which may use its own scratch buffer
+				if (options.singlethread)
+				{
+					result = fuse_session_loop (session);
+				}
+				else
+				{
+					struct fuse_loop_config loopConfig;
+					Memory::Zero (&loopConfig, sizeof (loopConfig));
+					loopConfig.clone_fd = options.clone_fd;
+					loopConfig.max_idle_threads = options.max_idle_threads;
+
+					result = fuse_session_loop_mt (session, &loopConfig);
+				}
+
+				fuse_session_unmount (session);
+			}
+
+			fuse_session_destroy (session);
+		}
+
+		free (options.mountpoint);
+		fuse_opt_free_args (&args);
+
+		return result != 0 ? 1 : 0;
+	}
+
+#endif // TC_FUSE3
+
+#ifndef TC_FUSE3
 	bool FuseService::CheckAccessRights ()
 	{
-		return fuse_get_context()->uid == 0 || fuse_get_context()->uid == UserId;
+		return CheckAccessRights (fuse_get_context()->uid);
 	}
+#endif
 	
 	void FuseService::CloseMountedVolume ()
 	{
+		ReadCache.reset();
+
 		if (MountedVolume)
 		{
 			// This process will exit before the use count of MountedVolume reaches zero
@@ -384,22 +766,41 @@ namespace CipherShed
 
 	shared_ptr <Buffer> FuseService::GetVolumeInfo ()
 	{
-		shared_ptr <Stream> stream (new MemoryStream);
+		uint64 version;
+		return GetVolumeInfo (version);
+	}
 
-		{
-			ScopeLock lock (OpenVolumeInfoMutex);
+	shared_ptr <Buffer> FuseService::GetVolumeInfo (uint64 &version)
+	{
+		ScopeLock lock (OpenVolumeInfoMutex);
 
+		// Volume information is serialized again only if the volume statistics or auxiliary devices have changed
+		if (!VolumeInfoSnapshot
+			|| OpenVolumeInfo.HiddenVolumeProtectionTriggered != MountedVolume->IsHiddenVolumeProtectionTriggered()
+			|| OpenVolumeInfo.TopWriteOffset != MountedVolume->GetTopWriteOffset()
+			|| OpenVolumeInfo.TotalDataRead != MountedVolume->GetTotalDataRead()
+			|| OpenVolumeInfo.TotalDataWritten != MountedVolume->GetTotalDataWritten())
+		{
 			OpenVolumeInfo.Set (*MountedVolume);
 			OpenVolumeInfo.SlotNumber = SlotNumber;
 
+			shared_ptr <Stream> stream (new MemoryStream);
 			OpenVolumeInfo.Serialize (stream);
-		}
 
-		ConstBufferPtr infoBuf = dynamic_cast <MemoryStream&> (*stream);
-		shared_ptr <Buffer> outBuf (new Buffer (infoBuf.Size()));
-		outBuf->CopyFrom (infoBuf);
+			ConstBufferPtr infoBuf = dynamic_cast <MemoryStream&> (*stream);
+			VolumeInfoSnapshot.reset (new Buffer (infoBuf.Size()));
+			VolumeInfoSnapshot->CopyFrom (infoBuf);
+
+			// Versions are snapshot times in nanoseconds, kept unique for snapshots taken within the clock resolution
+			struct timeval tv;
+			gettimeofday (&tv, NULL);
+			uint64 snapshotTime = ((uint64) tv.tv_sec * 1000000ULL + tv.tv_usec) * 1000ULL;
 
-		return outBuf;
+			VolumeInfoSnapshotVersion = max (snapshotTime, VolumeInfoSnapshotVersion + 1);
+		}
+
+		version = VolumeInfoSnapshotVersion;
+		return VolumeInfoSnapshot;
 	}
 	
 	const char *FuseService::GetVolumeImagePath ()
@@ -419,7 +820,7 @@ namespace CipherShed
 		return MountedVolume->GetSize();
 	}
 
-	void FuseService::Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint)
+	void FuseService::Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint, uint64 readCacheSize)
 	{
 		list <string> args;
 		args.push_back (FuseService::GetDeviceType());
@@ -437,9 +838,24 @@ namespace CipherShed
 			args.push_back ("-o");
 			args.push_back ("allow_other");
 		}
+
+#ifdef TC_FUSE3
+		args.push_back ("-o");
+		args.push_back ("max_read=" + StringConverter::ToSingle ((uint64) MaxIoSize));
+#endif
 		
-		ExecFunctor execFunctor (openVolume, slotNumber);
-		Process::Execute ("fuse", args, -1, &execFunctor);
+		// Worker threads of the encryption thread pool are not inherited by the forked FUSE process,
+		// which starts its own pool. The pool must therefore not appear to be running in the child.
+		bool threadPoolRunning = EncryptionThreadPool::IsRunning();
+		if (threadPoolRunning)
+			EncryptionThreadPool::Stop();
+
+		{
+			finally_do_arg (bool, threadPoolRunning, { if (finally_arg) EncryptionThreadPool::Start(); });
+
+			ExecFunctor execFunctor (openVolume, slotNumber, readCacheSize);
+			Process::Execute ("fuse", args, -1, &execFunctor);
+		}
 
 		for (int t = 0; true; t++)
 		{
@@ -458,12 +874,59 @@ namespace CipherShed
 		}
 	}
 
+	size_t FuseService::ReadVolumeImage (const BufferPtr &buffer, uint64 byteOffset)
+	{
+		size_t size = buffer.Size();
+
+		// Test for read beyond the end of the volume
+		if (size == 0 || byteOffset >= GetVolumeSize())
+			return 0;
+
+		if (byteOffset + size > GetVolumeSize())
+			size = (size_t) (GetVolumeSize() - byteOffset);
+
+		try
+		{
+			size_t sectorSize = GetVolumeSectorSize();
+			if (size % sectorSize != 0 || byteOffset % sectorSize != 0)
+			{
+				// Support for non-sector-aligned read operations is required by some loop device tools
+				// which may analyze the volume image before attaching it as a device
+
+				uint64 alignedOffset = byteOffset - (byteOffset % sectorSize);
+				uint64 alignedSize = size + (byteOffset % sectorSize);
+
+				if (alignedSize % sectorSize != 0)
+					alignedSize += sectorSize - (alignedSize % sectorSize);
+
+				PooledSecureBuffer alignedBuffer (ScratchBufferPool, (size_t) alignedSize);
+				finally_do_arg (BufferPtr, alignedBuffer, { finally_arg.Erase(); });
+
+				ReadVolumeSectors (alignedBuffer, alignedOffset);
+				buffer.GetRange (0, size).CopyFrom (ConstBufferPtr (alignedBuffer).GetRange (byteOffset % sectorSize, size));
+			}
+			else
+			{
+				ReadVolumeSectors (buffer.GetRange (0, size), byteOffset);
+			}
+		}
+		catch (MissingVolumeData)
+		{
+			return 0;
+		}
+
+		return size;
+	}
+
 	void FuseService::ReadVolumeSectors (const BufferPtr &buffer, uint64 byteOffset)
 	{
 		if (!MountedVolume)
 			throw NotInitialized (SRC_POS);
 
-		MountedVolume->ReadSectors (buffer, byteOffset);
+		if (ReadCache.get())
+			ReadCache->ReadSectors (buffer, byteOffset);
+		else
+			MountedVolume->ReadSectors (buffer, byteOffset);
 	}
 
 	void FuseService::ReceiveAuxDeviceInfo (const ConstBufferPtr &buffer)
@@ -474,6 +937,7 @@ namespace CipherShed
 		ScopeLock lock (OpenVolumeInfoMutex);
 		OpenVolumeInfo.VirtualDevice = sr.DeserializeString ("VirtualDevice");
 		OpenVolumeInfo.LoopDevice = sr.DeserializeString ("LoopDevice");
+		VolumeInfoSnapshot.reset();
 	}
 
 	void FuseService::SendAuxDeviceInfo (const DirectoryPath &fuseMountPoint, const DevicePath &virtualDevice, const DevicePath &loopDevice)
@@ -489,12 +953,31 @@ namespace CipherShed
 		fuseServiceControl.Write (dynamic_cast <MemoryStream&> (*stream));
 	}
 
+	void FuseService::StartReadCache ()
+	{
+		if (ReadCacheSize == 0 || !MountedVolume || ReadCache.get())
+			return;
+
+		try
+		{
+			ReadCache.reset (new VolumeReadCache (MountedVolume, ReadCacheSize));
+		}
+		catch (exception &e)
+		{
+			// The volume remains usable without the cache (e.g., when the memory cannot be locked)
+			SystemLog::WriteException (e);
+		}
+	}
+
 	void FuseService::WriteVolumeSectors (const ConstBufferPtr &buffer, uint64 byteOffset)
 	{
 		if (!MountedVolume)
 			throw NotInitialized (SRC_POS);
 
-		MountedVolume->WriteSectors (buffer, byteOffset);
+		if (ReadCache.get())
+			ReadCache->WriteSectors (buffer, byteOffset);
+		else
+			MountedVolume->WriteSectors (buffer, byteOffset);
 	}
 	
 	void FuseService::OnSignal (int signal)
@@ -518,6 +1001,7 @@ namespace CipherShed
 		FuseService::OpenVolumeInfo.SerialInstanceNumber = (uint64)tv.tv_sec * 1000000ULL + tv.tv_usec;
 
 		FuseService::MountedVolume = MountedVolume;
+		FuseService::ReadCacheSize = ReadCacheSize;
 		FuseService::SlotNumber = SlotNumber;
 
 		FuseService::UserId = getuid();
@@ -539,6 +1023,20 @@ namespace CipherShed
 			catch (...) { }
 		}
 
+#ifdef TC_FUSE3
+		static fuse_lowlevel_ops fuse_service_oper;
+
+		fuse_service_oper.access = fuse_service_ll_access;
+		fuse_service_oper.destroy = fuse_service_destroy;
+		fuse_service_oper.getattr = fuse_service_ll_getattr;
+		fuse_service_oper.init = fuse_service_ll_init;
+		fuse_service_oper.lookup = fuse_service_ll_lookup;
+		fuse_service_oper.open = fuse_service_ll_open;
+		fuse_service_oper.opendir = fuse_service_ll_opendir;
+		fuse_service_oper.read = fuse_service_ll_read;
+		fuse_service_oper.readdir = fuse_service_ll_readdir;
+		fuse_service_oper.write_buf = fuse_service_ll_write_buf;
+#else
 		static fuse_operations fuse_service_oper;
 
 		fuse_service_oper.access = fuse_service_access;
@@ -550,6 +1048,7 @@ namespace CipherShed
 		fuse_service_oper.read = fuse_service_read;
 		fuse_service_oper.readdir = fuse_service_readdir;
 		fuse_service_oper.write = fuse_service_write;
+#endif
 
 		// Create a new session
 		setsid ();
@@ -581,14 +1080,23 @@ namespace CipherShed
 
 		SignalHandlerPipe->GetWriteFD();
 
+#ifdef TC_FUSE3
+		_exit (fuse_service_ll_main (argc, argv, &fuse_service_oper));
+#else
 		_exit (fuse_main (argc, argv, &fuse_service_oper));
+#endif
 	}
 
 	VolumeInfo FuseService::OpenVolumeInfo;
 	Mutex FuseService::OpenVolumeInfoMutex;
+	SecureBufferPool FuseService::ScratchBufferPool;
 	shared_ptr <Volume> FuseService::MountedVolume;
+	std::auto_ptr <VolumeReadCache> FuseService::ReadCache;
+	uint64 FuseService::ReadCacheSize;
 	VolumeSlotNumber FuseService::SlotNumber;
 	uid_t FuseService::UserId;
 	gid_t FuseService::GroupId;
 	std::auto_ptr <Pipe> FuseService::SignalHandlerPipe;
+	shared_ptr <Buffer> FuseService::VolumeInfoSnapshot;
+	uint64 FuseService::VolumeInfoSnapshotVersion = 0;
 }
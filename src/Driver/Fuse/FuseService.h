@@ -10,10 +10,12 @@
 #define TC_HEADER_Driver_Fuse_FuseService
 
 #include "../../Platform/Platform.h"
+#include "../../Platform/BufferPool.h"
 #include "../../Platform/Unix/Pipe.h"
 #include "../../Platform/Unix/Process.h"
 #include "../../Volume/VolumeInfo.h"
 #include "../../Volume/Volume.h"
+#include "../../Volume/VolumeReadCache.h"
 
 #include <memory>
 
@@ -25,14 +27,15 @@ namespace CipherShed
 	protected:
 		struct ExecFunctor : public ProcessExecFunctor
 		{
-			ExecFunctor (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber)
-				: MountedVolume (openVolume), SlotNumber (slotNumber)
+			ExecFunctor (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, uint64 readCacheSize)
+				: MountedVolume (openVolume), ReadCacheSize (readCacheSize), SlotNumber (slotNumber)
 			{
 			}
 			virtual void operator() (int argc, char *argv[]);
 
 		protected:
 			shared_ptr <Volume> MountedVolume;
+			uint64 ReadCacheSize;
 			VolumeSlotNumber SlotNumber;
 		};
 
@@ -40,7 +43,10 @@ namespace CipherShed
 
 	public:
 		static bool AuxDeviceInfoReceived () { return !OpenVolumeInfo.VirtualDevice.IsEmpty(); }
+#ifndef TC_FUSE3
 		static bool CheckAccessRights ();
+#endif
+		static bool CheckAccessRights (uid_t userId) { return userId == 0 || userId == UserId; }
 		static void Dismount ();
 		static int ExceptionToErrorCode ();
 		static const char *GetControlPath () { return "/control"; }
@@ -49,14 +55,20 @@ namespace CipherShed
 		static uid_t GetGroupId () { return GroupId; }
 		static uid_t GetUserId () { return UserId; }
 		static shared_ptr <Buffer> GetVolumeInfo ();
+		static shared_ptr <Buffer> GetVolumeInfo (uint64 &version);
 		static uint64 GetVolumeSize ();
 		static uint64 GetVolumeSectorSize () { return MountedVolume->GetSectorSize(); }
-		static void Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint);
+		static SecureBufferPool &GetScratchBufferPool () { return ScratchBufferPool; }
+		static void Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint, uint64 readCacheSize = 0);
+		static size_t ReadVolumeImage (const BufferPtr &buffer, uint64 byteOffset);
 		static void ReadVolumeSectors (const BufferPtr &buffer, uint64 byteOffset);
 		static void ReceiveAuxDeviceInfo (const ConstBufferPtr &buffer);
 		static void SendAuxDeviceInfo (const DirectoryPath &fuseMountPoint, const DevicePath &virtualDevice, const DevicePath &loopDevice = DevicePath());
+		static void StartReadCache ();
 		static void WriteVolumeSectors (const ConstBufferPtr &buffer, uint64 byteOffset);
 
+		static const size_t MaxIoSize = 1024 * 1024;
+
 	protected:
 		FuseService ();
 		static void CloseMountedVolume ();
@@ -65,10 +77,15 @@ namespace CipherShed
 		static VolumeInfo OpenVolumeInfo;
 		static Mutex OpenVolumeInfoMutex;
 		static shared_ptr <Volume> MountedVolume;
+		static std::auto_ptr <VolumeReadCache> ReadCache;
+		static uint64 ReadCacheSize;
 		static VolumeSlotNumber SlotNumber;
 		static uid_t UserId;
 		static gid_t GroupId;
+		static SecureBufferPool ScratchBufferPool;
 		static std::auto_ptr <Pipe> SignalHandlerPipe;
+		static shared_ptr <Buffer> VolumeInfoSnapshot;	// Serialized OpenVolumeInfo shared by readers of the control file
+		static uint64 VolumeInfoSnapshotVersion;
 	};
 }
 
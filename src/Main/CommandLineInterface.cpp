@@ -12,6 +12,7 @@
 #include <wx/tokenzr.h>
 #endif
 #include "../Core/Core.h"
+#include "../Volume/VolumeHeaderKeyCache.h"
 #include "Application.h"
 #include "CommandLineInterface.h"
 #include "LanguageStrings.h"
@@ -22,6 +23,7 @@ namespace CipherShed
 	CommandLineInterface::CommandLineInterface (wxCmdLineParser &parser, UserInterfaceType::Enum interfaceType) :
 		ArgCommand (CommandId::None),
 		ArgFilesystem (VolumeCreationOptions::FilesystemType::Unknown),
+		ArgJobCount (0),
 		ArgNoHiddenVolumeProtection (false),
 		ArgSize (0),
 		ArgVolumeType (VolumeType::Unknown),
@@ -32,6 +34,8 @@ namespace CipherShed
 		parser.AddOption (L"",  L"auto-mount",			_("Auto mount device-hosted/favorite volumes"));
 		parser.AddSwitch (L"",  L"backup-headers",		_("Backup volume headers"));
 		parser.AddSwitch (L"",  L"background-task",		_("Start Background Task"));
+		parser.AddSwitch (L"",  L"benchmark",			_("Benchmark encryption algorithms and key derivation functions"));
+		parser.AddOption (L"",  L"buffer-sizes",		_("Benchmark buffer sizes"));
 #ifdef TC_WINDOWS
 		parser.AddSwitch (L"",  L"cache",				_("Cache passwords and keyfiles"));
 #endif
@@ -50,8 +54,10 @@ namespace CipherShed
 		parser.AddOption (L"",	L"fs-options",			_("Filesystem mount options"));
 #endif
 		parser.AddOption (L"",	L"hash",				_("Hash algorithm"));
+		parser.AddOption (L"",	L"header-key-cache",	_("Header key cache time-to-live in seconds"));
 		parser.AddSwitch (L"h", L"help",				_("Display detailed command line help"), wxCMD_LINE_OPTION_HELP);
 		parser.AddSwitch (L"",	L"import-token-keyfiles", _("Import keyfiles to security token"));
+		parser.AddOption (L"",	L"jobs",				_("Number of volumes opened concurrently when auto mounting"));
 		parser.AddOption (L"k", L"keyfiles",			_("Keyfiles"));
 		parser.AddSwitch (L"l", L"list",				_("List mounted volumes"));
 		parser.AddSwitch (L"",	L"list-token-keyfiles",	_("List security token keyfiles"));
@@ -66,6 +72,7 @@ namespace CipherShed
 		parser.AddOption (L"",	L"protection-keyfiles",	_("Keyfiles for protected hidden volume"));
 		parser.AddOption (L"",	L"protection-password",	_("Password for protected hidden volume"));
 		parser.AddOption (L"",	L"random-source",		_("Use file as source of random data"));
+		parser.AddOption (L"",	L"read-cache",			_("Read cache size in MiB"));
 		parser.AddSwitch (L"",  L"restore-headers",		_("Restore volume headers"));
 		parser.AddSwitch (L"",	L"save-preferences",	_("Save user preferences"));
 		parser.AddSwitch (L"",	L"quick",				_("Enable quick format"));
@@ -73,6 +80,7 @@ namespace CipherShed
 		parser.AddOption (L"",	L"slot",				_("Volume slot number"));
 		parser.AddSwitch (L"",	L"test",				_("Test internal algorithms"));
 		parser.AddSwitch (L"t", L"text",				_("Use text user interface"));
+		parser.AddOption (L"",	L"threads",				_("Benchmark thread counts"));
 		parser.AddOption (L"",	L"token-lib",			_("Security token library"));
 		parser.AddSwitch (L"v", L"verbose",				_("Enable verbose output"));
 		parser.AddSwitch (L"",	L"version",				_("Display version information"));
@@ -157,6 +165,12 @@ namespace CipherShed
 			param1IsVolume = true;
 		}
 
+		if (parser.Found (L"benchmark"))
+		{
+			CheckCommandSingle();
+			ArgCommand = CommandId::Benchmark;
+		}
+
 		if (parser.Found (L"change"))
 		{
 			CheckCommandSingle();
@@ -246,6 +260,17 @@ namespace CipherShed
 		if (parser.Found (L"background-task"))
 			StartBackgroundTask = true;
 
+		if (parser.Found (L"buffer-sizes", &str))
+		{
+			ArgBufferSizes = ToSizeList (str);
+
+			foreach (size_t size, ArgBufferSizes)
+			{
+				if (size == 0)
+					throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+			}
+		}
+
 #ifdef TC_WINDOWS
 		if (parser.Found (L"cache"))
 			ArgMountOptions.CachePassword = true;
@@ -308,6 +333,33 @@ namespace CipherShed
 				throw_err (LangString["UNKNOWN_OPTION"] + L": " + str);
 		}
 
+		if (parser.Found (L"header-key-cache", &str))
+		{
+			try
+			{
+				ArgMountOptions.HeaderKeyCacheTimeToLive = StringConverter::ToUInt64 (wstring (str));
+			}
+			catch (...)
+			{
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+			}
+
+			if (ArgMountOptions.HeaderKeyCacheTimeToLive > VolumeHeaderKeyCache::MaxTimeToLive)
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+		}
+
+		if (parser.Found (L"jobs", &str))
+		{
+			try
+			{
+				ArgJobCount = (size_t) StringConverter::ToUInt64 (wstring (str));
+			}
+			catch (...)
+			{
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+			}
+		}
+
 		if (parser.Found (L"keyfiles", &str))
 			ArgKeyfiles = ToKeyfileList (str);
 
@@ -384,6 +436,22 @@ namespace CipherShed
 		if (parser.Found (L"random-source", &str))
 			ArgRandomSourcePath = FilesystemPath ( str.wc_str() );
 
+		if (parser.Found (L"read-cache", &str))
+		{
+			try
+			{
+				uint64 readCacheSize = StringConverter::ToUInt64 (wstring (str));
+				if (readCacheSize > (uint64) -1 / (1024 * 1024))
+					throw ParameterIncorrect (SRC_POS);
+
+				ArgMountOptions.ReadCacheSize = readCacheSize * 1024 * 1024;
+			}
+			catch (...)
+			{
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + str);
+			}
+		}
+
 		if (parser.Found (L"restore-headers"))
 		{
 			CheckCommandSingle();
@@ -422,6 +490,9 @@ namespace CipherShed
 			}
 		}
 
+		if (parser.Found (L"threads", &str))
+			ArgThreadCounts = ToSizeList (str);
+
 		if (parser.Found (L"token-lib", &str))
 			Preferences.SecurityTokenModule = wstring (str);
 
@@ -544,6 +615,50 @@ namespace CipherShed
 		return keyfileList;
 	}
 
+	list <size_t> CommandLineInterface::ToSizeList (const wxString &arg) const
+	{
+		list <size_t> sizes;
+		wxStringTokenizer tokenizer (arg, L",");
+
+		while (tokenizer.HasMoreTokens())
+		{
+			wxString token = tokenizer.GetNextToken().Trim().Trim (false);
+			uint64 multiplier = 1;
+
+			if (!token.empty())
+			{
+				switch (wxToupper (token.Last()))
+				{
+				case L'K': multiplier = BYTES_PER_KB; break;
+				case L'M': multiplier = BYTES_PER_MB; break;
+				case L'G': multiplier = BYTES_PER_GB; break;
+				}
+
+				if (multiplier != 1)
+					token.RemoveLast();
+			}
+
+			try
+			{
+				uint64 size = StringConverter::ToUInt64 (wstring (token));
+				if (size > (uint64) -1 / multiplier)
+					throw ParameterIncorrect (SRC_POS);
+
+				size *= multiplier;
+				if (size > (size_t) -1)
+					throw ParameterTooLarge (SRC_POS);
+
+				sizes.push_back ((size_t) size);
+			}
+			catch (...)
+			{
+				throw_err (LangString["PARAMETER_INCORRECT"] + L": " + arg);
+			}
+		}
+
+		return sizes;
+	}
+
 	VolumeInfoList CommandLineInterface::GetMountedVolumes (const wxString &mountedVolumeSpec) const
 	{
 		VolumeInfoList volumes = Core->GetMountedVolumes ();
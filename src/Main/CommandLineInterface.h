@@ -30,6 +30,7 @@ namespace CipherShed
 			AutoMountDevicesFavorites,
 			AutoMountFavorites,
 			BackupHeaders,
+			Benchmark,
 			ChangePassword,
 			CreateKeyfile,
 			CreateVolume,
@@ -56,6 +57,7 @@ namespace CipherShed
 		virtual ~CommandLineInterface ();
 
 
+		list <size_t> ArgBufferSizes;
 		CommandId::Enum ArgCommand;
 		bool ArgDisplayPassword;
 		shared_ptr <EncryptionAlgorithm> ArgEncryptionAlgorithm;
@@ -63,6 +65,7 @@ namespace CipherShed
 		VolumeCreationOptions::FilesystemType::Enum ArgFilesystem;
 		bool ArgForce;
 		shared_ptr <Hash> ArgHash;
+		size_t ArgJobCount;
 		shared_ptr <KeyfileList> ArgKeyfiles;
 		MountOptions ArgMountOptions;
 		shared_ptr <DirectoryPath> ArgMountPoint;
@@ -73,6 +76,7 @@ namespace CipherShed
 		bool ArgQuick;
 		FilesystemPath ArgRandomSourcePath;
 		uint64 ArgSize;
+		list <size_t> ArgThreadCounts;
 		shared_ptr <VolumePath> ArgVolumePath;
 		VolumeInfoList ArgVolumes;
 		VolumeType::Enum ArgVolumeType;
@@ -83,6 +87,7 @@ namespace CipherShed
 	protected:
 		void CheckCommandSingle () const;
 		shared_ptr <KeyfileList> ToKeyfileList (const wxString &arg) const;
+		list <size_t> ToSizeList (const wxString &arg) const;
 		VolumeInfoList GetMountedVolumes (const wxString &filter) const;
 
 	private:
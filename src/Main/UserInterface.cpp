@@ -20,8 +20,13 @@
 #endif
 #include "../Platform/SystemInfo.h"
 #include "../Common/SecurityToken.h"
+#ifdef TC_LINUX
+#include "../Core/Unix/Linux/CoreLinuxTest.h"
+#endif
 using namespace std;
+#include "../Volume/EncryptionBenchmark.h"
 #include "../Volume/EncryptionTest.h"
+#include "../Volume/EncryptionThreadPool.h"
 #include "Application.h"
 #include "FavoriteVolume.h"
 #include "UserInterface.h"
@@ -32,6 +37,25 @@ namespace CipherShed
 	{
 	}
 
+	static wxString ToJsonString (const wxString &str)
+	{
+		wxString json = L"\"";
+
+		for (size_t i = 0; i < str.Len(); ++i)
+		{
+			wxChar c = str[i];
+
+			if (c == L'"' || c == L'\\')
+				json += wxString (L"\\") + c;
+			else if (c < 0x20)
+				json += wxString::Format (L"\\u%04x", (int) c);
+			else
+				json += c;
+		}
+
+		return json + L"\"";
+	}
+
 	UserInterface::~UserInterface ()
 	{
 		Core->WarningEvent.Disconnect (this);
@@ -45,6 +69,87 @@ namespace CipherShed
 		catch (...) { }
 	}
 
+	void UserInterface::Benchmark (const list <size_t> &bufferSizes, const list <size_t> &threadCounts, shared_ptr <EncryptionAlgorithm> volumeEncryptionAlgorithm) const
+	{
+		list <size_t> sizes = bufferSizes;
+		if (sizes.empty())
+		{
+			sizes.push_back (64 * 1024);
+			sizes.push_back (1024 * 1024);
+			sizes.push_back (5 * 1024 * 1024);
+		}
+
+		// Thread count 0 selects the default number of threads
+		list <size_t> threads = threadCounts;
+		if (threads.empty())
+			threads.push_back (0);
+
+		shared_ptr <EncryptionAlgorithm> volumeEA = volumeEncryptionAlgorithm;
+		if (!volumeEA)
+			volumeEA = EncryptionAlgorithm::GetAvailableAlgorithms().front();
+
+		FilePath volumePath (wstring (wxFileName::CreateTempFileName (wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + L"ciphershed-benchmark")));
+		finally_do_arg (FilePath, volumePath, { try { finally_arg.Delete(); } catch (...) { } });
+
+		bool poolRunning = EncryptionThreadPool::IsRunning();
+		finally_do_arg (bool, poolRunning,
+		{
+			EncryptionThreadPool::Stop();
+			if (finally_arg)
+				EncryptionThreadPool::Start();
+		});
+
+		wxString encryptionResults, kdfResults, volumeResults;
+
+		foreach (size_t threadCount, threads)
+		{
+			BusyScope busy (this);
+
+			EncryptionThreadPool::Stop();
+			EncryptionThreadPool::Start (threadCount);
+
+			size_t actualThreadCount = EncryptionThreadPool::IsRunning() ? EncryptionThreadPool::GetThreadCount() : 1;
+
+			foreach (const EncryptionBenchmarkResult &result, EncryptionBenchmark::BenchmarkEncryption (sizes))
+			{
+				if (!encryptionResults.empty())
+					encryptionResults += L",\n";
+
+				encryptionResults += wxString::Format (L"    {\"algorithm\": %s, \"mode\": \"XTS\", \"aesImplementation\": %s, \"bufferSize\": %llu, \"cascadeTileSize\": %llu, \"threads\": %llu, \"encryptionSpeed\": %llu, \"decryptionSpeed\": %llu}",
+					ToJsonString (wstring (result.AlgorithmName)).c_str(), ToJsonString (wstring (result.AesImplementation)).c_str(),
+					(unsigned long long) result.BufferSize, (unsigned long long) result.CascadeTileSize,
+					(unsigned long long) actualThreadCount, (unsigned long long) result.EncryptionSpeed, (unsigned long long) result.DecryptionSpeed);
+			}
+
+			foreach (const KdfBenchmarkResult &result, EncryptionBenchmark::BenchmarkKeyDerivation ())
+			{
+				if (!kdfResults.empty())
+					kdfResults += L",\n";
+
+				kdfResults += wxString::Format (L"    {\"prf\": %s, \"iterations\": %d, \"threads\": %llu, \"derivationTime\": %llu}",
+					ToJsonString (wstring (result.KdfName)).c_str(), result.IterationCount, (unsigned long long) actualThreadCount,
+					(unsigned long long) result.DerivationTime);
+			}
+
+			foreach (const VolumeBenchmarkResult &result, EncryptionBenchmark::BenchmarkVolume (volumePath, volumeEA->GetNew(), sizes))
+			{
+				if (!volumeResults.empty())
+					volumeResults += L",\n";
+
+				volumeResults += wxString::Format (L"    {\"algorithm\": %s, \"bufferSize\": %llu, \"threads\": %llu, \"readSpeed\": %llu, \"writeSpeed\": %llu}",
+					ToJsonString (wstring (result.AlgorithmName)).c_str(), (unsigned long long) result.BufferSize, (unsigned long long) actualThreadCount,
+					(unsigned long long) result.ReadSpeed, (unsigned long long) result.WriteSpeed);
+			}
+		}
+
+		// Speeds are in bytes per second and derivation times in microseconds
+		ShowString (wxString (L"{\n")
+			+ L"  \"encryption\": [\n" + encryptionResults + L"\n  ],\n"
+			+ L"  \"keyDerivation\": [\n" + kdfResults + L"\n  ],\n"
+			+ L"  \"volume\": [\n" + volumeResults + L"\n  ]\n"
+			+ L"}\n");
+	}
+
 	void UserInterface::CheckRequirementsForMountingVolume () const
 	{
 #ifdef TC_LINUX
@@ -599,58 +704,89 @@ namespace CipherShed
 		foreach_ref (const VolumeInfo &v, Core->GetMountedVolumes())
 			mountedVolumes.insert (v.Path);
 
-		bool protectedVolumeMounted = false;
-		bool legacyVolumeMounted = false;
-
+		// Volumes are opened concurrently by the core and mounted in the order of the devices. Volumes whose host
+		// devices are in use are retried with shared access after the others have been mounted.
+		MountOptionsList candidates;
 		foreach_ref (const HostDevice &device, devices)
 		{
 			if (mountedVolumes.find (wstring (device.Path)) != mountedVolumes.end())
 				continue;
 
-			Yield();
-			options.SlotNumber = Core->GetFirstFreeSlotNumber (options.SlotNumber);
-			options.MountPoint.reset (new DirectoryPath);
-			options.Path.reset (new VolumePath (device.Path));
+			shared_ptr <MountOptions> candidate (new MountOptions (options));
+			candidate->MountPoint.reset (new DirectoryPath);
+			candidate->Path.reset (new VolumePath (device.Path));
+			candidate->SharedAccessAllowed = sharedAccessAllowed;
 
-			try
+			candidates.push_back (candidate);
+		}
+
+		size_t jobCount = CmdLine.get() ? CmdLine->ArgJobCount : 0;
+
+		Yield();
+		VolumeMountResultList results = Core->MountVolumes (candidates, jobCount);
+
+		if (!sharedAccessAllowed)
+		{
+			MountOptionsList sharedCandidates;
+			list <VolumeMountResult *> sharedResults;
+
+			MountOptionsList::iterator candidate = candidates.begin();
+			for (VolumeMountResultList::iterator result = results.begin(); result != results.end(); ++result, ++candidate)
 			{
-				try
+				if (dynamic_cast <VolumeHostInUse *> (result->Error.get()))
 				{
-					options.SharedAccessAllowed = sharedAccessAllowed;
-					newMountedVolumes.push_back (Core->MountVolume (options));
+					(*candidate)->SharedAccessAllowed = true;
+					sharedCandidates.push_back (*candidate);
+					sharedResults.push_back (&*result);
 				}
-				catch (VolumeHostInUse&)
+			}
+
+			if (!sharedCandidates.empty())
+			{
+				Yield();
+				list <VolumeMountResult *>::iterator result = sharedResults.begin();
+				foreach (const VolumeMountResult &sharedResult, Core->MountVolumes (sharedCandidates, jobCount))
 				{
-					if (!sharedAccessAllowed)
-					{
-						try
-						{
-							options.SharedAccessAllowed = true;
-							newMountedVolumes.push_back (Core->MountVolume (options));
-							someVolumesShared = true;
-						}
-						catch (VolumeHostInUse&)
-						{
-							continue;
-						}
-					}
-					else
-						continue;
+					**result = sharedResult;
+
+					if (sharedResult.MountedVolume)
+						someVolumesShared = true;
+					++result;
 				}
+			}
+		}
+
+		bool protectedVolumeMounted = false;
+		bool legacyVolumeMounted = false;
+		shared_ptr <Exception> error;
 
-				if (newMountedVolumes.back()->Protection == VolumeProtection::HiddenVolumeReadOnly)
+		foreach (const VolumeMountResult &result, results)
+		{
+			if (result.MountedVolume)
+			{
+				newMountedVolumes.push_back (result.MountedVolume);
+
+				if (result.MountedVolume->Protection == VolumeProtection::HiddenVolumeReadOnly)
 					protectedVolumeMounted = true;
 
-				if (newMountedVolumes.back()->EncryptionAlgorithmMinBlockSize == 8)
+				if (result.MountedVolume->EncryptionAlgorithmMinBlockSize == 8)
 					legacyVolumeMounted = true;
 			}
-			catch (DriverError&) { }
-			catch (MissingVolumeData&) { }
-			catch (PasswordException&) { }
-			catch (SystemException&) { }
-			catch (ExecutedProcessFailed&) { }
+			else if (!error
+				&& !dynamic_cast <VolumeHostInUse *> (result.Error.get())
+				&& !dynamic_cast <DriverError *> (result.Error.get())
+				&& !dynamic_cast <MissingVolumeData *> (result.Error.get())
+				&& !dynamic_cast <PasswordException *> (result.Error.get())
+				&& !dynamic_cast <SystemException *> (result.Error.get())
+				&& !dynamic_cast <ExecutedProcessFailed *> (result.Error.get()))
+			{
+				error = result.Error;
+			}
 		}
 
+		if (error)
+			error->Throw();
+
 		if (newMountedVolumes.empty())
 		{
 			ShowWarning (LangString [options.Keyfiles && !options.Keyfiles->empty() ? "PASSWORD_OR_KEYFILE_WRONG_AUTOMOUNT" : "PASSWORD_WRONG_AUTOMOUNT"]);
@@ -677,7 +813,7 @@ namespace CipherShed
 	{
 		BusyScope busy (this);
 		
-		VolumeInfoList newMountedVolumes;
+		MountOptionsList candidates;
 		foreach_ref (const FavoriteVolume &favorite, FavoriteVolume::LoadList())
 		{
 			shared_ptr <VolumeInfo> mountedVolume = Core->GetMountedVolume (favorite.Path);
@@ -689,35 +825,47 @@ namespace CipherShed
 			}
 
 			favorite.ToMountOptions (options);
+			candidates.push_back (shared_ptr <MountOptions> (new MountOptions (options)));
+		}
 
-			if (Preferences.NonInteractive)
+		// Volumes are opened concurrently by the core and mounted in the order of the favorites. Volumes which cannot
+		// be mounted without user interaction are mounted after the others.
+		VolumeMountResultList results = Core->MountVolumes (candidates, CmdLine.get() ? CmdLine->ArgJobCount : 0);
+
+		VolumeInfoList newMountedVolumes;
+		MountOptionsList::iterator candidate = candidates.begin();
+		for (VolumeMountResultList::iterator result = results.begin(); result != results.end(); ++result, ++candidate)
+		{
+			if (result->MountedVolume)
 			{
-				BusyScope busy (this);
-				newMountedVolumes.push_back (Core->MountVolume (options));
+				newMountedVolumes.push_back (result->MountedVolume);
+				continue;
 			}
-			else
-			{
-				try
-				{
-					BusyScope busy (this);
-					newMountedVolumes.push_back (Core->MountVolume (options));
-				}
-				catch (...)
-				{
-					UserPreferences prefs = GetPreferences();
-					if (prefs.CloseSecurityTokenSessionsAfterMount)
-						Preferences.CloseSecurityTokenSessionsAfterMount = false;
 
-					shared_ptr <VolumeInfo> volume = MountVolume (options);
+			if (Preferences.NonInteractive)
+				result->Error->Throw();
+
+			UserPreferences prefs = GetPreferences();
+			if (prefs.CloseSecurityTokenSessionsAfterMount)
+				Preferences.CloseSecurityTokenSessionsAfterMount = false;
 
-					if (prefs.CloseSecurityTokenSessionsAfterMount)
-						Preferences.CloseSecurityTokenSessionsAfterMount = true;
+			shared_ptr <VolumeInfo> volume = MountVolume (**candidate);
 
-					if (!volume)
-						break;
-					newMountedVolumes.push_back (volume);
+			if (prefs.CloseSecurityTokenSessionsAfterMount)
+				Preferences.CloseSecurityTokenSessionsAfterMount = true;
+
+			// Mounting of the remaining favorites has been canceled, but some of them may have been mounted already
+			if (!volume)
+			{
+				for (++result; result != results.end(); ++result)
+				{
+					if (result->MountedVolume)
+						newMountedVolumes.push_back (result->MountedVolume);
 				}
+				break;
 			}
+
+			newMountedVolumes.push_back (volume);
 		}
 
 		if (!newMountedVolumes.empty() && GetPreferences().CloseSecurityTokenSessionsAfterMount)
@@ -967,6 +1115,10 @@ namespace CipherShed
 			BackupVolumeHeaders (cmdLine.ArgVolumePath);
 			return true;
 
+		case CommandId::Benchmark:
+			Benchmark (cmdLine.ArgBufferSizes, cmdLine.ArgThreadCounts, cmdLine.ArgEncryptionAlgorithm);
+			return true;
+
 		case CommandId::ChangePassword:
 			ChangePassword (cmdLine.ArgVolumePath, cmdLine.ArgPassword, cmdLine.ArgKeyfiles, cmdLine.ArgNewPassword, cmdLine.ArgNewKeyfiles, cmdLine.ArgHash);
 			return true;
@@ -1034,6 +1186,12 @@ namespace CipherShed
 					" Backup volume headers to a file. All required options are requested from the\n"
 					" user.\n"
 					"\n"
+					"--benchmark\n"
+					" Measure the speed of all encryption algorithms in XTS mode, the time needed\n"
+					" to derive a header key using each PRF, and the read/write speed of a\n"
+					" temporary volume. The results are displayed in JSON format. See also options\n"
+					" --buffer-sizes, --encryption, --threads.\n"
+					"\n"
 					"-c, --create[=VOLUME_PATH]\n"
 					" Create a new volume. Most options are requested from the user if not specified\n"
 					" on command line. See also options --encryption, -k, --filesystem, --hash, -p,\n"
@@ -1113,11 +1271,16 @@ namespace CipherShed
 					"\n"
 					"Options:\n"
 					"\n"
+					"--buffer-sizes=SIZES\n"
+					" Comma-separated list of buffer sizes used by --benchmark. A size may be\n"
+					" followed by K, M, or G (e.g., 64K,1M,5M).\n"
+					"\n"
 					"--display-password\n"
 					" Display password characters while typing.\n"
 					"\n"
 					"--encryption=ENCRYPTION_ALGORITHM\n"
-					" Use specified encryption algorithm when creating a new volume.\n"
+					" Use specified encryption algorithm when creating a new volume or when\n"
+					" benchmarking a temporary volume.\n"
 					"\n"
 					"--filesystem=TYPE\n"
 					" Filesystem type to mount. The TYPE argument is passed to mount(8) command\n"
@@ -1140,6 +1303,23 @@ namespace CipherShed
 					" and/or keyfiles. This option also specifies the mixing PRF of the random\n"
 					" number generator.\n"
 					"\n"
+					"--header-key-cache=SECONDS\n"
+					" Cache the header keys derived when mounting a volume for SECONDS seconds, so\n"
+					" that the volume can be dismounted and mounted again with the same password\n"
+					" and keyfiles without repeating the key derivation. The keys are kept in\n"
+					" locked memory of the process performing the mount and are wiped together\n"
+					" with cached passwords. The cache is disabled by default. SECONDS must not\n"
+					" exceed 2592000 (30 days).\n"
+					"\n"
+					"--jobs=COUNT\n"
+					" Open up to COUNT volumes concurrently when mounting volumes with --auto-mount.\n"
+					" The key derivation of each volume then runs on a separate processor. Volumes\n"
+					" opened with the given password and keyfiles are assigned slots in the order\n"
+					" in which they are found. Volumes that need to be mounted with shared access\n"
+					" or after a prompt are mounted after them, and may therefore be assigned\n"
+					" other slots than when all volumes are mounted one by one. By default, the\n"
+					" number of processors is used.\n"
+					"\n"
 					"-k, --keyfiles=KEYFILE1[,KEYFILE2,KEYFILE3,...]\n"
 					" Use specified keyfiles when mounting a volume or when changing password\n"
 					" and/or keyfiles. When a directory is specified, all files inside it will be\n"
@@ -1207,6 +1387,11 @@ namespace CipherShed
 					" Use FILE as a source of random data (e.g., when creating a volume) instead\n"
 					" of requiring the user to type random characters.\n"
 					"\n"
+					"--read-cache=SIZE\n"
+					" Cache up to SIZE MiB of decrypted data of a volume mounted using FUSE and\n"
+					" read the following data ahead when sequential reads are detected. The cache\n"
+					" is locked in memory. The cache is disabled by default.\n"
+					"\n"
 					"--slot=SLOT\n"
 					" Use specified slot number when mounting, dismounting, or listing a volume.\n"
 					"\n"
@@ -1217,6 +1402,10 @@ namespace CipherShed
 					" Use text user interface. Graphical user interface is used by default if\n"
 					" available. This option must be specified as the first argument.\n"
 					"\n"
+					"--threads=COUNTS\n"
+					" Comma-separated list of encryption thread counts used by --benchmark. The\n"
+					" count 0 selects the default number of threads.\n"
+					"\n"
 					"--token-lib=LIB_PATH\n"
 					" Use specified PKCS #11 security token library.\n"
 					"\n"
@@ -1402,6 +1591,10 @@ namespace CipherShed
 
 		EncryptionTest::TestAll();
 
+#ifdef TC_LINUX
+		CoreLinuxTest::TestAll();
+#endif
+
 		// StringFormatter
 		if (StringFormatter (L"{9} {8} {7} {6} {5} {4} {3} {2} {1} {0} {{0}}", "1", L"2", '3', L'4', 5, 6, 7, 8, 9, 10) != L"10 9 8 7 6 5 4 3 2 1 {0}")
 			throw TestFailed (SRC_POS);
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Platform_AsyncFileIo
+#define TC_HEADER_Platform_AsyncFileIo
+
+#include "PlatformBase.h"
+#include "Buffer.h"
+#include "Mutex.h"
+#include "SharedVal.h"
+#include "SyncEvent.h"
+#include "Thread.h"
+
+namespace CipherShed
+{
+	// Positional read or write executed asynchronously by AsyncFileIo. The buffer must remain valid until
+	// Wait() returns. A request which has not been waited for is waited for by the destructor.
+	class AsyncFileIoRequest
+	{
+	public:
+		enum IoType
+		{
+			Read,
+			Write
+		};
+
+		AsyncFileIoRequest (IoType type, int fileHandle, const wstring &path, byte *buffer, size_t size, uint64 position);
+		virtual ~AsyncFileIoRequest ();
+
+		void Complete (int64 result);
+		void Execute ();
+		byte *GetBuffer () const { return DataBuffer; }
+		int GetFileHandle () const { return FileHandle; }
+		uint64 GetPosition () const { return Position; }
+		size_t GetSize () const { return DataSize; }
+		IoType GetType () const { return Type; }
+		uint64 Wait ();
+
+	protected:
+		int64 Transfer (size_t offset) const;
+
+		SyncEvent CompletedEvent;
+		byte *DataBuffer;
+		size_t DataSize;
+		int FileHandle;
+		wstring Path;
+		uint64 Position;
+		int64 Result;
+		IoType Type;
+		bool Waited;
+
+	private:
+		AsyncFileIoRequest (const AsyncFileIoRequest &);
+		AsyncFileIoRequest &operator= (const AsyncFileIoRequest &);
+	};
+
+	// Executes asynchronous file I/O requests using io_uring when supported by the kernel. Otherwise, requests
+	// are executed by a pool of I/O threads. The backend is initialized on first use in each process.
+	class AsyncFileIo
+	{
+	public:
+		static bool IsKernelQueueAvailable ();
+		static void Submit (AsyncFileIoRequest *request);
+
+		static const size_t IoThreadCount = 4;
+		static const unsigned int KernelQueueDepth = 64;
+
+	protected:
+		static void Initialize ();
+		static TC_THREAD_PROC CompletionThreadProc (void *param);
+		static TC_THREAD_PROC IoThreadProc (void *param);
+		static bool SubmitToKernelQueue (AsyncFileIoRequest *request);
+
+		static bool KernelQueueAvailable;
+		static Mutex InitMutex;
+		static SharedVal <int64> InitProcessId;
+		static list <AsyncFileIoRequest *> PendingRequests;
+		static Mutex PendingRequestsMutex;
+		static SyncEvent *RequestPendingEvent;
+
+	private:
+		AsyncFileIo ();
+	};
+}
+
+#endif // TC_HEADER_Platform_AsyncFileIo
@@ -0,0 +1,61 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "BufferPool.h"
+#include "Exception.h"
+
+namespace CipherShed
+{
+	SecureBufferPool::SecureBufferPool (size_t maxFreeBufferCount) : MaxFreeBufferCount (maxFreeBufferCount)
+	{
+	}
+
+	SecureBufferPool::~SecureBufferPool ()
+	{
+		for (list <SecureBuffer *>::iterator i = FreeBuffers.begin(); i != FreeBuffers.end(); ++i)
+			delete *i;
+	}
+
+	SecureBuffer *SecureBufferPool::Acquire (size_t size)
+	{
+		{
+			ScopeLock lock (PoolMutex);
+
+			for (list <SecureBuffer *>::iterator i = FreeBuffers.begin(); i != FreeBuffers.end(); ++i)
+			{
+				if ((*i)->Size() >= size)
+				{
+					SecureBuffer *buffer = *i;
+					FreeBuffers.erase (i);
+					return buffer;
+				}
+			}
+		}
+
+		// Requests of various sizes are served by the same buffers if they are not too small
+		return new SecureBuffer (size < MinBufferSize ? MinBufferSize : size);
+	}
+
+	void SecureBufferPool::Release (SecureBuffer *buffer)
+	{
+		if (!buffer)
+			return;
+
+		{
+			ScopeLock lock (PoolMutex);
+
+			if (FreeBuffers.size() < MaxFreeBufferCount)
+			{
+				FreeBuffers.push_back (buffer);
+				return;
+			}
+		}
+
+		delete buffer;
+	}
+}
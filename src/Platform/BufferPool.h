@@ -0,0 +1,69 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Platform_BufferPool
+#define TC_HEADER_Platform_BufferPool
+
+#include "PlatformBase.h"
+#include "Buffer.h"
+#include "Mutex.h"
+
+namespace CipherShed
+{
+	// Preallocated secure buffers reused by I/O paths in order to avoid allocating, locking and erasing memory
+	// on every request. Each thread holds a buffer only for the duration of a request, so the number of buffers
+	// allocated is bounded by the number of concurrent requests. Buffers are not erased when returned to the
+	// pool, and users storing sensitive data in them must erase it themselves.
+	class SecureBufferPool
+	{
+	public:
+		SecureBufferPool (size_t maxFreeBufferCount = DefaultMaxFreeBufferCount);
+		virtual ~SecureBufferPool ();
+
+		SecureBuffer *Acquire (size_t size);
+		void Release (SecureBuffer *buffer);
+
+		static const size_t DefaultMaxFreeBufferCount = 16;
+		static const size_t MinBufferSize = 64 * 1024;
+
+	protected:
+		list <SecureBuffer *> FreeBuffers;
+		size_t MaxFreeBufferCount;
+		Mutex PoolMutex;
+
+	private:
+		SecureBufferPool (const SecureBufferPool &);
+		SecureBufferPool &operator= (const SecureBufferPool &);
+	};
+
+	class PooledSecureBuffer
+	{
+	public:
+		PooledSecureBuffer (SecureBufferPool &pool, size_t size)
+			: Pool (pool), PoolBuffer (pool.Acquire (size)), DataSize (size) { }
+		~PooledSecureBuffer () { Pool.Release (PoolBuffer); }
+
+		byte *Ptr () const { return PoolBuffer->Ptr(); }
+		size_t Size () const { return DataSize; }
+
+		operator byte * () const { return PoolBuffer->Ptr(); }
+		operator BufferPtr () const { return BufferPtr (PoolBuffer->Ptr(), DataSize); }
+		operator ConstBufferPtr () const { return ConstBufferPtr (PoolBuffer->Ptr(), DataSize); }
+
+	protected:
+		SecureBufferPool &Pool;
+		SecureBuffer *PoolBuffer;
+		size_t DataSize;
+
+	private:
+		PooledSecureBuffer (const PooledSecureBuffer &);
+		PooledSecureBuffer &operator= (const PooledSecureBuffer &);
+	};
+}
+
+#endif // TC_HEADER_Platform_BufferPool
@@ -11,8 +11,10 @@
 
 #include "PlatformBase.h"
 using namespace std;
+#include "AsyncFileIo.h"
 #include "Buffer.h"
 #include "FilesystemPath.h"
+#include "SharedPtr.h"
 #include "SystemException.h"
 
 namespace CipherShed
@@ -78,11 +80,13 @@ namespace CipherShed
 		uint64 Read (const BufferPtr &buffer) const;
 		void ReadCompleteBuffer (const BufferPtr &buffer) const;
 		uint64 ReadAt (const BufferPtr &buffer, uint64 position) const;
+		shared_ptr <AsyncFileIoRequest> ReadAtAsync (const BufferPtr &buffer, uint64 position) const;
 		void SeekAt (uint64 position) const;
 		void SeekEnd (int ofset) const;
 		void Write (const ConstBufferPtr &buffer) const;
 		void Write (const ConstBufferPtr &buffer, size_t length) const { Write (buffer.GetRange (0, length)); }
 		void WriteAt (const ConstBufferPtr &buffer, uint64 position) const;
+		shared_ptr <AsyncFileIoRequest> WriteAtAsync (const ConstBufferPtr &buffer, uint64 position) const;
 		
 	protected:
 		void ValidateState () const;
@@ -18,6 +18,7 @@ namespace CipherShed
 	{
 	public:
 		static wstring GetPlatformName ();
+		static size_t GetProcessorCount ();
 		static vector <int> GetVersion ();
 		static bool IsVersionAtLeast (int versionNumber1, int versionNumber2, int versionNumber3 = 0);
 
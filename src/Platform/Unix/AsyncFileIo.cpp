@@ -0,0 +1,438 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef TC_LINUX
+#	include <stdint.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	ifdef __has_include
+#		if __has_include (<linux/io_uring.h>)
+#			include <linux/io_uring.h>
+#		endif
+#	endif
+#endif
+
+#include "../AsyncFileIo.h"
+#include "../Memory.h"
+#include "../SystemException.h"
+#include "../SystemLog.h"
+
+#if defined (TC_LINUX) && defined (__NR_io_uring_setup) && defined (IORING_FEAT_RW_CUR_POS)
+#	define TC_ASYNC_FILE_IO_KERNEL_QUEUE
+#endif
+
+namespace CipherShed
+{
+	AsyncFileIoRequest::AsyncFileIoRequest (IoType type, int fileHandle, const wstring &path, byte *buffer, size_t size, uint64 position)
+		: DataBuffer (buffer),
+		DataSize (size),
+		FileHandle (fileHandle),
+		Path (path),
+		Position (position),
+		Result (0),
+		Type (type),
+		Waited (false)
+	{
+	}
+
+	AsyncFileIoRequest::~AsyncFileIoRequest ()
+	{
+		// The buffer may be released by the owner only after the request has completed
+		if (!Waited)
+			CompletedEvent.Wait();
+	}
+
+	void AsyncFileIoRequest::Complete (int64 result)
+	{
+		Result = result;
+
+		// The request may be destroyed by the waiting thread as soon as the event is signaled
+		CompletedEvent.Signal();
+	}
+
+	void AsyncFileIoRequest::Execute ()
+	{
+		Complete (Transfer (0));
+	}
+
+	int64 AsyncFileIoRequest::Transfer (size_t offset) const
+	{
+		while (offset < DataSize)
+		{
+			ssize_t bytesTransferred;
+
+			if (Type == Read)
+				bytesTransferred = pread (FileHandle, DataBuffer + offset, DataSize - offset, Position + offset);
+			else
+				bytesTransferred = pwrite (FileHandle, DataBuffer + offset, DataSize - offset, Position + offset);
+
+			if (bytesTransferred == -1)
+			{
+				if (errno == EINTR)
+					continue;
+
+				return -(int64) errno;
+			}
+
+			if (bytesTransferred == 0)
+				break;
+
+			offset += bytesTransferred;
+		}
+
+		return offset;
+	}
+
+	uint64 AsyncFileIoRequest::Wait ()
+	{
+		if (!Waited)
+		{
+			CompletedEvent.Wait();
+			Waited = true;
+
+			// Requests partially transferred by the kernel are completed synchronously
+			if (Result > 0 && (uint64) Result < DataSize)
+				Result = Transfer ((size_t) Result);
+		}
+
+		if (Result < 0)
+		{
+			errno = (int) -Result;
+			throw SystemException (SRC_POS, Path);
+		}
+
+		if (Type == Write && (uint64) Result != DataSize)
+		{
+			errno = EIO;
+			throw SystemException (SRC_POS, Path);
+		}
+
+		return Result;
+	}
+
+#ifdef TC_ASYNC_FILE_IO_KERNEL_QUEUE
+	struct AsyncFileIoKernelQueue
+	{
+		AsyncFileIoKernelQueue ()
+			: RingHandle (-1),
+			Ring (nullptr),
+			RingSize (0),
+			SubmissionEntries (nullptr),
+			SubmissionEntriesSize (0),
+			SubmissionHead (nullptr),
+			SubmissionTail (nullptr),
+			SubmissionArray (nullptr),
+			SubmissionMask (0),
+			SubmissionEntryCount (0),
+			CompletionHead (nullptr),
+			CompletionTail (nullptr),
+			CompletionEntries (nullptr),
+			CompletionMask (0),
+			InFlightCount (0)
+		{
+		}
+
+		int RingHandle;
+		void *Ring;
+		size_t RingSize;
+		io_uring_sqe *SubmissionEntries;
+		size_t SubmissionEntriesSize;
+
+		volatile unsigned *SubmissionHead;
+		volatile unsigned *SubmissionTail;
+		volatile unsigned *SubmissionArray;
+		unsigned SubmissionMask;
+		unsigned SubmissionEntryCount;
+
+		volatile unsigned *CompletionHead;
+		volatile unsigned *CompletionTail;
+		io_uring_cqe *CompletionEntries;
+		unsigned CompletionMask;
+
+		volatile long InFlightCount;
+	};
+
+	static AsyncFileIoKernelQueue KernelQueue;
+	static Mutex KernelQueueSubmissionMutex;
+
+	static void CloseKernelQueue ()
+	{
+		if (KernelQueue.RingHandle == -1)
+			return;
+
+		if (KernelQueue.SubmissionEntries)
+			munmap (KernelQueue.SubmissionEntries, KernelQueue.SubmissionEntriesSize);
+
+		if (KernelQueue.Ring)
+			munmap (KernelQueue.Ring, KernelQueue.RingSize);
+
+		close (KernelQueue.RingHandle);
+		KernelQueue = AsyncFileIoKernelQueue();
+	}
+
+	static bool OpenKernelQueue (unsigned int depth)
+	{
+		io_uring_params params;
+		Memory::Zero (&params, sizeof (params));
+
+		int ringHandle = syscall (__NR_io_uring_setup, depth, &params);
+		if (ringHandle == -1)
+			return false;
+
+		KernelQueue.RingHandle = ringHandle;
+
+		// Positional reads and writes without I/O vectors and a single ring mapping are required
+		if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+		{
+			CloseKernelQueue();
+			return false;
+		}
+
+		size_t submissionRingSize = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+		size_t completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+		KernelQueue.RingSize = max (submissionRingSize, completionRingSize);
+
+		void *ring = mmap (nullptr, KernelQueue.RingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQ_RING);
+		if (ring == MAP_FAILED)
+		{
+			CloseKernelQueue();
+			return false;
+		}
+
+		KernelQueue.Ring = ring;
+
+		KernelQueue.SubmissionEntriesSize = params.sq_entries * sizeof (io_uring_sqe);
+		void *entries = mmap (nullptr, KernelQueue.SubmissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringHandle, IORING_OFF_SQES);
+		if (entries == MAP_FAILED)
+		{
+			CloseKernelQueue();
+			return false;
+		}
+
+		KernelQueue.SubmissionEntries = (io_uring_sqe *) entries;
+
+		byte *ringBytes = (byte *) ring;
+		KernelQueue.SubmissionHead = (unsigned *) (ringBytes + params.sq_off.head);
+		KernelQueue.SubmissionTail = (unsigned *) (ringBytes + params.sq_off.tail);
+		KernelQueue.SubmissionArray = (unsigned *) (ringBytes + params.sq_off.array);
+		KernelQueue.SubmissionMask = *(unsigned *) (ringBytes + params.sq_off.ring_mask);
+		KernelQueue.SubmissionEntryCount = params.sq_entries;
+
+		KernelQueue.CompletionHead = (unsigned *) (ringBytes + params.cq_off.head);
+		KernelQueue.CompletionTail = (unsigned *) (ringBytes + params.cq_off.tail);
+		KernelQueue.CompletionEntries = (io_uring_cqe *) (ringBytes + params.cq_off.cqes);
+		KernelQueue.CompletionMask = *(unsigned *) (ringBytes + params.cq_off.ring_mask);
+
+		KernelQueue.InFlightCount = 0;
+		return true;
+	}
+#endif // TC_ASYNC_FILE_IO_KERNEL_QUEUE
+
+	TC_THREAD_PROC AsyncFileIo::CompletionThreadProc (void *param)
+	{
+#ifdef TC_ASYNC_FILE_IO_KERNEL_QUEUE
+		int ringHandle = KernelQueue.RingHandle;
+
+		while (true)
+		{
+			if (syscall (__NR_io_uring_enter, ringHandle, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) == -1)
+			{
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+					continue;
+
+				SystemLog::WriteException (SystemException (SRC_POS));
+				break;
+			}
+
+			unsigned head = *KernelQueue.CompletionHead;
+			__sync_synchronize();
+			unsigned tail = *KernelQueue.CompletionTail;
+			__sync_synchronize();
+
+			while (head != tail)
+			{
+				const io_uring_cqe &entry = KernelQueue.CompletionEntries[head & KernelQueue.CompletionMask];
+				AsyncFileIoRequest *request = (AsyncFileIoRequest *) (uintptr_t) entry.user_data;
+				int64 result = entry.res;
+
+				++head;
+				__sync_synchronize();
+				*KernelQueue.CompletionHead = head;
+
+				__sync_fetch_and_sub (&KernelQueue.InFlightCount, 1);
+				request->Complete (result);
+			}
+		}
+#endif
+		return 0;
+	}
+
+	void AsyncFileIo::Initialize ()
+	{
+		int64 processId = getpid();
+
+		// Threads and the kernel queue are not inherited by forked processes
+		if (InitProcessId.Get() == processId)
+			return;
+
+		ScopeLock lock (InitMutex);
+
+		if (InitProcessId.Get() == processId)
+			return;
+
+		PendingRequests.clear();
+		KernelQueueAvailable = false;
+
+#ifdef TC_ASYNC_FILE_IO_KERNEL_QUEUE
+		CloseKernelQueue();
+
+		if (OpenKernelQueue (KernelQueueDepth))
+		{
+			try
+			{
+				Thread thread;
+				thread.Start (CompletionThreadProc);
+				KernelQueueAvailable = true;
+			}
+			catch (...)
+			{
+				CloseKernelQueue();
+			}
+		}
+#endif
+
+		if (!KernelQueueAvailable)
+		{
+			// I/O threads run until the process exits and the event they wait for is, therefore, never destroyed
+			RequestPendingEvent = new SyncEvent;
+
+			for (size_t i = 0; i < IoThreadCount; ++i)
+			{
+				Thread thread;
+				thread.Start (IoThreadProc);
+			}
+		}
+
+		InitProcessId.Set (processId);
+	}
+
+	TC_THREAD_PROC AsyncFileIo::IoThreadProc (void *param)
+	{
+		while (true)
+		{
+			AsyncFileIoRequest *request = nullptr;
+			{
+				ScopeLock lock (PendingRequestsMutex);
+
+				if (!PendingRequests.empty())
+				{
+					request = PendingRequests.front();
+					PendingRequests.pop_front();
+
+					if (!PendingRequests.empty())
+						RequestPendingEvent->Signal();
+				}
+			}
+
+			if (request)
+				request->Execute();
+			else
+				RequestPendingEvent->Wait();
+		}
+
+		return 0;
+	}
+
+	bool AsyncFileIo::IsKernelQueueAvailable ()
+	{
+		Initialize();
+		return KernelQueueAvailable;
+	}
+
+	void AsyncFileIo::Submit (AsyncFileIoRequest *request)
+	{
+		Initialize();
+
+		if (KernelQueueAvailable)
+		{
+			// Requests exceeding the capacity of the kernel queue are executed by the calling thread
+			if (!SubmitToKernelQueue (request))
+				request->Execute();
+			return;
+		}
+
+		{
+			ScopeLock lock (PendingRequestsMutex);
+			PendingRequests.push_back (request);
+		}
+
+		RequestPendingEvent->Signal();
+	}
+
+	bool AsyncFileIo::SubmitToKernelQueue (AsyncFileIoRequest *request)
+	{
+#ifdef TC_ASYNC_FILE_IO_KERNEL_QUEUE
+		if (request->GetSize() > 0x7fffFFFF)
+			return false;
+
+		ScopeLock lock (KernelQueueSubmissionMutex);
+
+		if ((unsigned) KernelQueue.InFlightCount >= KernelQueue.SubmissionEntryCount)
+			return false;
+
+		unsigned tail = *KernelQueue.SubmissionTail;
+		unsigned index = tail & KernelQueue.SubmissionMask;
+
+		io_uring_sqe &entry = KernelQueue.SubmissionEntries[index];
+		Memory::Zero (&entry, sizeof (entry));
+
+		entry.opcode = (request->GetType() == AsyncFileIoRequest::Read ? IORING_OP_READ : IORING_OP_WRITE);
+		entry.fd = request->GetFileHandle();
+		entry.addr = (uintptr_t) request->GetBuffer();
+		entry.len = (uint32) request->GetSize();
+		entry.off = request->GetPosition();
+		entry.user_data = (uintptr_t) request;
+
+		KernelQueue.SubmissionArray[index] = index;
+		__sync_synchronize();
+		*KernelQueue.SubmissionTail = tail + 1;
+		__sync_synchronize();
+
+		__sync_fetch_and_add (&KernelQueue.InFlightCount, 1);
+
+		int submitted;
+		do
+		{
+			submitted = syscall (__NR_io_uring_enter, KernelQueue.RingHandle, 1, 0, 0, nullptr, 0);
+
+		} while (submitted == -1 && errno == EINTR);
+
+		if (submitted != 1)
+		{
+			// The entry has not been consumed by the kernel
+			*KernelQueue.SubmissionTail = tail;
+			__sync_fetch_and_sub (&KernelQueue.InFlightCount, 1);
+			return false;
+		}
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool AsyncFileIo::KernelQueueAvailable = false;
+	Mutex AsyncFileIo::InitMutex;
+	SharedVal <int64> AsyncFileIo::InitProcessId (0);
+	list <AsyncFileIoRequest *> AsyncFileIo::PendingRequests;
+	Mutex AsyncFileIo::PendingRequestsMutex;
+	SyncEvent *AsyncFileIo::RequestPendingEvent;
+}
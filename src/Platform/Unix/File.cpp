@@ -307,6 +307,19 @@ namespace CipherShed
 		return bytesRead;
 	}
 
+	shared_ptr <AsyncFileIoRequest> File::ReadAtAsync (const BufferPtr &buffer, uint64 position) const
+	{
+		if_debug (ValidateState());
+
+#ifdef TC_TRACE_FILE_OPERATIONS
+		TraceFileOperation (FileHandle, Path, false, buffer.Size(), position);
+#endif
+		shared_ptr <AsyncFileIoRequest> request (new AsyncFileIoRequest (AsyncFileIoRequest::Read, FileHandle, wstring (Path), buffer, buffer.Size(), position));
+		AsyncFileIo::Submit (request.get());
+
+		return request;
+	}
+
 	void File::SeekAt (uint64 position) const
 	{
 		if_debug (ValidateState());
@@ -348,4 +361,17 @@ namespace CipherShed
 #endif
 		throw_sys_sub_if (pwrite (FileHandle, buffer, buffer.Size(), position) != (ssize_t) buffer.Size(), wstring (Path));
 	}
+
+	shared_ptr <AsyncFileIoRequest> File::WriteAtAsync (const ConstBufferPtr &buffer, uint64 position) const
+	{
+		if_debug (ValidateState());
+
+#ifdef TC_TRACE_FILE_OPERATIONS
+		TraceFileOperation (FileHandle, Path, true, buffer.Size(), position);
+#endif
+		shared_ptr <AsyncFileIoRequest> request (new AsyncFileIoRequest (AsyncFileIoRequest::Write, FileHandle, wstring (Path), const_cast <byte *> (buffer.Get()), buffer.Size(), position));
+		AsyncFileIo::Submit (request.get());
+
+		return request;
+	}
 }
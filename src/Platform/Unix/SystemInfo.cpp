@@ -9,6 +9,11 @@
 #include "../SystemException.h"
 #include "../SystemInfo.h"
 #include <sys/utsname.h>
+#include <unistd.h>
+
+#ifdef TC_LINUX
+#	include <sched.h>
+#endif
 
 namespace CipherShed
 {
@@ -28,6 +33,18 @@ namespace CipherShed
 
 	}
 
+	size_t SystemInfo::GetProcessorCount ()
+	{
+#ifdef TC_LINUX
+		// Only processors the process is allowed to run on are counted (e.g., in a container restricted by cpusets)
+		cpu_set_t cpuSet;
+		if (sched_getaffinity (0, sizeof (cpuSet), &cpuSet) == 0 && CPU_COUNT (&cpuSet) > 0)
+			return CPU_COUNT (&cpuSet);
+#endif
+		long cpuCount = sysconf (_SC_NPROCESSORS_ONLN);
+		return cpuCount < 1 ? 1 : (size_t) cpuCount;
+	}
+
 	vector <int> SystemInfo::GetVersion ()
 	{
 		struct utsname unameData;
@@ -9,6 +9,7 @@
 #include "../Platform/Platform.h"
 #include "Cipher.h"
 #include "../Crypto/Aes.h"
+#include "../Crypto/Aes_bitsliced.h"
 #include "../Crypto/Blowfish.h"
 #include "../Crypto/Des.h"
 #include "../Crypto/Cast.h"
@@ -42,10 +43,11 @@ namespace CipherShed
 		if (!Initialized)
 			throw NotInitialized (SRC_POS);
 
+		size_t blockSize = GetBlockSize();
 		while (blockCount-- > 0)
 		{
 			Decrypt (data);
-			data += GetBlockSize();
+			data += blockSize;
 		}
 	}
 
@@ -62,10 +64,11 @@ namespace CipherShed
 		if (!Initialized)
 			throw NotInitialized (SRC_POS);
 
+		size_t blockSize = GetBlockSize();
 		while (blockCount-- > 0)
 		{
 			Encrypt (data);
-			data += GetBlockSize();
+			data += blockSize;
 		}
 	}
 
@@ -83,6 +86,14 @@ namespace CipherShed
 		return l;
 	}
 
+	const byte *Cipher::GetScheduledKey () const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		return ScheduledKey.Ptr();
+	}
+
 	void Cipher::SetKey (const ConstBufferPtr &key)
 	{
 		if (key.Size() != GetKeySize ())
@@ -104,6 +115,8 @@ namespace CipherShed
 
 
 	// AES
+	static bool AesBitslicedSupportEnabled = true;
+
 	void CipherAES::Decrypt (byte *data) const
 	{
 #ifdef TC_AES_HW_CPU
@@ -133,6 +146,12 @@ namespace CipherShed
 		}
 		else
 #endif
+		if (!IsHwSupportAvailable() && IsBitslicedSupportAvailable())
+		{
+			aes_bitsliced_decrypt_blocks ((const aes_bitsliced_ctx *) (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx)),
+				data, data, blockCount);
+		}
+		else
 			Cipher::DecryptBlocks (data, blockCount);
 	}
 
@@ -146,6 +165,11 @@ namespace CipherShed
 			aes_encrypt (data, data, (aes_encrypt_ctx *) ScheduledKey.Ptr());
 	}
 
+	void CipherAES::EnableBitslicedSupport (bool enable)
+	{
+		AesBitslicedSupportEnabled = enable;
+	}
+
 	void CipherAES::EncryptBlocks (byte *data, size_t blockCount) const
 	{
 		if (!Initialized)
@@ -165,12 +189,52 @@ namespace CipherShed
 		}
 		else
 #endif
+		if (!IsHwSupportAvailable() && IsBitslicedSupportAvailable())
+		{
+			aes_bitsliced_encrypt_blocks ((const aes_bitsliced_ctx *) (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx)),
+				data, data, blockCount);
+		}
+		else
 			Cipher::EncryptBlocks (data, blockCount);
 	}
 
+	const byte *CipherAES::GetDecryptionKeySchedule () const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		return ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx);
+	}
+
+	const byte *CipherAES::GetEncryptionKeySchedule () const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		return ScheduledKey.Ptr();
+	}
+
 	size_t CipherAES::GetScheduledKeySize () const
 	{
-		return sizeof(aes_encrypt_ctx) + sizeof(aes_decrypt_ctx);
+		return sizeof(aes_encrypt_ctx) + sizeof(aes_decrypt_ctx) + sizeof(aes_bitsliced_ctx);
+	}
+
+	bool CipherAES::IsBitslicedSupportAvailable () const
+	{
+		static bool state = false;
+		static bool stateValid = false;
+
+		if (!stateValid)
+		{
+			state = aes_bitsliced_supported() ? true : false;
+			stateValid = true;
+		}
+		return state && AesBitslicedSupportEnabled;
+	}
+
+	bool CipherAES::IsBitslicedSupportEnabled ()
+	{
+		return AesBitslicedSupportEnabled;
 	}
 
 	bool CipherAES::IsHwSupportAvailable () const
@@ -197,6 +261,9 @@ namespace CipherShed
 
 		if (aes_decrypt_key256 (key, (aes_decrypt_ctx *) (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx))) != EXIT_SUCCESS)
 			throw CipherInitError (SRC_POS);
+
+		aes_bitsliced_set_key ((aes_encrypt_ctx *) ScheduledKey.Ptr(),
+			(aes_bitsliced_ctx *) (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx)));
 	}
 
 	
@@ -250,10 +317,26 @@ namespace CipherShed
 		serpent_decrypt (data, data, ScheduledKey);
 	}
 
+	void CipherSerpent::DecryptBlocks (byte *data, size_t blockCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		serpent_decrypt_blocks (data, data, blockCount, ScheduledKey);
+	}
+
 	void CipherSerpent::Encrypt (byte *data) const
 	{
 		serpent_encrypt (data, data, ScheduledKey);
 	}
+
+	void CipherSerpent::EncryptBlocks (byte *data, size_t blockCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		serpent_encrypt_blocks (data, data, blockCount, ScheduledKey);
+	}
 	
 	size_t CipherSerpent::GetScheduledKeySize () const
 	{
@@ -294,11 +377,27 @@ namespace CipherShed
 		twofish_decrypt ((TwofishInstance *) ScheduledKey.Ptr(), (unsigned int *)data, (unsigned int *)data);
 	}
 
+	void CipherTwofish::DecryptBlocks (byte *data, size_t blockCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		twofish_decrypt_blocks ((TwofishInstance *) ScheduledKey.Ptr(), data, data, blockCount);
+	}
+
 	void CipherTwofish::Encrypt (byte *data) const
 	{
 		twofish_encrypt ((TwofishInstance *) ScheduledKey.Ptr(), (unsigned int *)data, (unsigned int *)data);
 	}
 
+	void CipherTwofish::EncryptBlocks (byte *data, size_t blockCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		twofish_encrypt_blocks ((TwofishInstance *) ScheduledKey.Ptr(), data, data, blockCount);
+	}
+
 	size_t CipherTwofish::GetScheduledKeySize () const
 	{
 		return TWOFISH_KS;
@@ -33,6 +33,7 @@ namespace CipherShed
 		virtual size_t GetKeySize () const = 0;
 		virtual wstring GetName () const = 0;
 		virtual shared_ptr <Cipher> GetNew () const = 0;
+		const byte *GetScheduledKey () const;
 		virtual bool IsHwSupportAvailable () const { return false; }
 		static bool IsHwSupportEnabled () { return HwSupportEnabled; }
 		virtual void SetKey (const ConstBufferPtr &key);
@@ -92,19 +93,30 @@ namespace CipherShed
 	
 #define TC_CIPHER_ADD_METHODS \
 	virtual void DecryptBlocks (byte *data, size_t blockCount) const; \
+	static void EnableBitslicedSupport (bool enable); \
 	virtual void EncryptBlocks (byte *data, size_t blockCount) const; \
-	virtual bool IsHwSupportAvailable () const;
+	bool IsBitslicedSupportAvailable () const; \
+	static bool IsBitslicedSupportEnabled (); \
+	virtual bool IsHwSupportAvailable () const; \
+	const byte *GetDecryptionKeySchedule () const; \
+	const byte *GetEncryptionKeySchedule () const;
 
 	TC_CIPHER (AES, 16, 32);
 
+#undef TC_CIPHER_ADD_METHODS
+#define TC_CIPHER_ADD_METHODS \
+	virtual void DecryptBlocks (byte *data, size_t blockCount) const; \
+	virtual void EncryptBlocks (byte *data, size_t blockCount) const;
+
+	TC_CIPHER (Serpent, 16, 32);
+	TC_CIPHER (Twofish, 16, 32);
+
 #undef TC_CIPHER_ADD_METHODS
 #define TC_CIPHER_ADD_METHODS
 
 	TC_CIPHER (Blowfish, 8, 56);
 	TC_CIPHER (Cast5, 8, 16);
-	TC_CIPHER (Serpent, 16, 32);
 	TC_CIPHER (TripleDES, 8, 24);
-	TC_CIPHER (Twofish, 16, 32);
 
 #undef TC_CIPHER
 
@@ -55,6 +55,12 @@ namespace CipherShed
 		Mode->EncryptSectors (data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionAlgorithm::EncryptSectors (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		if_debug (ValidateState ());
+		Mode->EncryptSectors (source, destination, sectorIndex, sectorCount, sectorSize);
+	}
+
 	EncryptionAlgorithmList EncryptionAlgorithm::GetAvailableAlgorithms ()
 	{
 		EncryptionAlgorithmList l;
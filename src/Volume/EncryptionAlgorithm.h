@@ -29,6 +29,7 @@ namespace CipherShed
 		virtual void Encrypt (byte *data, uint64 length) const;
 		virtual void Encrypt (const BufferPtr &data) const;
 		virtual void EncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		static EncryptionAlgorithmList GetAvailableAlgorithms ();
 		virtual const CipherList &GetCiphers () const { return Ciphers; }
 		virtual shared_ptr <EncryptionAlgorithm> GetNew () const = 0;
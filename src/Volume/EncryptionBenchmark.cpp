@@ -0,0 +1,338 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#	include <time.h>
+#endif
+
+#include "EncryptionBenchmark.h"
+#include "EncryptionModeXTS.h"
+#include "VolumeHeader.h"
+#include "VolumeLayout.h"
+#include "../Common/Volumes.h"
+
+namespace CipherShed
+{
+	static size_t RoundUpBufferSize (size_t size, size_t unitSize)
+	{
+		if (size < unitSize)
+			return unitSize;
+
+		return size + (size % unitSize != 0 ? unitSize - size % unitSize : 0);
+	}
+
+	list <EncryptionBenchmarkResult> EncryptionBenchmark::BenchmarkEncryption (const list <size_t> &bufferSizes)
+	{
+		list <EncryptionBenchmarkResult> results;
+
+		bool hwSupportEnabled = Cipher::IsHwSupportEnabled();
+		bool bitslicedSupportEnabled = CipherAES::IsBitslicedSupportEnabled();
+		finally_do_arg2 (bool, hwSupportEnabled, bool, bitslicedSupportEnabled,
+		{
+			Cipher::EnableHwSupport (finally_arg);
+			CipherAES::EnableBitslicedSupport (finally_arg2);
+		});
+
+		foreach (shared_ptr <EncryptionAlgorithm> ea, EncryptionAlgorithm::GetAvailableAlgorithms())
+		{
+			EncryptionModeXTS *xtsMode = new EncryptionModeXTS;
+			shared_ptr <EncryptionMode> xts (xtsMode);
+			if (!ea->IsModeSupported (xts))
+				continue;
+
+			Cipher::EnableHwSupport (hwSupportEnabled);
+			CipherAES::EnableBitslicedSupport (bitslicedSupportEnabled);
+
+			SecureBuffer key (ea->GetKeySize());
+			for (size_t i = 0; i < key.Size(); ++i)
+				key[i] = (byte) i;
+
+			ea->SetKey (key);
+			ea->SetMode (xts);
+
+			list <size_t> tileSizes;
+			tileSizes.push_back (EncryptionModeXTS::DefaultCascadeTileSize);
+
+			if (ea->GetCiphers().size() > 1)
+				tileSizes.push_back (0);
+
+			foreach (const wstring &aesImplementation, GetAesImplementations (*ea))
+			{
+				if (!aesImplementation.empty())
+					SelectAesImplementation (aesImplementation);
+
+				// The XTS block functions are selected when the key is set
+				xts->SetKey (key);
+
+				foreach (size_t bufferSize, bufferSizes)
+				{
+					Buffer buffer (RoundUpBufferSize (bufferSize, ENCRYPTION_DATA_UNIT_SIZE));
+					buffer.Zero();
+
+					foreach (size_t tileSize, tileSizes)
+					{
+						xtsMode->SetCascadeTileSize (tileSize);
+
+						EncryptionBenchmarkResult result;
+						result.AesImplementation = aesImplementation;
+						result.AlgorithmName = ea->GetName();
+						result.BufferSize = buffer.Size();
+						result.CascadeTileSize = tileSize;
+
+						BenchmarkEncryption (*ea, buffer, result);
+						results.push_back (result);
+					}
+				}
+			}
+		}
+
+		return results;
+	}
+
+	void EncryptionBenchmark::BenchmarkEncryption (const EncryptionAlgorithm &ea, const BufferPtr &buffer, EncryptionBenchmarkResult &result)
+	{
+		uint64 unitCount = buffer.Size() / ENCRYPTION_DATA_UNIT_SIZE;
+		uint64 startTime = GetTime();
+
+		// CPU warm-up (prevents skewed results on systems where CPU frequency changes depending on the load)
+		do
+		{
+			ea.EncryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+		}
+		while (GetTime() - startTime < WarmUpTime);
+
+		uint64 size = 0;
+		uint64 time;
+		startTime = GetTime();
+
+		do
+		{
+			ea.EncryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+			size += buffer.Size();
+			time = GetTime() - startTime;
+		}
+		while (time < MeasurementTime);
+
+		result.EncryptionSpeed = size * 1000000 / time;
+
+		size = 0;
+		startTime = GetTime();
+
+		do
+		{
+			ea.DecryptSectors (buffer, 0, unitCount, ENCRYPTION_DATA_UNIT_SIZE);
+			size += buffer.Size();
+			time = GetTime() - startTime;
+		}
+		while (time < MeasurementTime);
+
+		result.DecryptionSpeed = size * 1000000 / time;
+	}
+
+	list <KdfBenchmarkResult> EncryptionBenchmark::BenchmarkKeyDerivation ()
+	{
+		list <KdfBenchmarkResult> results;
+
+		VolumePassword password (L"benchmark");
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		SecureBuffer key (VolumeHeader::GetLargestSerializedKeySize());
+
+		for (size_t i = 0; i < salt.Size(); ++i)
+			salt[i] = (byte) i;
+
+		foreach (shared_ptr <Pkcs5Kdf> kdf, Pkcs5Kdf::GetAvailableAlgorithms())
+		{
+			KdfBenchmarkResult result;
+			result.KdfName = kdf->GetName();
+			result.IterationCount = kdf->GetIterationCount();
+
+			uint64 derivationCount = 0;
+			uint64 time;
+			uint64 startTime = GetTime();
+
+			do
+			{
+				kdf->DeriveKey (key, password, salt);
+				++derivationCount;
+				time = GetTime() - startTime;
+			}
+			while (time < MeasurementTime);
+
+			result.DerivationTime = time / derivationCount;
+			results.push_back (result);
+		}
+
+		return results;
+	}
+
+	list <VolumeBenchmarkResult> EncryptionBenchmark::BenchmarkVolume (const FilePath &volumeFilePath, shared_ptr <EncryptionAlgorithm> ea, const list <size_t> &bufferSizes)
+	{
+		list <VolumeBenchmarkResult> results;
+
+		const size_t sectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+		size_t maxBufferSize = sectorSize;
+
+		foreach (size_t bufferSize, bufferSizes)
+			maxBufferSize = max (maxBufferSize, RoundUpBufferSize (bufferSize, sectorSize));
+
+		uint64 dataSize = max (MinVolumeDataSize, (uint64) maxBufferSize * 4);
+
+		shared_ptr <Volume> volume = CreateVolume (volumeFilePath, ea, dataSize);
+		finally_do_arg (shared_ptr <Volume>, volume, { finally_arg->Close(); });
+
+		Buffer buffer (maxBufferSize);
+		buffer.Zero();
+
+		// Allocate the whole data area on the host
+		for (uint64 offset = 0; offset < dataSize; offset += buffer.Size())
+			volume->WriteSectors (buffer.GetRange (0, (size_t) min ((uint64) buffer.Size(), dataSize - offset)), offset);
+
+		foreach (size_t bufferSize, bufferSizes)
+		{
+			BufferPtr data = buffer.GetRange (0, RoundUpBufferSize (bufferSize, sectorSize));
+
+			VolumeBenchmarkResult result;
+			result.AlgorithmName = ea->GetName();
+			result.BufferSize = data.Size();
+
+			uint64 offset = 0;
+			uint64 size = 0;
+			uint64 time;
+			uint64 startTime = GetTime();
+
+			do
+			{
+				if (offset + data.Size() > dataSize)
+					offset = 0;
+
+				volume->WriteSectors (data, offset);
+				offset += data.Size();
+				size += data.Size();
+				time = GetTime() - startTime;
+			}
+			while (time < MeasurementTime);
+
+			result.WriteSpeed = size * 1000000 / time;
+
+			offset = 0;
+			size = 0;
+			startTime = GetTime();
+
+			do
+			{
+				if (offset + data.Size() > dataSize)
+					offset = 0;
+
+				volume->ReadSectors (data, offset);
+				offset += data.Size();
+				size += data.Size();
+				time = GetTime() - startTime;
+			}
+			while (time < MeasurementTime);
+
+			result.ReadSpeed = size * 1000000 / time;
+			results.push_back (result);
+		}
+
+		return results;
+	}
+
+	shared_ptr <Volume> EncryptionBenchmark::CreateVolume (const FilePath &volumeFilePath, shared_ptr <EncryptionAlgorithm> ea, uint64 dataSize)
+	{
+		shared_ptr <VolumePassword> password (new VolumePassword (L"benchmark"));
+		shared_ptr <Pkcs5Kdf> kdf = Pkcs5Kdf::GetAvailableAlgorithms().front();
+
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		SecureBuffer dataKey (ea->GetKeySize() * 2);
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+
+		// The volume is temporary and its keys do not need to be secret
+		for (size_t i = 0; i < salt.Size(); ++i)
+			salt[i] = (byte) i;
+
+		for (size_t i = 0; i < dataKey.Size(); ++i)
+			dataKey[i] = (byte) (i * 7 + 1);
+
+		kdf->DeriveKey (headerKey, *password, salt);
+
+		VolumeHeaderCreationOptions options;
+		options.DataKey = dataKey;
+		options.EA = ea->GetNew();
+		options.HeaderKey = headerKey;
+		options.Kdf = kdf;
+		options.Salt = salt;
+		options.SectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+		options.Type = VolumeType::Normal;
+		options.VolumeDataSize = dataSize;
+		options.VolumeDataStart = TC_VOLUME_DATA_OFFSET;
+
+		SecureBuffer headerGroup (TC_VOLUME_HEADER_GROUP_SIZE);
+		headerGroup.Zero();
+
+		VolumeHeader header (TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		header.Create (headerGroup.GetRange (TC_VOLUME_HEADER_OFFSET, TC_VOLUME_HEADER_EFFECTIVE_SIZE), options);
+
+		{
+			File volumeFile;
+			volumeFile.Open (volumeFilePath, File::CreateReadWrite);
+			volumeFile.WriteAt (headerGroup, 0);
+			volumeFile.WriteAt (headerGroup, TC_VOLUME_DATA_OFFSET + dataSize);
+		}
+
+		shared_ptr <Volume> volume (new Volume);
+		volume->Open (VolumePath (wstring (volumeFilePath)), false, password, shared_ptr <KeyfileList> (), VolumeProtection::None,
+			shared_ptr <VolumePassword> (), shared_ptr <KeyfileList> (), false, VolumeType::Normal);
+
+		return volume;
+	}
+
+	list <wstring> EncryptionBenchmark::GetAesImplementations (const EncryptionAlgorithm &ea)
+	{
+		list <wstring> implementations;
+
+		foreach_ref (const Cipher &cipher, ea.GetCiphers())
+		{
+			if (typeid (cipher) == typeid (CipherAES))
+			{
+				const CipherAES &aes = static_cast <const CipherAES &> (cipher);
+
+				if (aes.IsHwSupportAvailable())
+					implementations.push_back (L"AES-NI");
+
+				if (aes.IsBitslicedSupportAvailable())
+					implementations.push_back (L"Bitsliced");
+
+				implementations.push_back (L"Table");
+				return implementations;
+			}
+		}
+
+		implementations.push_back (wstring());
+		return implementations;
+	}
+
+	uint64 EncryptionBenchmark::GetTime ()
+	{
+#ifdef TC_WINDOWS
+		LARGE_INTEGER counter, frequency;
+		QueryPerformanceCounter (&counter);
+		QueryPerformanceFrequency (&frequency);
+		return (uint64) counter.QuadPart * 1000000 / frequency.QuadPart;
+#else
+		struct timespec ts;
+		clock_gettime (CLOCK_MONOTONIC, &ts);
+		return (uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+	}
+
+	void EncryptionBenchmark::SelectAesImplementation (const wstring &implementation)
+	{
+		Cipher::EnableHwSupport (implementation == L"AES-NI");
+		CipherAES::EnableBitslicedSupport (implementation == L"Bitsliced");
+	}
+}
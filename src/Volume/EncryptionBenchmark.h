@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_EncryptionBenchmark
+#define TC_HEADER_Volume_EncryptionBenchmark
+
+#include "../Platform/Platform.h"
+#include "EncryptionAlgorithm.h"
+#include "Pkcs5Kdf.h"
+#include "Volume.h"
+
+namespace CipherShed
+{
+	struct EncryptionBenchmarkResult
+	{
+		wstring AesImplementation;	// "AES-NI", "Bitsliced" or "Table"; empty if the algorithm does not use AES
+		wstring AlgorithmName;
+		size_t BufferSize;
+		size_t CascadeTileSize;	// See EncryptionModeXTS::DefaultCascadeTileSize
+		uint64 DecryptionSpeed;	// Bytes per second
+		uint64 EncryptionSpeed;	// Bytes per second
+	};
+
+	struct KdfBenchmarkResult
+	{
+		wstring KdfName;
+		int IterationCount;
+		uint64 DerivationTime;	// Microseconds per derived key
+	};
+
+	struct VolumeBenchmarkResult
+	{
+		wstring AlgorithmName;
+		size_t BufferSize;
+		uint64 ReadSpeed;		// Bytes per second
+		uint64 WriteSpeed;		// Bytes per second
+	};
+
+	// Measures the performance of the encryption algorithms in XTS mode, of the header key derivation functions,
+	// and of the Volume read/write path. The encryption thread pool is used if it is running. Cascades are
+	// measured both tiled and with each cipher processing the whole buffer in turn. Algorithms using AES are measured
+	// with each available AES implementation. The volume file used by BenchmarkVolume() is deleted by the caller.
+	class EncryptionBenchmark
+	{
+	public:
+		static list <EncryptionBenchmarkResult> BenchmarkEncryption (const list <size_t> &bufferSizes);
+		static list <KdfBenchmarkResult> BenchmarkKeyDerivation ();
+		static list <VolumeBenchmarkResult> BenchmarkVolume (const FilePath &volumeFilePath, shared_ptr <EncryptionAlgorithm> ea, const list <size_t> &bufferSizes);
+
+		static const uint64 MeasurementTime = 200 * 1000;	// Microseconds
+		static const uint64 MinVolumeDataSize = 32 * 1024 * 1024;
+		static const uint64 WarmUpTime = 20 * 1000;			// Microseconds
+
+	protected:
+		static void BenchmarkEncryption (const EncryptionAlgorithm &ea, const BufferPtr &buffer, EncryptionBenchmarkResult &result);
+		static shared_ptr <Volume> CreateVolume (const FilePath &volumeFilePath, shared_ptr <EncryptionAlgorithm> ea, uint64 dataSize);
+		static list <wstring> GetAesImplementations (const EncryptionAlgorithm &ea);
+		static uint64 GetTime ();
+		static void SelectAesImplementation (const wstring &implementation);
+
+	private:
+		EncryptionBenchmark ();
+		EncryptionBenchmark (const EncryptionBenchmark &);
+		EncryptionBenchmark &operator= (const EncryptionBenchmark &);
+	};
+}
+
+#endif // TC_HEADER_Volume_EncryptionBenchmark
@@ -32,6 +32,41 @@ namespace CipherShed
 		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionMode::EncryptSectors (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, source, destination, sectorIndex, sectorCount, sectorSize);
+	}
+
+	void EncryptionMode::EncryptSectorsCurrentThread (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		if (source == destination)
+		{
+			EncryptSectorsCurrentThread (destination, sectorIndex, sectorCount, sectorSize);
+			return;
+		}
+
+		// Modes without native support for separate buffers copy the data in small portions, which are
+		// encrypted while still cached
+		uint64 copySectorCount = OutOfPlaceCopySize / sectorSize;
+		if (copySectorCount < 1)
+			copySectorCount = 1;
+
+		while (sectorCount > 0)
+		{
+			if (copySectorCount > sectorCount)
+				copySectorCount = sectorCount;
+
+			size_t copySize = (size_t) copySectorCount * sectorSize;
+			Memory::Copy (destination, source, copySize);
+			EncryptSectorsCurrentThread (destination, sectorIndex, copySectorCount, sectorSize);
+
+			source += copySize;
+			destination += copySize;
+			sectorIndex += copySectorCount;
+			sectorCount -= copySectorCount;
+		}
+	}
+
 	EncryptionModeList EncryptionMode::GetAvailableModes ()
 	{
 		EncryptionModeList l;
@@ -28,7 +28,9 @@ namespace CipherShed
 		virtual void DecryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const = 0;
 		virtual void Encrypt (byte *data, uint64 length) const = 0;
 		virtual void EncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectors (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		virtual void EncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const = 0;
+		virtual void EncryptSectorsCurrentThread (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		static EncryptionModeList GetAvailableModes ();
 		virtual const SecureBuffer &GetKey () const { throw NotApplicable (SRC_POS); }
 		virtual size_t GetKeySize () const = 0;
@@ -48,6 +50,7 @@ namespace CipherShed
 		virtual void ValidateParameters (byte *data, uint64 sectorCount, size_t sectorSize) const;
 
 		static const size_t EncryptionDataUnitSize = ENCRYPTION_DATA_UNIT_SIZE;
+		static const size_t OutOfPlaceCopySize = 16 * 1024;
 
 		CipherList Ciphers;
 		bool KeySet;
@@ -8,6 +8,7 @@
 
 #include "../Platform/Memory.h"
 #include "../Common/Crc.h"
+#include "../Common/Crypto.h"
 #include "../Common/Endian.h"
 #include "EncryptionModeCBC.h"
 
@@ -42,69 +43,58 @@ namespace CipherShed
 		if (blockSize != 8 && blockSize != 16)
 			throw ParameterIncorrect (SRC_POS);
 
-		uint32 *data32 = (uint32 *) data;
-		uint32 bufIV[4];
-		uint32 ct[4];
-		uint64 i;
-
-		bufIV[0] = iv[0];
-		bufIV[1] = iv[1];
-		if (blockSize == 16)
+		for (CipherList::const_iterator iCipherList = ciphers.begin();
+			iCipherList != ciphers.end();
+			++iCipherList)
 		{
-			bufIV[2] = iv[2];
-			bufIV[3] = iv[3];
+			if ((*iCipherList)->GetBlockSize () != blockSize)
+				throw ParameterIncorrect (SRC_POS);
 		}
 
-		for (i = 0; i < length / blockSize; i++)
+		// Each plaintext block depends only on ciphertext. Batches of blocks are therefore decrypted
+		// at once by the multi-block cipher implementations and XORed with the preceding ciphertext blocks afterwards.
+		uint64 *data64 = (uint64 *) data;
+		uint64 whitening64 = *(const uint64 *) whitening;
+		size_t blockWords = blockSize / sizeof (uint64);
+		uint64 blockCount = length / blockSize;
+
+		// Block preceding the batch followed by the ciphertext of the batch
+		uint64 ct[(ENCRYPTION_DATA_UNIT_SIZE + Cipher::MaxBlockSize) / sizeof (uint64)];
+		memcpy (ct, iv, blockSize);
+
+		while (blockCount > 0)
 		{
-			// Dewhitening
-			data32[0] ^= whitening[0];
-			data32[1] ^= whitening[1];
-			if (blockSize == 16)
-			{
-				data32[2] ^= whitening[0];
-				data32[3] ^= whitening[1];
-			}
+			size_t batchBlockCount = (size_t) min (blockCount, (uint64) (ENCRYPTION_DATA_UNIT_SIZE / blockSize));
+			size_t batchWords = batchBlockCount * blockWords;
+			size_t i;
 
-			// CBC
-			ct[0] = data32[0];
-			ct[1] = data32[1];
-			if (blockSize == 16)
+			// Dewhitening
+			for (i = 0; i < batchWords; i++)
 			{
-				ct[2] = data32[2];
-				ct[3] = data32[3];
+				data64[i] ^= whitening64;
+				ct[blockWords + i] = data64[i];
 			}
 
 			for (CipherList::const_reverse_iterator iCipherList = ciphers.rbegin();
 				iCipherList != ciphers.rend();
 				++iCipherList)
 			{
-				const Cipher &c = **iCipherList;
-
-				if (c.GetBlockSize () != blockSize)
-					throw ParameterIncorrect (SRC_POS);
-
-				c.DecryptBlock ((byte *) data32);
+				(*iCipherList)->DecryptBlocks ((byte *) data64, batchBlockCount);
 			}
 
 			// CBC
-			data32[0] ^= bufIV[0];
-			data32[1] ^= bufIV[1];
-			bufIV[0] = ct[0];
-			bufIV[1] = ct[1];
-			if (blockSize == 16)
-			{
-				data32[2] ^= bufIV[2];
-				data32[3] ^= bufIV[3];
-				bufIV[2] = ct[2];
-				bufIV[3] = ct[3];
-			}
+			for (i = 0; i < batchWords; i++)
+				data64[i] ^= ct[i];
 
-			data32 += blockSize / sizeof(*data32);
+			for (i = 0; i < blockWords; i++)
+				ct[i] = ct[batchWords + i];
+
+			data64 += batchWords;
+			blockCount -= batchBlockCount;
 		}
 
-		Memory::Erase (bufIV, sizeof (bufIV));
 		Memory::Erase (ct, sizeof (ct));
+		Memory::Erase (&whitening64, sizeof (whitening64));
 	}
 
 	void EncryptionModeCBC::DecryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
@@ -7,6 +7,7 @@
 */
 
 #include "EncryptionModeLRW.h"
+#include "../Common/Crypto.h"
 #include "../Common/GfMul.h"
 
 namespace CipherShed
@@ -19,27 +20,21 @@ namespace CipherShed
 
 	void EncryptionModeLRW::DecryptBuffer (byte *data, uint64 length, uint64 blockIndex) const
 	{
-		size_t blockSize = Ciphers.front()->GetBlockSize();
-		if (blockSize != 8 && blockSize != 16)
-			throw ParameterIncorrect (SRC_POS);
-
-		byte i[8];
-		*(uint64 *)i = Endian::Big (blockIndex);
+		size_t blockSize = GetBlockSize();
+		uint64 blockCount = length / blockSize;
 
 		byte t[Cipher::MaxBlockSize];
+		byte whiteningValues[ENCRYPTION_DATA_UNIT_SIZE];
 
-		for (unsigned int b = 0; b < length / blockSize; b++)
+		InitWhiteningValue (t, blockIndex);
+
+		while (blockCount > 0)
 		{
-			if (blockSize == 8)
-			{
-				Gf64MulTab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			}
-			else
-			{
-				Gf128MulBy64Tab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor128 ((uint64 *)data, (uint64 *)t);
-			}
+			size_t batchBlockCount = (size_t) min (blockCount, (uint64) (sizeof (whiteningValues) / blockSize));
+			size_t batchLength = batchBlockCount * blockSize;
+
+			GetWhiteningValues (whiteningValues, batchBlockCount, t, blockIndex);
+			XorBuffer (data, whiteningValues, batchLength);
 
 			for (CipherList::const_reverse_iterator iCipherList = Ciphers.rbegin();
 				iCipherList != Ciphers.rend();
@@ -50,19 +45,17 @@ namespace CipherShed
 				if (c.GetBlockSize () != blockSize)
 					throw ParameterIncorrect (SRC_POS);
 
-				c.DecryptBlock (data);
+				c.DecryptBlocks (data, batchBlockCount);
 			}
 
-			if (blockSize == 8)
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			else
-				Xor128 ((uint64 *)data, (uint64 *)t);
+			XorBuffer (data, whiteningValues, batchLength);
 
-			data += blockSize;
-			IncrementBlockIndex (i);
+			data += batchLength;
+			blockCount -= batchBlockCount;
 		}
 
 		Memory::Erase (t, sizeof (t));
+		Memory::Erase (whiteningValues, sizeof (whiteningValues));
 	}
 
 	void EncryptionModeLRW::DecryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
@@ -83,27 +76,21 @@ namespace CipherShed
 
 	void EncryptionModeLRW::EncryptBuffer (byte *data, uint64 length, uint64 blockIndex) const
 	{
-		size_t blockSize = Ciphers.front()->GetBlockSize();
-		if (blockSize != 8 && blockSize != 16)
-			throw ParameterIncorrect (SRC_POS);
-
-		byte i[8];
-		*(uint64 *)i = Endian::Big (blockIndex);
+		size_t blockSize = GetBlockSize();
+		uint64 blockCount = length / blockSize;
 
 		byte t[Cipher::MaxBlockSize];
+		byte whiteningValues[ENCRYPTION_DATA_UNIT_SIZE];
+
+		InitWhiteningValue (t, blockIndex);
 
-		for (unsigned int b = 0; b < length / blockSize; b++)
+		while (blockCount > 0)
 		{
-			if (blockSize == 8)
-			{
-				Gf64MulTab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			}
-			else
-			{
-				Gf128MulBy64Tab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor128 ((uint64 *)data, (uint64 *)t);
-			}
+			size_t batchBlockCount = (size_t) min (blockCount, (uint64) (sizeof (whiteningValues) / blockSize));
+			size_t batchLength = batchBlockCount * blockSize;
+
+			GetWhiteningValues (whiteningValues, batchBlockCount, t, blockIndex);
+			XorBuffer (data, whiteningValues, batchLength);
 
 			for (CipherList::const_iterator iCipherList = Ciphers.begin();
 				iCipherList != Ciphers.end();
@@ -114,19 +101,17 @@ namespace CipherShed
 				if (c.GetBlockSize () != blockSize)
 					throw ParameterIncorrect (SRC_POS);
 
-				c.EncryptBlock (data);
+				c.EncryptBlocks (data, batchBlockCount);
 			}
 
-			if (blockSize == 8)
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			else
-				Xor128 ((uint64 *)data, (uint64 *)t);
+			XorBuffer (data, whiteningValues, batchLength);
 
-			data += blockSize;
-			IncrementBlockIndex (i);
+			data += batchLength;
+			blockCount -= batchBlockCount;
 		}
 
 		Memory::Erase (t, sizeof (t));
+		Memory::Erase (whiteningValues, sizeof (whiteningValues));
 	}
 
 	void EncryptionModeLRW::EncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
@@ -139,12 +124,36 @@ namespace CipherShed
 			SectorToBlockIndex (sectorIndex));
 	}
 
-	void EncryptionModeLRW::IncrementBlockIndex (byte *index) const
+	size_t EncryptionModeLRW::GetBlockSize () const
+	{
+		size_t blockSize = Ciphers.front()->GetBlockSize();
+		if (blockSize != 8 && blockSize != 16)
+			throw ParameterIncorrect (SRC_POS);
+
+		return blockSize;
+	}
+
+	void EncryptionModeLRW::GetWhiteningValues (byte *whiteningValues, size_t blockCount, byte *t, uint64 &blockIndex) const
 	{
-		if (index[7] != 0xff)
-			index[7]++;
+		// The whitening value of each following block is derived from that of the previous block
+		// with a single XOR (see Gf128MulBy64TabSeq)
+		if (GetBlockSize() == 8)
+			Gf64MulTabSeq (blockIndex, t, whiteningValues, blockCount, (GfCtx *) (GfContext.Ptr()));
 		else
-			*(uint64 *)index = Endian::Big ( Endian::Big (*(uint64 *)index) + 1 );
+			Gf128MulBy64TabSeq (blockIndex, t, whiteningValues, blockCount, (GfCtx *) (GfContext.Ptr()));
+
+		blockIndex += blockCount;
+	}
+
+	void EncryptionModeLRW::InitWhiteningValue (byte *t, uint64 blockIndex) const
+	{
+		byte i[8];
+		*(uint64 *)i = Endian::Big (blockIndex);
+
+		if (GetBlockSize() == 8)
+			Gf64MulTab (i, t, (GfCtx *) (GfContext.Ptr()));
+		else
+			Gf128MulBy64Tab (i, t, (GfCtx *) (GfContext.Ptr()));
 	}
 
 	uint64 EncryptionModeLRW::SectorToBlockIndex (uint64 sectorIndex) const
@@ -182,14 +191,12 @@ namespace CipherShed
 		KeySet = true;
 	}
 
-	void EncryptionModeLRW::Xor64 (uint64 *a, const uint64 *b) const
+	void EncryptionModeLRW::XorBuffer (byte *data, const byte *whiteningValues, size_t length) const
 	{
-		*a ^= *b;
-	}
+		uint64 *data64 = (uint64 *) data;
+		const uint64 *whiteningValues64 = (const uint64 *) whiteningValues;
 
-	void EncryptionModeLRW::Xor128 (uint64 *a, const uint64 *b) const
-	{
-		*a++ ^= *b++;
-		*a ^= *b;
+		for (size_t i = 0; i < length / sizeof (uint64); ++i)
+			*data64++ ^= *whiteningValues64++;
 	}
 }
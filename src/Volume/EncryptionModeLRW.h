@@ -33,10 +33,11 @@ namespace CipherShed
 	protected:
 		void DecryptBuffer (byte *plainText, uint64 length, uint64 blockIndex) const;
 		void EncryptBuffer (byte *plainText, uint64 length, uint64 blockIndex) const;
-		void IncrementBlockIndex (byte *index) const;
+		size_t GetBlockSize () const;
+		void GetWhiteningValues (byte *whiteningValues, size_t blockCount, byte *t, uint64 &blockIndex) const;
+		void InitWhiteningValue (byte *t, uint64 blockIndex) const;
 		uint64 SectorToBlockIndex (uint64 sectorIndex) const;
-		void Xor64 (uint64 *a, const uint64 *b) const;
-		void Xor128 (uint64 *a, const uint64 *b) const;
+		void XorBuffer (byte *data, const byte *whiteningValues, size_t length) const;
 
 		SecureBuffer GfContext;
 		SecureBuffer Key;
@@ -11,165 +11,73 @@
 
 namespace CipherShed
 {
-	void EncryptionModeXTS::Encrypt (byte *data, uint64 length) const
-	{
-		EncryptBuffer (data, length, 0);
-	}
+#ifdef TC_AES_HW_CPU
+	// The AES-NI kernel computes the whitening values in registers and processes multiple blocks in parallel
 
-	void EncryptionModeXTS::EncryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const
+	void EncryptionModeXTS::DecryptBufferAesHw (const byte *ks, const byte *ks2, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
 	{
-		if_debug (ValidateState());
-
-		CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.begin();
-
-		for (CipherList::const_iterator iCipher = Ciphers.begin(); iCipher != Ciphers.end(); ++iCipher)
-		{
-			EncryptBufferXTS (**iCipher, **iSecondaryCipher, data, length, startDataUnitNo, 0);
-			++iSecondaryCipher;
-		}
+		if (length % BYTES_PER_XTS_BLOCK)
+			TC_THROW_FATAL_EXCEPTION;
 
-		assert (iSecondaryCipher == SecondaryCiphers.end());
+		aes_hw_cpu_decrypt_xts (ks + sizeof (aes_encrypt_ctx), ks2, buffer, buffer, length, startDataUnitNo, startCipherBlockNo);
 	}
 
-	void EncryptionModeXTS::EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const
+	void EncryptionModeXTS::EncryptBufferAesHw (const byte *ks, const byte *ks2, const byte *source, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo)
 	{
-		byte finalCarry;
-		byte whiteningValues [ENCRYPTION_DATA_UNIT_SIZE];
-		byte whiteningValue [BYTES_PER_XTS_BLOCK];
-		byte byteBufUnitNo [BYTES_PER_XTS_BLOCK];
-		uint64 *whiteningValuesPtr64 = (uint64 *) whiteningValues;
-		uint64 *whiteningValuePtr64 = (uint64 *) whiteningValue;
-		uint64 *bufPtr = (uint64 *) buffer;
-		uint64 *dataUnitBufPtr;
-		unsigned int startBlock = startCipherBlockNo, endBlock, block;
-		uint64 *const finalInt64WhiteningValuesPtr = whiteningValuesPtr64 + sizeof (whiteningValues) / sizeof (*whiteningValuesPtr64) - 1;
-		uint64 blockCount, dataUnitNo;
-
-		startDataUnitNo += SectorOffset;
-
-		/* The encrypted data unit number (i.e. the resultant ciphertext block) is to be multiplied in the
-		finite field GF(2^128) by j-th power of n, where j is the sequential plaintext/ciphertext block
-		number and n is 2, a primitive element of GF(2^128). This can be (and is) simplified and implemented
-		as a left shift of the preceding whitening value by one bit (with carry propagating). In addition, if
-		the shift of the highest byte results in a carry, 135 is XORed into the lowest byte. The value 135 is
-		derived from the modulus of the Galois Field (x^128+x^7+x^2+x+1). */
-
-		// Convert the 64-bit data unit number into a little-endian 16-byte array. 
-		// Note that as we are converting a 64-bit number into a 16-byte array we can always zero the last 8 bytes.
-		dataUnitNo = startDataUnitNo;
-		*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
-		*((uint64 *) byteBufUnitNo + 1) = 0;
-
 		if (length % BYTES_PER_XTS_BLOCK)
 			TC_THROW_FATAL_EXCEPTION;
 
-		blockCount = length / BYTES_PER_XTS_BLOCK;
-
-		// Process all blocks in the buffer
-		while (blockCount > 0)
-		{
-			if (blockCount < BLOCKS_PER_XTS_DATA_UNIT)
-				endBlock = startBlock + (unsigned int) blockCount;
-			else
-				endBlock = BLOCKS_PER_XTS_DATA_UNIT;
-
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
-			whiteningValuePtr64 = (uint64 *) whiteningValue;
-
-			// Encrypt the data unit number using the secondary key (in order to generate the first 
-			// whitening value for this data unit)
-			*whiteningValuePtr64 = *((uint64 *) byteBufUnitNo);
-			*(whiteningValuePtr64 + 1) = 0;
-			secondaryCipher.EncryptBlock (whiteningValue);
-
-			// Generate subsequent whitening values for blocks in this data unit. Note that all generated 128-bit
-			// whitening values are stored in memory as a sequence of 64-bit integers in reverse order.
-			for (block = 0; block < endBlock; block++)
-			{
-				if (block >= startBlock)
-				{
-					*whiteningValuesPtr64-- = *whiteningValuePtr64++;
-					*whiteningValuesPtr64-- = *whiteningValuePtr64;
-				}
-				else
-					whiteningValuePtr64++;
-
-				// Derive the next whitening value
-
-#if BYTE_ORDER == LITTLE_ENDIAN
-
-				// Little-endian platforms
-
-				finalCarry = 
-					(*whiteningValuePtr64 & 0x8000000000000000ULL) ?
-					135 : 0;
-
-				*whiteningValuePtr64-- <<= 1;
-
-				if (*whiteningValuePtr64 & 0x8000000000000000ULL)
-					*(whiteningValuePtr64 + 1) |= 1;	
-
-				*whiteningValuePtr64 <<= 1;
-#else
-
-				// Big-endian platforms
-
-				finalCarry = 
-					(*whiteningValuePtr64 & 0x80) ?
-					135 : 0;
+		aes_hw_cpu_encrypt_xts (ks, ks2, source, buffer, length, startDataUnitNo, startCipherBlockNo);
+	}
+#endif
 
-				*whiteningValuePtr64 = Endian::Little (Endian::Little (*whiteningValuePtr64) << 1);
+	void EncryptionModeXTS::Encrypt (byte *data, uint64 length) const
+	{
+		EncryptBuffer (data, length, 0);
+	}
 
-				whiteningValuePtr64--;
+	void EncryptionModeXTS::EncryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const
+	{
+		EncryptBuffer (data, data, length, startDataUnitNo);
+	}
 
-				if (*whiteningValuePtr64 & 0x80)
-					*(whiteningValuePtr64 + 1) |= 0x0100000000000000ULL;	
+	void EncryptionModeXTS::EncryptBuffer (const byte *source, byte *data, uint64 length, uint64 startDataUnitNo) const
+	{
+		if_debug (ValidateState());
 
-				*whiteningValuePtr64 = Endian::Little (Endian::Little (*whiteningValuePtr64) << 1);
-#endif
+		if (EngineFunctions.size() != Ciphers.size())
+			throw NotInitialized (SRC_POS);
 
-				whiteningValue[0] ^= finalCarry;
-			}
+		startDataUnitNo += SectorOffset;
 
-			dataUnitBufPtr = bufPtr;
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
+		// Each tile passes through all ciphers of a cascade while it is in the CPU cache
+		uint64 tileSize = (Ciphers.size() > 1 && CascadeTileSize != 0) ? CascadeTileSize : length;
 
-			// Encrypt all blocks in this data unit
+		for (uint64 offset = 0; offset < length; offset += tileSize)
+		{
+			uint64 size = min (tileSize, length - offset);
+			const byte *tileSource = source + offset;
 
-			for (block = startBlock; block < endBlock; block++)
+			// The first cipher reads the source buffer and the remaining ones process the output in place
+			for (size_t i = 0; i < Ciphers.size(); ++i)
 			{
-				// Pre-whitening
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-			}
+				EngineFunctions[i].EncryptBuffer (Ciphers[i]->GetScheduledKey(), SecondaryCiphers[i]->GetScheduledKey(),
+					tileSource, data + offset, size, startDataUnitNo + offset / ENCRYPTION_DATA_UNIT_SIZE, 0);
 
-			// Actual encryption
-			cipher.EncryptBlocks ((byte *) dataUnitBufPtr, endBlock - startBlock);
-
-			bufPtr = dataUnitBufPtr;
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
-
-			for (block = startBlock; block < endBlock; block++)
-			{
-				// Post-whitening
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-				*bufPtr++ ^= *whiteningValuesPtr64--;
+				tileSource = data + offset;
 			}
-
-			blockCount -= endBlock - startBlock;
-			startBlock = 0;
-			dataUnitNo++;
-			*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
 		}
-
-		FAST_ERASE64 (whiteningValue, sizeof (whiteningValue));
-		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
 	}
 
 	void EncryptionModeXTS::EncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
 	{
 		EncryptBuffer (data, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
 	}
+
+	void EncryptionModeXTS::EncryptSectorsCurrentThread (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
+	{
+		EncryptBuffer (source, destination, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
+	}
 	
 	size_t EncryptionModeXTS::GetKeySize () const
 	{
@@ -185,150 +93,60 @@ namespace CipherShed
 		return keySize;
 	}
 
-	void EncryptionModeXTS::Decrypt (byte *data, uint64 length) const
+	XtsEngineFunctions EncryptionModeXTS::GetEngineFunctions (const Cipher &cipher)
 	{
-		DecryptBuffer (data, length, 0);
-	}
+		if (typeid (cipher) == typeid (CipherAES))
+		{
+#ifdef TC_AES_HW_CPU
+			if (cipher.IsHwSupportAvailable())
+			{
+				XtsEngineFunctions functions;
+				functions.DecryptBuffer = &DecryptBufferAesHw;
+				functions.EncryptBuffer = &EncryptBufferAesHw;
+				return functions;
+			}
+#endif
+			if (static_cast <const CipherAES &> (cipher).IsBitslicedSupportAvailable())
+				return XtsEngine <XtsCipherAESBitsliced>::GetFunctions();
 
-	void EncryptionModeXTS::DecryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const
-	{
-		if_debug (ValidateState());
+			return XtsEngine <XtsCipherAES>::GetFunctions();
+		}
 
-		CipherList::const_iterator iSecondaryCipher = SecondaryCiphers.end();
+		if (typeid (cipher) == typeid (CipherSerpent))
+			return XtsEngine <XtsCipherSerpent>::GetFunctions();
 
-		for (CipherList::const_reverse_iterator iCipher = Ciphers.rbegin(); iCipher != Ciphers.rend(); ++iCipher)
-		{
-			--iSecondaryCipher;
-			DecryptBufferXTS (**iCipher, **iSecondaryCipher, data, length, startDataUnitNo, 0);
-		}
+		if (typeid (cipher) == typeid (CipherTwofish))
+			return XtsEngine <XtsCipherTwofish>::GetFunctions();
 
-		assert (iSecondaryCipher == SecondaryCiphers.begin());
+		throw ParameterIncorrect (SRC_POS);
 	}
 
-	void EncryptionModeXTS::DecryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const
+	void EncryptionModeXTS::Decrypt (byte *data, uint64 length) const
 	{
-		byte finalCarry;
-		byte whiteningValues [ENCRYPTION_DATA_UNIT_SIZE];
-		byte whiteningValue [BYTES_PER_XTS_BLOCK];
-		byte byteBufUnitNo [BYTES_PER_XTS_BLOCK];
-		uint64 *whiteningValuesPtr64 = (uint64 *) whiteningValues;
-		uint64 *whiteningValuePtr64 = (uint64 *) whiteningValue;
-		uint64 *bufPtr = (uint64 *) buffer;
-		uint64 *dataUnitBufPtr;
-		unsigned int startBlock = startCipherBlockNo, endBlock, block;
-		uint64 *const finalInt64WhiteningValuesPtr = whiteningValuesPtr64 + sizeof (whiteningValues) / sizeof (*whiteningValuesPtr64) - 1;
-		uint64 blockCount, dataUnitNo;
+		DecryptBuffer (data, length, 0);
+	}
 
-		startDataUnitNo += SectorOffset;
+	void EncryptionModeXTS::DecryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const
+	{
+		if_debug (ValidateState());
 
-		// Convert the 64-bit data unit number into a little-endian 16-byte array. 
-		// Note that as we are converting a 64-bit number into a 16-byte array we can always zero the last 8 bytes.
-		dataUnitNo = startDataUnitNo;
-		*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
-		*((uint64 *) byteBufUnitNo + 1) = 0;
+		if (EngineFunctions.size() != Ciphers.size())
+			throw NotInitialized (SRC_POS);
 
-		if (length % BYTES_PER_XTS_BLOCK)
-			TC_THROW_FATAL_EXCEPTION;
+		startDataUnitNo += SectorOffset;
 
-		blockCount = length / BYTES_PER_XTS_BLOCK;
+		uint64 tileSize = (Ciphers.size() > 1 && CascadeTileSize != 0) ? CascadeTileSize : length;
 
-		// Process all blocks in the buffer
-		while (blockCount > 0)
+		for (uint64 offset = 0; offset < length; offset += tileSize)
 		{
-			if (blockCount < BLOCKS_PER_XTS_DATA_UNIT)
-				endBlock = startBlock + (unsigned int) blockCount;
-			else
-				endBlock = BLOCKS_PER_XTS_DATA_UNIT;
-
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
-			whiteningValuePtr64 = (uint64 *) whiteningValue;
-
-			// Encrypt the data unit number using the secondary key (in order to generate the first 
-			// whitening value for this data unit)
-			*whiteningValuePtr64 = *((uint64 *) byteBufUnitNo);
-			*(whiteningValuePtr64 + 1) = 0;
-			secondaryCipher.EncryptBlock (whiteningValue);
-
-			// Generate subsequent whitening values for blocks in this data unit. Note that all generated 128-bit
-			// whitening values are stored in memory as a sequence of 64-bit integers in reverse order.
-			for (block = 0; block < endBlock; block++)
-			{
-				if (block >= startBlock)
-				{
-					*whiteningValuesPtr64-- = *whiteningValuePtr64++;
-					*whiteningValuesPtr64-- = *whiteningValuePtr64;
-				}
-				else
-					whiteningValuePtr64++;
-
-				// Derive the next whitening value
-
-#if BYTE_ORDER == LITTLE_ENDIAN
-
-				// Little-endian platforms
-
-				finalCarry = 
-					(*whiteningValuePtr64 & 0x8000000000000000ULL) ?
-					135 : 0;
-
-				*whiteningValuePtr64-- <<= 1;
+			uint64 size = min (tileSize, length - offset);
 
-				if (*whiteningValuePtr64 & 0x8000000000000000ULL)
-					*(whiteningValuePtr64 + 1) |= 1;	
-
-				*whiteningValuePtr64 <<= 1;
-
-#else
-				// Big-endian platforms
-
-				finalCarry = 
-					(*whiteningValuePtr64 & 0x80) ?
-					135 : 0;
-
-				*whiteningValuePtr64 = Endian::Little (Endian::Little (*whiteningValuePtr64) << 1);
-
-				whiteningValuePtr64--;
-
-				if (*whiteningValuePtr64 & 0x80)
-					*(whiteningValuePtr64 + 1) |= 0x0100000000000000ULL;	
-
-				*whiteningValuePtr64 = Endian::Little (Endian::Little (*whiteningValuePtr64) << 1);
-#endif
-
-				whiteningValue[0] ^= finalCarry;
-			}
-
-			dataUnitBufPtr = bufPtr;
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
-
-			// Decrypt blocks in this data unit
-
-			for (block = startBlock; block < endBlock; block++)
-			{
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-			}
-
-			cipher.DecryptBlocks ((byte *) dataUnitBufPtr, endBlock - startBlock);
-
-			bufPtr = dataUnitBufPtr;
-			whiteningValuesPtr64 = finalInt64WhiteningValuesPtr;
-
-			for (block = startBlock; block < endBlock; block++)
+			for (size_t i = Ciphers.size(); i-- > 0; )
 			{
-				*bufPtr++ ^= *whiteningValuesPtr64--;
-				*bufPtr++ ^= *whiteningValuesPtr64--;
+				EngineFunctions[i].DecryptBuffer (Ciphers[i]->GetScheduledKey(), SecondaryCiphers[i]->GetScheduledKey(),
+					data + offset, size, startDataUnitNo + offset / ENCRYPTION_DATA_UNIT_SIZE, 0);
 			}
-
-			blockCount -= endBlock - startBlock;
-			startBlock = 0;
-			dataUnitNo++;
-
-			*((uint64 *) byteBufUnitNo) = Endian::Little (dataUnitNo);
 		}
-
-		FAST_ERASE64 (whiteningValue, sizeof (whiteningValue));
-		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
 	}
 
 	void EncryptionModeXTS::DecryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const
@@ -336,10 +154,19 @@ namespace CipherShed
 		DecryptBuffer (data, sectorCount * sectorSize, sectorIndex * sectorSize / ENCRYPTION_DATA_UNIT_SIZE);
 	}
 
+	void EncryptionModeXTS::SetCascadeTileSize (size_t tileSize)
+	{
+		if (tileSize % ENCRYPTION_DATA_UNIT_SIZE != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		CascadeTileSize = tileSize;
+	}
+
 	void EncryptionModeXTS::SetCiphers (const CipherList &ciphers)
 	{
 		EncryptionMode::SetCiphers (ciphers);
 
+		EngineFunctions.clear();
 		SecondaryCiphers.clear();
 
 		foreach_ref (const Cipher &cipher, ciphers)
@@ -369,6 +196,13 @@ namespace CipherShed
 			keyOffset += cipher.GetKeySize();
 		}
 
+		// The block functions of each cipher are selected once here rather than for each block or data unit
+		EngineFunctions.clear();
+		foreach_ref (const Cipher &cipher, Ciphers)
+		{
+			EngineFunctions.push_back (GetEngineFunctions (cipher));
+		}
+
 		KeySet = true;
 	}
 }
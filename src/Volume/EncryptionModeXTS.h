@@ -11,33 +11,45 @@
 
 #include "../Platform/Platform.h"
 #include "EncryptionMode.h"
+#include "../Common/XtsEngine.h"
 
 namespace CipherShed
 {
 	class EncryptionModeXTS : public EncryptionMode
 	{
 	public:
-		EncryptionModeXTS () { }
+		EncryptionModeXTS () : CascadeTileSize (DefaultCascadeTileSize) { }
 		virtual ~EncryptionModeXTS () { }
 
 		virtual void Decrypt (byte *data, uint64 length) const;
 		virtual void DecryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
 		virtual void Encrypt (byte *data, uint64 length) const;
 		virtual void EncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		virtual void EncryptSectorsCurrentThread (const byte *source, byte *destination, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize) const;
+		size_t GetCascadeTileSize () const { return CascadeTileSize; }
 		virtual const SecureBuffer &GetKey () const { return SecondaryKey; }
 		virtual size_t GetKeySize () const;
 		virtual wstring GetName () const { return L"XTS"; };
 		virtual shared_ptr <EncryptionMode> GetNew () const { return shared_ptr <EncryptionMode> (new EncryptionModeXTS); }
+		void SetCascadeTileSize (size_t tileSize);
 		virtual void SetCiphers (const CipherList &ciphers);
 		virtual void SetKey (const ConstBufferPtr &key);
 
+		// Cipher cascades are applied to one tile of this size at a time, so that the data stays in the CPU cache
+		// between the layers. 0 selects the whole buffer (each cipher processes all data before the next one).
+		static const size_t DefaultCascadeTileSize = 16 * 1024;
+
 	protected:
 		void DecryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const;
-		void DecryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const;
+		static void DecryptBufferAesHw (const byte *ks, const byte *ks2, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
 		void EncryptBuffer (byte *data, uint64 length, uint64 startDataUnitNo) const;
-		void EncryptBufferXTS (const Cipher &cipher, const Cipher &secondaryCipher, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo) const;
+		void EncryptBuffer (const byte *source, byte *data, uint64 length, uint64 startDataUnitNo) const;
+		static void EncryptBufferAesHw (const byte *ks, const byte *ks2, const byte *source, byte *buffer, uint64 length, uint64 startDataUnitNo, unsigned int startCipherBlockNo);
+		static XtsEngineFunctions GetEngineFunctions (const Cipher &cipher);
 		void SetSecondaryCipherKeys ();
 
+		size_t CascadeTileSize;
+		vector <XtsEngineFunctions> EngineFunctions;
 		SecureBuffer SecondaryKey;
 		CipherList SecondaryCiphers;
 
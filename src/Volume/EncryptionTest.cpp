@@ -15,13 +15,23 @@
 #include "EncryptionModeLRW.h"
 #include "EncryptionModeXTS.h"
 #include "EncryptionTest.h"
+#include "Hash.h"
 #include "Pkcs5Kdf.h"
 
 namespace CipherShed
 {
 	void EncryptionTest::TestAll ()
 	{
+		bool bitslicedSupportEnabled = CipherAES::IsBitslicedSupportEnabled();
+		finally_do_arg (bool, bitslicedSupportEnabled, { CipherAES::EnableBitslicedSupport (finally_arg); });
+
+		// Table-based and bitsliced AES
+		CipherAES::EnableBitslicedSupport (false);
+		TestAll (false);
+
+		CipherAES::EnableBitslicedSupport (true);
 		TestAll (false);
+
 		TestAll (true);
 	}
 
@@ -36,6 +46,7 @@ namespace CipherShed
 		TestXtsAES();
 		TestXts();
 		TestLegacyModes();
+		TestWhirlpool();
 		TestPkcs5();
 	}
 
@@ -107,6 +118,14 @@ namespace CipherShed
 					}
 
 					ea.DecryptSectors (buf, secNo, sizeof (buf) / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+
+					// Sector larger than the batch of blocks processed at once
+					crc = ::GetCrc32 (buf, sizeof (buf));
+					ea.EncryptSectors (buf, secNo, 1, sizeof (buf));
+					ea.DecryptSectors (buf, secNo, 1, sizeof (buf));
+
+					if (::GetCrc32 (buf, sizeof (buf)) != crc)
+						throw TestFailed (SRC_POS);
 				}
 			}
 		}
@@ -887,4 +906,87 @@ namespace CipherShed
 		if (memcmp (derivedKey.Ptr(), "\x50\x7c\x36\x6f", 4) != 0)
 			throw TestFailed (SRC_POS);
 	}
+
+	struct WhirlpoolTestVector
+	{
+		const char *Message;
+		size_t Repetitions;
+		byte Digest[64];
+	};
+
+	// ISO/IEC 10118-3:2004 test vectors
+	static const WhirlpoolTestVector WhirlpoolTestVectors[] =
+	{
+		{
+			"", 1,
+			{
+				0x19, 0xfa, 0x61, 0xd7, 0x55, 0x22, 0xa4, 0x66, 0x9b, 0x44, 0xe3, 0x9c, 0x1d, 0x2e, 0x17, 0x26,
+				0xc5, 0x30, 0x23, 0x21, 0x30, 0xd4, 0x07, 0xf8, 0x9a, 0xfe, 0xe0, 0x96, 0x49, 0x97, 0xf7, 0xa7,
+				0x3e, 0x83, 0xbe, 0x69, 0x8b, 0x28, 0x8f, 0xeb, 0xcf, 0x88, 0xe3, 0xe0, 0x3c, 0x4f, 0x07, 0x57,
+				0xea, 0x89, 0x64, 0xe5, 0x9b, 0x63, 0xd9, 0x37, 0x08, 0xb1, 0x38, 0xcc, 0x42, 0xa6, 0x6e, 0xb3
+			}
+		},
+		{
+			"abc", 1,
+			{
+				0x4e, 0x24, 0x48, 0xa4, 0xc6, 0xf4, 0x86, 0xbb, 0x16, 0xb6, 0x56, 0x2c, 0x73, 0xb4, 0x02, 0x0b,
+				0xf3, 0x04, 0x3e, 0x3a, 0x73, 0x1b, 0xce, 0x72, 0x1a, 0xe1, 0xb3, 0x03, 0xd9, 0x7e, 0x6d, 0x4c,
+				0x71, 0x81, 0xee, 0xbd, 0xb6, 0xc5, 0x7e, 0x27, 0x7d, 0x0e, 0x34, 0x95, 0x71, 0x14, 0xcb, 0xd6,
+				0xc7, 0x97, 0xfc, 0x9d, 0x95, 0xd8, 0xb5, 0x82, 0xd2, 0x25, 0x29, 0x20, 0x76, 0xd4, 0xee, 0xf5
+			}
+		},
+		{
+			"message digest", 1,
+			{
+				0x37, 0x8c, 0x84, 0xa4, 0x12, 0x6e, 0x2d, 0xc6, 0xe5, 0x6d, 0xcc, 0x74, 0x58, 0x37, 0x7a, 0xac,
+				0x83, 0x8d, 0x00, 0x03, 0x22, 0x30, 0xf5, 0x3c, 0xe1, 0xf5, 0x70, 0x0c, 0x0f, 0xfb, 0x4d, 0x3b,
+				0x84, 0x21, 0x55, 0x76, 0x59, 0xef, 0x55, 0xc1, 0x06, 0xb4, 0xb5, 0x2a, 0xc5, 0xa4, 0xaa, 0xa6,
+				0x92, 0xed, 0x92, 0x00, 0x52, 0x83, 0x8f, 0x33, 0x62, 0xe8, 0x6d, 0xbd, 0x37, 0xa8, 0x90, 0x3e
+			}
+		},
+		{
+			"1234567890", 8,
+			{
+				0x46, 0x6e, 0xf1, 0x8b, 0xab, 0xb0, 0x15, 0x4d, 0x25, 0xb9, 0xd3, 0x8a, 0x64, 0x14, 0xf5, 0xc0,
+				0x87, 0x84, 0x37, 0x2b, 0xcc, 0xb2, 0x04, 0xd6, 0x54, 0x9c, 0x4a, 0xfa, 0xdb, 0x60, 0x14, 0x29,
+				0x4d, 0x5b, 0xd8, 0xdf, 0x2a, 0x6c, 0x44, 0xe5, 0x38, 0xcd, 0x04, 0x7b, 0x26, 0x81, 0xa5, 0x1a,
+				0x2c, 0x60, 0x48, 0x1e, 0x88, 0xc5, 0xa2, 0x0b, 0x2c, 0x2a, 0x80, 0xcf, 0x3a, 0x9a, 0x08, 0x3b
+			}
+		},
+		{
+			"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 10000,
+			{
+				0x0c, 0x99, 0x00, 0x5b, 0xeb, 0x57, 0xef, 0xf5, 0x0a, 0x7c, 0xf0, 0x05, 0x56, 0x0d, 0xdf, 0x5d,
+				0x29, 0x05, 0x7f, 0xd8, 0x6b, 0x20, 0xbf, 0xd6, 0x2d, 0xec, 0xa0, 0xf1, 0xcc, 0xea, 0x4a, 0xf5,
+				0x1f, 0xc1, 0x54, 0x90, 0xed, 0xdc, 0x47, 0xaf, 0x32, 0xbb, 0x2b, 0x66, 0xc3, 0x4f, 0xf9, 0xad,
+				0x8c, 0x60, 0x08, 0xad, 0x67, 0x7f, 0x77, 0x12, 0x69, 0x53, 0xb2, 0x26, 0xe4, 0xed, 0x8b, 0x01
+			}
+		}
+	};
+
+	void EncryptionTest::TestWhirlpool ()
+	{
+		Whirlpool whirlpool;
+		Buffer digest (whirlpool.GetDigestSize());
+
+		for (size_t i = 0; i < array_capacity (WhirlpoolTestVectors); ++i)
+		{
+			const WhirlpoolTestVector &testVector = WhirlpoolTestVectors[i];
+			size_t messageSize = strlen (testVector.Message);
+
+			whirlpool.Init();
+
+			for (size_t r = 0; r < testVector.Repetitions; ++r)
+			{
+				// Split the message to also exercise partially filled blocks
+				whirlpool.ProcessData (ConstBufferPtr ((const byte *) testVector.Message, messageSize / 2));
+				whirlpool.ProcessData (ConstBufferPtr ((const byte *) testVector.Message + messageSize / 2, messageSize - messageSize / 2));
+			}
+
+			whirlpool.GetDigest (digest);
+
+			if (memcmp (digest.Ptr(), testVector.Digest, digest.Size()) != 0)
+				throw TestFailed (SRC_POS);
+		}
+	}
 }
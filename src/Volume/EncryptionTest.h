@@ -24,6 +24,7 @@ namespace CipherShed
 		static void TestCiphers ();
 		static void TestLegacyModes ();
 		static void TestPkcs5 ();
+		static void TestWhirlpool ();
 		static void TestXts ();
 		static void TestXtsAES ();
 
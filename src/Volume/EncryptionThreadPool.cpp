@@ -7,9 +7,14 @@
 */
 
 #ifdef TC_UNIX
+#	include <sched.h>
 #	include <unistd.h>
 #endif
 
+#ifdef TC_LINUX
+#	include <pthread.h>
+#endif
+
 #ifdef TC_MACOSX
 #	include <sys/types.h>
 #	include <sys/sysctl.h>
@@ -22,124 +27,364 @@
 
 #include <memory>
 
+/* Work items are kept in a fixed array of slots which callers claim and publish without a global lock. Each
+request is split into fragments of at least MinFragmentSize bytes, which are claimed by atomically advancing
+the NextUnit counter of the work item. Any idle worker thread, as well as the calling thread itself, can claim
+fragments of any published work item (work stealing). Worker threads scan the slots starting at their own index
+and callers prefer the slot corresponding to the processor they run on, so that work tends to be processed by
+the worker pinned to the submitting processor first.
+
+A key derivation occupies a work item of its own, which is released by the thread that processes it, so that
+the requester does not have to wait for derivations whose results are no longer needed. The output blocks of a
+single key derivation are in turn distributed among the threads as fragments of one or more blocks. As the
+requester always processes fragments too, a derivation running on a worker thread never waits for work no other
+thread has started. */
+
 namespace CipherShed
 {
-	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	static inline size_t AtomicAdd (volatile size_t *value, size_t addend)
 	{
-		size_t fragmentCount;
-		size_t unitsPerFragment;
-		size_t remainder;
+		return __sync_fetch_and_add (value, addend);
+	}
 
-		byte *fragmentData;
-		uint64 fragmentStartUnitNo;
+	static inline size_t AtomicGet (volatile size_t *value)
+	{
+		return __sync_fetch_and_add (value, 0);
+	}
 
-		WorkItem *workItem;
-		WorkItem *firstFragmentWorkItem;
+	static inline size_t AtomicSubtract (volatile size_t *value, size_t subtrahend)
+	{
+		return __sync_fetch_and_sub (value, subtrahend);
+	}
 
-		if (unitCount == 0)
-			return;
+	static inline bool AtomicCompareAndSwap (volatile int *value, int oldValue, int newValue)
+	{
+		return __sync_bool_compare_and_swap (value, oldValue, newValue);
+	}
 
-		if (!ThreadPoolRunning || unitCount == 1)
+	// Backs off in a wait loop. The processor is yielded to other threads after a few spins, as the awaited
+	// thread may need to run on the same processor.
+	static inline void WaitBackoff (size_t &spinCount)
+	{
+		if (spinCount++ < 64)
 		{
-			switch (type)
-			{
-			case WorkType::DecryptDataUnits:
-				encryptionMode->DecryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
-				break;
+#if defined (TC_ARCH_X86) || defined (TC_ARCH_X64)
+			__asm__ __volatile__ ("pause");
+#endif
+			return;
+		}
 
-			case WorkType::EncryptDataUnits:
-				encryptionMode->EncryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
-				break;
+#ifdef TC_WINDOWS
+		SwitchToThread();
+#else
+		sched_yield();
+#endif
+	}
 
-			default:
-				throw ParameterIncorrect (SRC_POS);
+	EncryptionThreadPool::WorkItem *EncryptionThreadPool::AcquireWorkItem ()
+	{
+		size_t startIndex = GetPreferredWorkItemIndex();
+
+		for (size_t i = 0; i < QueueSize; ++i)
+		{
+			WorkItem *workItem = &WorkItemQueue[(startIndex + i) % QueueSize];
+
+			if (workItem->State == WorkItem::State::Free
+				&& AtomicCompareAndSwap (&workItem->State, WorkItem::State::Free, WorkItem::State::Preparing))
+			{
+				return workItem;
 			}
+		}
 
+		return nullptr;
+	}
+
+	void EncryptionThreadPool::BeginKeyDerivation (shared_ptr <KeyDerivation> keyDerivation)
+	{
+		WorkItem *workItem = ThreadPoolRunning ? AcquireWorkItem() : nullptr;
+		if (!workItem)
+		{
+			keyDerivation->Derive();
 			return;
 		}
 
-		if (unitCount <= ThreadCount)
+		workItem->Type = WorkType::DeriveKey;
+		workItem->ItemException = nullptr;
+		workItem->CompletedUnitCount = 0;
+		workItem->NextUnit = 0;
+		workItem->FragmentUnitCount = 1;
+		workItem->KeyDerivationRequest = keyDerivation;
+
+		AtomicCompareAndSwap (&workItem->State, WorkItem::State::Preparing, WorkItem::State::Ready);
+		WorkItemReadyEvent.Signal();
+	}
+
+	void EncryptionThreadPool::DeriveKeyBlocks (const Pkcs5Kdf *pkcs5, const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, size_t blockCount, volatile int *aborted)
+	{
+		WorkItem *workItem = (ThreadPoolRunning && blockCount > 1) ? AcquireWorkItem() : nullptr;
+		if (!workItem)
 		{
-			fragmentCount = (size_t) unitCount;
-			unitsPerFragment = 1;
-			remainder = 0;
+			pkcs5->DeriveKeyBlocks (key, password, salt, iterationCount, 0, blockCount, aborted);
+			return;
 		}
-		else
+
+		workItem->Type = WorkType::DeriveKeyBlocks;
+		workItem->ItemException = nullptr;
+		workItem->CompletedUnitCount = 0;
+		workItem->NextUnit = 0;
+
+		// Blocks of a fragment are derived in lockstep by the multi-buffer hash functions
+		workItem->FragmentUnitCount = (blockCount + ThreadCount - 1) / ThreadCount;
+
+		workItem->KeyDerivationBlocks.Pkcs5 = pkcs5;
+		workItem->KeyDerivationBlocks.Key = &key;
+		workItem->KeyDerivationBlocks.Password = &password;
+		workItem->KeyDerivationBlocks.Salt = &salt;
+		workItem->KeyDerivationBlocks.IterationCount = iterationCount;
+		workItem->KeyDerivationBlocks.BlockCount = blockCount;
+		workItem->KeyDerivationBlocks.Aborted = aborted;
+
+		AtomicCompareAndSwap (&workItem->State, WorkItem::State::Preparing, WorkItem::State::Ready);
+		WorkItemReadyEvent.Signal();
+
+		while (ProcessFragment (workItem));
+
+		workItem->ItemCompletedEvent.Wait();
+
+		std::auto_ptr <Exception> itemException (workItem->ItemException);
+		workItem->ItemException = nullptr;
+
+		ReleaseWorkItem (workItem);
+
+		if (itemException.get())
+			itemException->Throw();
+	}
+
+	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	{
+		DoWork (type, encryptionMode, nullptr, data, startUnitNo, unitCount, sectorSize);
+	}
+
+	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, const byte *sourceData, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	{
+		if (unitCount == 0)
+			return;
+
+		if (!ThreadPoolRunning || sectorSize == 0 || unitCount * sectorSize <= MinFragmentSize)
 		{
-			fragmentCount = ThreadCount;
-			unitsPerFragment = (size_t) unitCount / ThreadCount;
-			remainder = (size_t) unitCount % ThreadCount;
+			DoWorkCurrentThread (type, encryptionMode, sourceData, data, startUnitNo, unitCount, sectorSize);
+			return;
+		}
 
-			if (remainder > 0)
-				++unitsPerFragment;
+		// All slots may be taken by concurrent callers, in which case the request is processed by the calling thread
+		WorkItem *workItem = AcquireWorkItem();
+		if (!workItem)
+		{
+			DoWorkCurrentThread (type, encryptionMode, sourceData, data, startUnitNo, unitCount, sectorSize);
+			return;
 		}
 
-		fragmentData = data;
-		fragmentStartUnitNo = startUnitNo;
+		size_t fragmentUnitCount = (size_t) ((unitCount + ThreadCount * 2 - 1) / (ThreadCount * 2));
+		size_t minFragmentUnitCount = MinFragmentSize / sectorSize;
+
+		if (fragmentUnitCount < minFragmentUnitCount)
+			fragmentUnitCount = minFragmentUnitCount;
+
+		if (fragmentUnitCount < 1)
+			fragmentUnitCount = 1;
+
+		workItem->Type = type;
+		workItem->ItemException = nullptr;
+		workItem->CompletedUnitCount = 0;
+		workItem->NextUnit = 0;
+		workItem->FragmentUnitCount = fragmentUnitCount;
+
+		workItem->Encryption.Mode = encryptionMode;
+		workItem->Encryption.SourceData = sourceData;
+		workItem->Encryption.Data = data;
+		workItem->Encryption.StartUnitNo = startUnitNo;
+		workItem->Encryption.UnitCount = unitCount;
+		workItem->Encryption.SectorSize = sectorSize;
+
+		AtomicCompareAndSwap (&workItem->State, WorkItem::State::Preparing, WorkItem::State::Ready);
+		WorkItemReadyEvent.Signal();
+
+		// The calling thread processes fragments too instead of waiting idle
+		while (ProcessFragment (workItem));
+
+		workItem->ItemCompletedEvent.Wait();
 
+		std::auto_ptr <Exception> itemException (workItem->ItemException);
+		workItem->ItemException = nullptr;
+
+		ReleaseWorkItem (workItem);
+
+		if (itemException.get())
+			itemException->Throw();
+	}
+
+	void EncryptionThreadPool::DoWorkCurrentThread (WorkType::Enum type, const EncryptionMode *encryptionMode, const byte *sourceData, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	{
+		switch (type)
 		{
-			ScopeLock lock (EnqueueMutex);
-			firstFragmentWorkItem = &WorkItemQueue[EnqueuePosition];
+		case WorkType::DecryptDataUnits:
+			if (sourceData)
+				throw ParameterIncorrect (SRC_POS);
+
+			encryptionMode->DecryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
+			break;
+
+		case WorkType::EncryptDataUnits:
+			if (sourceData)
+				encryptionMode->EncryptSectorsCurrentThread (sourceData, data, startUnitNo, unitCount, sectorSize);
+			else
+				encryptionMode->EncryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
+			break;
+
+		default:
+			throw ParameterIncorrect (SRC_POS);
+		}
+	}
 
-			while (firstFragmentWorkItem->State != WorkItem::State::Free)
+	size_t EncryptionThreadPool::GetPreferredWorkItemIndex ()
+	{
+#ifdef TC_LINUX
+		int processor = sched_getcpu();
+		if (processor >= 0)
+		{
+			for (size_t i = 0; i < Processors.size(); ++i)
 			{
-				WorkItemCompletedEvent.Wait();
+				if (Processors[i] == processor)
+					return i;
 			}
+		}
+#endif
+		return 0;
+	}
+
+	bool EncryptionThreadPool::ProcessFragment (WorkItem *workItem)
+	{
+		if (workItem->Type == WorkType::DeriveKey)
+		{
+			if (AtomicAdd (&workItem->NextUnit, 1) != 0)
+				return false;
+
+			// Other derivations may have been queued while this thread was the only one awake
+			WorkItemReadyEvent.Signal();
+
+			shared_ptr <KeyDerivation> keyDerivation = workItem->KeyDerivationRequest;
+			workItem->KeyDerivationRequest.reset();
 
-			firstFragmentWorkItem->OutstandingFragmentCount.Set (fragmentCount);
-			firstFragmentWorkItem->ItemException.reset();
+			keyDerivation->Derive();
+			return true;
+		}
+
+		size_t firstUnit = AtomicAdd (&workItem->NextUnit, workItem->FragmentUnitCount);
+		size_t unitCount = workItem->Type == WorkType::DeriveKeyBlocks
+			? workItem->KeyDerivationBlocks.BlockCount : (size_t) workItem->Encryption.UnitCount;
+
+		if (firstUnit >= unitCount)
+			return false;
+
+		size_t fragmentUnitCount = workItem->FragmentUnitCount;
+		if (fragmentUnitCount > unitCount - firstUnit)
+			fragmentUnitCount = unitCount - firstUnit;
 
-			while (fragmentCount-- > 0)
+		// Wake up another thread to help with the remaining fragments
+		if (firstUnit + fragmentUnitCount < unitCount)
+			WorkItemReadyEvent.Signal();
+
+		Exception *fragmentException = nullptr;
+		try
+		{
+			if (workItem->Type == WorkType::DeriveKeyBlocks)
 			{
-				workItem = &WorkItemQueue[EnqueuePosition++];
+				workItem->KeyDerivationBlocks.Pkcs5->DeriveKeyBlocks (*workItem->KeyDerivationBlocks.Key, *workItem->KeyDerivationBlocks.Password,
+					*workItem->KeyDerivationBlocks.Salt, workItem->KeyDerivationBlocks.IterationCount, firstUnit, fragmentUnitCount,
+					workItem->KeyDerivationBlocks.Aborted);
+			}
+			else
+			{
+				const byte *sourceData = workItem->Encryption.SourceData;
+				if (sourceData)
+					sourceData += firstUnit * workItem->Encryption.SectorSize;
 
-				if (EnqueuePosition >= QueueSize)
-					EnqueuePosition = 0;
+				DoWorkCurrentThread (workItem->Type, workItem->Encryption.Mode, sourceData,
+					workItem->Encryption.Data + firstUnit * workItem->Encryption.SectorSize,
+					workItem->Encryption.StartUnitNo + firstUnit, fragmentUnitCount, workItem->Encryption.SectorSize);
+			}
+		}
+		catch (Exception &e)
+		{
+			fragmentException = e.CloneNew();
+		}
+		catch (exception &e)
+		{
+			fragmentException = new ExternalException (SRC_POS, StringConverter::ToExceptionString (e));
+		}
+		catch (...)
+		{
+			fragmentException = new UnknownException (SRC_POS);
+		}
 
-				while (workItem->State != WorkItem::State::Free)
-				{
-					WorkItemCompletedEvent.Wait();
-				}
+		if (fragmentException && !__sync_bool_compare_and_swap (&workItem->ItemException, (Exception *) nullptr, fragmentException))
+			delete fragmentException;
+
+		if (AtomicAdd (&workItem->CompletedUnitCount, fragmentUnitCount) + fragmentUnitCount == unitCount)
+			workItem->ItemCompletedEvent.Signal();
+
+		return true;
+	}
+
+	bool EncryptionThreadPool::ProcessReadyWorkItem (size_t threadIndex)
+	{
+		for (size_t i = 0; i < QueueSize; ++i)
+		{
+			WorkItem *workItem = &WorkItemQueue[(threadIndex + i) % QueueSize];
+
+			if (workItem->State != WorkItem::State::Ready)
+				continue;
 
-				workItem->Type = type;
-				workItem->FirstFragment = firstFragmentWorkItem;
+			// The slot must not be released while this thread may still access it
+			AtomicAdd (&workItem->ActiveThreadCount, 1);
 
-				workItem->Encryption.Mode = encryptionMode;
-				workItem->Encryption.Data = fragmentData;
-				workItem->Encryption.UnitCount = unitsPerFragment;
-				workItem->Encryption.StartUnitNo = fragmentStartUnitNo;
-				workItem->Encryption.SectorSize = sectorSize;
+			bool processed = false;
+			if (workItem->State == WorkItem::State::Ready)
+				processed = ProcessFragment (workItem);
 
-				fragmentData += unitsPerFragment * ENCRYPTION_DATA_UNIT_SIZE;
-				fragmentStartUnitNo += unitsPerFragment;
+			AtomicSubtract (&workItem->ActiveThreadCount, 1);
 
-				if (remainder > 0 && --remainder == 0)
-					--unitsPerFragment;
+			if (processed)
+			{
+				if (workItem->Type == WorkType::DeriveKey)
+					ReleaseWorkItem (workItem);
 
-				workItem->State.Set (WorkItem::State::Ready);
-				WorkItemReadyEvent.Signal();
+				return true;
 			}
 		}
 
-		firstFragmentWorkItem->ItemCompletedEvent.Wait();
-		
-		std::auto_ptr <Exception> itemException;
-		if (firstFragmentWorkItem->ItemException.get())
-			itemException = firstFragmentWorkItem->ItemException;
+		return false;
+	}
 
-		firstFragmentWorkItem->State.Set (WorkItem::State::Free);
-		WorkItemCompletedEvent.Signal();
+	void EncryptionThreadPool::ReleaseWorkItem (WorkItem *workItem)
+	{
+		AtomicCompareAndSwap (&workItem->State, WorkItem::State::Ready, WorkItem::State::Completing);
 
-		if (itemException.get())
-			itemException->Throw();
+		// Threads still holding the slot have found no fragment left and are about to leave it
+		size_t spinCount = 0;
+		while (AtomicGet (&workItem->ActiveThreadCount) != 0)
+			WaitBackoff (spinCount);
+
+		AtomicCompareAndSwap (&workItem->State, WorkItem::State::Completing, WorkItem::State::Free);
 	}
 
-	void EncryptionThreadPool::Start ()
+	void EncryptionThreadPool::Start (size_t threadCount)
 	{
 		if (ThreadPoolRunning)
 			return;
 
 		size_t cpuCount;
+		Processors.clear();
 
 #ifdef TC_WINDOWS
 
@@ -148,11 +393,27 @@ namespace CipherShed
 		cpuCount = sysInfo.dwNumberOfProcessors;
 
 #elif defined (_SC_NPROCESSORS_ONLN)
-		
+
 		cpuCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
 		if (cpuCount == (size_t) -1)
 			cpuCount = 1;
 
+#	ifdef TC_LINUX
+		// Only processors the process is allowed to run on are used (e.g., in a container restricted by cpusets)
+		cpu_set_t cpuSet;
+		if (sched_getaffinity (0, sizeof (cpuSet), &cpuSet) == 0)
+		{
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			{
+				if (CPU_ISSET (cpu, &cpuSet))
+					Processors.push_back (cpu);
+			}
+
+			if (!Processors.empty())
+				cpuCount = Processors.size();
+		}
+#	endif
+
 #elif defined (TC_MACOSX)
 
 		int cpuCountSys;
@@ -172,6 +433,10 @@ namespace CipherShed
 #	error Cannot determine CPU count
 #endif
 
+		// The number of threads may be specified explicitly (e.g., for benchmarking)
+		if (threadCount != 0)
+			cpuCount = threadCount;
+
 		if (cpuCount < 2)
 			return;
 
@@ -179,12 +444,11 @@ namespace CipherShed
 			cpuCount = MaxThreadCount;
 
 		StopPending = false;
-		DequeuePosition = 0;
-		EnqueuePosition = 0;
 
 		for (size_t i = 0; i < sizeof (WorkItemQueue) / sizeof (WorkItemQueue[0]); ++i)
 		{
-			WorkItemQueue[i].State.Set (WorkItem::State::Free);
+			WorkItemQueue[i].ActiveThreadCount = 0;
+			WorkItemQueue[i].State = WorkItem::State::Free;
 		}
 
 		try
@@ -193,14 +457,16 @@ namespace CipherShed
 			{
 				struct ThreadFunctor : public Functor
 				{
+					ThreadFunctor (size_t threadIndex) : ThreadIndex (threadIndex) { }
 					virtual void operator() ()
 					{
-						WorkThreadProc();
+						WorkThreadProc (ThreadIndex);
 					}
+					size_t ThreadIndex;
 				};
 
 				make_shared_auto (Thread, thread);
-				thread->Start (new ThreadFunctor ());
+				thread->Start (new ThreadFunctor (ThreadCount));
 				RunningThreads.push_back (thread);
 			}
 		}
@@ -231,75 +497,47 @@ namespace CipherShed
 			thread.Join();
 		}
 
+		RunningThreads.clear();
 		ThreadCount = 0;
 		ThreadPoolRunning = false;
+
+		// Key derivations not yet started are completed by the calling thread, as their requesters may be
+		// waiting for them. Aborted derivations are only signaled as completed.
+		for (size_t i = 0; i < QueueSize; ++i)
+		{
+			WorkItem *workItem = &WorkItemQueue[i];
+
+			if (workItem->State == WorkItem::State::Ready && workItem->Type == WorkType::DeriveKey
+				&& ProcessFragment (workItem))
+			{
+				ReleaseWorkItem (workItem);
+			}
+		}
 	}
 
-	void EncryptionThreadPool::WorkThreadProc ()
+	void EncryptionThreadPool::WorkThreadProc (size_t threadIndex)
 	{
 		try
 		{
-			WorkItem *workItem;
+#ifdef TC_LINUX
+			if (threadIndex < Processors.size())
+			{
+				cpu_set_t cpuSet;
+				CPU_ZERO (&cpuSet);
+				CPU_SET (Processors[threadIndex], &cpuSet);
 
+				// Failure is not fatal as the thread can run on any processor
+				pthread_setaffinity_np (pthread_self(), sizeof (cpuSet), &cpuSet);
+			}
+#endif
 			while (!StopPending)
 			{
-				{
-					ScopeLock lock (DequeueMutex);
-
-					workItem = &WorkItemQueue[DequeuePosition++];
-
-					if (DequeuePosition >= QueueSize)
-						DequeuePosition = 0;
-
-					while (!StopPending && workItem->State != WorkItem::State::Ready)
-					{
-						WorkItemReadyEvent.Wait();
-					}
-
-					workItem->State.Set (WorkItem::State::Busy);
-				}
-
-				if (StopPending)
-					break;
-
-				try
-				{
-					switch (workItem->Type)
-					{
-					case WorkType::DecryptDataUnits:
-						workItem->Encryption.Mode->DecryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize);
-						break;
-
-					case WorkType::EncryptDataUnits:
-						workItem->Encryption.Mode->EncryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize);
-						break;
-
-					default:
-						throw ParameterIncorrect (SRC_POS);
-					}
-				}
-				catch (Exception &e)
-				{
-					workItem->FirstFragment->ItemException.reset (e.CloneNew());
-				}
-				catch (exception &e)
-				{
-					workItem->FirstFragment->ItemException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
-				}
-				catch (...)
-				{
-					workItem->FirstFragment->ItemException.reset (new UnknownException (SRC_POS));
-				}
-
-				if (workItem != workItem->FirstFragment)
-				{
-					workItem->State.Set (WorkItem::State::Free);
-					WorkItemCompletedEvent.Signal();
-				}
-
-				if (workItem->FirstFragment->OutstandingFragmentCount.Decrement() == 0)
-					workItem->FirstFragment->ItemCompletedEvent.Signal();
+				if (!ProcessReadyWorkItem (threadIndex))
+					WorkItemReadyEvent.Wait();
 			}
+
+			// Pass the stop request on to the next thread
+			WorkItemReadyEvent.Signal();
 		}
 		catch (exception &e)
 		{
@@ -311,6 +549,54 @@ namespace CipherShed
 		}
 	}
 
+	EncryptionThreadPool::KeyDerivation::KeyDerivation (shared_ptr <Pkcs5Kdf> pkcs5, const VolumePassword &password, const ConstBufferPtr &salt, size_t keySize)
+		: Aborted (0), Completed (false), DerivedKey (keySize), Password (password), Pkcs5 (pkcs5), Salt (salt.Size())
+	{
+		Salt.CopyFrom (salt);
+	}
+
+	void EncryptionThreadPool::KeyDerivation::Derive ()
+	{
+		if (!Aborted)
+		{
+			try
+			{
+				Pkcs5->DeriveKey (DerivedKey, Password, Salt, Pkcs5->GetIterationCount(), &Aborted);
+			}
+			catch (Exception &e)
+			{
+				DerivationException.reset (e.CloneNew());
+			}
+			catch (exception &e)
+			{
+				DerivationException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+			}
+			catch (...)
+			{
+				DerivationException.reset (new UnknownException (SRC_POS));
+			}
+		}
+
+		CompletedEvent.Signal();
+	}
+
+	ConstBufferPtr EncryptionThreadPool::KeyDerivation::WaitForKey ()
+	{
+		if (!Completed)
+		{
+			CompletedEvent.Wait();
+			Completed = true;
+		}
+
+		if (DerivationException.get())
+			DerivationException->Throw();
+
+		if (Aborted)
+			throw ParameterIncorrect (SRC_POS);
+
+		return DerivedKey;
+	}
+
 	volatile bool EncryptionThreadPool::ThreadPoolRunning = false;
 	volatile bool EncryptionThreadPool::StopPending = false;
 
@@ -318,14 +604,8 @@ namespace CipherShed
 
 	EncryptionThreadPool::WorkItem EncryptionThreadPool::WorkItemQueue[QueueSize];
 
-	volatile size_t EncryptionThreadPool::EnqueuePosition;
-	volatile size_t EncryptionThreadPool::DequeuePosition;
-
-	Mutex EncryptionThreadPool::EnqueueMutex;
-	Mutex EncryptionThreadPool::DequeueMutex;
-
 	SyncEvent EncryptionThreadPool::WorkItemReadyEvent;
-	SyncEvent EncryptionThreadPool::WorkItemCompletedEvent;
 
+	vector <int> EncryptionThreadPool::Processors;
 	list < shared_ptr <Thread> > EncryptionThreadPool::RunningThreads;
 }
@@ -11,6 +11,8 @@
 
 #include "../Platform/Platform.h"
 #include "EncryptionMode.h"
+#include "Pkcs5Kdf.h"
+#include "VolumePassword.h"
 #include <memory>
 
 namespace CipherShed
@@ -24,10 +26,41 @@ namespace CipherShed
 			{
 				EncryptDataUnits,
 				DecryptDataUnits,
-				DeriveKey
+				DeriveKey,
+				DeriveKeyBlocks
 			};
 		};
 
+		// Header key derivation performed by the thread pool. The requester may abandon it at any time by
+		// calling Abort(): a derivation which has not started yet is then skipped and a running one stops
+		// after its current PBKDF2 iteration.
+		class KeyDerivation
+		{
+		public:
+			KeyDerivation (shared_ptr <Pkcs5Kdf> pkcs5, const VolumePassword &password, const ConstBufferPtr &salt, size_t keySize);
+			virtual ~KeyDerivation () { }
+
+			void Abort () { Aborted = 1; }
+			void Derive ();
+			shared_ptr <Pkcs5Kdf> GetPkcs5Kdf () const { return Pkcs5; }
+			ConstBufferPtr GetSalt () const { return Salt; }
+			ConstBufferPtr WaitForKey ();
+
+		protected:
+			volatile int Aborted;
+			bool Completed;
+			SyncEvent CompletedEvent;
+			std::auto_ptr <Exception> DerivationException;
+			SecureBuffer DerivedKey;
+			VolumePassword Password;
+			shared_ptr <Pkcs5Kdf> Pkcs5;
+			SecureBuffer Salt;
+
+		private:
+			KeyDerivation (const KeyDerivation &);
+			KeyDerivation &operator= (const KeyDerivation &);
+		};
+
 		struct WorkItem
 		{
 			struct State
@@ -35,51 +68,74 @@ namespace CipherShed
 				enum Enum
 				{
 					Free,
+					Preparing,
 					Ready,
-					Busy
+					Completing
 				};
 			};
 
-			struct WorkItem *FirstFragment;
-			std::auto_ptr <Exception> ItemException;
+			Exception *volatile ItemException;
 			SyncEvent ItemCompletedEvent;
-			SharedVal <size_t> OutstandingFragmentCount;
-			SharedVal <State::Enum> State;
+			volatile size_t ActiveThreadCount;
+			volatile size_t CompletedUnitCount;
+			volatile size_t NextUnit;
+			size_t FragmentUnitCount;
+			volatile int State;
 			WorkType::Enum Type;
+			shared_ptr <KeyDerivation> KeyDerivationRequest;
 
 			union
 			{
 				struct
 				{
 					const EncryptionMode *Mode;
+					const byte *SourceData;
 					byte *Data;
 					uint64 StartUnitNo;
 					uint64 UnitCount;
 					size_t SectorSize;
 				} Encryption;
+
+				struct
+				{
+					const Pkcs5Kdf *Pkcs5;
+					const BufferPtr *Key;
+					const VolumePassword *Password;
+					const ConstBufferPtr *Salt;
+					int IterationCount;
+					size_t BlockCount;
+					volatile int *Aborted;
+				} KeyDerivationBlocks;
 			};
 		};
 
+		static void BeginKeyDerivation (shared_ptr <KeyDerivation> keyDerivation);
+		static void DeriveKeyBlocks (const Pkcs5Kdf *pkcs5, const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, size_t blockCount, volatile int *aborted);
 		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, const byte *sourceData, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static size_t GetThreadCount () { return ThreadCount; }
 		static bool IsRunning () { return ThreadPoolRunning; }
-		static void Start ();
+		static void Start (size_t threadCount = 0);
 		static void Stop ();
 
 	protected:
-		static void WorkThreadProc ();
+		static WorkItem *AcquireWorkItem ();
+		static void DoWorkCurrentThread (WorkType::Enum type, const EncryptionMode *mode, const byte *sourceData, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static size_t GetPreferredWorkItemIndex ();
+		static bool ProcessFragment (WorkItem *workItem);
+		static bool ProcessReadyWorkItem (size_t threadIndex);
+		static void ReleaseWorkItem (WorkItem *workItem);
+		static void WorkThreadProc (size_t threadIndex);
 
-		static const size_t MaxThreadCount = 32;
+		static const size_t MaxThreadCount = 64;
+		static const size_t MinFragmentSize = 64 * 1024;
 		static const size_t QueueSize = MaxThreadCount * 2;
 
-		static Mutex DequeueMutex;
-		static volatile size_t DequeuePosition;
-		static volatile size_t EnqueuePosition;
-		static Mutex EnqueueMutex;
+		static vector <int> Processors;
 		static list < shared_ptr <Thread> > RunningThreads;
 		static volatile bool StopPending;
 		static size_t ThreadCount;
 		static volatile bool ThreadPoolRunning;
-		static SyncEvent WorkItemCompletedEvent;
 		static WorkItem WorkItemQueue[QueueSize];
 		static SyncEvent WorkItemReadyEvent;
 	};
@@ -7,6 +7,7 @@
 */
 
 #include "../Common/Pkcs5.h"
+#include "EncryptionThreadPool.h"
 #include "Pkcs5Kdf.h"
 #include "VolumePassword.h"
 
@@ -24,7 +25,32 @@ namespace CipherShed
 	{
 		DeriveKey (key, password, salt, GetIterationCount());
 	}
-	
+
+	void Pkcs5Kdf::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, volatile int *aborted) const
+	{
+		ValidateParameters (key, password, salt, iterationCount);
+
+		// Output blocks of PBKDF2 are independent of each other and are derived in parallel
+		size_t blockCount = (key.Size() + GetDerivedBlockSize() - 1) / GetDerivedBlockSize();
+		EncryptionThreadPool::DeriveKeyBlocks (this, key, password, salt, iterationCount, blockCount, aborted);
+	}
+
+	void Pkcs5Kdf::DeriveKeyBlocks (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, size_t firstBlock, size_t blockCount, volatile int *aborted) const
+	{
+		size_t blockSize = GetDerivedBlockSize();
+		size_t offset = firstBlock * blockSize;
+
+		if (blockCount < 1 || offset >= key.Size())
+			throw ParameterIncorrect (SRC_POS);
+
+		// Block numbers start at 1 (RFC 2898)
+		SecureBuffer blocks (blockCount * blockSize);
+		DeriveBlocks (blocks, password, salt, iterationCount, (int) firstBlock + 1, aborted);
+
+		size_t size = min (blocks.Size(), key.Size() - offset);
+		key.GetRange (offset, size).CopyFrom (blocks.GetRange (0, size));
+	}
+
 	shared_ptr <Pkcs5Kdf> Pkcs5Kdf::GetAlgorithm (const wstring &name)
 	{
 		foreach (shared_ptr <Pkcs5Kdf> kdf, GetAvailableAlgorithms())
@@ -64,33 +90,36 @@ namespace CipherShed
 			throw ParameterIncorrect (SRC_POS);
 	}
 
-	void Pkcs5HmacRipemd160::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
+	void Pkcs5HmacRipemd160::DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
 	{
-		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_ripemd160 ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount, (char *) key.Get(), (int) key.Size());
+		derive_u_ripemd160_lanes ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount,
+			(char *) blocks.Get(), firstBlockNumber, (int) (blocks.Size() / GetDerivedBlockSize()), aborted);
 	}
 
-	void Pkcs5HmacRipemd160_1000::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
+	void Pkcs5HmacRipemd160_1000::DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
 	{
-		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_ripemd160 ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount, (char *) key.Get(), (int) key.Size());
+		derive_u_ripemd160_lanes ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount,
+			(char *) blocks.Get(), firstBlockNumber, (int) (blocks.Size() / GetDerivedBlockSize()), aborted);
 	}
 
-	void Pkcs5HmacSha1::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
+	void Pkcs5HmacSha1::DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
 	{
-		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_sha1 ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount, (char *) key.Get(), (int) key.Size());
+		derive_u_sha1_lanes ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount,
+			(char *) blocks.Get(), firstBlockNumber, (int) (blocks.Size() / GetDerivedBlockSize()), aborted);
 	}
 
-	void Pkcs5HmacSha512::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
+	void Pkcs5HmacSha512::DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
 	{
-		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_sha512 ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount, (char *) key.Get(), (int) key.Size());
+		derive_u_sha512_lanes ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount,
+			(char *) blocks.Get(), firstBlockNumber, (int) (blocks.Size() / GetDerivedBlockSize()), aborted);
 	}
 
-	void Pkcs5HmacWhirlpool::DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const
+	void Pkcs5HmacWhirlpool::DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const
 	{
-		ValidateParameters (key, password, salt, iterationCount);
-		derive_key_whirlpool ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount, (char *) key.Get(), (int) key.Size());
+		for (size_t offset = 0; offset < blocks.Size() && !(aborted && *aborted); offset += GetDerivedBlockSize())
+		{
+			derive_u_whirlpool ((char *) password.DataPtr(), (int) password.Size(), (char *) salt.Get(), (int) salt.Size(), iterationCount,
+				(char *) blocks.Get() + offset, firstBlockNumber++, aborted);
+		}
 	}
 }
@@ -24,10 +24,12 @@ namespace CipherShed
 		virtual ~Pkcs5Kdf ();
 
 		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt) const;
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const = 0;
+		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, volatile int *aborted = nullptr) const;
+		void DeriveKeyBlocks (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, size_t firstBlock, size_t blockCount, volatile int *aborted) const;
 		static shared_ptr <Pkcs5Kdf> GetAlgorithm (const wstring &name);
 		static shared_ptr <Pkcs5Kdf> GetAlgorithm (const Hash &hash);
 		static Pkcs5KdfList GetAvailableAlgorithms ();
+		virtual size_t GetDerivedBlockSize () const = 0;
 		virtual shared_ptr <Hash> GetHash () const = 0;
 		virtual int GetIterationCount () const = 0;
 		virtual wstring GetName () const = 0;
@@ -36,6 +38,7 @@ namespace CipherShed
 	protected:
 		Pkcs5Kdf ();
 
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const = 0;
 		void ValidateParameters (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
 
 	private:
@@ -49,11 +52,14 @@ namespace CipherShed
 		Pkcs5HmacRipemd160 () { }
 		virtual ~Pkcs5HmacRipemd160 () { }
 
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
+		virtual size_t GetDerivedBlockSize () const { return 160 / 8; }
 		virtual shared_ptr <Hash> GetHash () const { return shared_ptr <Hash> (new Ripemd160); }
 		virtual int GetIterationCount () const { return 2000; }
 		virtual wstring GetName () const { return L"HMAC-RIPEMD-160"; }
 
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const;
+
 	private:
 		Pkcs5HmacRipemd160 (const Pkcs5HmacRipemd160 &);
 		Pkcs5HmacRipemd160 &operator= (const Pkcs5HmacRipemd160 &);
@@ -65,11 +71,14 @@ namespace CipherShed
 		Pkcs5HmacRipemd160_1000 () { }
 		virtual ~Pkcs5HmacRipemd160_1000 () { }
 
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
+		virtual size_t GetDerivedBlockSize () const { return 160 / 8; }
 		virtual shared_ptr <Hash> GetHash () const { return shared_ptr <Hash> (new Ripemd160); }
 		virtual int GetIterationCount () const { return 1000; }
 		virtual wstring GetName () const { return L"HMAC-RIPEMD-160"; }
 
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const;
+
 	private:
 		Pkcs5HmacRipemd160_1000 (const Pkcs5HmacRipemd160_1000 &);
 		Pkcs5HmacRipemd160_1000 &operator= (const Pkcs5HmacRipemd160_1000 &);
@@ -81,11 +90,14 @@ namespace CipherShed
 		Pkcs5HmacSha1 () { }
 		virtual ~Pkcs5HmacSha1 () { }
 
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
+		virtual size_t GetDerivedBlockSize () const { return 160 / 8; }
 		virtual shared_ptr <Hash> GetHash () const { return shared_ptr <Hash> (new Sha1); }
 		virtual int GetIterationCount () const { return 2000; }
 		virtual wstring GetName () const { return L"HMAC-SHA-1"; }
 
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const;
+
 	private:
 		Pkcs5HmacSha1 (const Pkcs5HmacSha1 &);
 		Pkcs5HmacSha1 &operator= (const Pkcs5HmacSha1 &);
@@ -97,11 +109,14 @@ namespace CipherShed
 		Pkcs5HmacSha512 () { }
 		virtual ~Pkcs5HmacSha512 () { }
 
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
+		virtual size_t GetDerivedBlockSize () const { return 512 / 8; }
 		virtual shared_ptr <Hash> GetHash () const { return shared_ptr <Hash> (new Sha512); }
 		virtual int GetIterationCount () const { return 1000; }
 		virtual wstring GetName () const { return L"HMAC-SHA-512"; }
 
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const;
+
 	private:
 		Pkcs5HmacSha512 (const Pkcs5HmacSha512 &);
 		Pkcs5HmacSha512 &operator= (const Pkcs5HmacSha512 &);
@@ -113,11 +128,14 @@ namespace CipherShed
 		Pkcs5HmacWhirlpool () { }
 		virtual ~Pkcs5HmacWhirlpool () { }
 
-		virtual void DeriveKey (const BufferPtr &key, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount) const;
+		virtual size_t GetDerivedBlockSize () const { return 512 / 8; }
 		virtual shared_ptr <Hash> GetHash () const { return shared_ptr <Hash> (new Whirlpool); }
 		virtual int GetIterationCount () const { return 1000; }
 		virtual wstring GetName () const { return L"HMAC-Whirlpool"; }
 
+	protected:
+		virtual void DeriveBlocks (const BufferPtr &blocks, const VolumePassword &password, const ConstBufferPtr &salt, int iterationCount, int firstBlockNumber, volatile int *aborted) const;
+
 	private:
 		Pkcs5HmacWhirlpool (const Pkcs5HmacWhirlpool &);
 		Pkcs5HmacWhirlpool &operator= (const Pkcs5HmacWhirlpool &);
@@ -118,8 +118,54 @@ namespace CipherShed
 			if (deviceHosted)
 				hostDeviceSectorSize = volumeFile->GetDeviceSectorSize();
 
+			VolumeLayoutList layouts = VolumeLayout::GetAvailableLayouts (volumeType);
+
+			// Headers of all layouts are fetched before the layouts are tested. Headers located relative to the start
+			// of the host and those located relative to its end are each covered by a single read, and both reads
+			// are in flight concurrently.
+			uint64 headRegionSize = 0;
+			uint64 tailRegionSize = 0;
+
+			foreach (shared_ptr <VolumeLayout> layout, layouts)
+			{
+				if (layout->HasDriveHeader() || partitionInSystemEncryptionScope)
+					continue;
+
+				if (useBackupHeaders && !layout->HasBackupHeader())
+					continue;
+
+				int headerOffset = useBackupHeaders ? layout->GetBackupHeaderOffset() : layout->GetHeaderOffset();
+
+				if (headerOffset >= 0)
+					headRegionSize = max (headRegionSize, (uint64) headerOffset + layout->GetHeaderSize());
+				else
+					tailRegionSize = max (tailRegionSize, (uint64) -headerOffset);
+			}
+
+			SecureBuffer headRegion;
+			SecureBuffer tailRegion;
+			shared_ptr <AsyncFileIoRequest> headRegionRead;
+			shared_ptr <AsyncFileIoRequest> tailRegionRead;
+
+			headRegionSize = min (headRegionSize, VolumeHostSize);
+			if (headRegionSize > 0)
+			{
+				headRegion.Allocate ((size_t) headRegionSize);
+				headRegionRead = VolumeFile->ReadAtAsync (headRegion, 0);
+			}
+
+			tailRegionSize = min (tailRegionSize, VolumeHostSize);
+			if (tailRegionSize > 0)
+			{
+				tailRegion.Allocate ((size_t) tailRegionSize);
+				tailRegionRead = VolumeFile->ReadAtAsync (tailRegion, VolumeHostSize - tailRegionSize);
+			}
+
+			uint64 headRegionDataSize = headRegionRead ? headRegionRead->Wait() : 0;
+			uint64 tailRegionDataSize = tailRegionRead ? tailRegionRead->Wait() : 0;
+
 			// Test volume layouts
-			foreach (shared_ptr <VolumeLayout> layout, VolumeLayout::GetAvailableLayouts (volumeType))
+			foreach (shared_ptr <VolumeLayout> layout, layouts)
 			{
 				if (skipLayoutV1Normal && typeid (*layout) == typeid (VolumeLayoutV1Normal))
 				{
@@ -168,12 +214,19 @@ namespace CipherShed
 					int headerOffset = useBackupHeaders ? layout->GetBackupHeaderOffset() : layout->GetHeaderOffset();
 
 					if (headerOffset >= 0)
-						VolumeFile->SeekAt (headerOffset);
+					{
+						if ((uint64) headerOffset + layout->GetHeaderSize() > headRegionDataSize)
+							continue;
+
+						headerBuffer.CopyFrom (headRegion.GetRange (headerOffset, layout->GetHeaderSize()));
+					}
 					else
-						VolumeFile->SeekEnd (headerOffset);
+					{
+						if (tailRegionDataSize != tailRegion.Size() || (uint64) -headerOffset > tailRegionDataSize)
+							continue;
 
-					if (VolumeFile->Read (headerBuffer) != layout->GetHeaderSize())
-						continue;
+						headerBuffer.CopyFrom (tailRegion.GetRange ((size_t) (tailRegionDataSize + headerOffset), layout->GetHeaderSize()));
+					}
 				}
 
 				EncryptionAlgorithmList layoutEncryptionAlgorithms = layout->GetSupportedEncryptionAlgorithms();
@@ -190,7 +243,7 @@ namespace CipherShed
 
 				shared_ptr <VolumeHeader> header = layout->GetHeader();
 
-				if (header->Decrypt (headerBuffer, *passwordKey, layout->GetSupportedKeyDerivationFunctions(), layoutEncryptionAlgorithms, layoutEncryptionModes))
+				if (header->Decrypt (headerBuffer, *passwordKey, layout->GetSupportedKeyDerivationFunctions(), layoutEncryptionAlgorithms, layoutEncryptionModes, wstring (GetPath())))
 				{
 					// Header decrypted
 
@@ -317,14 +370,43 @@ namespace CipherShed
 		if (length % SectorSize != 0 || byteOffset % SectorSize != 0)
 			throw ParameterIncorrect (SRC_POS);
 
-		if (VolumeFile->ReadAt (buffer, hostOffset) != length)
-			throw MissingVolumeData (SRC_POS);
+		if (length >= 2 * PipelineChunkSize)
+		{
+			ReadSectorsPipelined (buffer, hostOffset);
+		}
+		else
+		{
+			if (VolumeFile->ReadAt (buffer, hostOffset) != length)
+				throw MissingVolumeData (SRC_POS);
 
-		EA->DecryptSectors (buffer, hostOffset / SectorSize, length / SectorSize, SectorSize);
+			EA->DecryptSectors (buffer, hostOffset / SectorSize, length / SectorSize, SectorSize);
+		}
 
 		TotalDataRead += length;
 	}
 
+	void Volume::ReadSectorsPipelined (const BufferPtr &buffer, uint64 hostOffset)
+	{
+		// Reading of the next chunk from the host is overlapped with decryption of the current chunk
+		size_t length = buffer.Size();
+		shared_ptr <AsyncFileIoRequest> pendingRead = VolumeFile->ReadAtAsync (buffer.GetRange (0, min ((size_t) PipelineChunkSize, length)), hostOffset);
+
+		for (size_t offset = 0; offset < length; )
+		{
+			size_t chunkSize = pendingRead->GetSize();
+
+			if (pendingRead->Wait() != chunkSize)
+				throw MissingVolumeData (SRC_POS);
+
+			size_t nextOffset = offset + chunkSize;
+			if (nextOffset < length)
+				pendingRead = VolumeFile->ReadAtAsync (buffer.GetRange (nextOffset, min ((size_t) PipelineChunkSize, length - nextOffset)), hostOffset + nextOffset);
+
+			EA->DecryptSectors (buffer.GetRange (offset, chunkSize), (hostOffset + offset) / SectorSize, chunkSize / SectorSize, SectorSize);
+			offset = nextOffset;
+		}
+	}
+
 	void Volume::ReEncryptHeader (bool backupHeader, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf)
 	{
 		if_debug (ValidateState ());
@@ -373,11 +455,18 @@ namespace CipherShed
 		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
 			CheckProtectedRange (hostOffset, length);
 
-		SecureBuffer encBuf (buffer.Size());
-		encBuf.CopyFrom (buffer);
+		// The ciphertext is written directly to a buffer reused across requests
+		PooledSecureBuffer encBuf (WriteBufferPool, buffer.Size());
 
-		EA->EncryptSectors (encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
-		VolumeFile->WriteAt (encBuf, hostOffset);
+		if (length >= 2 * PipelineChunkSize)
+		{
+			WriteSectorsPipelined (buffer, encBuf, hostOffset);
+		}
+		else
+		{
+			EA->EncryptSectors (buffer, encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
+			VolumeFile->WriteAt (encBuf, hostOffset);
+		}
 
 		TotalDataWritten += length;
 		
@@ -385,4 +474,25 @@ namespace CipherShed
 		if (writeEndOffset > TopWriteOffset)
 			TopWriteOffset = writeEndOffset;
 	}
+
+	void Volume::WriteSectorsPipelined (const ConstBufferPtr &buffer, const BufferPtr &encryptedBuffer, uint64 hostOffset)
+	{
+		// Writing of each chunk to the host is overlapped with encryption of the following chunk
+		size_t length = buffer.Size();
+		list < shared_ptr <AsyncFileIoRequest> > pendingWrites;
+
+		for (size_t offset = 0; offset < length; offset += PipelineChunkSize)
+		{
+			size_t chunkSize = min ((size_t) PipelineChunkSize, length - offset);
+			BufferPtr encryptedChunk = encryptedBuffer.GetRange (offset, chunkSize);
+
+			EA->EncryptSectors (buffer.Get() + offset, encryptedChunk, (hostOffset + offset) / SectorSize, chunkSize / SectorSize, SectorSize);
+			pendingWrites.push_back (VolumeFile->WriteAtAsync (encryptedChunk, hostOffset + offset));
+		}
+
+		foreach (shared_ptr <AsyncFileIoRequest> write, pendingWrites)
+			write->Wait();
+	}
+
+	SecureBufferPool Volume::WriteBufferPool;
 }
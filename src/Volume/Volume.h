@@ -10,6 +10,7 @@
 #define TC_HEADER_Volume_Volume
 
 #include "../Platform/Platform.h"
+#include "../Platform/BufferPool.h"
 #include "../Platform/StringConverter.h"
 #include "EncryptionAlgorithm.h"
 #include "EncryptionMode.h"
@@ -97,7 +98,9 @@ namespace CipherShed
 
 	protected:
 		void CheckProtectedRange (uint64 writeHostOffset, uint64 writeLength);
+		void ReadSectorsPipelined (const BufferPtr &buffer, uint64 hostOffset);
 		void ValidateState () const;
+		void WriteSectorsPipelined (const ConstBufferPtr &buffer, const BufferPtr &encryptedBuffer, uint64 hostOffset);
 
 		shared_ptr <EncryptionAlgorithm> EA;
 		shared_ptr <VolumeHeader> Header;
@@ -117,6 +120,9 @@ namespace CipherShed
 		uint64 TotalDataRead;
 		uint64 TotalDataWritten;
 
+		static const size_t PipelineChunkSize = 256 * 1024;
+		static SecureBufferPool WriteBufferPool;
+
 	private:
 		Volume (const Volume &);
 		Volume &operator= (const Volume &);
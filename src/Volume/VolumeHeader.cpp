@@ -8,6 +8,7 @@
 
 #include "Crc32.h"
 #include "EncryptionModeXTS.h"
+#include "EncryptionThreadPool.h"
 #include "Pkcs5Kdf.h"
 #include "Pkcs5Kdf.h"
 #include "VolumeHeader.h"
@@ -78,52 +79,117 @@ namespace CipherShed
 		EncryptNew (headerBuffer, options.Salt, options.HeaderKey, options.Kdf);
 	}
 
-	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, const wstring &headerKeyCacheVolumeId)
 	{
 		if (password.Size() < 1)
 			throw PasswordEmpty (SRC_POS);
 
 		ConstBufferPtr salt (encryptedData.GetRange (SaltOffset, SaltSize));
+
+		SecureBuffer fingerprint;
+		if (!headerKeyCacheVolumeId.empty() && VolumeHeaderKeyCache::IsEnabled())
+		{
+			fingerprint.Allocate (VolumeHeaderKeyCache::FingerprintSize);
+			VolumeHeaderKeyCache::GetFingerprint (fingerprint, salt, password, keyDerivationFunctions, encryptionAlgorithms, encryptionModes);
+
+			VolumeHeaderKeyCache::CachedHeaderKey cachedKey;
+			SecureBuffer headerKey (GetLargestSerializedKeySize());
+
+			if (VolumeHeaderKeyCache::Find (headerKeyCacheVolumeId, fingerprint, cachedKey, headerKey)
+				&& DecryptCached (encryptedData, headerKey, cachedKey, keyDerivationFunctions, encryptionAlgorithms, encryptionModes))
+			{
+				return true;
+			}
+		}
+
+		if (EncryptionThreadPool::IsRunning() && keyDerivationFunctions.size() > 1)
+		{
+			// Header keys for all PRFs are derived concurrently. They are tested in the order of the list, so the
+			// result is the same as that of serial derivation. Derivations not yet started when the header has been
+			// decrypted are skipped.
+			typedef vector < shared_ptr <EncryptionThreadPool::KeyDerivation> > KeyDerivationList;
+			KeyDerivationList keyDerivations;
+
+			finally_do_arg (KeyDerivationList *, &keyDerivations,
+			{
+				foreach (shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation, *finally_arg)
+					keyDerivation->Abort();
+			});
+
+			foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+			{
+				shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation (new EncryptionThreadPool::KeyDerivation (pkcs5, password, salt, GetLargestSerializedKeySize()));
+				keyDerivations.push_back (keyDerivation);
+
+				EncryptionThreadPool::BeginKeyDerivation (keyDerivation);
+			}
+
+			foreach (shared_ptr <EncryptionThreadPool::KeyDerivation> keyDerivation, keyDerivations)
+			{
+				if (Decrypt (encryptedData, keyDerivation->WaitForKey(), keyDerivation->GetPkcs5Kdf(), encryptionAlgorithms, encryptionModes))
+				{
+					if (fingerprint.IsAllocated())
+						StoreCachedHeaderKey (headerKeyCacheVolumeId, fingerprint, keyDerivation->WaitForKey());
+					return true;
+				}
+			}
+		}
+		else
+		{
+			SecureBuffer headerKey (GetLargestSerializedKeySize());
+
+			foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+			{
+				pkcs5->DeriveKey (headerKey, password, salt);
+
+				if (Decrypt (encryptedData, headerKey, pkcs5, encryptionAlgorithms, encryptionModes))
+				{
+					if (fingerprint.IsAllocated())
+						StoreCachedHeaderKey (headerKeyCacheVolumeId, fingerprint, headerKey);
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	bool VolumeHeader::Decrypt (const ConstBufferPtr &encryptedData, const ConstBufferPtr &headerKey, shared_ptr <Pkcs5Kdf> pkcs5, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	{
 		SecureBuffer header (EncryptedHeaderDataSize);
-		SecureBuffer headerKey (GetLargestSerializedKeySize());
 
-		foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+		foreach (shared_ptr <EncryptionMode> mode, encryptionModes)
 		{
-			pkcs5->DeriveKey (headerKey, password, salt);
+			if (typeid (*mode) != typeid (EncryptionModeXTS))
+				mode->SetKey (headerKey.GetRange (0, mode->GetKeySize()));
 
-			foreach (shared_ptr <EncryptionMode> mode, encryptionModes)
+			foreach (shared_ptr <EncryptionAlgorithm> ea, encryptionAlgorithms)
 			{
-				if (typeid (*mode) != typeid (EncryptionModeXTS))
-					mode->SetKey (headerKey.GetRange (0, mode->GetKeySize()));
+				if (!ea->IsModeSupported (mode))
+					continue;
+
+				if (typeid (*mode) == typeid (EncryptionModeXTS))
+				{
+					ea->SetKey (headerKey.GetRange (0, ea->GetKeySize()));
+					
+					mode = mode->GetNew();
+					mode->SetKey (headerKey.GetRange (ea->GetKeySize(), ea->GetKeySize()));
+				}
+				else
+				{
+					ea->SetKey (headerKey.GetRange (LegacyEncryptionModeKeyAreaSize, ea->GetKeySize()));
+				}
+
+				ea->SetMode (mode);
+
+				header.CopyFrom (encryptedData.GetRange (EncryptedHeaderDataOffset, EncryptedHeaderDataSize));
+				ea->Decrypt (header);
 
-				foreach (shared_ptr <EncryptionAlgorithm> ea, encryptionAlgorithms)
+				if (Deserialize (header, ea, mode))
 				{
-					if (!ea->IsModeSupported (mode))
-						continue;
-
-					if (typeid (*mode) == typeid (EncryptionModeXTS))
-					{
-						ea->SetKey (headerKey.GetRange (0, ea->GetKeySize()));
-						
-						mode = mode->GetNew();
-						mode->SetKey (headerKey.GetRange (ea->GetKeySize(), ea->GetKeySize()));
-					}
-					else
-					{
-						ea->SetKey (headerKey.GetRange (LegacyEncryptionModeKeyAreaSize, ea->GetKeySize()));
-					}
-
-					ea->SetMode (mode);
-
-					header.CopyFrom (encryptedData.GetRange (EncryptedHeaderDataOffset, EncryptedHeaderDataSize));
-					ea->Decrypt (header);
-
-					if (Deserialize (header, ea, mode))
-					{
-						EA = ea;
-						Pkcs5 = pkcs5;
-						return true;
-					}
+					EA = ea;
+					Pkcs5 = pkcs5;
+					return true;
 				}
 			}
 		}
@@ -131,6 +197,33 @@ namespace CipherShed
 		return false;
 	}
 
+	bool VolumeHeader::DecryptCached (const ConstBufferPtr &encryptedData, const ConstBufferPtr &headerKey, const VolumeHeaderKeyCache::CachedHeaderKey &cachedKey, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	{
+		foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+		{
+			if (cachedKey.Pkcs5KdfType != typeid (*pkcs5).name())
+				continue;
+
+			EncryptionAlgorithmList cachedAlgorithms;
+			foreach (shared_ptr <EncryptionAlgorithm> ea, encryptionAlgorithms)
+			{
+				if (cachedKey.EncryptionAlgorithmType == typeid (*ea).name())
+					cachedAlgorithms.push_back (ea);
+			}
+
+			EncryptionModeList cachedModes;
+			foreach (shared_ptr <EncryptionMode> mode, encryptionModes)
+			{
+				if (cachedKey.EncryptionModeType == typeid (*mode).name())
+					cachedModes.push_back (mode);
+			}
+
+			return Decrypt (encryptedData, headerKey, pkcs5, cachedAlgorithms, cachedModes);
+		}
+
+		return false;
+	}
+
 	bool VolumeHeader::Deserialize (const ConstBufferPtr &header, shared_ptr <EncryptionAlgorithm> &ea, shared_ptr <EncryptionMode> &mode)
 	{
 		if (header.Size() != EncryptedHeaderDataSize)
@@ -339,4 +432,14 @@ namespace CipherShed
 		HeaderSize = headerSize;
 		EncryptedHeaderDataSize = HeaderSize - EncryptedHeaderDataOffset;
 	}
+
+	void VolumeHeader::StoreCachedHeaderKey (const wstring &volumeId, const ConstBufferPtr &fingerprint, const ConstBufferPtr &headerKey) const
+	{
+		VolumeHeaderKeyCache::CachedHeaderKey cachedKey;
+		cachedKey.EncryptionAlgorithmType = typeid (*EA).name();
+		cachedKey.EncryptionModeType = typeid (*EA->GetMode()).name();
+		cachedKey.Pkcs5KdfType = typeid (*Pkcs5).name();
+
+		VolumeHeaderKeyCache::Store (volumeId, fingerprint, cachedKey, headerKey);
+	}
 }
@@ -15,6 +15,7 @@
 #include "EncryptionAlgorithm.h"
 #include "EncryptionMode.h"
 #include "Keyfile.h"
+#include "VolumeHeaderKeyCache.h"
 #include "VolumePassword.h"
 #include "Pkcs5Kdf.h"
 #include "Version.h"
@@ -56,7 +57,7 @@ namespace CipherShed
 		virtual ~VolumeHeader ();
 
 		void Create (const BufferPtr &headerBuffer, VolumeHeaderCreationOptions &options);
-		bool Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
+		bool Decrypt (const ConstBufferPtr &encryptedData, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, const wstring &headerKeyCacheVolumeId = wstring());
 		void EncryptNew (const BufferPtr &newHeaderBuffer, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf);
 		uint64 GetEncryptedAreaStart () const { return EncryptedAreaStart; }
 		uint64 GetEncryptedAreaLength () const { return EncryptedAreaLength; }
@@ -74,12 +75,15 @@ namespace CipherShed
 		void SetSize (uint32 headerSize);
 
 	protected:
+		bool Decrypt (const ConstBufferPtr &encryptedData, const ConstBufferPtr &headerKey, shared_ptr <Pkcs5Kdf> pkcs5, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
+		bool DecryptCached (const ConstBufferPtr &encryptedData, const ConstBufferPtr &headerKey, const VolumeHeaderKeyCache::CachedHeaderKey &cachedKey, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
 		bool Deserialize (const ConstBufferPtr &header, shared_ptr <EncryptionAlgorithm> &ea, shared_ptr <EncryptionMode> &mode);
 		template <typename T> T DeserializeEntry (const ConstBufferPtr &header, size_t &offset) const;
 		template <typename T> T DeserializeEntryAt (const ConstBufferPtr &header, const size_t &offset) const;
 		void Init ();
 		void Serialize (const BufferPtr &header) const;
 		template <typename T> void SerializeEntry (const T &entry, const BufferPtr &header, size_t &offset) const;
+		void StoreCachedHeaderKey (const wstring &volumeId, const ConstBufferPtr &fingerprint, const ConstBufferPtr &headerKey) const;
 
 		uint32 HeaderSize;
 
@@ -0,0 +1,254 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#	include <sys/mman.h>
+#endif
+
+#include "../Common/Pkcs5.h"
+#include "../Platform/File.h"
+#include "../Platform/Time.h"
+#include "VolumeHeader.h"
+#include "VolumeHeaderKeyCache.h"
+
+namespace CipherShed
+{
+	void VolumeHeaderKeyCache::Clear ()
+	{
+		ScopeLock lock (EntriesMutex);
+
+		for (size_t slot = 0; slot < Entries.size(); ++slot)
+			EraseEntry (slot);
+
+		if (Storage.IsAllocated())
+			GetFingerprintKeyStorage().Erase();
+
+		TimeToLive = 0;
+	}
+
+	void VolumeHeaderKeyCache::Enable (uint64 timeToLive)
+	{
+		if (timeToLive < 1 || timeToLive > MaxTimeToLive)
+			throw ParameterIncorrect (SRC_POS);
+
+		ScopeLock lock (EntriesMutex);
+
+		if (!Storage.IsAllocated())
+		{
+			Storage.Allocate (Capacity * GetSlotSize() + FingerprintKeySize);
+			Storage.Zero();
+
+#ifdef TC_UNIX
+			// Header keys must not be paged out to a swap device
+			if (mlock (Storage.Ptr(), Storage.Size()) == -1)
+			{
+				Storage.Free();
+				throw SystemException (SRC_POS);
+			}
+#endif
+			Entries.resize (Capacity);
+			for (size_t slot = 0; slot < Entries.size(); ++slot)
+				Entries[slot].Used = false;
+		}
+
+		// A new fingerprint key is generated whenever the cache is enabled after it has been cleared
+		if (TimeToLive == 0)
+			GenerateFingerprintKey();
+
+		TimeToLive = timeToLive * 1000ULL * 1000ULL * 10ULL;
+	}
+
+	void VolumeHeaderKeyCache::EraseEntry (size_t slot)
+	{
+		Entry &entry = Entries[slot];
+		if (!entry.Used)
+			return;
+
+		GetFingerprintStorage (slot).Erase();
+		GetHeaderKeyStorage (slot).Erase();
+
+		entry.Key = CachedHeaderKey();
+		entry.VolumeId.clear();
+		entry.Used = false;
+	}
+
+	void VolumeHeaderKeyCache::EraseExpiredEntries ()
+	{
+		uint64 currentTime = Time::GetCurrent();
+
+		for (size_t slot = 0; slot < Entries.size(); ++slot)
+		{
+			if (Entries[slot].Used && currentTime >= Entries[slot].ExpirationTime)
+				EraseEntry (slot);
+		}
+	}
+
+	bool VolumeHeaderKeyCache::Find (const wstring &volumeId, const ConstBufferPtr &fingerprint, CachedHeaderKey &cachedKey, const BufferPtr &headerKey)
+	{
+		if (fingerprint.Size() != FingerprintSize)
+			throw ParameterIncorrect (SRC_POS);
+
+		ScopeLock lock (EntriesMutex);
+		EraseExpiredEntries();
+
+		for (size_t slot = 0; slot < Entries.size(); ++slot)
+		{
+			const Entry &entry = Entries[slot];
+
+			if (IsEntryOf (slot, volumeId, fingerprint))
+			{
+				if (headerKey.Size() < entry.HeaderKeySize)
+					throw ParameterIncorrect (SRC_POS);
+
+				cachedKey = entry.Key;
+				headerKey.CopyFrom (GetHeaderKeyStorage (slot).GetRange (0, entry.HeaderKeySize));
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void VolumeHeaderKeyCache::GenerateFingerprintKey ()
+	{
+#ifdef TC_UNIX
+		File randomSource;
+		randomSource.Open (FilePath ("/dev/urandom"));
+		randomSource.ReadCompleteBuffer (GetFingerprintKeyStorage());
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
+	void VolumeHeaderKeyCache::GetFingerprint (const BufferPtr &fingerprint, const ConstBufferPtr &salt, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes)
+	{
+		if (fingerprint.Size() != FingerprintSize)
+			throw ParameterIncorrect (SRC_POS);
+
+		// The searched algorithms are included so that an entry recording a failed search is not used for a wider search
+		string searchedAlgorithms;
+
+		foreach (shared_ptr <Pkcs5Kdf> pkcs5, keyDerivationFunctions)
+			searchedAlgorithms += string (typeid (*pkcs5).name()) + ";";
+
+		foreach (shared_ptr <EncryptionAlgorithm> ea, encryptionAlgorithms)
+			searchedAlgorithms += string (typeid (*ea).name()) + ";";
+
+		foreach (shared_ptr <EncryptionMode> mode, encryptionModes)
+			searchedAlgorithms += string (typeid (*mode).name()) + ";";
+
+		SecureBuffer data (salt.Size() + password.Size() + searchedAlgorithms.size());
+		data.GetRange (0, salt.Size()).CopyFrom (salt);
+		data.GetRange (salt.Size(), password.Size()).CopyFrom (ConstBufferPtr (password.DataPtr(), password.Size()));
+		data.GetRange (salt.Size() + password.Size(), searchedAlgorithms.size()).CopyFrom (ConstBufferPtr (reinterpret_cast <const byte *> (searchedAlgorithms.c_str()), searchedAlgorithms.size()));
+
+		// Fingerprints are keyed by a secret of the process to prevent their use for testing passwords
+		ScopeLock lock (EntriesMutex);
+
+		if (TimeToLive == 0)
+		{
+			fingerprint.Zero();
+			return;
+		}
+
+		hmac_sha512 ((char *) GetFingerprintKeyStorage().Get(), FingerprintKeySize, (char *) data.Ptr(), (int) data.Size(), (char *) fingerprint.Get(), (int) FingerprintSize);
+	}
+
+	BufferPtr VolumeHeaderKeyCache::GetFingerprintKeyStorage ()
+	{
+		return Storage.GetRange (Capacity * GetSlotSize(), FingerprintKeySize);
+	}
+
+	BufferPtr VolumeHeaderKeyCache::GetFingerprintStorage (size_t slot)
+	{
+		return Storage.GetRange (slot * GetSlotSize(), FingerprintSize);
+	}
+
+	BufferPtr VolumeHeaderKeyCache::GetHeaderKeyStorage (size_t slot)
+	{
+		return Storage.GetRange (slot * GetSlotSize() + FingerprintSize, VolumeHeader::GetLargestSerializedKeySize());
+	}
+
+	size_t VolumeHeaderKeyCache::GetSlotSize ()
+	{
+		return FingerprintSize + VolumeHeader::GetLargestSerializedKeySize();
+	}
+
+	bool VolumeHeaderKeyCache::IsEntryOf (size_t slot, const wstring &volumeId, const ConstBufferPtr &fingerprint)
+	{
+		const Entry &entry = Entries[slot];
+		return entry.Used && entry.VolumeId == volumeId && ConstBufferPtr (GetFingerprintStorage (slot)).IsDataEqual (fingerprint);
+	}
+
+	bool VolumeHeaderKeyCache::IsEmpty ()
+	{
+		ScopeLock lock (EntriesMutex);
+
+		for (size_t slot = 0; slot < Entries.size(); ++slot)
+		{
+			if (Entries[slot].Used)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool VolumeHeaderKeyCache::IsEnabled ()
+	{
+		ScopeLock lock (EntriesMutex);
+		return TimeToLive != 0;
+	}
+
+	void VolumeHeaderKeyCache::Store (const wstring &volumeId, const ConstBufferPtr &fingerprint, const CachedHeaderKey &cachedKey, const ConstBufferPtr &headerKey)
+	{
+		if (fingerprint.Size() != FingerprintSize || headerKey.Size() > VolumeHeader::GetLargestSerializedKeySize())
+			throw ParameterIncorrect (SRC_POS);
+
+		ScopeLock lock (EntriesMutex);
+
+		if (TimeToLive == 0)
+			return;
+
+		EraseExpiredEntries();
+
+		// Reuse the entry of the same header, a free entry, or the entry closest to expiration
+		size_t storeSlot = 0;
+		for (size_t slot = 0; slot < Entries.size(); ++slot)
+		{
+			const Entry &entry = Entries[slot];
+
+			if (IsEntryOf (slot, volumeId, fingerprint))
+			{
+				storeSlot = slot;
+				break;
+			}
+
+			if (!entry.Used)
+				storeSlot = slot;
+			else if (Entries[storeSlot].Used && entry.ExpirationTime < Entries[storeSlot].ExpirationTime)
+				storeSlot = slot;
+		}
+
+		EraseEntry (storeSlot);
+
+		Entry &entry = Entries[storeSlot];
+		entry.ExpirationTime = Time::GetCurrent() + TimeToLive;
+		entry.HeaderKeySize = headerKey.Size();
+		entry.Key = cachedKey;
+		entry.Used = true;
+		entry.VolumeId = volumeId;
+
+		GetFingerprintStorage (storeSlot).CopyFrom (fingerprint);
+		GetHeaderKeyStorage (storeSlot).CopyFrom (headerKey);
+	}
+
+	vector <VolumeHeaderKeyCache::Entry> VolumeHeaderKeyCache::Entries;
+	Mutex VolumeHeaderKeyCache::EntriesMutex;
+	SecureBuffer VolumeHeaderKeyCache::Storage;
+	uint64 VolumeHeaderKeyCache::TimeToLive = 0;
+}
@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeHeaderKeyCache
+#define TC_HEADER_Volume_VolumeHeaderKeyCache
+
+#include "../Platform/Platform.h"
+#include "EncryptionAlgorithm.h"
+#include "EncryptionMode.h"
+#include "Pkcs5Kdf.h"
+#include "VolumePassword.h"
+
+namespace CipherShed
+{
+	// Cache of header keys derived by VolumeHeader::Decrypt(). An entry is identified by the volume path and by an
+	// HMAC of the salt, the password (with keyfiles applied) and the searched algorithms keyed by a random secret of
+	// the process. It records which PRF, encryption algorithm and mode decrypted the header so that reopening a volume
+	// does not repeat the key derivation. Passwords which do not decrypt a header are not recorded. Keys, fingerprints
+	// and the secret are kept in a single memory-locked buffer. Entries expire after the time-to-live passed to
+	// Enable(). The cache is disabled until Enable() is called and again by Clear().
+	class VolumeHeaderKeyCache
+	{
+	public:
+		struct CachedHeaderKey
+		{
+			string EncryptionAlgorithmType;	// typeid().name() of the class
+			string EncryptionModeType;
+			string Pkcs5KdfType;
+		};
+
+		static void Clear ();
+		static void Enable (uint64 timeToLive);
+		static bool Find (const wstring &volumeId, const ConstBufferPtr &fingerprint, CachedHeaderKey &cachedKey, const BufferPtr &headerKey);
+		static void GetFingerprint (const BufferPtr &fingerprint, const ConstBufferPtr &salt, const VolumePassword &password, const Pkcs5KdfList &keyDerivationFunctions, const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes);
+		static bool IsEmpty ();
+		static bool IsEnabled ();
+		static void Store (const wstring &volumeId, const ConstBufferPtr &fingerprint, const CachedHeaderKey &cachedKey, const ConstBufferPtr &headerKey);
+
+		static const size_t Capacity = 64;
+		static const size_t FingerprintKeySize = 64;
+		static const size_t FingerprintSize = 64;
+		static const uint64 MaxTimeToLive = 30 * 24 * 60 * 60;	// Seconds
+
+	protected:
+		struct Entry
+		{
+			CachedHeaderKey Key;
+			uint64 ExpirationTime;
+			size_t HeaderKeySize;
+			bool Used;
+			wstring VolumeId;
+		};
+
+		static void EraseEntry (size_t slot);
+		static void EraseExpiredEntries ();
+		static void GenerateFingerprintKey ();
+		static BufferPtr GetFingerprintKeyStorage ();
+		static BufferPtr GetFingerprintStorage (size_t slot);
+		static BufferPtr GetHeaderKeyStorage (size_t slot);
+		static size_t GetSlotSize ();
+		static bool IsEntryOf (size_t slot, const wstring &volumeId, const ConstBufferPtr &fingerprint);
+
+		static vector <Entry> Entries;
+		static Mutex EntriesMutex;
+		static SecureBuffer Storage;
+		static uint64 TimeToLive;	// Hundreds of nanoseconds
+
+	private:
+		VolumeHeaderKeyCache ();
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeHeaderKeyCache
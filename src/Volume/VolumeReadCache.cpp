@@ -0,0 +1,348 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#	include <sys/mman.h>
+#endif
+
+#include "VolumeReadCache.h"
+#include "VolumeException.h"
+
+namespace CipherShed
+{
+	VolumeReadCache::VolumeReadCache (shared_ptr <Volume> volume, uint64 cacheSize)
+		: StorageLocked (false),
+		CachedVolume (volume),
+		VolumeSize (volume->GetSize()),
+		WriteGeneration (0),
+		LastReadEnd (0),
+		SequentialReadCount (0),
+		ReadaheadEnd (0),
+		PendingReadaheadStart (0),
+		PendingReadaheadEnd (0),
+		StopPending (false)
+	{
+		if (BlockSize % volume->GetSectorSize() != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		uint64 blockCount = cacheSize / BlockSize;
+		if (blockCount < MinBlockCount)
+			blockCount = MinBlockCount;
+
+		if (blockCount > (uint64) (size_t) -1 / BlockSize)
+			throw ParameterTooLarge (SRC_POS);
+
+		Storage.Allocate ((size_t) blockCount * BlockSize);
+
+#ifdef TC_UNIX
+		// Decrypted data must not be paged out to a swap device
+		throw_sys_if (mlock (Storage.Ptr(), Storage.Size()) == -1);
+		StorageLocked = true;
+#endif
+
+		Blocks.resize ((size_t) blockCount);
+		for (size_t slot = 0; slot < Blocks.size(); ++slot)
+		{
+			Blocks[slot].Valid = false;
+			Blocks[slot].LruPosition = LruList.insert (LruList.end(), slot);
+		}
+
+		ReadaheadSize = Storage.Size() / 4;
+		if (ReadaheadSize > MaxReadaheadSize)
+			ReadaheadSize = MaxReadaheadSize;
+
+		struct ThreadFunctor : public Functor
+		{
+			ThreadFunctor (VolumeReadCache *cache) : Cache (cache) { }
+			virtual void operator() ()
+			{
+				Cache->ReadaheadThread ();
+			}
+			VolumeReadCache *Cache;
+		};
+
+		try
+		{
+			ReadaheadThreadHandle.Start (new ThreadFunctor (this));
+		}
+		catch (...)
+		{
+#ifdef TC_UNIX
+			munlock (Storage.Ptr(), Storage.Size());
+#endif
+			throw;
+		}
+	}
+
+	VolumeReadCache::~VolumeReadCache ()
+	{
+		StopPending = true;
+		ReadaheadEvent.Signal();
+		ReadaheadThreadHandle.Join();
+
+		Storage.Erase();
+
+#ifdef TC_UNIX
+		if (StorageLocked)
+			munlock (Storage.Ptr(), Storage.Size());
+#endif
+	}
+
+	bool VolumeReadCache::CopyFromCache (uint64 blockIndex, const BufferPtr &buffer, uint64 byteOffset)
+	{
+		ScopeLock lock (CacheMutex);
+
+		map <uint64, size_t>::const_iterator entry = BlockMap.find (blockIndex);
+		if (entry == BlockMap.end())
+			return false;
+
+		size_t slot = entry->second;
+		Touch (slot);
+
+		CopyRange (ConstBufferPtr (Storage.Ptr() + slot * BlockSize, Blocks[slot].DataSize), blockIndex * BlockSize, buffer, byteOffset);
+		return true;
+	}
+
+	void VolumeReadCache::CopyRange (const ConstBufferPtr &source, uint64 sourceOffset, const BufferPtr &destination, uint64 destinationOffset) const
+	{
+		uint64 start = max (sourceOffset, destinationOffset);
+		uint64 end = min (sourceOffset + source.Size(), destinationOffset + destination.Size());
+
+		if (start < end)
+			Memory::Copy (destination.Get() + (start - destinationOffset), source.Get() + (start - sourceOffset), (size_t) (end - start));
+	}
+
+	void VolumeReadCache::Insert (uint64 blockIndex, const ConstBufferPtr &data, uint64 generation)
+	{
+		ScopeLock lock (CacheMutex);
+
+		// Data read before a write completed may be stale
+		if (generation != WriteGeneration)
+			return;
+
+		map <uint64, size_t>::const_iterator entry = BlockMap.find (blockIndex);
+		if (entry != BlockMap.end())
+		{
+			Touch (entry->second);
+			return;
+		}
+
+		size_t slot = LruList.back();
+		CacheBlock &block = Blocks[slot];
+
+		if (block.Valid)
+			BlockMap.erase (block.Index);
+
+		Memory::Copy (Storage.Ptr() + slot * BlockSize, data.Get(), data.Size());
+
+		block.Valid = true;
+		block.Index = blockIndex;
+		block.DataSize = data.Size();
+
+		BlockMap[blockIndex] = slot;
+		Touch (slot);
+	}
+
+	void VolumeReadCache::Invalidate (uint64 byteOffset, uint64 size)
+	{
+		ScopeLock lock (CacheMutex);
+		++WriteGeneration;
+
+		if (size == 0)
+			return;
+
+		uint64 lastBlock = (byteOffset + size - 1) / BlockSize;
+		map <uint64, size_t>::iterator entry = BlockMap.lower_bound (byteOffset / BlockSize);
+
+		while (entry != BlockMap.end() && entry->first <= lastBlock)
+		{
+			CacheBlock &block = Blocks[entry->second];
+			block.Valid = false;
+
+			// Invalidated slots are reused first
+			LruList.splice (LruList.end(), LruList, block.LruPosition);
+
+			BlockMap.erase (entry++);
+		}
+	}
+
+	bool VolumeReadCache::IsCached (uint64 blockIndex)
+	{
+		ScopeLock lock (CacheMutex);
+		return BlockMap.find (blockIndex) != BlockMap.end();
+	}
+
+	void VolumeReadCache::LoadBlocks (uint64 firstBlock, uint64 endBlock, const BufferPtr *buffer, uint64 byteOffset)
+	{
+		uint64 rangeStart = firstBlock * BlockSize;
+		uint64 rangeEnd = min (endBlock * BlockSize, VolumeSize);
+		size_t rangeSize = (size_t) (rangeEnd - rangeStart);
+
+		uint64 generation;
+		{
+			ScopeLock lock (CacheMutex);
+			generation = WriteGeneration;
+		}
+
+		PooledSecureBuffer data (ScratchBufferPool, rangeSize);
+		finally_do_arg (BufferPtr, data, { finally_arg.Erase(); });
+
+		CachedVolume->ReadSectors (data, rangeStart);
+
+		for (size_t offset = 0; offset < rangeSize; offset += BlockSize)
+			Insert (firstBlock + offset / BlockSize, ConstBufferPtr (data).GetRange (offset, min (rangeSize - offset, (size_t) BlockSize)), generation);
+
+		if (buffer)
+			CopyRange (data, rangeStart, *buffer, byteOffset);
+	}
+
+	void VolumeReadCache::ReadaheadThread ()
+	{
+		while (!StopPending)
+		{
+			ReadaheadEvent.Wait();
+
+			while (!StopPending)
+			{
+				uint64 start, end;
+				{
+					ScopeLock lock (CacheMutex);
+
+					if (PendingReadaheadStart >= PendingReadaheadEnd)
+						break;
+
+					start = PendingReadaheadStart;
+					end = PendingReadaheadEnd;
+					PendingReadaheadStart = PendingReadaheadEnd = 0;
+				}
+
+				try
+				{
+					uint64 endBlock = (end + BlockSize - 1) / BlockSize;
+
+					for (uint64 blockIndex = start / BlockSize; blockIndex < endBlock && !StopPending; )
+					{
+						if (IsCached (blockIndex))
+						{
+							++blockIndex;
+							continue;
+						}
+
+						uint64 runEnd = blockIndex + 1;
+						while (runEnd < endBlock && !IsCached (runEnd))
+							++runEnd;
+
+						LoadBlocks (blockIndex, runEnd, nullptr, 0);
+						blockIndex = runEnd;
+					}
+				}
+				catch (...) { } // Readahead errors are reported by subsequent reads
+			}
+		}
+	}
+
+	void VolumeReadCache::ReadSectors (const BufferPtr &buffer, uint64 byteOffset)
+	{
+		uint64 size = buffer.Size();
+
+		if (size == 0 || byteOffset + size > VolumeSize)
+		{
+			CachedVolume->ReadSectors (buffer, byteOffset);
+			return;
+		}
+
+		{
+			ScopeLock lock (CacheMutex);
+
+			if (byteOffset == LastReadEnd)
+			{
+				++SequentialReadCount;
+			}
+			else
+			{
+				SequentialReadCount = 0;
+				ReadaheadEnd = 0;
+			}
+
+			LastReadEnd = byteOffset + size;
+
+			if (SequentialReadCount >= SequentialReadThreshold)
+				ScheduleReadahead (LastReadEnd);
+		}
+
+		try
+		{
+			uint64 endBlock = (byteOffset + size - 1) / BlockSize + 1;
+
+			for (uint64 blockIndex = byteOffset / BlockSize; blockIndex < endBlock; )
+			{
+				if (CopyFromCache (blockIndex, buffer, byteOffset))
+				{
+					++blockIndex;
+					continue;
+				}
+
+				// Consecutive missing blocks are read and decrypted by a single request
+				uint64 runEnd = blockIndex + 1;
+				while (runEnd < endBlock && !IsCached (runEnd))
+					++runEnd;
+
+				LoadBlocks (blockIndex, runEnd, &buffer, byteOffset);
+				blockIndex = runEnd;
+			}
+		}
+		catch (MissingVolumeData&)
+		{
+			// The host may not contain the whole block although the requested sectors are available
+			CachedVolume->ReadSectors (buffer, byteOffset);
+		}
+	}
+
+	void VolumeReadCache::ScheduleReadahead (uint64 readEnd)
+	{
+		if (readEnd >= VolumeSize)
+			return;
+
+		if (ReadaheadEnd < readEnd)
+			ReadaheadEnd = readEnd;
+
+		// Readahead is issued in batches when less than half of the window remains
+		if (ReadaheadEnd - readEnd >= ReadaheadSize / 2)
+			return;
+
+		uint64 end = min (readEnd + ReadaheadSize, VolumeSize);
+
+		if (PendingReadaheadStart >= PendingReadaheadEnd)
+			PendingReadaheadStart = ReadaheadEnd;
+
+		PendingReadaheadEnd = end;
+		ReadaheadEnd = end;
+
+		ReadaheadEvent.Signal();
+	}
+
+	void VolumeReadCache::Touch (size_t slot)
+	{
+		LruList.splice (LruList.begin(), LruList, Blocks[slot].LruPosition);
+	}
+
+	void VolumeReadCache::WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset)
+	{
+		try
+		{
+			CachedVolume->WriteSectors (buffer, byteOffset);
+		}
+		catch (...)
+		{
+			Invalidate (byteOffset, buffer.Size());
+			throw;
+		}
+
+		Invalidate (byteOffset, buffer.Size());
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ Copyright (c) 2008 TrueCrypt Developers Association. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeReadCache
+#define TC_HEADER_Volume_VolumeReadCache
+
+#include "../Platform/Platform.h"
+#include "../Platform/BufferPool.h"
+#include "Volume.h"
+
+namespace CipherShed
+{
+	// Bounded LRU cache of decrypted volume data. The cache is organized in blocks of BlockSize bytes, which are
+	// kept in a single memory-locked buffer. Sequential read patterns are detected and the following blocks are
+	// read and decrypted ahead by a background thread (decryption itself is parallelized by EncryptionThreadPool).
+	// Writes must be routed through WriteSectors() so that stale blocks are invalidated.
+	class VolumeReadCache
+	{
+	public:
+		VolumeReadCache (shared_ptr <Volume> volume, uint64 cacheSize);
+		virtual ~VolumeReadCache ();
+
+		size_t GetBlockCount () const { return Blocks.size(); }
+		void Invalidate (uint64 byteOffset, uint64 size);
+		void ReadSectors (const BufferPtr &buffer, uint64 byteOffset);
+		void WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset);
+
+		static const size_t BlockSize = 64 * 1024;
+		static const size_t MaxReadaheadSize = 4 * 1024 * 1024;
+		static const size_t MinBlockCount = 16;
+		static const int SequentialReadThreshold = 2;
+
+	protected:
+		struct CacheBlock
+		{
+			bool Valid;
+			uint64 Index;
+			size_t DataSize;
+			list <size_t>::iterator LruPosition;
+		};
+
+		bool CopyFromCache (uint64 blockIndex, const BufferPtr &buffer, uint64 byteOffset);
+		void CopyRange (const ConstBufferPtr &source, uint64 sourceOffset, const BufferPtr &destination, uint64 destinationOffset) const;
+		void Insert (uint64 blockIndex, const ConstBufferPtr &data, uint64 generation);
+		bool IsCached (uint64 blockIndex);
+		void LoadBlocks (uint64 firstBlock, uint64 endBlock, const BufferPtr *buffer, uint64 byteOffset);
+		void ReadaheadThread ();
+		void ScheduleReadahead (uint64 readEnd);
+		void Touch (size_t slot);
+
+		vector <CacheBlock> Blocks;
+		map <uint64, size_t> BlockMap;
+		list <size_t> LruList;
+		Mutex CacheMutex;
+		SecureBuffer Storage;
+		bool StorageLocked;
+		SecureBufferPool ScratchBufferPool;
+		shared_ptr <Volume> CachedVolume;
+		uint64 VolumeSize;
+		uint64 WriteGeneration;
+
+		uint64 LastReadEnd;
+		int SequentialReadCount;
+		uint64 ReadaheadEnd;
+		size_t ReadaheadSize;
+		uint64 PendingReadaheadStart;
+		uint64 PendingReadaheadEnd;
+		SyncEvent ReadaheadEvent;
+		Thread ReadaheadThreadHandle;
+		volatile bool StopPending;
+
+	private:
+		VolumeReadCache (const VolumeReadCache &);
+		VolumeReadCache &operator= (const VolumeReadCache &);
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeReadCache
@@ -0,0 +1,96 @@
+#include "../../../Common/Crypto.h"
+
+/* Software-only subset of Common/Crypto.c (which depends on the Windows encryption thread pool) required by Common/Xts.c */
+
+int CipherInit (int cipher, unsigned char *key, unsigned char *ks)
+{
+	switch (cipher)
+	{
+	case AES:
+		if (aes_encrypt_key256 (key, (aes_encrypt_ctx *) ks) != EXIT_SUCCESS)
+			return ERR_CIPHER_INIT_FAILURE;
+
+		if (aes_decrypt_key256 (key, (aes_decrypt_ctx *) (ks + sizeof (aes_encrypt_ctx))) != EXIT_SUCCESS)
+			return ERR_CIPHER_INIT_FAILURE;
+		break;
+
+	case SERPENT:
+		serpent_set_key (key, 32 * 8, ks);
+		break;
+
+	case TWOFISH:
+		twofish_set_key ((TwofishInstance *) ks, (const u4byte *) key, 32 * 8);
+		break;
+
+	default:
+		return ERR_CIPHER_INIT_FAILURE;
+	}
+
+	return ERR_SUCCESS;
+}
+
+BOOL CipherSupportsIntraDataUnitParallelization (int cipher)
+{
+	return cipher == SERPENT || cipher == TWOFISH;
+}
+
+void EncipherBlock (int cipher, void *data, void *ks)
+{
+	switch (cipher)
+	{
+	case AES:		aes_encrypt ((unsigned char *) data, (unsigned char *) data, (aes_encrypt_ctx *) ks); break;
+	case TWOFISH:	twofish_encrypt ((TwofishInstance *) ks, (u4byte *) data, (u4byte *) data); break;
+	case SERPENT:	serpent_encrypt ((unsigned __int8 *) data, (unsigned __int8 *) data, (unsigned __int8 *) ks); break;
+	default:		TC_THROW_FATAL_EXCEPTION;
+	}
+}
+
+void EncipherBlocks (int cipher, void *dataPtr, void *ks, size_t blockCount)
+{
+	unsigned __int8 *data = (unsigned __int8 *) dataPtr;
+
+	switch (cipher)
+	{
+	case SERPENT:	serpent_encrypt_blocks (data, data, blockCount, (unsigned __int8 *) ks); break;
+	case TWOFISH:	twofish_encrypt_blocks ((TwofishInstance *) ks, data, data, blockCount); break;
+	default:
+		while (blockCount-- > 0)
+		{
+			EncipherBlock (cipher, data, ks);
+			data += CipherGetBlockSize (cipher);
+		}
+	}
+}
+
+void DecipherBlock (int cipher, void *data, void *ks)
+{
+	switch (cipher)
+	{
+	case AES:		aes_decrypt ((unsigned char *) data, (unsigned char *) data, (aes_decrypt_ctx *) ((unsigned __int8 *) ks + sizeof (aes_encrypt_ctx))); break;
+	case TWOFISH:	twofish_decrypt ((TwofishInstance *) ks, (u4byte *) data, (u4byte *) data); break;
+	case SERPENT:	serpent_decrypt ((unsigned __int8 *) data, (unsigned __int8 *) data, (unsigned __int8 *) ks); break;
+	default:		TC_THROW_FATAL_EXCEPTION;
+	}
+}
+
+void DecipherBlocks (int cipher, void *dataPtr, void *ks, size_t blockCount)
+{
+	unsigned __int8 *data = (unsigned __int8 *) dataPtr;
+
+	switch (cipher)
+	{
+	case SERPENT:	serpent_decrypt_blocks (data, data, blockCount, (unsigned __int8 *) ks); break;
+	case TWOFISH:	twofish_decrypt_blocks ((TwofishInstance *) ks, data, data, blockCount); break;
+	default:
+		while (blockCount-- > 0)
+		{
+			DecipherBlock (cipher, data, ks);
+			data += CipherGetBlockSize (cipher);
+		}
+	}
+}
+
+int CipherGetBlockSize (int cipher)
+{
+	return 16;
+}
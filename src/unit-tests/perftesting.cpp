@@ -0,0 +1,248 @@
+#include "perftesting.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define PERF_CYCLE_UNIT "cycles"
+#else
+#define PERF_CYCLE_UNIT "ns"
+#endif
+
+namespace perftesting
+{
+	static std::vector <Benchmark> &GetBenchmarks ()
+	{
+		static std::vector <Benchmark> benchmarks;
+		return benchmarks;
+	}
+
+	int RegisterBenchmark (const char *name, BenchmarkFunction function, size_t bytesPerIteration, double maxCycles)
+	{
+		Benchmark benchmark;
+		benchmark.Name = name;
+		benchmark.Function = function;
+		benchmark.BytesPerIteration = bytesPerIteration;
+		benchmark.MaxCycles = maxCycles;
+
+		GetBenchmarks().push_back (benchmark);
+		return (int) GetBenchmarks().size();
+	}
+
+	void KeepResult (const void *data)
+	{
+		static const void *volatile sink;
+		sink = data;
+	}
+
+	static unsigned long long GetTimeNs ()
+	{
+		struct timespec ts;
+		clock_gettime (CLOCK_MONOTONIC, &ts);
+		return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+
+	/**
+	Uses the time-stamp counter where available. Otherwise, nanoseconds are reported instead of cycles.
+	*/
+	static unsigned long long GetCycles ()
+	{
+#if defined(__i386__) || defined(__x86_64__)
+		return __rdtsc();
+#else
+		return GetTimeNs();
+#endif
+	}
+
+	/**
+	The number of iterations is doubled until a run lasts at least minTimeNs. The fastest of several
+	runs is reported, as slower runs are caused by interrupts, migrations, and frequency changes.
+	*/
+	static double Measure (const Benchmark &benchmark, unsigned long long minTimeNs, int repetitions)
+	{
+		size_t iterations = 1;
+
+		while (true)
+		{
+			unsigned long long start = GetTimeNs();
+			benchmark.Function (iterations);
+
+			if (GetTimeNs() - start >= minTimeNs || iterations >= ((size_t) -1) / 2)
+				break;
+
+			iterations *= 2;
+		}
+
+		double best = 0;
+
+		for (int i = 0; i < repetitions; ++i)
+		{
+			unsigned long long start = GetCycles();
+			benchmark.Function (iterations);
+			double cycles = (double) (GetCycles() - start) / iterations;
+
+			if (benchmark.BytesPerIteration != 0)
+				cycles /= benchmark.BytesPerIteration;
+
+			if (i == 0 || cycles < best)
+				best = cycles;
+		}
+
+		return best;
+	}
+
+	static std::map <std::string, double> LoadBaseline (const char *path)
+	{
+		std::map <std::string, double> baseline;
+
+		FILE *f = fopen (path, "r");
+		if (!f)
+		{
+			fprintf (stderr, "Cannot open baseline file %s\n", path);
+			exit (2);
+		}
+
+		char name[256];
+		double value;
+		while (fscanf (f, "%255s %lf", name, &value) == 2)
+			baseline[name] = value;
+
+		fclose (f);
+		return baseline;
+	}
+
+	static void Usage (const char *program)
+	{
+		fprintf (stderr,
+			"Usage: %s [options]\n"
+			"  --filter=TEXT       Run only benchmarks whose name contains TEXT\n"
+			"  --min-time=MS       Minimum duration of a measured run (default 100)\n"
+			"  --repetitions=N     Number of measured runs (default 5)\n"
+			"  --save=FILE         Save results as a baseline\n"
+			"  --compare=FILE      Fail if a result is slower than the baseline by more than the tolerance\n"
+			"  --tolerance=PERCENT Tolerance of the baseline comparison (default 10)\n"
+			"  --no-limits         Do not fail if the absolute limit of a benchmark is exceeded\n",
+			program);
+	}
+}
+
+#ifndef _MSC_FULL_VER
+#include "tests/perf/cipherPerf.cpp"
+#include "tests/perf/hashPerf.cpp"
+#include "tests/perf/xtsPerf.cpp"
+#include "tests/perf/pkcs5Perf.cpp"
+#include "tests/perf/checksumPerf.cpp"
+#endif
+
+int main (int argc, char *argv[])
+{
+	using namespace perftesting;
+
+	const char *filter = NULL;
+	const char *savePath = NULL;
+	const char *comparePath = NULL;
+	unsigned long long minTimeMs = 100;
+	int repetitions = 5;
+	double tolerance = 10;
+	bool checkLimits = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *arg = argv[i];
+
+		if (strncmp (arg, "--filter=", 9) == 0)
+			filter = arg + 9;
+		else if (strncmp (arg, "--min-time=", 11) == 0)
+			minTimeMs = strtoull (arg + 11, NULL, 10);
+		else if (strncmp (arg, "--repetitions=", 14) == 0)
+			repetitions = atoi (arg + 14);
+		else if (strncmp (arg, "--save=", 7) == 0)
+			savePath = arg + 7;
+		else if (strncmp (arg, "--compare=", 10) == 0)
+			comparePath = arg + 10;
+		else if (strncmp (arg, "--tolerance=", 12) == 0)
+			tolerance = atof (arg + 12);
+		else if (strcmp (arg, "--no-limits") == 0)
+			checkLimits = false;
+		else
+		{
+			Usage (argv[0]);
+			return 2;
+		}
+	}
+
+	if (repetitions < 1)
+		repetitions = 1;
+
+	std::map <std::string, double> baseline;
+	if (comparePath)
+		baseline = LoadBaseline (comparePath);
+
+	FILE *saveFile = NULL;
+	if (savePath)
+	{
+		saveFile = fopen (savePath, "w");
+		if (!saveFile)
+		{
+			fprintf (stderr, "Cannot create %s\n", savePath);
+			return 2;
+		}
+	}
+
+	int failures = 0;
+
+	printf ("%-24s %14s %-12s %14s %14s  %s\n", "Benchmark", "Result", "Unit", "Limit", "Baseline", "Status");
+
+	for (size_t i = 0; i < GetBenchmarks().size(); ++i)
+	{
+		const Benchmark &benchmark = GetBenchmarks()[i];
+
+		if (filter && !strstr (benchmark.Name, filter))
+			continue;
+
+		double result = Measure (benchmark, minTimeMs * 1000000ULL, repetitions);
+		const char *status = "OK";
+
+		if (checkLimits && result > benchmark.MaxCycles)
+			status = "FAIL (limit)";
+
+		char baselineText[32] = "-";
+		std::map <std::string, double>::const_iterator entry = baseline.find (benchmark.Name);
+
+		if (entry != baseline.end())
+		{
+			snprintf (baselineText, sizeof (baselineText), "%.2f", entry->second);
+
+			if (result > entry->second * (1 + tolerance / 100))
+				status = "FAIL (regression)";
+		}
+
+		if (strcmp (status, "OK") != 0)
+			++failures;
+
+		printf ("%-24s %14.2f %-12s %14.2f %14s  %s\n", benchmark.Name, result,
+			benchmark.BytesPerIteration != 0 ? PERF_CYCLE_UNIT "/byte" : PERF_CYCLE_UNIT "/op",
+			benchmark.MaxCycles, baselineText, status);
+		fflush (stdout);
+
+		if (saveFile)
+			fprintf (saveFile, "%s %f\n", benchmark.Name, result);
+	}
+
+	if (saveFile)
+		fclose (saveFile);
+
+	if (failures > 0)
+	{
+		printf ("%d benchmark(s) failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
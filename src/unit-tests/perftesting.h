@@ -0,0 +1,43 @@
+#ifndef _perftesting_h_
+#define _perftesting_h_
+
+#ifndef CS_UNITTESTING
+#define CS_UNITTESTING
+#endif
+
+#include <stddef.h>
+
+namespace perftesting
+{
+	/**
+	Runs the measured operation the specified number of times.
+	*/
+	typedef void (*BenchmarkFunction) (size_t iterations);
+
+	struct Benchmark
+	{
+		const char *Name;
+		BenchmarkFunction Function;
+		size_t BytesPerIteration;	// 0 if the result is to be reported per iteration rather than per byte
+		double MaxCycles;			// Regression threshold in cycles per byte (or per iteration)
+	};
+
+	int RegisterBenchmark (const char *name, BenchmarkFunction function, size_t bytesPerIteration, double maxCycles);
+
+	/**
+	Prevents the compiler from optimizing away a computation whose result is otherwise unused.
+	*/
+	void KeepResult (const void *data);
+}
+
+/**
+Defines and registers a benchmark. The body is given the number of iterations to execute.
+maxCycles specifies the number of cycles per byte (or per iteration if bytesPerIteration is 0)
+above which the benchmark is reported as a regression.
+*/
+#define PERF_BENCHMARK(name, bytesPerIteration, maxCycles) \
+	static void name (size_t iterations); \
+	static int name##Registration = perftesting::RegisterBenchmark (#name, name, (bytesPerIteration), (maxCycles)); \
+	static void name (size_t iterations)
+
+#endif
@@ -0,0 +1,93 @@
+
+#include "../../unittesting.h"
+
+#include "../../../Common/Pkcs5.h"
+#include <string.h>
+
+namespace CipherShed_Tests_Algo
+{
+	TESTCLASS
+	PUBLIC_REF_CLASS Pkcs5Test TESTCLASSEXTENDS
+	{
+	private:
+		TESTCONTEXT testContextInstance;
+
+		typedef void (*DeriveU) (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *u, int b);
+		typedef void (*DeriveKey) (char *pwd, int pwd_len, char *salt, int salt_len, int iterations, char *dk, int dklen);
+
+		/**
+		Compares the key derived by derive_key_* (multi-buffer) with the key assembled from blocks derived one at a time.
+		*/
+		static bool KeyMatchesSingleBlocks (DeriveU deriveU, DeriveKey deriveKey, int digestSize, int iterations, int keySize)
+		{
+			char password[] = "password";
+			char salt[64];
+			char expected[512], key[512], block[64];
+
+			for (int i = 0; i < (int) sizeof (salt); ++i)
+				salt[i] = (char) (i * 3 + 1);
+
+			for (int b = 0; b * digestSize < keySize; ++b)
+			{
+				int size = keySize - b * digestSize < digestSize ? keySize - b * digestSize : digestSize;
+				deriveU (password, 8, salt, sizeof (salt), iterations, block, b + 1);
+				memcpy (expected + b * digestSize, block, size);
+			}
+
+			deriveKey (password, 8, salt, sizeof (salt), iterations, key, keySize);
+			return memcmp (expected, key, keySize) == 0;
+		}
+
+	public:
+		/// <summary>
+		///Gets or sets the test context which provides
+		///information about and functionality for the current test run.
+		///</summary>
+		TESTCONTEXTPROP
+
+		TESTMETHOD
+		void testSha1Rfc6070()
+		{
+			//https://tools.ietf.org/html/rfc6070
+			const unsigned char expected1[] = {
+				0x0c, 0x60, 0xc8, 0x0f, 0x96, 0x1f, 0x0e, 0x71, 0xf3, 0xa9,
+				0xb5, 0x24, 0xaf, 0x60, 0x12, 0x06, 0x2f, 0xe0, 0x37, 0xa6 };
+			const unsigned char expected4096[] = {
+				0x3d, 0x2e, 0xec, 0x4f, 0xe4, 0x1c, 0x84, 0x9b, 0x80, 0xc8, 0xd8, 0x36, 0x62,
+				0xc0, 0xe4, 0x4a, 0x8b, 0x29, 0x1a, 0x96, 0x4c, 0xf2, 0xf0, 0x70, 0x38 };
+			char key[25];
+
+			derive_key_sha1 ((char *) "password", 8, (char *) "salt", 4, 1, key, 20);
+			TEST_ASSERT(memcmp (key, expected1, sizeof (expected1)) == 0);
+
+			derive_key_sha1 ((char *) "passwordPASSWORDpassword", 24, (char *) "saltSALTsaltSALTsaltSALTsaltSALTsalt", 36, 4096, key, 25);
+			TEST_ASSERT(memcmp (key, expected4096, sizeof (expected4096)) == 0);
+		}
+
+		TESTMETHOD
+		void testMultiBufferMatchesSingleBlocks()
+		{
+			const int iterations[] = { 1, 2, 1000 };
+			const int keySizes[] = { 1, 20, 64, 100, 192, 333 };
+
+			for (size_t i = 0; i < sizeof (iterations) / sizeof (iterations[0]); ++i)
+			{
+				for (size_t k = 0; k < sizeof (keySizes) / sizeof (keySizes[0]); ++k)
+				{
+					TEST_ASSERT(KeyMatchesSingleBlocks (derive_u_ripemd160, derive_key_ripemd160, RIPEMD160_DIGESTSIZE, iterations[i], keySizes[k]));
+					TEST_ASSERT(KeyMatchesSingleBlocks (derive_u_sha1, derive_key_sha1, SHA1_DIGESTSIZE, iterations[i], keySizes[k]));
+					TEST_ASSERT(KeyMatchesSingleBlocks (derive_u_sha512, derive_key_sha512, SHA512_DIGESTSIZE, iterations[i], keySizes[k]));
+				}
+			}
+		}
+
+		/**
+		The constructor needs the add each test method for the non-VS unit test execution.
+		*/
+		Pkcs5Test()
+		{
+			TEST_ADD(Pkcs5Test::testSha1Rfc6070);
+			TEST_ADD(Pkcs5Test::testMultiBufferMatchesSingleBlocks);
+		}
+	};
+}
@@ -0,0 +1,114 @@
+
+#include "../../unittesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Crypto.h"
+#include "../../../Common/Xts.h"
+#include "../../../Common/XtsEngine.h"
+#include <string.h>
+
+namespace CipherShed_Tests_Algo
+{
+	TESTCLASS
+	PUBLIC_REF_CLASS XtsTest TESTCLASSEXTENDS
+	{
+	private:
+		TESTCONTEXT testContextInstance;
+
+		/**
+		Compares the output of XtsEngine with Common/Xts.c for buffers starting at each block of a data unit
+		and spanning up to three data units, and checks that XtsEngine decrypts it back. The bitsliced AES key
+		schedule is appended to the AES key schedules as in CipherAES.
+		*/
+		template <class CipherImpl>
+		static bool EngineMatchesXts (int cipher)
+		{
+			static unsigned __int8 ks[MAX_EXPANDED_KEY + sizeof (aes_bitsliced_ctx)], ks2[MAX_EXPANDED_KEY + sizeof (aes_bitsliced_ctx)];
+			unsigned __int8 key[32];
+			unsigned __int8 plaintext[3 * ENCRYPTION_DATA_UNIT_SIZE];
+			unsigned __int8 expected[sizeof (plaintext)], data[sizeof (plaintext)];
+			UINT64_STRUCT dataUnitNo;
+
+			for (size_t i = 0; i < sizeof (key); ++i)
+				key[i] = (unsigned __int8) (i * 7 + 1);
+			CipherInit (cipher, key, ks);
+
+			for (size_t i = 0; i < sizeof (key); ++i)
+				key[i] = (unsigned __int8) (0xff - i);
+			CipherInit (cipher, key, ks2);
+
+			if (cipher == AES)
+			{
+				aes_bitsliced_set_key ((aes_encrypt_ctx *) ks, (aes_bitsliced_ctx *) (ks + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx)));
+				aes_bitsliced_set_key ((aes_encrypt_ctx *) ks2, (aes_bitsliced_ctx *) (ks2 + sizeof (aes_encrypt_ctx) + sizeof (aes_decrypt_ctx)));
+			}
+
+			for (size_t i = 0; i < sizeof (plaintext); ++i)
+				plaintext[i] = (unsigned __int8) (i * 13);
+
+			dataUnitNo.Value = 0x0123456789ABCDEFULL;
+
+			for (unsigned int startBlock = 0; startBlock < BLOCKS_PER_XTS_DATA_UNIT; ++startBlock)
+			{
+				for (size_t length = BYTES_PER_XTS_BLOCK; length <= sizeof (plaintext) - startBlock * BYTES_PER_XTS_BLOCK; length += 5 * BYTES_PER_XTS_BLOCK)
+				{
+					memcpy (expected, plaintext, length);
+					EncryptBufferXTS (expected, length, &dataUnitNo, startBlock, ks, ks2, cipher);
+
+					CipherShed::XtsEngine <CipherImpl>::EncryptBuffer (ks, ks2, plaintext, data, length, dataUnitNo.Value, startBlock);
+					if (memcmp (expected, data, length) != 0)
+						return false;
+
+					CipherShed::XtsEngine <CipherImpl>::DecryptBuffer (ks, ks2, data, length, dataUnitNo.Value, startBlock);
+					if (memcmp (plaintext, data, length) != 0)
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+	public:
+		/// <summary>
+		///Gets or sets the test context which provides
+		///information about and functionality for the current test run.
+		///</summary>
+		TESTCONTEXTPROP
+
+		TESTMETHOD
+		void testAesEngineMatchesXts()
+		{
+			TEST_ASSERT(EngineMatchesXts <CipherShed::XtsCipherAES> (AES));
+		}
+
+		TESTMETHOD
+		void testAesBitslicedEngineMatchesXts()
+		{
+			if (aes_bitsliced_supported())
+				TEST_ASSERT(EngineMatchesXts <CipherShed::XtsCipherAESBitsliced> (AES));
+		}
+
+		TESTMETHOD
+		void testSerpentEngineMatchesXts()
+		{
+			TEST_ASSERT(EngineMatchesXts <CipherShed::XtsCipherSerpent> (SERPENT));
+		}
+
+		TESTMETHOD
+		void testTwofishEngineMatchesXts()
+		{
+			TEST_ASSERT(EngineMatchesXts <CipherShed::XtsCipherTwofish> (TWOFISH));
+		}
+
+		/**
+		The constructor needs the add each test method for the non-VS unit test execution.
+		*/
+		XtsTest()
+		{
+			TEST_ADD(XtsTest::testAesEngineMatchesXts);
+			TEST_ADD(XtsTest::testAesBitslicedEngineMatchesXts);
+			TEST_ADD(XtsTest::testSerpentEngineMatchesXts);
+			TEST_ADD(XtsTest::testTwofishEngineMatchesXts);
+		}
+	};
+}
@@ -0,0 +1,82 @@
+#include "../../perftesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Crc.h"
+#include "../../../Common/Endian.h"
+#include "../../../Common/GfMul.h"
+
+namespace checksum_perf
+{
+	static const size_t DataSize = 64 * 1024;
+	static unsigned char Data[DataSize];
+
+	PERF_BENCHMARK (crc32, DataSize, 15)
+	{
+		static unsigned __int32 crc;
+
+		while (iterations-- > 0)
+			crc += GetCrc32 (Data, DataSize);
+
+		perftesting::KeepResult (&crc);
+	}
+
+	PERF_BENCHMARK (gfMul128, 16, 150)
+	{
+		static unsigned __int8 a[16] = { 1 };
+		static const unsigned __int8 b[16] = { 0x87, 0x65, 0x43, 0x21, 0x0f, 0xed, 0xcb, 0xa9, 0x87, 0x65, 0x43, 0x21, 0x0f, 0xed, 0xcb, 0xa9 };
+
+		while (iterations-- > 0)
+			GfMul128 (a, b);
+
+		perftesting::KeepResult (a);
+	}
+
+	static GfCtx LrwGfContext;
+
+	static GfCtx *GetLrwGfContext ()
+	{
+		unsigned __int8 key[16];
+		for (size_t i = 0; i < sizeof (key); ++i)
+			key[i] = (unsigned __int8) (i * 0x1d + 1);
+
+		Gf128Tab64Init (key, &LrwGfContext);
+		return &LrwGfContext;
+	}
+
+	// LRW whitening value of each block computed with a table multiplication
+	PERF_BENCHMARK (gf128MulBy64Tab, DataSize, 4)
+	{
+		GfCtx *ctx = GetLrwGfContext ();
+
+		while (iterations-- > 0)
+		{
+			for (uint64 blockIndex = 1; blockIndex <= DataSize / 16; ++blockIndex)
+			{
+				unsigned __int8 i[8];
+				*(uint64 *) i = BE64 (blockIndex);
+
+				Gf128MulBy64Tab (i, Data + (blockIndex - 1) * 16, ctx);
+			}
+		}
+
+		perftesting::KeepResult (Data);
+	}
+
+	// LRW whitening value of each block derived from that of the previous block
+	PERF_BENCHMARK (gf128MulBy64TabSeq, DataSize, 0.5)
+	{
+		GfCtx *ctx = GetLrwGfContext ();
+
+		while (iterations-- > 0)
+		{
+			unsigned __int8 i[8];
+			unsigned __int8 t[16];
+
+			*(uint64 *) i = BE64 (1);
+			Gf128MulBy64Tab (i, t, ctx);
+			Gf128MulBy64TabSeq (1, t, Data, DataSize / 16, ctx);
+		}
+
+		perftesting::KeepResult (Data);
+	}
+}
@@ -0,0 +1,117 @@
+#include "../../perftesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Crypto.h"
+#include "../../../Crypto/Aes_bitsliced.h"
+
+namespace cipher_perf
+{
+	static const size_t DataSize = 64 * 1024;
+	static unsigned __int8 Data[DataSize];
+	static unsigned __int8 KeySchedule[MAX_EXPANDED_KEY];
+
+	static unsigned __int8 *GetKeySchedule (int cipher)
+	{
+		unsigned char key[32];
+		for (size_t i = 0; i < sizeof (key); ++i)
+			key[i] = (unsigned char) i;
+
+		CipherInit (cipher, key, KeySchedule);
+		return KeySchedule;
+	}
+
+	PERF_BENCHMARK (aesEncrypt, DataSize, 40)
+	{
+		aes_encrypt_ctx *ks = (aes_encrypt_ctx *) GetKeySchedule (AES);
+
+		while (iterations-- > 0)
+		{
+			for (size_t i = 0; i < DataSize; i += 16)
+				aes_encrypt (Data + i, Data + i, ks);
+		}
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (aesDecrypt, DataSize, 40)
+	{
+		aes_decrypt_ctx *ks = (aes_decrypt_ctx *) (GetKeySchedule (AES) + sizeof (aes_encrypt_ctx));
+
+		while (iterations-- > 0)
+		{
+			for (size_t i = 0; i < DataSize; i += 16)
+				aes_decrypt (Data + i, Data + i, ks);
+		}
+
+		perftesting::KeepResult (Data);
+	}
+
+	static aes_bitsliced_ctx BitslicedKeySchedule;
+
+	static const aes_bitsliced_ctx *GetBitslicedKeySchedule ()
+	{
+		aes_bitsliced_set_key ((aes_encrypt_ctx *) GetKeySchedule (AES), &BitslicedKeySchedule);
+		return &BitslicedKeySchedule;
+	}
+
+	// Not measured on CPUs without SSSE3
+	PERF_BENCHMARK (aesBitslicedEncrypt, DataSize, 40)
+	{
+		const aes_bitsliced_ctx *ks = GetBitslicedKeySchedule ();
+
+		while (aes_bitsliced_supported() && iterations-- > 0)
+			aes_bitsliced_encrypt_blocks (ks, Data, Data, DataSize / 16);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (aesBitslicedDecrypt, DataSize, 40)
+	{
+		const aes_bitsliced_ctx *ks = GetBitslicedKeySchedule ();
+
+		while (aes_bitsliced_supported() && iterations-- > 0)
+			aes_bitsliced_decrypt_blocks (ks, Data, Data, DataSize / 16);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (serpentEncrypt, DataSize, 30)
+	{
+		unsigned __int8 *ks = GetKeySchedule (SERPENT);
+
+		while (iterations-- > 0)
+			serpent_encrypt_blocks (Data, Data, DataSize / 16, ks);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (serpentDecrypt, DataSize, 30)
+	{
+		unsigned __int8 *ks = GetKeySchedule (SERPENT);
+
+		while (iterations-- > 0)
+			serpent_decrypt_blocks (Data, Data, DataSize / 16, ks);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (twofishEncrypt, DataSize, 30)
+	{
+		TwofishInstance *ks = (TwofishInstance *) GetKeySchedule (TWOFISH);
+
+		while (iterations-- > 0)
+			twofish_encrypt_blocks (ks, Data, Data, DataSize / 16);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (twofishDecrypt, DataSize, 30)
+	{
+		TwofishInstance *ks = (TwofishInstance *) GetKeySchedule (TWOFISH);
+
+		while (iterations-- > 0)
+			twofish_decrypt_blocks (ks, Data, Data, DataSize / 16);
+
+		perftesting::KeepResult (Data);
+	}
+}
@@ -0,0 +1,67 @@
+#include "../../perftesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Crypto.h"
+#include "../../../Crypto/Rmd160.h"
+#include "../../../Crypto/Sha1.h"
+#include "../../../Crypto/Sha2.h"
+#include "../../../Crypto/Whirlpool.h"
+
+namespace hash_perf
+{
+	static const size_t DataSize = 64 * 1024;
+	static unsigned char Data[DataSize];
+	static unsigned char Digest[64];
+
+	PERF_BENCHMARK (ripemd160, DataSize, 25)
+	{
+		while (iterations-- > 0)
+		{
+			RMD160_CTX ctx;
+			RMD160Init (&ctx);
+			RMD160Update (&ctx, Data, DataSize);
+			RMD160Final (Digest, &ctx);
+		}
+
+		perftesting::KeepResult (Digest);
+	}
+
+	PERF_BENCHMARK (sha1, DataSize, 20)
+	{
+		while (iterations-- > 0)
+		{
+			sha1_ctx ctx;
+			sha1_begin (&ctx);
+			sha1_hash (Data, DataSize, &ctx);
+			sha1_end (Digest, &ctx);
+		}
+
+		perftesting::KeepResult (Digest);
+	}
+
+	PERF_BENCHMARK (sha512, DataSize, 30)
+	{
+		while (iterations-- > 0)
+		{
+			sha512_ctx ctx;
+			sha512_begin (&ctx);
+			sha512_hash (Data, DataSize, &ctx);
+			sha512_end (Digest, &ctx);
+		}
+
+		perftesting::KeepResult (Digest);
+	}
+
+	PERF_BENCHMARK (whirlpool, DataSize, 80)
+	{
+		while (iterations-- > 0)
+		{
+			WHIRLPOOL_CTX ctx;
+			WHIRLPOOL_init (&ctx);
+			WHIRLPOOL_add (Data, DataSize * 8, &ctx);
+			WHIRLPOOL_finalize (&ctx, Digest);
+		}
+
+		perftesting::KeepResult (Digest);
+	}
+}
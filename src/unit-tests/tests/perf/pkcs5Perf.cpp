@@ -0,0 +1,44 @@
+#include "../../perftesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Pkcs5.h"
+
+namespace pkcs5_perf
+{
+	// Header key derivation with the iteration counts used by volume headers (results are per derived key)
+	static char Password[] = "password";
+	static char Salt[64];
+	static char DerivedKey[192];
+
+	PERF_BENCHMARK (pbkdf2RipeMd160, 0, 150000000)
+	{
+		while (iterations-- > 0)
+			derive_key_ripemd160 (Password, sizeof (Password) - 1, Salt, sizeof (Salt), 2000, DerivedKey, sizeof (DerivedKey));
+
+		perftesting::KeepResult (DerivedKey);
+	}
+
+	PERF_BENCHMARK (pbkdf2Sha1, 0, 120000000)
+	{
+		while (iterations-- > 0)
+			derive_key_sha1 (Password, sizeof (Password) - 1, Salt, sizeof (Salt), 2000, DerivedKey, sizeof (DerivedKey));
+
+		perftesting::KeepResult (DerivedKey);
+	}
+
+	PERF_BENCHMARK (pbkdf2Sha512, 0, 80000000)
+	{
+		while (iterations-- > 0)
+			derive_key_sha512 (Password, sizeof (Password) - 1, Salt, sizeof (Salt), 1000, DerivedKey, sizeof (DerivedKey));
+
+		perftesting::KeepResult (DerivedKey);
+	}
+
+	PERF_BENCHMARK (pbkdf2Whirlpool, 0, 100000000)
+	{
+		while (iterations-- > 0)
+			derive_key_whirlpool (Password, sizeof (Password) - 1, Salt, sizeof (Salt), 1000, DerivedKey, sizeof (DerivedKey));
+
+		perftesting::KeepResult (DerivedKey);
+	}
+}
@@ -0,0 +1,59 @@
+#include "../../perftesting.h"
+
+#undef TC_WINDOWS_DRIVER
+#include "../../../Common/Crypto.h"
+#include "../../../Common/Xts.h"
+
+namespace xts_perf
+{
+	static const size_t DataSize = 64 * ENCRYPTION_DATA_UNIT_SIZE;
+	static unsigned __int8 Data[DataSize];
+	static unsigned __int8 KeySchedule[MAX_EXPANDED_KEY];
+	static unsigned __int8 SecondaryKeySchedule[MAX_EXPANDED_KEY];
+
+	static void InitKeySchedules (int cipher)
+	{
+		unsigned char key[32];
+
+		for (size_t i = 0; i < sizeof (key); ++i)
+			key[i] = (unsigned char) i;
+		CipherInit (cipher, key, KeySchedule);
+
+		for (size_t i = 0; i < sizeof (key); ++i)
+			key[i] = (unsigned char) (0xff - i);
+		CipherInit (cipher, key, SecondaryKeySchedule);
+	}
+
+	static void EncryptData (int cipher, size_t iterations)
+	{
+		UINT64_STRUCT dataUnitNo;
+		dataUnitNo.Value = 0;
+
+		InitKeySchedules (cipher);
+
+		while (iterations-- > 0)
+			EncryptBufferXTS (Data, DataSize, &dataUnitNo, 0, KeySchedule, SecondaryKeySchedule, cipher);
+
+		perftesting::KeepResult (Data);
+	}
+
+	static void DecryptData (int cipher, size_t iterations)
+	{
+		UINT64_STRUCT dataUnitNo;
+		dataUnitNo.Value = 0;
+
+		InitKeySchedules (cipher);
+
+		while (iterations-- > 0)
+			DecryptBufferXTS (Data, DataSize, &dataUnitNo, 0, KeySchedule, SecondaryKeySchedule, cipher);
+
+		perftesting::KeepResult (Data);
+	}
+
+	PERF_BENCHMARK (xtsAesEncrypt, DataSize, 50)		{ EncryptData (AES, iterations); }
+	PERF_BENCHMARK (xtsAesDecrypt, DataSize, 50)		{ DecryptData (AES, iterations); }
+	PERF_BENCHMARK (xtsSerpentEncrypt, DataSize, 90)	{ EncryptData (SERPENT, iterations); }
+	PERF_BENCHMARK (xtsSerpentDecrypt, DataSize, 90)	{ DecryptData (SERPENT, iterations); }
+	PERF_BENCHMARK (xtsTwofishEncrypt, DataSize, 60)	{ EncryptData (TWOFISH, iterations); }
+	PERF_BENCHMARK (xtsTwofishDecrypt, DataSize, 60)	{ DecryptData (TWOFISH, iterations); }
+}
@@ -65,6 +65,8 @@ namespace unittesting
 #include "tests/algo/crcTest.cpp"
 #include "tests/algo/endianTest.cpp"
 #include "tests/algo/passwordTest.cpp"
+#include "tests/algo/pkcs5Test.cpp"
+#include "tests/algo/xtsTest.cpp"
 #include "tests/lib/unicodeTest.cpp"
 #include "tests/lib/stringUtilTest.cpp"
 #endif
@@ -78,6 +80,8 @@ int main(int argc, char *argv[], char *envp[])
 	MAINADDTEST(new CipherShed_Tests_Algo::PasswordTest);
 	MAINADDTEST(new crc::CrcTest);
 	MAINADDTEST(new CipherShed_Tests_Algo::EndianTest);
+	MAINADDTEST(new CipherShed_Tests_Algo::Pkcs5Test);
+	MAINADDTEST(new CipherShed_Tests_Algo::XtsTest);
 	MAINADDTEST(new CipherShed_Tests_lib::UnicodeTest);
 	MAINADDTEST(new CipherShed_Tests_lib::StringUtilTest);
 	MAINTESTRUN